@@ -0,0 +1,320 @@
+// Callback vs coroutine: WebSocketClientPlain against AwaitableClientPlain,
+// both echoing through an in-process LocalServer on loopback.
+//
+// For every payload size each client runs two phases on a fresh connection:
+//   - pipelined: --window echoes outstanding; msgs/s and RTT percentiles
+//   - ping-pong: one message outstanding; msgs/s and RTT percentiles
+//
+// Needs a C++20 build; otherwise it only says so.
+
+#include "awaitable_client.hpp"
+#include "latency_histogram.hpp"
+#include "local_server.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <CLI/CLI.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+
+// GCC 12 pairs Asio's coroutine frame operator new with its sized delete
+// and warns about a mismatch that is not there
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    std::vector<std::size_t> sizes{32, 1024, 16384};
+    std::size_t window = 64;
+    std::uint64_t messages = 50000;
+    std::uint64_t rtt_samples = 10000;
+};
+
+struct PhaseResult {
+    double seconds = 0;
+    std::uint64_t messages = 0;
+    websocket_client::LatencyHistogram rtt;
+};
+
+std::uint64_t elapsedNs(Clock::time_point since, Clock::time_point now) {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - since).count());
+}
+
+// Callback side: the same driver as websocket_client_bench
+class CallbackDriver {
+public:
+    CallbackDriver(boost::asio::io_context& ioc, std::size_t payload_size)
+        : client_(std::make_shared<websocket_client::WebSocketClientPlain>(ioc))
+        , payload_(payload_size, 'x')
+    {
+    }
+
+    void connect(unsigned short port) {
+        std::promise<void> connected;
+        auto connected_future = connected.get_future();
+        client_->connect(
+            "127.0.0.1",
+            std::to_string(port),
+            "/",
+            [this](std::string_view, websocket_client::Opcode) { onEcho(); },
+            [](const std::string& error) {
+                std::cerr << "bench client error: " << error << std::endl;
+            },
+            [&connected]() { connected.set_value(); });
+        connected_future.wait();
+    }
+
+    PhaseResult run(boost::asio::io_context& ioc, std::uint64_t messages, std::size_t window) {
+        result_ = PhaseResult{};
+        remaining_ = messages;
+        outstanding_ = 0;
+        done_ = std::promise<void>();
+        auto done = done_.get_future();
+
+        const auto start = Clock::now();
+        boost::asio::post(ioc, [this, window]() {
+            for (std::size_t i = 0; i < window && remaining_ > 0; ++i) {
+                sendNext();
+            }
+        });
+        done.wait();
+
+        result_.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return std::move(result_);
+    }
+
+    void close() { client_->close(); }
+
+private:
+    void sendNext() {
+        --remaining_;
+        ++outstanding_;
+        sent_at_.push_back(Clock::now());
+        client_->send(payload_);
+    }
+
+    void onEcho() {
+        result_.rtt.record(elapsedNs(sent_at_.front(), Clock::now()));
+        sent_at_.pop_front();
+        ++result_.messages;
+        --outstanding_;
+
+        if (remaining_ > 0) {
+            sendNext();
+        } else if (outstanding_ == 0) {
+            done_.set_value();
+        }
+    }
+
+    std::shared_ptr<websocket_client::WebSocketClientPlain> client_;
+    std::string payload_;
+    std::deque<Clock::time_point> sent_at_;
+    std::uint64_t remaining_ = 0;
+    std::size_t outstanding_ = 0;
+    PhaseResult result_;
+    std::promise<void> done_;
+};
+
+// Coroutine side: a writer and a reader coroutine share the connection; the
+// writer parks on a timer while `window` echoes are outstanding
+struct Pipeline {
+    Pipeline(websocket_client::AwaitableClientPlain& client, const std::string& payload,
+             std::uint64_t messages, std::size_t window)
+        : client(client)
+        , payload(payload)
+        , messages(messages)
+        , window(window)
+        , space(client.get_executor())
+    {
+    }
+
+    websocket_client::AwaitableClientPlain& client;
+    const std::string& payload;
+    std::uint64_t messages;
+    std::size_t window;
+    std::deque<Clock::time_point> sent_at;
+    std::size_t outstanding = 0;
+    bool writing = true;
+    boost::asio::steady_timer space;
+    PhaseResult result;
+
+    boost::asio::awaitable<void> wake() {
+        boost::system::error_code ec;
+        space.expires_at(Clock::time_point::max());
+        co_await space.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    }
+
+    boost::asio::awaitable<void> write() {
+        for (std::uint64_t i = 0; i < messages; ++i) {
+            while (outstanding >= window) {
+                co_await wake();
+            }
+            ++outstanding;
+            sent_at.push_back(Clock::now());
+            co_await client.write(payload);
+        }
+        writing = false;
+        space.cancel();
+    }
+
+    boost::asio::awaitable<void> read() {
+        for (std::uint64_t i = 0; i < messages; ++i) {
+            co_await client.read();
+            result.rtt.record(elapsedNs(sent_at.front(), Clock::now()));
+            sent_at.pop_front();
+            ++result.messages;
+            --outstanding;
+            space.cancel();
+        }
+
+        // The last write can complete after its echo has been read
+        while (writing) {
+            co_await wake();
+        }
+    }
+};
+
+boost::asio::awaitable<PhaseResult> coroutinePhase(
+    websocket_client::AwaitableClientPlain& client, const std::string& payload,
+    std::uint64_t messages, std::size_t window) {
+    const auto start = Clock::now();
+
+    if (window <= 1) {
+        PhaseResult result;
+        for (std::uint64_t i = 0; i < messages; ++i) {
+            const auto sent = Clock::now();
+            co_await client.write(payload);
+            co_await client.read();
+            result.rtt.record(elapsedNs(sent, Clock::now()));
+            ++result.messages;
+        }
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        co_return result;
+    }
+
+    Pipeline pipeline(client, payload, messages, window);
+    boost::asio::co_spawn(client.get_executor(), pipeline.write(), boost::asio::detached);
+    co_await pipeline.read();
+
+    pipeline.result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    co_return std::move(pipeline.result);
+}
+
+void printPhase(const char* client, const char* phase, std::size_t size,
+                const PhaseResult& result) {
+    std::printf("%-9s %-9s %8zu %10.0f %9.1f %9.1f %9.1f\n",
+        client, phase, size,
+        static_cast<double>(result.messages) / result.seconds,
+        static_cast<double>(result.rtt.percentile(50.0)) / 1e3,
+        static_cast<double>(result.rtt.percentile(99.0)) / 1e3,
+        static_cast<double>(result.rtt.percentile(99.9)) / 1e3);
+    std::fflush(stdout);
+}
+
+void runCallback(unsigned short port, std::size_t size, const BenchOptions& options) {
+    boost::asio::io_context ioc;
+    CallbackDriver driver(ioc, size);
+    std::thread io_thread([&ioc]() {
+        auto guard = boost::asio::make_work_guard(ioc);
+        ioc.run();
+    });
+
+    driver.connect(port);
+    printPhase("callback", "pipelined", size, driver.run(ioc, options.messages, options.window));
+    printPhase("callback", "ping-pong", size, driver.run(ioc, options.rtt_samples, 1));
+
+    driver.close();
+    ioc.stop();
+    io_thread.join();
+}
+
+void runCoroutine(unsigned short port, std::size_t size, const BenchOptions& options) {
+    boost::asio::io_context ioc;
+    const std::string payload(size, 'x');
+
+    boost::asio::co_spawn(ioc,
+        [&]() -> boost::asio::awaitable<void> {
+            websocket_client::AwaitableClientPlain client(co_await boost::asio::this_coro::executor);
+            co_await client.connect("127.0.0.1", std::to_string(port), "/");
+
+            printPhase("coroutine", "pipelined", size,
+                co_await coroutinePhase(client, payload, options.messages, options.window));
+            printPhase("coroutine", "ping-pong", size,
+                co_await coroutinePhase(client, payload, options.rtt_samples, 1));
+
+            co_await client.close();
+        },
+        [](std::exception_ptr e) {
+            if (e) {
+                std::rethrow_exception(e);
+            }
+        });
+
+    ioc.run();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+
+    CLI::App app{"Callback vs coroutine client benchmark"};
+    app.add_option("--sizes", options.sizes, "Comma-separated payload sizes in bytes")
+        ->delimiter(',');
+    app.add_option("--window", options.window, "Outstanding echoes in the pipelined phase");
+    app.add_option("--messages", options.messages, "Messages in the pipelined phase");
+    app.add_option("--rtt-samples", options.rtt_samples, "Messages in the ping-pong phase");
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError& e) {
+        return app.exit(e);
+    }
+
+    try {
+        websocket_client::LocalServer server({});
+        server.start();
+
+        std::printf("%-9s %-9s %8s %10s %9s %9s %9s\n",
+            "client", "phase", "bytes", "msgs/s", "p50(us)", "p99(us)", "p99.9(us)");
+        for (std::size_t size : options.sizes) {
+            runCallback(server.port(), size, options);
+            runCoroutine(server.port(), size, options);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+#else
+
+int main() {
+    std::cerr << "websocket_awaitable_bench needs a C++20 build" << std::endl;
+    return 1;
+}
+
+#endif // BOOST_ASIO_HAS_CO_AWAIT
@@ -0,0 +1,163 @@
+// Client frame masking, and what it costs end to end.
+//
+// kernels: every masking kernel this CPU can run masks the same buffer over
+//          and over, for each --mask-sizes entry, reporting GB/s.
+// send:    WebSocketClientPlain sends --count binary messages of each
+//          --send-sizes entry to an in-process sink server, once through
+//          Beast's writer and once through FrameEncoder, reporting MB/s of
+//          payload from the first sendBinary() until the server has read
+//          the last message.
+
+#include "frame_encoder.hpp"
+#include "local_server.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <CLI/CLI.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    std::vector<std::size_t> mask_sizes{64, 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+    std::vector<std::size_t> send_sizes_kb{64, 256, 1024, 4096, 16384};
+    std::uint64_t mask_bytes = 4ull * 1024 * 1024 * 1024;
+    std::size_t count = 32;
+};
+
+void benchKernels(const BenchOptions& options) {
+    const websocket_client::MaskKey key{0x37, 0xfa, 0x21, 0x3d};
+
+    std::printf("%-8s %10s %10s\n", "kernel", "bytes", "GB/s");
+    for (std::size_t size : options.mask_sizes) {
+        // Offset by one byte so no kernel gets an aligned buffer for free
+        std::string buffer(size + 1, 'x');
+        char* data = buffer.data() + 1;
+        const std::uint64_t rounds = std::max<std::uint64_t>(options.mask_bytes / size, 1);
+
+        for (auto kernel : websocket_client::availableMaskKernels()) {
+            const auto start = Clock::now();
+            for (std::uint64_t i = 0; i < rounds; ++i) {
+                websocket_client::maskInPlace(kernel, data, size, key);
+            }
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+            // Keep the compiler from dropping the loop
+            volatile char sink = data[size / 2];
+            (void)sink;
+
+            std::printf("%-8s %10zu %10.2f\n",
+                websocket_client::maskKernelName(kernel), size,
+                static_cast<double>(size) * static_cast<double>(rounds) / seconds / 1e9);
+            std::fflush(stdout);
+        }
+    }
+}
+
+double sendOnce(bool encoder, std::size_t size, std::size_t count,
+                websocket_client::LocalServer& server) {
+    boost::asio::io_context ioc;
+    auto client = std::make_shared<websocket_client::WebSocketClientPlain>(ioc);
+    client->setFrameEncoder(encoder);
+
+    std::promise<void> connected;
+    auto connected_future = connected.get_future();
+    client->connect(
+        "127.0.0.1",
+        std::to_string(server.port()),
+        "/",
+        [](std::string_view, websocket_client::Opcode) {},
+        [](const std::string& error) {
+            std::cerr << "bench client error: " << error << std::endl;
+        },
+        [&connected]() { connected.set_value(); });
+    std::thread io_thread([&ioc]() {
+        auto guard = boost::asio::make_work_guard(ioc);
+        ioc.run();
+    });
+    connected_future.wait();
+
+    // sendBinary() copies into the queue, as callers would pay anyway
+    const std::vector<uint8_t> payload(size, 0x5a);
+    const std::uint64_t received_before = server.stats().messages_received;
+
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        client->sendBinary(payload);
+    }
+    while (server.stats().messages_received < received_before + count) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    client->close();
+    ioc.stop();
+    io_thread.join();
+    return static_cast<double>(size) * static_cast<double>(count) / seconds / 1e6;
+}
+
+void benchSend(const BenchOptions& options) {
+    websocket_client::LocalServer::Options server_options;
+    server_options.mode = websocket_client::LocalServer::Mode::sink;
+    websocket_client::LocalServer server(server_options);
+    server.start();
+
+    std::printf("\n%-8s %10s %10s (kernel %s)\n", "path", "KiB", "MB/s",
+        websocket_client::maskKernelName(websocket_client::detectMaskKernel()));
+    for (std::size_t size_kb : options.send_sizes_kb) {
+        // Fewer of the big ones, so each run moves a similar amount
+        const std::size_t count = std::max<std::size_t>(options.count * 64 / std::max<std::size_t>(size_kb, 64), 2);
+        for (bool encoder : {false, true}) {
+            const double mbps = sendOnce(encoder, size_kb * 1024, count, server);
+            std::printf("%-8s %10zu %10.1f\n", encoder ? "encoder" : "beast", size_kb, mbps);
+            std::fflush(stdout);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    std::string run{"both"};
+
+    CLI::App app{"Frame masking benchmark"};
+    app.add_option("--run", run, "Which part to run")
+        ->check(CLI::IsMember({"kernels", "send", "both"}));
+    app.add_option("--mask-sizes", options.mask_sizes, "Comma-separated buffer sizes in bytes")
+        ->delimiter(',');
+    app.add_option("--mask-bytes", options.mask_bytes, "Bytes masked per kernel and size");
+    app.add_option("--send-sizes", options.send_sizes_kb, "Comma-separated message sizes in KiB")
+        ->delimiter(',');
+    app.add_option("--count", options.count, "Messages per 64 KiB send run, scaled down for bigger sizes");
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError& e) {
+        return app.exit(e);
+    }
+
+    try {
+        if (run != "send") {
+            benchKernels(options);
+        }
+        if (run != "kernels") {
+            benchSend(options);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,294 @@
+// Cost per message of the Asio reactor this binary was built with, for
+// comparing epoll against io_uring (GN arg `use_io_uring`).
+//
+// WebSocketClientPlain talks to an in-process LocalServer echo on loopback.
+// Both ends run on the same backend, and the counters cover the whole
+// process. For every payload size two phases run on one connection:
+//   - pipelined: --window echoes outstanding, for throughput and cost
+//   - ping-pong: one message outstanding, for cost and RTT percentiles
+//
+// Reported per echoed message:
+//   sys  - system calls (raw_syscalls:sys_enter; needs tracefs and
+//          perf_event_paranoid -1 or CAP_PERFMON, otherwise "n/a")
+//   cpu  - user + system CPU microseconds across all threads
+//   csw  - context switches, voluntary and involuntary
+//
+// Build both variants and run them one after another:
+//   websocket_io_backend_bench && websocket_io_backend_bench_io_uring
+
+#include "io_backend.hpp"
+#include "latency_histogram.hpp"
+#include "local_server.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <CLI/CLI.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    std::vector<std::size_t> sizes{32, 1024, 16384};
+    std::size_t window = 64;
+    std::uint64_t messages = 50000;
+    std::uint64_t rtt_samples = 5000;
+};
+
+// Counts system calls made by this process and every thread it starts
+// afterwards. Must be created before any other thread.
+class SyscallCounter {
+public:
+    SyscallCounter() {
+        const long id = tracepointId();
+        if (id < 0) {
+            return;
+        }
+
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.config = static_cast<std::uint64_t>(id);
+        attr.inherit = 1;
+        fd_ = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~SyscallCounter() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    bool available() const { return fd_ >= 0; }
+
+    std::uint64_t read() const {
+        std::uint64_t value = 0;
+        if (fd_ >= 0 && ::read(fd_, &value, sizeof(value)) != sizeof(value)) {
+            value = 0;
+        }
+        return value;
+    }
+
+private:
+    static long tracepointId() {
+        for (const char* path : {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                                 "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"}) {
+            std::ifstream in(path);
+            long id = -1;
+            if (in >> id) {
+                return id;
+            }
+        }
+        return -1;
+    }
+
+    int fd_ = -1;
+};
+
+struct Usage {
+    std::uint64_t syscalls = 0;
+    double cpu_us = 0;
+    std::uint64_t switches = 0;
+
+    static Usage now(const SyscallCounter& counter) {
+        rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+
+        Usage usage;
+        usage.syscalls = counter.read();
+        usage.cpu_us = static_cast<double>(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e6
+            + static_cast<double>(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+        usage.switches = static_cast<std::uint64_t>(ru.ru_nvcsw + ru.ru_nivcsw);
+        return usage;
+    }
+};
+
+struct PhaseResult {
+    double seconds = 0;
+    std::uint64_t messages = 0;
+    Usage before;
+    Usage after;
+    websocket_client::LatencyHistogram rtt;
+};
+
+// Same driver as websocket_client_bench: each echo records an RTT and, while
+// messages remain, sends the next one from the io thread
+class EchoDriver {
+public:
+    EchoDriver(std::shared_ptr<websocket_client::WebSocketClientPlain> client,
+               std::size_t payload_size)
+        : client_(std::move(client))
+        , payload_(payload_size, 'x')
+    {
+    }
+
+    void connect(unsigned short port) {
+        std::promise<void> connected;
+        auto connected_future = connected.get_future();
+        client_->connect(
+            "127.0.0.1",
+            std::to_string(port),
+            "/",
+            [this](std::string_view, websocket_client::Opcode) { onEcho(); },
+            [](const std::string& error) {
+                std::cerr << "bench client error: " << error << std::endl;
+            },
+            [&connected]() { connected.set_value(); });
+        connected_future.wait();
+    }
+
+    PhaseResult run(boost::asio::io_context& ioc, const SyscallCounter& counter,
+                    std::uint64_t messages, std::size_t window) {
+        result_ = PhaseResult{};
+        remaining_ = messages;
+        outstanding_ = 0;
+        done_ = std::promise<void>();
+        auto done = done_.get_future();
+
+        result_.before = Usage::now(counter);
+        const auto start = Clock::now();
+        boost::asio::post(ioc, [this, window]() {
+            for (std::size_t i = 0; i < window && remaining_ > 0; ++i) {
+                sendNext();
+            }
+        });
+        done.wait();
+
+        result_.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        result_.after = Usage::now(counter);
+        return std::move(result_);
+    }
+
+    void close() { client_->close(); }
+
+private:
+    void sendNext() {
+        --remaining_;
+        ++outstanding_;
+        sent_at_.push_back(Clock::now());
+        client_->send(payload_);
+    }
+
+    void onEcho() {
+        const auto now = Clock::now();
+        result_.rtt.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - sent_at_.front()).count()));
+        sent_at_.pop_front();
+        ++result_.messages;
+        --outstanding_;
+
+        if (remaining_ > 0) {
+            sendNext();
+        } else if (outstanding_ == 0) {
+            done_.set_value();
+        }
+    }
+
+    std::shared_ptr<websocket_client::WebSocketClientPlain> client_;
+    std::string payload_;
+    std::deque<Clock::time_point> sent_at_;
+    std::uint64_t remaining_ = 0;
+    std::size_t outstanding_ = 0;
+    PhaseResult result_;
+    std::promise<void> done_;
+};
+
+void printPhase(const char* phase, std::size_t size, const PhaseResult& result,
+                bool have_syscalls) {
+    const double messages = static_cast<double>(std::max<std::uint64_t>(result.messages, 1));
+    char syscalls[32] = "n/a";
+    if (have_syscalls) {
+        std::snprintf(syscalls, sizeof(syscalls), "%.2f",
+            static_cast<double>(result.after.syscalls - result.before.syscalls) / messages);
+    }
+
+    std::printf("%-9s %8zu %10.0f %8s %9.2f %8.3f %9.1f %9.1f %9.1f\n",
+        phase, size,
+        static_cast<double>(result.messages) / result.seconds,
+        syscalls,
+        (result.after.cpu_us - result.before.cpu_us) / messages,
+        static_cast<double>(result.after.switches - result.before.switches) / messages,
+        static_cast<double>(result.rtt.percentile(50.0)) / 1e3,
+        static_cast<double>(result.rtt.percentile(99.0)) / 1e3,
+        static_cast<double>(result.rtt.percentile(99.9)) / 1e3);
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+
+    CLI::App app{"Reactor backend benchmark"};
+    app.add_option("--sizes", options.sizes, "Comma-separated payload sizes in bytes")
+        ->delimiter(',');
+    app.add_option("--window", options.window, "Outstanding echoes in the pipelined phase");
+    app.add_option("--messages", options.messages, "Messages in the pipelined phase");
+    app.add_option("--rtt-samples", options.rtt_samples, "Messages in the ping-pong phase");
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError& e) {
+        return app.exit(e);
+    }
+
+    try {
+        websocket_client::execEpollFallbackIfNeeded(argv, "websocket_io_backend_bench");
+
+        // Before any thread exists, so every thread is counted
+        const SyscallCounter counter;
+
+        websocket_client::LocalServer server({});
+        server.start();
+
+        std::printf("backend: %s (kernel io_uring support: %s)\n",
+            websocket_client::ioBackendName(websocket_client::compiledIoBackend()),
+            websocket_client::kernelSupportsIoUring() ? "yes" : "no");
+        std::printf("%-9s %8s %10s %8s %9s %8s %9s %9s %9s\n",
+            "phase", "bytes", "msgs/s", "sys/msg", "cpu(us)", "csw/msg",
+            "p50(us)", "p99(us)", "p99.9(us)");
+
+        for (std::size_t size : options.sizes) {
+            boost::asio::io_context ioc;
+            std::thread io_thread([&ioc]() {
+                auto guard = boost::asio::make_work_guard(ioc);
+                ioc.run();
+            });
+
+            EchoDriver driver(std::make_shared<websocket_client::WebSocketClientPlain>(ioc), size);
+            driver.connect(server.port());
+
+            printPhase("pipelined", size,
+                driver.run(ioc, counter, options.messages, options.window), counter.available());
+            printPhase("ping-pong", size,
+                driver.run(ioc, counter, options.rtt_samples, 1), counter.available());
+
+            driver.close();
+            ioc.stop();
+            io_thread.join();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
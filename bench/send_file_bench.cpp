@@ -0,0 +1,183 @@
+// Peak memory and throughput of sending one large file as a single
+// WebSocket message, two ways:
+//   - vector: read the file into a std::vector and sendBinary() it, which
+//     is what callers had to do before sendFile() existed
+//   - mmap:   sendFile(), which maps the file and streams it in fragments
+//
+// Each run uses a fresh WebSocketClientPlain against an in-process sink
+// server, which discards data as it arrives. Peak RSS is the process high
+// water mark (VmHWM, reset through /proc/self/clear_refs before each run)
+// minus the RSS at the start of the run.
+
+#include "local_server.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <CLI/CLI.hpp>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    std::vector<std::size_t> sizes_mb{1, 16, 128, 1024};
+    std::string paths{"both"};
+    std::string dir{"/tmp"};
+    std::size_t fragment_kb = 64;
+};
+
+struct RunResult {
+    double seconds = 0;
+    std::uint64_t peak_rss_kb = 0;
+};
+
+// Reads one "Name:   123 kB" line from /proc/self/status
+std::uint64_t procStatusKb(const char* name) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    const std::string prefix = std::string(name) + ":";
+    while (std::getline(status, line)) {
+        if (line.compare(0, prefix.size(), prefix) == 0) {
+            return std::stoull(line.substr(prefix.size()));
+        }
+    }
+    return 0;
+}
+
+void resetPeakRss() {
+    // "5" resets VmHWM to the current RSS (Linux 4.0+)
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+// Filled with non-zero bytes so every page is backed by real data
+std::string makeFile(const std::string& dir, std::size_t bytes) {
+    std::string path = dir + "/websocket_send_file_bench_XXXXXX";
+    const int fd = mkstemp(path.data());
+    if (fd < 0) {
+        throw std::runtime_error("cannot create a file in " + dir);
+    }
+    close(fd);
+
+    std::ofstream out(path, std::ios::binary);
+    const std::string block(1024 * 1024, 'x');
+    for (std::size_t written = 0; written < bytes; written += block.size()) {
+        out.write(block.data(), static_cast<std::streamsize>(std::min(block.size(), bytes - written)));
+    }
+    return path;
+}
+
+RunResult runOnce(const std::string& path_kind, const std::string& file,
+                  websocket_client::LocalServer& server, const BenchOptions& options) {
+    boost::asio::io_context ioc;
+    auto client = std::make_shared<websocket_client::WebSocketClientPlain>(ioc);
+    client->setWriteFragmentSize(options.fragment_kb * 1024);
+
+    std::promise<void> connected;
+    auto connected_future = connected.get_future();
+    client->connect(
+        "127.0.0.1",
+        std::to_string(server.port()),
+        "/",
+        [](std::string_view, websocket_client::Opcode) {},
+        [](const std::string& error) {
+            std::cerr << "bench client error: " << error << std::endl;
+        },
+        [&connected]() { connected.set_value(); });
+    std::thread io_thread([&ioc]() {
+        auto guard = boost::asio::make_work_guard(ioc);
+        ioc.run();
+    });
+    connected_future.wait();
+
+    const std::uint64_t received_before = server.stats().messages_received;
+    const std::uint64_t rss_before = procStatusKb("VmRSS");
+    resetPeakRss();
+
+    RunResult result;
+    const auto start = Clock::now();
+    if (path_kind == "vector") {
+        std::ifstream in(file, std::ios::binary);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)),
+                                  std::istreambuf_iterator<char>());
+        client->sendBinary(data);
+    } else {
+        client->sendFile(file);
+    }
+
+    while (server.stats().messages_received == received_before) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    const std::uint64_t peak = procStatusKb("VmHWM");
+    result.peak_rss_kb = peak > rss_before ? peak - rss_before : 0;
+
+    client->close();
+    ioc.stop();
+    io_thread.join();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+
+    CLI::App app{"WebSocket file send benchmark"};
+    app.add_option("--sizes", options.sizes_mb, "Comma-separated payload sizes in MiB")
+        ->delimiter(',');
+    app.add_option("--paths", options.paths, "Send paths to run")
+        ->check(CLI::IsMember({"vector", "mmap", "both"}));
+    app.add_option("--dir", options.dir, "Directory for the temporary payload files");
+    app.add_option("--fragment-kb", options.fragment_kb, "sendFile() fragment size in KiB");
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError& e) {
+        return app.exit(e);
+    }
+
+    try {
+        websocket_client::LocalServer::Options server_options;
+        server_options.mode = websocket_client::LocalServer::Mode::sink;
+        websocket_client::LocalServer server(server_options);
+        server.start();
+
+        std::printf("%-7s %9s %10s %10s %14s\n",
+            "path", "MiB", "seconds", "MB/s", "peak RSS(MiB)");
+
+        for (std::size_t size_mb : options.sizes_mb) {
+            const std::size_t bytes = size_mb * 1024 * 1024;
+            const std::string file = makeFile(options.dir, bytes);
+
+            for (const char* kind : {"vector", "mmap"}) {
+                if (options.paths != "both" && options.paths != kind) {
+                    continue;
+                }
+                const RunResult result = runOnce(kind, file, server, options);
+                std::printf("%-7s %9zu %10.3f %10.1f %14.1f\n",
+                    kind, size_mb, result.seconds,
+                    static_cast<double>(bytes) / result.seconds / 1e6,
+                    static_cast<double>(result.peak_rss_kb) / 1024.0);
+                std::fflush(stdout);
+            }
+
+            unlink(file.c_str());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
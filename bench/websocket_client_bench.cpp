@@ -0,0 +1,298 @@
+// Throughput and round-trip latency of WebSocketClientPlain and
+// WebSocketClient against an in-process LocalServer on loopback.
+//
+// For every payload size and client class the benchmark runs two phases
+// on a fresh connection:
+//   - pipelined: keeps --window echoes outstanding and reports msgs/s and
+//     payload MB/s (one direction)
+//   - ping-pong: one message outstanding and reports p50/p99/p99.9 RTT
+//
+// A final section times full connects (TCP + TLS + WebSocket handshake)
+// to the wss server with and without TLS session resumption.
+
+#include "latency_histogram.hpp"
+#include "local_server.hpp"
+#include "tls_session_cache.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <CLI/CLI.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    std::vector<std::size_t> sizes{32, 256, 2048, 16384, 131072, 1048576};
+    std::string clients{"both"};
+    std::size_t window = 64;
+    std::uint64_t messages = 20000;
+    std::uint64_t byte_budget = 256ull * 1024 * 1024;
+    std::uint64_t rtt_samples = 2000;
+    std::uint64_t connect_samples = 200;
+};
+
+struct PhaseResult {
+    double seconds = 0;
+    std::uint64_t messages = 0;
+    websocket_client::LatencyHistogram rtt;
+};
+
+// Drives one connection from its io thread: every echo that comes back
+// records an RTT and, while messages remain, sends the next one.
+template <class Client>
+class EchoDriver {
+public:
+    EchoDriver(std::shared_ptr<Client> client, std::size_t payload_size)
+        : client_(std::move(client))
+        , payload_(payload_size, 'x')
+    {
+    }
+
+    void connect(unsigned short port) {
+        std::promise<void> connected;
+        auto connected_future = connected.get_future();
+        client_->connect(
+            "127.0.0.1",
+            std::to_string(port),
+            "/",
+            [this](std::string_view, websocket_client::Opcode) {
+                onEcho();
+            },
+            [](const std::string& error) {
+                std::cerr << "bench client error: " << error << std::endl;
+            },
+            [&connected]() {
+                connected.set_value();
+            });
+        connected_future.wait();
+    }
+
+    // Runs on the caller's thread; all driver state lives on the io thread
+    PhaseResult run(boost::asio::io_context& ioc, std::uint64_t messages, std::size_t window) {
+        result_ = PhaseResult{};
+        remaining_ = messages;
+        outstanding_ = 0;
+        done_ = std::promise<void>();
+        auto done = done_.get_future();
+
+        const auto start = Clock::now();
+        boost::asio::post(ioc, [this, window]() {
+            for (std::size_t i = 0; i < window && remaining_ > 0; ++i) {
+                sendNext();
+            }
+        });
+        done.wait();
+
+        result_.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return std::move(result_);
+    }
+
+    void close() { client_->close(); }
+
+private:
+    void sendNext() {
+        --remaining_;
+        ++outstanding_;
+        sent_at_.push_back(Clock::now());
+        client_->send(payload_);
+    }
+
+    void onEcho() {
+        const auto now = Clock::now();
+        result_.rtt.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - sent_at_.front()).count()));
+        sent_at_.pop_front();
+        ++result_.messages;
+        --outstanding_;
+
+        if (remaining_ > 0) {
+            sendNext();
+        } else if (outstanding_ == 0) {
+            done_.set_value();
+        }
+    }
+
+    std::shared_ptr<Client> client_;
+    std::string payload_;
+    std::deque<Clock::time_point> sent_at_;
+    std::uint64_t remaining_ = 0;
+    std::size_t outstanding_ = 0;
+    PhaseResult result_;
+    std::promise<void> done_;
+};
+
+template <class Client, class MakeClient>
+void runCase(const char* name, unsigned short port, std::size_t size,
+             const BenchOptions& options, MakeClient make_client) {
+    boost::asio::io_context ioc;
+    EchoDriver<Client> driver(make_client(ioc), size);
+
+    std::thread io_thread([&ioc]() {
+        auto guard = boost::asio::make_work_guard(ioc);
+        ioc.run();
+    });
+
+    driver.connect(port);
+
+    const std::uint64_t messages = std::clamp<std::uint64_t>(
+        options.byte_budget / std::max<std::size_t>(size, 1), 100, options.messages);
+    const PhaseResult pipelined = driver.run(ioc, messages, options.window);
+    const PhaseResult pingpong = driver.run(ioc,
+        std::min<std::uint64_t>(options.rtt_samples, messages), 1);
+
+    driver.close();
+    ioc.stop();
+    io_thread.join();
+
+    const double msgs_per_sec = static_cast<double>(pipelined.messages) / pipelined.seconds;
+    const double mb_per_sec = msgs_per_sec * static_cast<double>(size) / 1e6;
+    std::printf("%-6s %9zu %12.0f %10.1f %10.1f %10.1f %10.1f\n",
+        name, size, msgs_per_sec, mb_per_sec,
+        static_cast<double>(pingpong.rtt.percentile(50.0)) / 1e3,
+        static_cast<double>(pingpong.rtt.percentile(99.0)) / 1e3,
+        static_cast<double>(pingpong.rtt.percentile(99.9)) / 1e3);
+    std::fflush(stdout);
+}
+
+// Time `samples` sequential connects; with a cache every connect after the
+// first offers the previous session.
+void runConnectLatency(const char* name, unsigned short port, std::uint64_t samples,
+                       std::shared_ptr<websocket_client::TlsSessionCache> cache) {
+    boost::asio::ssl::context ssl_ctx{boost::asio::ssl::context::tlsv13_client};
+    ssl_ctx.set_verify_mode(boost::asio::ssl::verify_none);
+    if (cache) {
+        cache->attach(ssl_ctx);
+    }
+
+    boost::asio::io_context ioc;
+    auto work = boost::asio::make_work_guard(ioc);
+    std::thread io_thread([&ioc]() { ioc.run(); });
+
+    websocket_client::LatencyHistogram latency;
+    for (std::uint64_t i = 0; i < samples; ++i) {
+        auto client = std::make_shared<websocket_client::WebSocketClient>(ioc, ssl_ctx);
+        client->setSessionCache(cache);
+
+        // Round-trip one message so TLS 1.3 tickets are in before closing
+        std::promise<void> echoed;
+        auto echoed_future = echoed.get_future();
+        Clock::time_point connected_at;
+        const auto start = Clock::now();
+        client->connect(
+            "127.0.0.1",
+            std::to_string(port),
+            "/",
+            [&echoed](std::string_view, websocket_client::Opcode) { echoed.set_value(); },
+            [](const std::string& error) {
+                std::cerr << "bench client error: " << error << std::endl;
+            },
+            [&client, &connected_at]() {
+                connected_at = Clock::now();
+                client->send("x");
+            });
+        echoed_future.wait();
+
+        latency.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(connected_at - start).count()));
+        client->close();
+    }
+
+    work.reset();
+    io_thread.join();
+
+    std::printf("%-12s %8llu %10.1f %10.1f %10.1f\n", name,
+        static_cast<unsigned long long>(latency.count()),
+        static_cast<double>(latency.percentile(50.0)) / 1e3,
+        static_cast<double>(latency.percentile(99.0)) / 1e3,
+        static_cast<double>(latency.percentile(99.9)) / 1e3);
+    if (cache) {
+        const auto stats = cache->stats();
+        std::printf("%-12s resumed=%llu full=%llu\n", "",
+            static_cast<unsigned long long>(stats.resumed_handshakes),
+            static_cast<unsigned long long>(stats.full_handshakes));
+    }
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+
+    CLI::App app{"WebSocket client benchmark"};
+    app.add_option("--sizes", options.sizes, "Comma-separated payload sizes in bytes")
+        ->delimiter(',');
+    app.add_option("--clients", options.clients, "Client classes to run")
+        ->check(CLI::IsMember({"plain", "tls", "both"}));
+    app.add_option("--window", options.window, "Outstanding echoes in the pipelined phase");
+    app.add_option("--messages", options.messages, "Maximum messages per pipelined run");
+    app.add_option("--byte-budget", options.byte_budget, "Maximum payload bytes per pipelined run");
+    app.add_option("--rtt-samples", options.rtt_samples, "Messages in the ping-pong phase");
+    app.add_option("--connect-samples", options.connect_samples,
+        "TLS connects per resumption run (0 skips it)");
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError& e) {
+        return app.exit(e);
+    }
+
+    try {
+        websocket_client::LocalServer plain_server({});
+        plain_server.start();
+
+        websocket_client::LocalServer::Options secure_options;
+        secure_options.secure = true;
+        websocket_client::LocalServer secure_server(secure_options);
+        secure_server.start();
+
+        boost::asio::ssl::context ssl_ctx{boost::asio::ssl::context::tlsv12_client};
+        ssl_ctx.set_verify_mode(boost::asio::ssl::verify_none);
+
+        std::printf("%-6s %9s %12s %10s %10s %10s %10s\n",
+            "client", "bytes", "msgs/s", "MB/s", "p50(us)", "p99(us)", "p99.9(us)");
+
+        for (std::size_t size : options.sizes) {
+            if (options.clients != "tls") {
+                runCase<websocket_client::WebSocketClientPlain>(
+                    "plain", plain_server.port(), size, options,
+                    [](boost::asio::io_context& ioc) {
+                        return std::make_shared<websocket_client::WebSocketClientPlain>(ioc);
+                    });
+            }
+            if (options.clients != "plain") {
+                runCase<websocket_client::WebSocketClient>(
+                    "tls", secure_server.port(), size, options,
+                    [&ssl_ctx](boost::asio::io_context& ioc) {
+                        return std::make_shared<websocket_client::WebSocketClient>(ioc, ssl_ctx);
+                    });
+            }
+        }
+
+        if (options.connect_samples > 0 && options.clients != "plain") {
+            std::printf("\n%-12s %8s %10s %10s %10s\n",
+                "tls connect", "samples", "p50(us)", "p99(us)", "p99.9(us)");
+            runConnectLatency("full", secure_server.port(), options.connect_samples, nullptr);
+            runConnectLatency("resumed", secure_server.port(), options.connect_samples,
+                std::make_shared<websocket_client::TlsSessionCache>());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,286 @@
+// Write batching against the per-message write path, for small payloads.
+//
+// WebSocketClientPlain talks to an in-process LocalServer echo on loopback.
+// For every payload size each mode runs on a fresh connection, keeping up
+// to --window echoes outstanding and topping the window up in bursts of
+// half its size, the way a producer that wakes up now and then would:
+//   - off:    one socket write per frame (the default)
+//   - batch:  frames gathered up to --batch-bytes, written when the queue
+//             runs dry
+//   - linger: as batch, but a batch waits up to --linger-us for more frames
+//
+// Reported per echoed message:
+//   msgs/s - echoes per second
+//   writes - socket writes made by the client (ConnectionStats)
+//   sys    - system calls by the whole process, server included
+//            (raw_syscalls:sys_enter; needs tracefs and perf_event_paranoid
+//            -1 or CAP_PERFMON, otherwise "n/a")
+// plus p50/p99 round trips.
+
+#include "latency_histogram.hpp"
+#include "local_server.hpp"
+#include "websocket_client_plain.hpp"
+#include "write_batch_options.hpp"
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <CLI/CLI.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    std::vector<std::size_t> sizes{32, 64, 128, 256, 512};
+    std::size_t window = 256;
+    std::uint64_t messages = 200000;
+    std::size_t batch_bytes = 64 * 1024;
+    unsigned linger_us = 50;
+};
+
+// Counts system calls made by this process and every thread it starts
+// afterwards, as in websocket_io_backend_bench. Must be created before any
+// other thread.
+class SyscallCounter {
+public:
+    SyscallCounter() {
+        const long id = tracepointId();
+        if (id < 0) {
+            return;
+        }
+
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.config = static_cast<std::uint64_t>(id);
+        attr.inherit = 1;
+        fd_ = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~SyscallCounter() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    bool available() const { return fd_ >= 0; }
+
+    std::uint64_t read() const {
+        std::uint64_t value = 0;
+        if (fd_ >= 0 && ::read(fd_, &value, sizeof(value)) != sizeof(value)) {
+            value = 0;
+        }
+        return value;
+    }
+
+private:
+    static long tracepointId() {
+        for (const char* path : {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                                 "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"}) {
+            std::ifstream in(path);
+            long id = -1;
+            if (in >> id) {
+                return id;
+            }
+        }
+        return -1;
+    }
+
+    int fd_ = -1;
+};
+
+struct PhaseResult {
+    double seconds = 0;
+    std::uint64_t messages = 0;
+    std::uint64_t syscalls = 0;
+    std::uint64_t writes = 0;
+    websocket_client::LatencyHistogram rtt;
+};
+
+// Each echo records an RTT. Once half the window has come back, the next
+// half goes out from a single handler, so the client sees bursts.
+class BurstDriver {
+public:
+    BurstDriver(std::shared_ptr<websocket_client::WebSocketClientPlain> client,
+                std::size_t payload_size)
+        : client_(std::move(client))
+        , payload_(payload_size, 'x')
+    {
+    }
+
+    void connect(unsigned short port) {
+        std::promise<void> connected;
+        auto connected_future = connected.get_future();
+        client_->connect(
+            "127.0.0.1",
+            std::to_string(port),
+            "/",
+            [this](std::string_view, websocket_client::Opcode) { onEcho(); },
+            [](const std::string& error) {
+                std::cerr << "bench client error: " << error << std::endl;
+            },
+            [&connected]() { connected.set_value(); });
+        connected_future.wait();
+    }
+
+    PhaseResult run(const SyscallCounter& counter, std::uint64_t messages, std::size_t window) {
+        result_ = PhaseResult{};
+        remaining_ = messages;
+        outstanding_ = 0;
+        window_ = std::max<std::size_t>(window, 2);
+        done_ = std::promise<void>();
+        auto done = done_.get_future();
+
+        const std::uint64_t syscalls = counter.read();
+        const std::uint64_t writes = client_->stats().transport_writes;
+        const auto start = Clock::now();
+        boost::asio::post(client_->get_executor(), [this]() { topUp(); });
+        done.wait();
+
+        result_.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        result_.syscalls = counter.read() - syscalls;
+        result_.writes = client_->stats().transport_writes - writes;
+        return std::move(result_);
+    }
+
+    void close() { client_->close(); }
+
+private:
+    void topUp() {
+        while (outstanding_ < window_ && remaining_ > 0) {
+            --remaining_;
+            ++outstanding_;
+            sent_at_.push_back(Clock::now());
+            client_->send(payload_);
+        }
+    }
+
+    void onEcho() {
+        const auto now = Clock::now();
+        result_.rtt.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - sent_at_.front()).count()));
+        sent_at_.pop_front();
+        ++result_.messages;
+        --outstanding_;
+
+        if (outstanding_ <= window_ / 2) {
+            topUp();
+        }
+        if (remaining_ == 0 && outstanding_ == 0) {
+            done_.set_value();
+        }
+    }
+
+    std::shared_ptr<websocket_client::WebSocketClientPlain> client_;
+    std::string payload_;
+    std::deque<Clock::time_point> sent_at_;
+    std::uint64_t remaining_ = 0;
+    std::size_t outstanding_ = 0;
+    std::size_t window_ = 0;
+    PhaseResult result_;
+    std::promise<void> done_;
+};
+
+void printResult(const char* mode, std::size_t size, const PhaseResult& result,
+                 bool have_syscalls) {
+    const double messages = static_cast<double>(std::max<std::uint64_t>(result.messages, 1));
+    char syscalls[32] = "n/a";
+    if (have_syscalls) {
+        std::snprintf(syscalls, sizeof(syscalls), "%.2f",
+            static_cast<double>(result.syscalls) / messages);
+    }
+
+    std::printf("%-7s %6zu %10.0f %9.3f %8s %9.1f %9.1f\n",
+        mode, size,
+        static_cast<double>(result.messages) / result.seconds,
+        static_cast<double>(result.writes) / messages,
+        syscalls,
+        static_cast<double>(result.rtt.percentile(50.0)) / 1e3,
+        static_cast<double>(result.rtt.percentile(99.0)) / 1e3);
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+
+    CLI::App app{"Write batching benchmark"};
+    app.add_option("--sizes", options.sizes, "Comma-separated payload sizes in bytes")
+        ->delimiter(',');
+    app.add_option("--window", options.window, "Most echoes outstanding at once");
+    app.add_option("--messages", options.messages, "Messages per size and mode");
+    app.add_option("--batch-bytes", options.batch_bytes, "Largest batch in the batched modes");
+    app.add_option("--linger-us", options.linger_us, "Batch linger in the linger mode");
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError& e) {
+        return app.exit(e);
+    }
+
+    try {
+        // Before any thread exists, so every thread is counted
+        const SyscallCounter counter;
+
+        websocket_client::LocalServer server({});
+        server.start();
+
+        websocket_client::WriteBatchOptions batch;
+        batch.max_bytes = options.batch_bytes;
+        websocket_client::WriteBatchOptions linger = batch;
+        linger.linger = std::chrono::microseconds(options.linger_us);
+
+        const std::pair<const char*, websocket_client::WriteBatchOptions> modes[] = {
+            {"off", {}},
+            {"batch", batch},
+            {"linger", linger},
+        };
+
+        std::printf("%-7s %6s %10s %9s %8s %9s %9s\n",
+            "mode", "bytes", "msgs/s", "writes", "sys/msg", "p50(us)", "p99(us)");
+
+        for (std::size_t size : options.sizes) {
+            for (const auto& [name, mode] : modes) {
+                boost::asio::io_context ioc;
+                std::thread io_thread([&ioc]() {
+                    auto guard = boost::asio::make_work_guard(ioc);
+                    ioc.run();
+                });
+
+                auto client = std::make_shared<websocket_client::WebSocketClientPlain>(ioc);
+                client->setWriteBatching(mode);
+
+                BurstDriver driver(client, size);
+                driver.connect(server.port());
+                printResult(name, size, driver.run(counter, options.messages, options.window),
+                    counter.available());
+
+                driver.close();
+                ioc.stop();
+                io_thread.join();
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
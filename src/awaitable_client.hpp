@@ -0,0 +1,192 @@
+#pragma once
+
+#include <boost/asio/detail/config.hpp>
+
+// The coroutine API needs a C++20 compiler; in C++17 builds this header
+// declares nothing
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+
+#include "compression_options.hpp"
+#include "connection_stats.hpp"
+#include "message_types.hpp"
+#include "metered_stream.hpp"
+#include "tls_session_cache.hpp"
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl/error.hpp>
+#include <boost/asio/ssl/stream.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/websocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+#include <openssl/err.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace websocket_client {
+
+// A message returned by read(). The view points into the client's read
+// buffer and is valid until the next read().
+struct AwaitableMessage {
+    std::string_view data;
+    Opcode opcode = Opcode::text;
+};
+
+// Coroutine counterpart of WebSocketClientPlain / WebSocketClient, for
+// request/response code that reads better as straight-line code:
+//
+//     AwaitableClientPlain client(co_await this_coro::executor);
+//     co_await client.connect("127.0.0.1", "9001", "/");
+//     co_await client.write("ping");
+//     auto reply = co_await client.read();
+//
+// Every call is one co_await on the Beast operation itself. Nothing is
+// queued or copied, and no shared_ptr is taken per hop. Failures throw
+// boost::system::system_error.
+//
+// The caller drives everything, so there is no reconnect, outbound queue
+// or read loop. At most one read() and one write() may be outstanding at a
+// time, and both must run on the client's executor. On a multi-threaded
+// io_context, construct the client with a strand.
+template <class NextLayer>
+class BasicAwaitableClient {
+public:
+    using executor_type = boost::asio::any_io_executor;
+
+    // `args` follow the executor into NextLayer's constructor; for TLS that
+    // is the ssl::context
+    template <class... Args>
+    explicit BasicAwaitableClient(executor_type executor, Args&&... args)
+        : ws_(counters_.wire_bytes_received, counters_.wire_bytes_sent,
+              executor, std::forward<Args>(args)...)
+    {
+    }
+
+    BasicAwaitableClient(const BasicAwaitableClient&) = delete;
+    BasicAwaitableClient& operator=(const BasicAwaitableClient&) = delete;
+
+    executor_type get_executor() { return ws_.get_executor(); }
+
+    // Apply before connect()
+    void setCompression(const CompressionOptions& options) { compression_ = options; }
+    void setReadMessageMax(std::uint64_t bytes) { read_message_max_ = bytes; }
+    void setSessionCache(std::shared_ptr<TlsSessionCache> cache) { session_cache_ = std::move(cache); }
+
+    // Resolve, connect, TLS handshake if secure, then WebSocket handshake
+    boost::asio::awaitable<void> connect(std::string host, std::string port, std::string target) {
+        const auto started = std::chrono::steady_clock::now();
+        auto& tcp = boost::beast::get_lowest_layer(ws_);
+
+        boost::asio::ip::tcp::resolver resolver(get_executor());
+        const auto results = co_await resolver.async_resolve(host, port, boost::asio::use_awaitable);
+
+        tcp.expires_after(std::chrono::seconds(30));
+        const auto endpoint = co_await tcp.async_connect(results, boost::asio::use_awaitable);
+
+        // Small messages go out now rather than waiting on delayed ACKs
+        boost::beast::error_code ignored;
+        tcp.socket().set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+
+        if constexpr (kSecure) {
+            auto& tls = ws_.next_layer().next_layer();
+            if (!SSL_set_tlsext_host_name(tls.native_handle(), host.c_str())) {
+                throw boost::system::system_error(
+                    boost::system::error_code(static_cast<int>(::ERR_get_error()),
+                        boost::asio::error::get_ssl_category()),
+                    "sni");
+            }
+            if (session_cache_) {
+                session_key_ = host + ":" + port;
+                session_cache_->prepare(tls.native_handle(), session_key_);
+            }
+
+            co_await tls.async_handshake(boost::asio::ssl::stream_base::client,
+                boost::asio::use_awaitable);
+
+            const bool resumed = session_cache_
+                && session_cache_->recordHandshake(tls.native_handle());
+            (resumed ? counters_.tls_resumed_handshakes : counters_.tls_full_handshakes)
+                .fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // The websocket stream has its own timeouts from here on
+        tcp.expires_never();
+        ws_.set_option(boost::beast::websocket::stream_base::timeout::suggested(
+            boost::beast::role_type::client));
+        ws_.set_option(boost::beast::websocket::stream_base::decorator(
+            [](boost::beast::websocket::request_type& req) {
+                req.set(boost::beast::http::field::user_agent,
+                    std::string(BOOST_BEAST_VERSION_STRING) + " websocket-client-cpp");
+            }));
+        ws_.set_option(toPermessageDeflate(compression_));
+        ws_.read_message_max(read_message_max_);
+
+        std::string host_header = host;
+        if (endpoint.port() != 80 && endpoint.port() != 443) {
+            host_header += ':' + std::to_string(endpoint.port());
+        }
+
+        boost::beast::websocket::response_type response;
+        co_await ws_.async_handshake(response, host_header, target, boost::asio::use_awaitable);
+
+        counters_.onConnected(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started).count()));
+        counters_.compression_negotiated.store(
+            response[boost::beast::http::field::sec_websocket_extensions]
+                .find("permessage-deflate") != boost::beast::string_view::npos,
+            std::memory_order_relaxed);
+    }
+
+    // The next whole message
+    boost::asio::awaitable<AwaitableMessage> read() {
+        buffer_.clear();
+        const std::size_t bytes = co_await ws_.async_read(buffer_, boost::asio::use_awaitable);
+        counters_.onReceived(bytes);
+
+        const auto data = buffer_.cdata();
+        co_return AwaitableMessage{
+            std::string_view(static_cast<const char*>(data.data()), data.size()),
+            ws_.got_binary() ? Opcode::binary : Opcode::text};
+    }
+
+    // Sends one message; `payload` only has to live until this completes
+    boost::asio::awaitable<void> write(std::string_view payload, Opcode opcode = Opcode::text) {
+        ws_.binary(opcode == Opcode::binary);
+        co_await ws_.async_write(boost::asio::buffer(payload.data(), payload.size()),
+            boost::asio::use_awaitable);
+        counters_.onSent(payload.size());
+    }
+
+    boost::asio::awaitable<void> close() {
+        co_await ws_.async_close(boost::beast::websocket::close_code::normal,
+            boost::asio::use_awaitable);
+    }
+
+    ConnectionStats stats() const { return counters_.snapshot(); }
+
+private:
+    static constexpr bool kSecure = !std::is_same_v<NextLayer, boost::beast::tcp_stream>;
+
+    ConnectionCounters counters_;
+    boost::beast::websocket::stream<MeteredStream<NextLayer>> ws_;
+    boost::beast::flat_buffer buffer_;
+    CompressionOptions compression_;
+    std::uint64_t read_message_max_{16 * 1024 * 1024};
+    std::shared_ptr<TlsSessionCache> session_cache_;
+    std::string session_key_;  // outlives the SSL object, as prepare() needs
+};
+
+using AwaitableClientPlain = BasicAwaitableClient<boost::beast::tcp_stream>;
+using AwaitableClient = BasicAwaitableClient<boost::beast::ssl_stream<boost::beast::tcp_stream>>;
+
+} // namespace websocket_client
+
+#endif // BOOST_ASIO_HAS_CO_AWAIT
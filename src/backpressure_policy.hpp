@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace websocket_client {
+
+// Opt-in limits on a client's outbound queue.
+//
+// send() never refuses a message, so a server that reads slowly lets the
+// queue, and our memory, grow without bound. Every message is counted from
+// send() until its write completes. Once the queued bytes or messages reach
+// their high watermark the client is backpressured: the handler is told so
+// and trySend() refuses new messages. Both have to drain to their low
+// watermarks before the handler is told it is over and trySend() accepts
+// again, so a producer that pauses and resumes on the handler does not
+// flap around a single threshold.
+//
+// A zero high watermark leaves that count unlimited.
+struct BackpressurePolicy {
+    std::size_t high_water_bytes = 0;
+    std::size_t low_water_bytes = 0;
+    std::size_t high_water_messages = 0;
+    std::size_t low_water_messages = 0;
+
+    bool enabled() const { return high_water_bytes > 0 || high_water_messages > 0; }
+
+    bool reachedHigh(std::uint64_t bytes, std::uint64_t messages) const {
+        return (high_water_bytes > 0 && bytes >= high_water_bytes)
+            || (high_water_messages > 0 && messages >= high_water_messages);
+    }
+
+    bool drainedToLow(std::uint64_t bytes, std::uint64_t messages) const {
+        return (high_water_bytes == 0 || bytes <= low_water_bytes)
+            && (high_water_messages == 0 || messages <= low_water_messages);
+    }
+};
+
+// Called on the client's strand with true when the outbound queue reaches a
+// high watermark, and with false once it has drained to the low ones
+using BackpressureHandler = std::function<void(bool backpressured)>;
+
+} // namespace websocket_client
@@ -0,0 +1,244 @@
+#include "buffer_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace websocket_client {
+
+namespace {
+
+void unref(detail::PoolBlock* block) noexcept {
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Keep the pool alive until release() has returned
+        std::shared_ptr<BufferPool> pool = std::move(block->pool);
+        pool->release(block);
+    }
+}
+
+} // namespace
+
+std::shared_ptr<BufferPool> BufferPool::create() {
+    return create(Options());
+}
+
+std::shared_ptr<BufferPool> BufferPool::create(Options options) {
+    return std::shared_ptr<BufferPool>(new BufferPool(options));
+}
+
+const std::shared_ptr<BufferPool>& BufferPool::global() {
+    static const std::shared_ptr<BufferPool> pool = create();
+    return pool;
+}
+
+BufferPool::BufferPool(Options options)
+    : options_(options)
+    , class_count_(0)
+{
+    while (class_count_ < kMaxClasses
+           && (options_.min_block << class_count_) <= options_.max_block) {
+        ++class_count_;
+    }
+}
+
+BufferPool::~BufferPool() {
+    for (auto& size_class : classes_) {
+        for (detail::PoolBlock* block : size_class.free) {
+            deallocate(block);
+        }
+    }
+}
+
+std::size_t BufferPool::classFor(std::size_t capacity) const {
+    for (std::size_t i = 0; i < class_count_; ++i) {
+        if ((options_.min_block << i) >= capacity) {
+            return i;
+        }
+    }
+    return kUnpooled;
+}
+
+detail::PoolBlock* BufferPool::acquire(std::size_t min_capacity) {
+    const std::size_t size_class = classFor(min_capacity);
+
+    detail::PoolBlock* block = nullptr;
+    if (size_class != kUnpooled) {
+        SizeClass& sc = classes_[size_class];
+        std::lock_guard<std::mutex> lock(sc.mutex);
+        if (!sc.free.empty()) {
+            block = sc.free.back();
+            sc.free.pop_back();
+        }
+    }
+
+    if (block) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        bytes_cached_.fetch_sub(block->capacity, std::memory_order_relaxed);
+    } else {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        block = allocate(size_class,
+            size_class == kUnpooled ? min_capacity : options_.min_block << size_class);
+    }
+
+    block->refs.store(1, std::memory_order_relaxed);
+    block->pool = shared_from_this();
+    blocks_in_use_.fetch_add(1, std::memory_order_relaxed);
+    bytes_in_use_.fetch_add(block->capacity, std::memory_order_relaxed);
+    return block;
+}
+
+void BufferPool::release(detail::PoolBlock* block) {
+    blocks_in_use_.fetch_sub(1, std::memory_order_relaxed);
+    bytes_in_use_.fetch_sub(block->capacity, std::memory_order_relaxed);
+
+    if (block->size_class != kUnpooled) {
+        const std::uint64_t cached =
+            bytes_cached_.fetch_add(block->capacity, std::memory_order_relaxed);
+        if (cached + block->capacity <= options_.max_cached_bytes) {
+            SizeClass& sc = classes_[block->size_class];
+            std::lock_guard<std::mutex> lock(sc.mutex);
+            sc.free.push_back(block);
+            return;
+        }
+        bytes_cached_.fetch_sub(block->capacity, std::memory_order_relaxed);
+    }
+
+    deallocate(block);
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.blocks_in_use = blocks_in_use_.load(std::memory_order_relaxed);
+    stats.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+    stats.bytes_cached = bytes_cached_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+detail::PoolBlock* BufferPool::allocate(std::size_t size_class, std::size_t capacity) {
+    void* memory = ::operator new(sizeof(detail::PoolBlock) + capacity);
+    auto* block = new (memory) detail::PoolBlock;
+    block->size_class = size_class;
+    block->capacity = capacity;
+    return block;
+}
+
+void BufferPool::deallocate(detail::PoolBlock* block) {
+    block->~PoolBlock();
+    ::operator delete(block);
+}
+
+PooledMessage::PooledMessage(const PooledMessage& other) noexcept
+    : block_(other.block_)
+    , offset_(other.offset_)
+    , size_(other.size_)
+{
+    if (block_) {
+        block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PooledMessage::PooledMessage(PooledMessage&& other) noexcept
+    : block_(std::exchange(other.block_, nullptr))
+    , offset_(std::exchange(other.offset_, 0))
+    , size_(std::exchange(other.size_, 0))
+{
+}
+
+PooledMessage& PooledMessage::operator=(PooledMessage other) noexcept {
+    std::swap(block_, other.block_);
+    std::swap(offset_, other.offset_);
+    std::swap(size_, other.size_);
+    return *this;
+}
+
+PooledMessage::~PooledMessage() {
+    if (block_) {
+        unref(block_);
+    }
+}
+
+PooledBuffer::PooledBuffer(std::shared_ptr<BufferPool> pool, std::size_t keep_capacity)
+    : pool_(std::move(pool))
+    , keep_capacity_(keep_capacity)
+{
+}
+
+PooledBuffer::~PooledBuffer() {
+    releaseBlock();
+}
+
+void PooledBuffer::setPool(std::shared_ptr<BufferPool> pool) {
+    releaseBlock();
+    size_ = 0;
+    offset_ = 0;
+    pool_ = std::move(pool);
+}
+
+PooledBuffer::const_buffers_type PooledBuffer::data() const noexcept {
+    return const_buffers_type(block_ ? block_->data() + offset_ : nullptr, size_);
+}
+
+PooledBuffer::mutable_buffers_type PooledBuffer::prepare(std::size_t n) {
+    const std::size_t needed = size_ + n;
+
+    if (!block_ || needed > block_->capacity) {
+        // Move to a block of the next size class that fits
+        detail::PoolBlock* grown = pool_->acquire(needed);
+        if (block_) {
+            std::memcpy(grown->data(), block_->data() + offset_, size_);
+            unref(block_);
+        }
+        block_ = grown;
+        offset_ = 0;
+    } else if (offset_ + needed > block_->capacity) {
+        // Fits once the consumed prefix is reclaimed
+        std::memmove(block_->data(), block_->data() + offset_, size_);
+        offset_ = 0;
+    }
+
+    prepared_ = n;
+    return mutable_buffers_type(block_->data() + offset_ + size_, n);
+}
+
+void PooledBuffer::commit(std::size_t n) noexcept {
+    size_ += std::min(n, prepared_);
+    prepared_ = 0;
+}
+
+void PooledBuffer::consume(std::size_t n) noexcept {
+    n = std::min(n, size_);
+    offset_ += n;
+    size_ -= n;
+    if (size_ == 0) {
+        offset_ = 0;
+    }
+}
+
+PooledMessage PooledBuffer::detach() noexcept {
+    if (!block_ || size_ == 0) {
+        return PooledMessage();
+    }
+
+    PooledMessage message(std::exchange(block_, nullptr), offset_, size_);
+    offset_ = 0;
+    size_ = 0;
+    return message;
+}
+
+void PooledBuffer::clear() noexcept {
+    offset_ = 0;
+    size_ = 0;
+    if (block_ && block_->capacity > keep_capacity_) {
+        releaseBlock();
+    }
+}
+
+void PooledBuffer::releaseBlock() noexcept {
+    if (block_) {
+        unref(std::exchange(block_, nullptr));
+    }
+}
+
+} // namespace websocket_client
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <boost/asio/buffer.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace websocket_client {
+
+class BufferPool;
+
+namespace detail {
+
+// Header in front of every pooled allocation; the payload follows it.
+struct alignas(std::max_align_t) PoolBlock {
+    std::atomic<std::uint32_t> refs{0};
+    std::size_t size_class = 0;
+    std::size_t capacity = 0;
+
+    // Set while the block is handed out, so the pool outlives its blocks
+    std::shared_ptr<BufferPool> pool;
+
+    char* data() noexcept { return reinterpret_cast<char*>(this + 1); }
+};
+
+} // namespace detail
+
+// Receive-buffer pool shared by any number of connections.
+//
+// Blocks come in power-of-two size classes from min_block to max_block.
+// Released blocks go back on their class's free list until max_cached_bytes
+// are parked there; beyond that, and for requests above max_block, memory
+// goes straight back to the allocator. A connection therefore only holds
+// as much memory as the message it is reading, instead of the largest
+// message it has ever seen. All methods are thread-safe.
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+public:
+    struct Options {
+        std::size_t min_block = 512;
+        std::size_t max_block = 16 * 1024 * 1024;
+        std::size_t max_cached_bytes = 64 * 1024 * 1024;
+    };
+
+    struct Stats {
+        std::uint64_t hits = 0;     // served from a free list
+        std::uint64_t misses = 0;   // went to the allocator
+        std::uint64_t blocks_in_use = 0;
+        std::uint64_t bytes_in_use = 0;
+        std::uint64_t bytes_cached = 0;
+    };
+
+    static std::shared_ptr<BufferPool> create();
+    static std::shared_ptr<BufferPool> create(Options options);
+
+    // Pool used by clients that were not given one
+    static const std::shared_ptr<BufferPool>& global();
+
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // A block of at least min_capacity bytes holding one reference
+    detail::PoolBlock* acquire(std::size_t min_capacity);
+
+    // Called when the last reference to a block goes away
+    void release(detail::PoolBlock* block);
+
+    Stats stats() const;
+
+private:
+    static constexpr std::size_t kMaxClasses = 32;
+    static constexpr std::size_t kUnpooled = kMaxClasses;
+
+    struct SizeClass {
+        std::mutex mutex;
+        std::vector<detail::PoolBlock*> free;
+    };
+
+    explicit BufferPool(Options options);
+
+    std::size_t classFor(std::size_t capacity) const;
+    static detail::PoolBlock* allocate(std::size_t size_class, std::size_t capacity);
+    static void deallocate(detail::PoolBlock* block);
+
+    const Options options_;
+    std::size_t class_count_;
+    std::array<SizeClass, kMaxClasses> classes_;
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> blocks_in_use_{0};
+    std::atomic<std::uint64_t> bytes_in_use_{0};
+    std::atomic<std::uint64_t> bytes_cached_{0};
+};
+
+// Reference-counted handle to a received message living in a pooled block.
+// Copies share the bytes; the block returns to its pool when the last
+// handle goes away, on whichever thread that happens.
+class PooledMessage {
+public:
+    PooledMessage() = default;
+    PooledMessage(const PooledMessage& other) noexcept;
+    PooledMessage(PooledMessage&& other) noexcept;
+    PooledMessage& operator=(PooledMessage other) noexcept;
+    ~PooledMessage();
+
+    const char* data() const noexcept { return block_ ? block_->data() + offset_ : nullptr; }
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::string_view view() const noexcept { return std::string_view(data(), size_); }
+
+private:
+    friend class PooledBuffer;
+
+    // Adopts the reference the caller holds on `block`
+    PooledMessage(detail::PoolBlock* block, std::size_t offset, std::size_t size) noexcept
+        : block_(block)
+        , offset_(offset)
+        , size_(size)
+    {
+    }
+
+    detail::PoolBlock* block_ = nullptr;
+    std::size_t offset_ = 0;
+    std::size_t size_ = 0;
+};
+
+// Beast DynamicBuffer backed by a pooled block. Grows by moving to a block
+// of the next size class. After a message has been read it can be handed
+// off as a PooledMessage without copying, or cleared for the next one.
+class PooledBuffer {
+public:
+    using const_buffers_type = boost::asio::const_buffer;
+    using mutable_buffers_type = boost::asio::mutable_buffer;
+
+    // clear() keeps a block of up to keep_capacity bytes for the next
+    // message and hands larger ones back to the pool
+    explicit PooledBuffer(
+        std::shared_ptr<BufferPool> pool = BufferPool::global(),
+        std::size_t keep_capacity = 4096);
+    ~PooledBuffer();
+
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    void setPool(std::shared_ptr<BufferPool> pool);
+
+    // DynamicBuffer_v1
+    std::size_t size() const noexcept { return size_; }
+    std::size_t max_size() const noexcept { return static_cast<std::size_t>(-1) / 2; }
+    std::size_t capacity() const noexcept { return block_ ? block_->capacity - offset_ : 0; }
+    const_buffers_type data() const noexcept;
+    mutable_buffers_type prepare(std::size_t n);
+    void commit(std::size_t n) noexcept;
+    void consume(std::size_t n) noexcept;
+
+    // Hand the readable bytes over and leave the buffer empty
+    PooledMessage detach() noexcept;
+
+    // Drop the readable bytes, returning an oversized block to the pool
+    void clear() noexcept;
+
+private:
+    void releaseBlock() noexcept;
+
+    std::shared_ptr<BufferPool> pool_;
+    std::size_t keep_capacity_;
+    detail::PoolBlock* block_ = nullptr;
+    std::size_t offset_ = 0;
+    std::size_t size_ = 0;
+    std::size_t prepared_ = 0;
+};
+
+} // namespace websocket_client
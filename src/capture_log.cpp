@@ -0,0 +1,389 @@
+#include "capture_log.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+
+namespace websocket_client {
+
+namespace capture {
+
+std::string segmentPath(const std::string& base, std::uint64_t index) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%06llu", static_cast<unsigned long long>(index));
+    return base + suffix;
+}
+
+} // namespace capture
+
+namespace {
+
+constexpr std::size_t kHeaderSize = sizeof(capture::SegmentHeader);
+
+std::size_t alignUp(std::size_t size) {
+    return (size + capture::kAlignment - 1) & ~(capture::kAlignment - 1);
+}
+
+std::uint64_t systemNowNs() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+[[noreturn]] void throwErrno(int error, const std::string& what) {
+    throw std::system_error(error, std::generic_category(), what);
+}
+
+} // namespace
+
+// A mapped segment file. The struct outlives its mapping: a writer that
+// loaded it just before a roll may still bump `tail`, and only then sees
+// that its reservation is past the end.
+struct CaptureLog::Segment {
+    std::uint64_t index = 0;
+    int fd = -1;
+    char* base = nullptr;          // the mapping, header included
+    std::size_t capacity = 0;      // record bytes after the header
+    std::atomic<std::size_t> tail{0};       // bytes reserved
+    std::atomic<std::size_t> committed{0};  // bytes fully written
+    std::size_t end = 0;           // bytes in use, set when the segment is retired
+};
+
+CaptureLog::CaptureLog(std::string base_path)
+    : CaptureLog(std::move(base_path), Options())
+{
+}
+
+CaptureLog::CaptureLog(std::string base_path, Options options)
+    : base_(std::move(base_path))
+    , options_(options)
+{
+    auto first = createSegment(next_index_++);
+    current_.store(first.get(), std::memory_order_release);
+    segments_.push_back(std::move(first));
+
+    worker_ = std::thread([this]() { run(); });
+}
+
+CaptureLog::~CaptureLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        if (Segment* last = current_.exchange(nullptr, std::memory_order_acq_rel)) {
+            last->end = std::min(last->tail.load(std::memory_order_acquire), last->capacity);
+            retiring_.push_back(last);
+        }
+    }
+    cv_.notify_all();
+    worker_.join();
+
+    // A spare that was never used leaves no file behind
+    if (spare_) {
+        munmap(spare_->base, kHeaderSize + spare_->capacity);
+        ::close(spare_->fd);
+        unlink(capture::segmentPath(base_, spare_->index).c_str());
+    }
+}
+
+std::unique_ptr<CaptureLog::Segment> CaptureLog::createSegment(std::uint64_t index) {
+    const std::string path = capture::segmentPath(base_, index);
+    const std::size_t total = std::max(options_.segment_size, kHeaderSize + capture::kAlignment);
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throwErrno(errno, "open " + path);
+    }
+
+    // Reserve the blocks now so appends never hit a full disk halfway
+    // through a page; filesystems without fallocate get a sparse file
+    int error = posix_fallocate(fd, 0, static_cast<off_t>(total));
+    if (error == EOPNOTSUPP || error == EINVAL) {
+        error = ftruncate(fd, static_cast<off_t>(total)) == 0 ? 0 : errno;
+    }
+    if (error != 0) {
+        ::close(fd);
+        throwErrno(error, "allocate " + path);
+    }
+
+    // Populate up front so io threads never take the page faults
+    void* base = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (base == MAP_FAILED) {
+        error = errno;
+        ::close(fd);
+        throwErrno(error, "mmap " + path);
+    }
+
+    auto segment = std::make_unique<Segment>();
+    segment->index = index;
+    segment->fd = fd;
+    segment->base = static_cast<char*>(base);
+    segment->capacity = total - kHeaderSize;
+
+    capture::SegmentHeader header{};
+    std::memcpy(header.magic, capture::kSegmentMagic, sizeof(header.magic));
+    header.version = capture::kVersion;
+    header.header_size = kHeaderSize;
+    header.index = index;
+    header.created_ns = systemNowNs();
+    std::memcpy(segment->base, &header, sizeof(header));
+
+    return segment;
+}
+
+bool CaptureLog::append(std::uint32_t connection_id, Opcode opcode, std::string_view payload) {
+    const std::size_t size = alignUp(sizeof(capture::RecordHeader) + payload.size());
+    if (size > options_.segment_size - kHeaderSize) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    for (;;) {
+        Segment* segment = current_.load(std::memory_order_acquire);
+        if (!segment) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        const std::size_t offset = segment->tail.fetch_add(size, std::memory_order_acq_rel);
+        if (offset + size <= segment->capacity) {
+            char* at = segment->base + kHeaderSize + offset;
+
+            capture::RecordHeader header{};
+            header.length = static_cast<std::uint32_t>(payload.size());
+            header.timestamp_ns = systemNowNs();
+            header.connection_id = connection_id;
+            header.opcode = static_cast<std::uint8_t>(opcode);
+            std::memcpy(at, &header, sizeof(header));
+            std::memcpy(at + sizeof(header), payload.data(), payload.size());
+
+            // A reader that sees the magic sees the whole record
+            __atomic_store_n(reinterpret_cast<std::uint32_t*>(at), capture::kRecordMagic,
+                __ATOMIC_RELEASE);
+
+            segment->committed.fetch_add(size, std::memory_order_release);
+            records_.fetch_add(1, std::memory_order_relaxed);
+            payload_bytes_.fetch_add(payload.size(), std::memory_order_relaxed);
+            return true;
+        }
+
+        // Exactly one reservation straddles the end; its owner rolls over
+        if (offset <= segment->capacity) {
+            if (!roll(segment, offset)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            continue;
+        }
+
+        while (current_.load(std::memory_order_acquire) == segment) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool CaptureLog::roll(Segment* full, std::size_t end) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    full->end = end;
+    retiring_.push_back(full);
+
+    // Normally the spare is long ready and this does not wait
+    cv_.wait(lock, [this]() { return spare_ || failed_ || stopping_; });
+    if (!spare_) {
+        current_.store(nullptr, std::memory_order_release);
+        cv_.notify_all();
+        return false;
+    }
+
+    current_.store(spare_.get(), std::memory_order_release);
+    segments_.push_back(std::move(spare_));
+    cv_.notify_all();
+    return true;
+}
+
+void CaptureLog::retire(Segment& segment) {
+    // Writers with a reservation below `end` may still be copying
+    while (segment.committed.load(std::memory_order_acquire) < segment.end) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    munmap(segment.base, kHeaderSize + segment.capacity);
+    segment.base = nullptr;
+
+    // Trim the unused tail so the files only hold what was captured
+    if (ftruncate(segment.fd, static_cast<off_t>(kHeaderSize + segment.end)) != 0) {
+        // The zero-filled tail reads as end of segment, so this is harmless
+    }
+    ::close(segment.fd);
+    segment.fd = -1;
+}
+
+void CaptureLog::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait(lock, [this]() {
+            return !retiring_.empty() || (!spare_ && !failed_ && !stopping_) || stopping_;
+        });
+
+        if (!retiring_.empty()) {
+            Segment* segment = retiring_.front();
+            retiring_.erase(retiring_.begin());
+            lock.unlock();
+            retire(*segment);
+            lock.lock();
+            continue;
+        }
+
+        if (!spare_ && !failed_ && !stopping_) {
+            const std::uint64_t index = next_index_++;
+            lock.unlock();
+            std::unique_ptr<Segment> segment;
+            try {
+                segment = createSegment(index);
+            } catch (const std::system_error&) {
+                // Appends start dropping; the error itself has nowhere to go
+            }
+            lock.lock();
+            failed_ = !segment;
+            spare_ = std::move(segment);
+            cv_.notify_all();
+            continue;
+        }
+
+        if (stopping_) {
+            return;
+        }
+    }
+}
+
+CaptureLog::Stats CaptureLog::stats() const {
+    Stats stats;
+    stats.records = records_.load(std::memory_order_relaxed);
+    stats.payload_bytes = payload_bytes_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.segments = segments_.size();
+    return stats;
+}
+
+CaptureReader::CaptureReader(std::string base_path)
+    : base_(std::move(base_path))
+{
+    if (!open(0)) {
+        throwErrno(errno ? errno : EINVAL, "open " + capture::segmentPath(base_, 0));
+    }
+}
+
+CaptureReader::~CaptureReader() {
+    close();
+}
+
+bool CaptureReader::open(std::uint64_t index) {
+    const std::string path = capture::segmentPath(base_, index);
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < kHeaderSize) {
+        ::close(fd);
+        errno = EINVAL;
+        return false;
+    }
+
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    capture::SegmentHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, capture::kSegmentMagic, sizeof(header.magic)) != 0
+        || header.version != capture::kVersion
+        || header.header_size < kHeaderSize
+        || header.header_size > size) {
+        munmap(data, size);
+        errno = EINVAL;
+        return false;
+    }
+
+    // Records are read front to back, once
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    close();
+    index_ = index;
+    data_ = static_cast<const char*>(data);
+    size_ = size;
+    offset_ = header.header_size;
+    ++segments_read_;
+    return true;
+}
+
+void CaptureReader::close() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+    }
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+    while (data_) {
+        if (offset_ + sizeof(capture::RecordHeader) <= size_) {
+            capture::RecordHeader header;
+            std::memcpy(&header, data_ + offset_, sizeof(header));
+
+            const std::size_t payload_at = offset_ + sizeof(header);
+            if (header.magic == capture::kRecordMagic && header.length <= size_ - payload_at) {
+                record.timestamp_ns = header.timestamp_ns;
+                record.connection_id = header.connection_id;
+                record.opcode = header.opcode ? Opcode::binary : Opcode::text;
+                record.payload = std::string_view(data_ + payload_at, header.length);
+                offset_ = alignUp(payload_at + header.length);
+                return true;
+            }
+        }
+
+        // Unwritten space or the end of the file: on to the next segment
+        if (!open(index_ + 1)) {
+            close();
+        }
+    }
+    return false;
+}
+
+ReplayClock::ReplayClock(double speed)
+    : speed_(speed)
+{
+}
+
+void ReplayClock::waitFor(std::uint64_t timestamp_ns) {
+    if (speed_ <= 0) {
+        return;
+    }
+
+    if (!started_) {
+        started_ = true;
+        first_ns_ = timestamp_ns;
+        start_ = std::chrono::steady_clock::now();
+        return;
+    }
+
+    // Records appended concurrently may be a hair out of order
+    if (timestamp_ns <= first_ns_) {
+        return;
+    }
+
+    const double offset = static_cast<double>(timestamp_ns - first_ns_) / speed_;
+    std::this_thread::sleep_until(start_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::nano>(offset)));
+}
+
+} // namespace websocket_client
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "message_types.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+
+// On-disk layout of a capture log, shared by CaptureLog and CaptureReader.
+//
+// A log is a series of segment files "<base>.000000", "<base>.000001", ...
+// Each starts with a SegmentHeader, followed by 8-byte aligned records. A
+// record whose magic is not kRecordMagic (normally zero, i.e. never written)
+// ends the segment, and the reader moves on to the next file.
+namespace capture {
+
+constexpr char kSegmentMagic[8] = {'W', 'S', 'C', 'A', 'P', 'L', 'O', 'G'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kRecordMagic = 0x31524357;  // "WCR1"
+constexpr std::size_t kAlignment = 8;
+
+struct SegmentHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t header_size;
+    std::uint64_t index;
+    std::uint64_t created_ns;
+    std::uint8_t reserved[32];
+};
+static_assert(sizeof(SegmentHeader) == 64, "segment header layout");
+
+struct RecordHeader {
+    std::uint32_t magic;          // stored last, once the payload is in place
+    std::uint32_t length;         // payload bytes
+    std::uint64_t timestamp_ns;   // system_clock, since the epoch
+    std::uint32_t connection_id;
+    std::uint8_t opcode;          // Opcode
+    std::uint8_t reserved[3];
+};
+static_assert(sizeof(RecordHeader) == 24, "record header layout");
+
+std::string segmentPath(const std::string& base, std::uint64_t index);
+
+} // namespace capture
+
+// One captured message. The payload views the mapped log file.
+struct CaptureRecord {
+    std::uint64_t timestamp_ns = 0;
+    std::uint32_t connection_id = 0;
+    Opcode opcode = Opcode::text;
+    std::string_view payload;
+};
+
+// Append-only capture of received messages into preallocated, memory-mapped
+// segment files.
+//
+// append() is meant for io threads. It reserves space with one atomic add
+// and copies the message into mapped memory. It makes no system calls and
+// takes no locks. The one exception is a full segment when the background
+// thread has not yet got the next one ready.
+//
+// A background thread does the I/O. It creates and pre-faults the next
+// segment before it is needed, and unmaps and trims each full segment once
+// every writer has finished with it.
+class CaptureLog {
+public:
+    struct Options {
+        // Bytes per segment file, header included. Larger messages are
+        // dropped.
+        std::size_t segment_size = 64 * 1024 * 1024;
+    };
+
+    struct Stats {
+        std::uint64_t records = 0;
+        std::uint64_t payload_bytes = 0;
+        std::uint64_t dropped = 0;
+        std::uint64_t segments = 0;
+    };
+
+    // Creates the first segment; throws std::system_error if it cannot
+    explicit CaptureLog(std::string base_path);
+    CaptureLog(std::string base_path, Options options);
+
+    // Appends must have stopped. Trims the last segment to its contents.
+    ~CaptureLog();
+
+    CaptureLog(const CaptureLog&) = delete;
+    CaptureLog& operator=(const CaptureLog&) = delete;
+
+    // Thread-safe. Returns false if the message was dropped: too large for
+    // a segment, or a segment could not be created.
+    bool append(std::uint32_t connection_id, Opcode opcode, std::string_view payload);
+
+    Stats stats() const;
+
+private:
+    struct Segment;
+
+    std::unique_ptr<Segment> createSegment(std::uint64_t index);
+    bool roll(Segment* full, std::size_t end);
+    void retire(Segment& segment);
+    void run();
+
+    const std::string base_;
+    const Options options_;
+    std::atomic<Segment*> current_{nullptr};
+
+    std::atomic<std::uint64_t> records_{0};
+    std::atomic<std::uint64_t> payload_bytes_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+
+    // Shared with the background thread
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::unique_ptr<Segment>> segments_;  // every segment so far
+    std::unique_ptr<Segment> spare_;
+    std::vector<Segment*> retiring_;
+    std::uint64_t next_index_{0};
+    bool failed_{false};
+    bool stopping_{false};
+
+    std::thread worker_;
+};
+
+// Walks a capture log in order without copying: each record's payload
+// points straight into the mapped segment.
+class CaptureReader {
+public:
+    // Throws std::system_error if the first segment cannot be opened
+    explicit CaptureReader(std::string base_path);
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    // The next record, or false at the end of the log. The payload stays
+    // valid until the following call.
+    bool next(CaptureRecord& record);
+
+    std::uint64_t segmentsRead() const { return segments_read_; }
+
+private:
+    bool open(std::uint64_t index);
+    void close();
+
+    const std::string base_;
+    std::uint64_t index_{0};
+    std::uint64_t segments_read_{0};
+    const char* data_{nullptr};
+    std::size_t size_{0};
+    std::size_t offset_{0};
+};
+
+// Paces a replay to the spacing of the original timestamps, divided by
+// `speed`. A speed of 0 never waits.
+class ReplayClock {
+public:
+    explicit ReplayClock(double speed);
+
+    // Blocks until the record stamped `timestamp_ns` is due
+    void waitFor(std::uint64_t timestamp_ns);
+
+private:
+    double speed_;
+    bool started_{false};
+    std::uint64_t first_ns_{0};
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace websocket_client
@@ -1,4 +1,6 @@
 #include "cli_handler.hpp"
+#include <boost/version.hpp>
+#include <cstdlib>
 
 namespace websocket_client {
 
@@ -14,6 +16,214 @@ CLIHandler::CLIHandler() {
     
     // Add the no-secure flag as a member variable
     app_.add_flag("--no-secure", no_secure_flag_, "Disable secure WebSocket (use ws:// instead of wss://)");
+
+    // permessage-deflate negotiation
+    app_.add_flag("--compress", compression_.enabled, "Offer permessage-deflate compression");
+
+    app_.add_option("--compress-window-bits", compression_.window_bits, "Deflate window bits")
+        ->default_val(15)
+        ->check(CLI::Range(9, 15));
+
+    app_.add_flag("--compress-no-context-takeover", compression_.no_context_takeover,
+        "Reset the deflate context after every message");
+
+    app_.add_option("--compress-mem-level", compression_.mem_level, "Deflate memLevel")
+        ->default_val(4)
+        ->check(CLI::Range(1, 9));
+
+#if BOOST_VERSION >= 108100
+    app_.add_option("--compress-min-size", compression_.min_message_size,
+        "Send messages smaller than this many bytes uncompressed")
+        ->default_val(0);
+#else
+    // Older Beast compresses every message; refuse a threshold it would ignore
+    app_.add_option("--compress-min-size", compression_.min_message_size,
+        "Send messages smaller than this many bytes uncompressed (needs Boost 1.81+; only 0 here)")
+        ->default_val(0)
+        ->check(CLI::Validator(
+            [](std::string& value) -> std::string {
+                if (std::strtoull(value.c_str(), nullptr, 10) == 0) {
+                    return {};
+                }
+                return "needs Boost 1.81 or newer; this build compresses every message";
+            },
+            "", "BOOST_1_81"));
+#endif
+
+    // io_context sharding
+    app_.add_option("--io-threads", io_threads_, "Number of io_context threads (0 = one per core)")
+        ->default_val(1);
+
+    app_.add_flag("--pin-threads", pin_threads_, "Pin each io thread to its own CPU");
+
+    // Automatic reconnect
+    app_.add_flag("--reconnect", reconnect_, "Reconnect automatically when the connection drops");
+
+    app_.add_option("--reconnect-initial-delay", reconnect_initial_ms_,
+        "Backoff before the second reconnect attempt, in milliseconds")
+        ->default_val(100);
+
+    app_.add_option("--reconnect-max-delay", reconnect_max_ms_,
+        "Upper bound on the reconnect backoff, in milliseconds")
+        ->default_val(5000);
+
+    app_.add_option("--reconnect-max-attempts", reconnect_max_attempts_,
+        "Give up after this many failed attempts (0 = never)")
+        ->default_val(0);
+
+    // Keepalive pings
+    app_.add_option("--ping-interval", ping_interval_ms_,
+        "Ping the server this often, in milliseconds, timing the pongs (0 = off)")
+        ->default_val(0);
+
+    app_.add_option("--ping-max-missed", ping_max_missed_,
+        "Fail the connection after this many unanswered pings in a row")
+        ->default_val(2)
+        ->check(CLI::PositiveNumber);
+
+    // Outbound backpressure
+    app_.add_option("--max-queued-bytes", max_queued_bytes_,
+        "Pause input while this many bytes wait to be sent, until half have gone (0 = no limit)")
+        ->default_val(0);
+
+    app_.add_option("--max-queued-messages", max_queued_messages_,
+        "Pause input while this many messages wait to be sent, until half have gone (0 = no limit)")
+        ->default_val(0);
+
+    // Outbound write batching
+    app_.add_option("--batch-bytes", batch_bytes_,
+        "Gather small frames into writes of up to this many bytes (0 = one write per frame)")
+        ->default_val(0);
+
+    app_.add_option("--batch-linger-us", batch_linger_us_,
+        "Hold a batch this many microseconds for more frames to join it")
+        ->default_val(0);
+
+    app_.add_flag("--frame-encoder", frame_encoder_,
+        "Frame and mask outgoing messages with SIMD kernels instead of through Beast");
+
+    // Inbound message size guard
+    app_.add_option("--max-message-size", max_message_size_,
+        "Fail the connection on a message larger than this many bytes (0 = no limit)")
+        ->default_val(16 * 1024 * 1024);
+
+    // Input replay
+    app_.add_option("--input-file", input_file_,
+        "Send the lines of this file instead of reading stdin")
+        ->check(CLI::ExistingFile);
+
+    app_.add_option("--rate", rate_, "Send at most this many lines per second (0 = no limit)")
+        ->default_val(0)
+        ->check(CLI::NonNegativeNumber);
+
+    app_.add_option("--burst", burst_, "Lines that may go out back to back under --rate")
+        ->default_val(1)
+        ->check(CLI::PositiveNumber);
+
+    // Received message output
+    app_.add_option("--output", output_,
+        "Where received messages are printed: stdout, none, or a file path")
+        ->default_val("stdout");
+
+    app_.add_flag("--output-drop", output_drop_,
+        "Skip received messages while the output is 4 MiB behind instead of waiting for it");
+
+    // Latency histograms
+    app_.add_option("--latency-report", latency_report_s_,
+        "Record per-message latencies and print them to stderr every this many seconds (0 = off)")
+        ->default_val(0);
+
+    // Connection tracing
+    app_.add_option("--trace-file", trace_file_,
+        "Write connection phases to this file on exit, as Chrome trace JSON");
+
+    app_.add_option("--trace-sample", trace_sample_,
+        "With --trace-file, also trace one read and one write in this many (0 = none)")
+        ->default_val(0);
+
+    // Capture
+    app_.add_option("--capture", capture_file_,
+        "Record received messages to segment files <path>.000000, <path>.000001, ...");
+
+    // Load generator
+    app_.add_flag("--load", load_, "Generate load instead of sending input lines");
+
+    app_.add_option("--connections", load_connections_, "Connections opened by --load")
+        ->default_val(1)
+        ->check(CLI::PositiveNumber);
+
+    app_.add_option("--load-rate", load_rate_, "Messages per second on each --load connection")
+        ->default_val(10)
+        ->check(CLI::PositiveNumber);
+
+    app_.add_option("--payload-size", payload_size_, "Bytes per --load message")
+        ->default_val(64);
+
+    app_.add_option("--payload-pattern", payload_pattern_, "Contents of --load messages")
+        ->default_val("fill")
+        ->check(CLI::IsMember({"fill", "random", "binary"}));
+
+    app_.add_flag("--measure-rtt", measure_rtt_,
+        "Timestamp --load messages and report echo round trips");
+
+    app_.add_option("--duration", load_duration_s_, "Seconds to run --load for (0 = until Ctrl-C)")
+        ->default_val(0);
+
+    app_.add_option("--report-interval", report_interval_s_, "Seconds between --load reports")
+        ->default_val(1)
+        ->check(CLI::PositiveNumber);
+}
+
+ReconnectPolicy CLIHandler::getReconnectPolicy() const {
+    ReconnectPolicy policy;
+    policy.enabled = reconnect_;
+    policy.initial_delay = std::chrono::milliseconds(reconnect_initial_ms_);
+    policy.max_delay = std::chrono::milliseconds(reconnect_max_ms_);
+    policy.max_attempts = reconnect_max_attempts_;
+    return policy;
+}
+
+KeepalivePolicy CLIHandler::getKeepalivePolicy() const {
+    KeepalivePolicy policy;
+    policy.interval = std::chrono::milliseconds(ping_interval_ms_);
+    policy.max_missed = ping_max_missed_;
+    return policy;
+}
+
+BackpressurePolicy CLIHandler::getBackpressurePolicy() const {
+    BackpressurePolicy policy;
+    policy.high_water_bytes = max_queued_bytes_;
+    policy.low_water_bytes = max_queued_bytes_ / 2;
+    policy.high_water_messages = max_queued_messages_;
+    policy.low_water_messages = max_queued_messages_ / 2;
+    return policy;
+}
+
+WriteBatchOptions CLIHandler::getWriteBatchOptions() const {
+    WriteBatchOptions options;
+    options.max_bytes = batch_bytes_;
+    options.linger = std::chrono::microseconds(batch_linger_us_);
+    return options;
+}
+
+LoadOptions CLIHandler::getLoadOptions() const {
+    LoadOptions options;
+    options.connections = load_connections_;
+    options.rate = load_rate_;
+    options.payload_size = payload_size_;
+    options.measure_rtt = measure_rtt_;
+    options.compression = compression_;
+    options.reconnect = getReconnectPolicy();
+    options.keepalive = getKeepalivePolicy();
+    options.write_batch = getWriteBatchOptions();
+    options.frame_encoder = frame_encoder_;
+
+    if (payload_pattern_ == "random") {
+        options.pattern = PayloadPattern::random;
+    } else if (payload_pattern_ == "binary") {
+        options.pattern = PayloadPattern::binary;
+    }
+    return options;
 }
 
 bool CLIHandler::parse(int argc, char* argv[]) {
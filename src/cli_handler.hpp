@@ -1,5 +1,12 @@
 #pragma once
 
+#include "backpressure_policy.hpp"
+#include "compression_options.hpp"
+#include "keepalive_policy.hpp"
+#include "load_options.hpp"
+#include "reconnect_policy.hpp"
+#include "write_batch_options.hpp"
+#include <cstdint>
 #include <string>
 #include <functional>
 #include <CLI/CLI.hpp>
@@ -15,6 +22,28 @@ public:
     std::string getPort() const { return port_; }
     std::string getTarget() const { return target_; }
     bool isSecure() const { return secure_; }
+    CompressionOptions getCompressionOptions() const { return compression_; }
+    std::size_t getIoThreads() const { return io_threads_; }
+    bool pinThreads() const { return pin_threads_; }
+    ReconnectPolicy getReconnectPolicy() const;
+    KeepalivePolicy getKeepalivePolicy() const;
+    BackpressurePolicy getBackpressurePolicy() const;
+    WriteBatchOptions getWriteBatchOptions() const;
+    bool useFrameEncoder() const { return frame_encoder_; }
+    std::uint64_t getMaxMessageSize() const { return max_message_size_; }
+    std::string getInputFile() const { return input_file_; }
+    double getRate() const { return rate_; }
+    std::size_t getBurst() const { return burst_; }
+    std::string getCaptureFile() const { return capture_file_; }
+    std::string getOutput() const { return output_; }
+    bool dropOutputWhenBehind() const { return output_drop_; }
+    unsigned getLatencyReportInterval() const { return latency_report_s_; }
+    std::string getTraceFile() const { return trace_file_; }
+    std::uint32_t getTraceSample() const { return trace_sample_; }
+    bool isLoadMode() const { return load_; }
+    LoadOptions getLoadOptions() const;
+    unsigned getLoadDuration() const { return load_duration_s_; }
+    unsigned getReportInterval() const { return report_interval_s_; }
 
 private:
     CLI::App app_{"WebSocket Client"};
@@ -23,6 +52,38 @@ private:
     std::string target_{"/"};
     bool secure_{true};
     bool no_secure_flag_{false};
+    CompressionOptions compression_;
+    std::size_t io_threads_{1};
+    bool pin_threads_{false};
+    bool reconnect_{false};
+    unsigned reconnect_initial_ms_{100};
+    unsigned reconnect_max_ms_{5000};
+    std::size_t reconnect_max_attempts_{0};
+    unsigned ping_interval_ms_{0};
+    std::size_t ping_max_missed_{2};
+    std::size_t max_queued_bytes_{0};
+    std::size_t max_queued_messages_{0};
+    std::size_t batch_bytes_{0};
+    unsigned batch_linger_us_{0};
+    bool frame_encoder_{false};
+    std::uint64_t max_message_size_{16 * 1024 * 1024};
+    std::string input_file_;
+    double rate_{0};
+    std::size_t burst_{1};
+    std::string capture_file_;
+    std::string output_{"stdout"};
+    bool output_drop_{false};
+    unsigned latency_report_s_{0};
+    std::string trace_file_;
+    std::uint32_t trace_sample_{0};
+    bool load_{false};
+    std::size_t load_connections_{1};
+    double load_rate_{10};
+    std::size_t payload_size_{64};
+    std::string payload_pattern_{"fill"};
+    bool measure_rtt_{false};
+    unsigned load_duration_s_{0};
+    unsigned report_interval_s_{1};
 };
 
 } // namespace websocket_client
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "write_batch_options.hpp"
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/core/role.hpp>
+#include <boost/beast/core/stream_traits.hpp>
+#include <boost/beast/websocket/teardown.hpp>
+#include <boost/system/error_code.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace websocket_client {
+
+// Stream layer that gathers small writes and hands them to the layer below
+// in one go, so a run of small WebSocket frames costs one system call
+// instead of one per frame. See WriteBatchOptions for when a batch goes out.
+//
+// A write is copied into the batch and completes straight away, unless the
+// batch is then full, in which case it completes once the batch has been
+// written. The batch is written when the caller does not follow up with
+// another write from inside that completion handler, which is how the
+// websocket stream behaves once the client's queue is empty. A write of at
+// least max_bytes that finds nothing gathered skips the copy.
+//
+// Reads pass straight through. Writes handed to the layer below, batched
+// or not, are added to the counter given to setOptions(), which belongs to
+// the owner like MeteredStream's.
+//
+// Only the stream above calls into this layer, always on its strand, with
+// at most one write outstanding. Pending flushes keep their state alive, so
+// the layer may be destroyed with a write in flight once its socket has
+// been closed.
+template <class NextLayer>
+class CoalescingStream {
+public:
+    using next_layer_type = std::remove_reference_t<NextLayer>;
+    using lowest_layer_type = boost::beast::lowest_layer_type<next_layer_type>;
+    using executor_type = typename next_layer_type::executor_type;
+
+    // Takes a single argument so it can sit below an ssl_stream
+    template <class Arg>
+    explicit CoalescingStream(Arg&& arg)
+        : next_layer_(std::forward<Arg>(arg))
+        , batch_(std::make_shared<Batch>(next_layer_))
+    {
+    }
+
+    ~CoalescingStream() {
+        batch_->detach();
+    }
+
+    CoalescingStream(const CoalescingStream&) = delete;
+    CoalescingStream& operator=(const CoalescingStream&) = delete;
+
+    executor_type get_executor() noexcept { return next_layer_.get_executor(); }
+
+    next_layer_type& next_layer() noexcept { return next_layer_; }
+    const next_layer_type& next_layer() const noexcept { return next_layer_; }
+
+    // For boost::asio::ssl::stream
+    lowest_layer_type& lowest_layer() noexcept { return boost::beast::get_lowest_layer(next_layer_); }
+    const lowest_layer_type& lowest_layer() const noexcept {
+        return boost::beast::get_lowest_layer(next_layer_);
+    }
+
+    // Call before the first write
+    void setOptions(const WriteBatchOptions& options, std::atomic<std::uint64_t>& writes) {
+        batch_->options = options;
+        batch_->writes = &writes;
+    }
+
+    template <class MutableBufferSequence, class ReadHandler>
+    auto async_read_some(const MutableBufferSequence& buffers, ReadHandler&& handler) {
+        return next_layer_.async_read_some(buffers, std::forward<ReadHandler>(handler));
+    }
+
+    template <class ConstBufferSequence, class WriteHandler>
+    auto async_write_some(const ConstBufferSequence& buffers, WriteHandler&& handler) {
+        return boost::asio::async_initiate<WriteHandler,
+            void(boost::system::error_code, std::size_t)>(
+                [this](auto&& h, const ConstBufferSequence& b) {
+                    if (!batch_->options.enabled()) {
+                        batch_->countWrite();
+                        next_layer_.async_write_some(b, std::forward<decltype(h)>(h));
+                        return;
+                    }
+                    Batch::write(batch_, b, std::forward<decltype(h)>(h));
+                },
+                handler, buffers);
+    }
+
+private:
+    // Everything a flush in flight needs, shared with its handlers
+    struct Batch : std::enable_shared_from_this<Batch> {
+        // A write held back until the batch it filled has been written
+        struct Waiter {
+            virtual ~Waiter() = default;
+            virtual void complete(boost::system::error_code ec) = 0;
+        };
+
+        template <class Handler>
+        struct WaiterFor final : Waiter {
+            WaiterFor(std::shared_ptr<Batch> b, Handler h, std::size_t n)
+                : batch(std::move(b)), handler(std::move(h)), bytes(n) {}
+
+            void complete(boost::system::error_code ec) override {
+                Batch::complete(std::move(batch), std::move(handler), ec, ec ? 0 : bytes);
+            }
+
+            std::shared_ptr<Batch> batch;
+            Handler handler;
+            std::size_t bytes;
+        };
+
+        explicit Batch(next_layer_type& next)
+            : stream(&next)
+            , timer(next.get_executor())
+        {
+        }
+
+        void countWrite() {
+            if (writes) {
+                writes->fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void detach() {
+            stream = nullptr;
+            timer.cancel();
+        }
+
+        template <class ConstBufferSequence, class Handler>
+        static void write(const std::shared_ptr<Batch>& self, const ConstBufferSequence& buffers,
+                          Handler&& handler) {
+            const std::size_t size = boost::asio::buffer_size(buffers);
+            if (self->error) {
+                return complete(self, std::forward<Handler>(handler), self->error, 0);
+            }
+
+            if (self->pending.empty() && !self->write_in_flight && size >= self->options.max_bytes) {
+                return self->writeThrough(buffers, std::forward<Handler>(handler));
+            }
+
+            const bool first = self->pending.empty();
+            const std::size_t offset = self->pending.size();
+            self->pending.resize(offset + size);
+            boost::asio::buffer_copy(boost::asio::buffer(&self->pending[offset], size), buffers);
+            ++self->appends;
+
+            if (self->pending.size() >= self->options.max_bytes) {
+                self->waiter = std::make_unique<WaiterFor<std::decay_t<Handler>>>(
+                    self, std::forward<Handler>(handler), size);
+                self->flush();
+                return;
+            }
+
+            if (first && self->options.linger.count() > 0) {
+                self->timer.expires_after(self->options.linger);
+                self->timer.async_wait([self](boost::system::error_code ec) {
+                    if (!ec) {
+                        self->flush();
+                    }
+                });
+            }
+            complete(self, std::forward<Handler>(handler), {}, size);
+        }
+
+        // Runs `handler` on its own executor, never inline. If it does not
+        // write again the writer has gone idle and the batch may go out.
+        template <class Handler>
+        static void complete(std::shared_ptr<Batch> self, Handler&& handler,
+                             boost::system::error_code ec, std::size_t bytes) {
+            auto ex = boost::asio::get_associated_executor(handler, self->timer.get_executor());
+            boost::asio::post(ex,
+                [self = std::move(self), h = std::forward<Handler>(handler), ec, bytes]() mutable {
+                    const std::uint64_t appends = self->appends;
+                    std::move(h)(ec, bytes);
+                    if (self->appends == appends && self->options.linger.count() == 0) {
+                        self->flush();
+                    }
+                });
+        }
+
+        template <class ConstBufferSequence, class Handler>
+        void writeThrough(const ConstBufferSequence& buffers, Handler&& handler) {
+            write_in_flight = true;
+            countWrite();
+            auto ex = boost::asio::get_associated_executor(handler, timer.get_executor());
+            stream->async_write_some(buffers, boost::asio::bind_executor(ex,
+                [self = this->shared_from_this(), h = std::forward<Handler>(handler)](
+                    boost::system::error_code ec, std::size_t bytes) mutable {
+                    self->write_in_flight = false;
+                    if (ec && !self->error) {
+                        self->error = ec;
+                    }
+                    std::move(h)(ec, bytes);
+                }));
+        }
+
+        void flush() {
+            if (write_in_flight) {
+                flush_after_write = true;
+                return;
+            }
+            if (pending.empty() || !stream) {
+                return;
+            }
+
+            timer.cancel();
+            writing.swap(pending);
+            pending.clear();
+            write_in_flight = true;
+            countWrite();
+
+            boost::asio::async_write(*stream, boost::asio::buffer(writing),
+                [self = this->shared_from_this(), done = std::move(waiter)](
+                    boost::system::error_code ec, std::size_t) mutable {
+                    self->write_in_flight = false;
+                    self->writing.clear();
+                    if (ec && !self->error) {
+                        self->error = ec;
+                    } else if (!self->stream && !self->error) {
+                        self->error = boost::asio::error::operation_aborted;
+                    }
+                    if (done) {
+                        done->complete(ec);
+                    }
+
+                    // Nothing more goes out; release a writer still held back
+                    if (self->error) {
+                        self->pending.clear();
+                        if (self->waiter) {
+                            std::exchange(self->waiter, nullptr)->complete(self->error);
+                        }
+                        return;
+                    }
+
+                    // Anything gathered meanwhile stays for the idle check or
+                    // the linger timer, unless one of them already fired
+                    if (std::exchange(self->flush_after_write, false)) {
+                        self->flush();
+                    }
+                });
+        }
+
+        next_layer_type* stream;  // null once the layer is destroyed
+        std::atomic<std::uint64_t>* writes = nullptr;
+        WriteBatchOptions options;
+        boost::asio::steady_timer timer;  // linger
+        std::string pending;  // gathered, not yet written
+        std::string writing;  // being written
+        std::unique_ptr<Waiter> waiter;
+        boost::system::error_code error;  // first failed write; fails every later one
+        std::uint64_t appends = 0;
+        bool write_in_flight = false;
+        bool flush_after_write = false;  // flush() came while writing
+    };
+
+    NextLayer next_layer_;
+    std::shared_ptr<Batch> batch_;
+};
+
+// Let websocket::stream tear down whatever sits below the batching
+template <class NextLayer>
+void teardown(
+    boost::beast::role_type role,
+    CoalescingStream<NextLayer>& stream,
+    boost::system::error_code& ec)
+{
+    using boost::beast::websocket::teardown;
+    teardown(role, stream.next_layer(), ec);
+}
+
+template <class NextLayer, class TeardownHandler>
+void async_teardown(
+    boost::beast::role_type role,
+    CoalescingStream<NextLayer>& stream,
+    TeardownHandler&& handler)
+{
+    using boost::beast::websocket::async_teardown;
+    async_teardown(role, stream.next_layer(),
+        std::forward<TeardownHandler>(handler));
+}
+
+} // namespace websocket_client
@@ -0,0 +1,24 @@
+#include "compression_options.hpp"
+#include <boost/beast/websocket/option.hpp>
+#include <boost/version.hpp>
+
+namespace websocket_client {
+
+boost::beast::websocket::permessage_deflate toPermessageDeflate(
+    const CompressionOptions& options)
+{
+    boost::beast::websocket::permessage_deflate pmd;
+    pmd.client_enable = options.enabled;
+    pmd.client_max_window_bits = options.window_bits;
+    pmd.server_max_window_bits = options.window_bits;
+    pmd.client_no_context_takeover = options.no_context_takeover;
+    pmd.server_no_context_takeover = options.no_context_takeover;
+    pmd.memLevel = options.mem_level;
+    pmd.compLevel = options.level;
+#if BOOST_VERSION >= 108100
+    pmd.msg_size_threshold = options.min_message_size;
+#endif
+    return pmd;
+}
+
+} // namespace websocket_client
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+namespace boost {
+namespace beast {
+namespace websocket {
+struct permessage_deflate;
+} // namespace websocket
+} // namespace beast
+} // namespace boost
+
+namespace websocket_client {
+
+// permessage-deflate (RFC 7692) settings offered during the handshake.
+struct CompressionOptions {
+    bool enabled = false;
+
+    // LZ77 window size, 9..15. Applied to both directions.
+    int window_bits = 15;
+
+    // Reset the compressor after every message. Costs ratio, saves the
+    // per-connection window memory on both ends.
+    bool no_context_takeover = false;
+
+    // zlib memLevel, 1..9: memory used by the compressor's internal state
+    int mem_level = 4;
+
+    // zlib compression level, 0..9
+    int level = 8;
+
+    // Messages smaller than this are sent uncompressed. Needs Boost 1.81 or
+    // newer; older Beast compresses everything once negotiated, and the CLI
+    // refuses a non-zero --compress-min-size there.
+    std::size_t min_message_size = 0;
+};
+
+// Translate to the Beast option set on the websocket stream
+boost::beast::websocket::permessage_deflate toPermessageDeflate(
+    const CompressionOptions& options);
+
+} // namespace websocket_client
@@ -0,0 +1,206 @@
+#include "connection_manager.hpp"
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+namespace websocket_client {
+
+ConnectionManager::ConnectionManager()
+    : ConnectionManager(Options())
+{
+}
+
+ConnectionManager::ConnectionManager(Options options)
+    : options_(options)
+    , dns_cache_(std::make_shared<DnsCache>(options_.dns_ttl))
+    , next_shard_(0)
+{
+    std::size_t threads = options_.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 0; i < threads; ++i) {
+        auto shard = std::make_unique<Shard>();
+        Shard& s = *shard;
+        s.thread = std::thread([&s]() {
+            s.ioc.run();
+        });
+
+        if (options_.pin_threads) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(i % cores, &cpus);
+            // Best effort: a restricted cpuset just leaves the thread unpinned
+            pthread_setaffinity_np(s.thread.native_handle(), sizeof(cpus), &cpus);
+        }
+
+        shards_.push_back(std::move(shard));
+    }
+}
+
+ConnectionManager::~ConnectionManager() {
+    stop();
+}
+
+std::shared_ptr<WebSocketClientPlain> ConnectionManager::createPlainClient() {
+    const std::size_t index = pickShard();
+    auto client = std::make_shared<WebSocketClientPlain>(shards_[index]->ioc);
+    client->setDnsCache(dns_cache_);
+    track(index, client);
+    return client;
+}
+
+std::shared_ptr<WebSocketClient> ConnectionManager::createClient(
+    boost::asio::ssl::context& ssl_ctx) {
+    const std::size_t index = pickShard();
+    auto client = std::make_shared<WebSocketClient>(shards_[index]->ioc, ssl_ctx);
+    client->setDnsCache(dns_cache_);
+    track(index, client);
+    return client;
+}
+
+template <class Client>
+void ConnectionManager::track(std::size_t index, const std::shared_ptr<Client>& client) {
+    std::weak_ptr<Client> weak = client;
+    std::lock_guard<std::mutex> lock(mutex_);
+    Member member;
+    member.client = weak;
+    member.stats = [weak]() -> std::optional<ConnectionStats> {
+        if (auto c = weak.lock()) {
+            return c->stats();
+        }
+        return std::nullopt;
+    };
+    member.send = [weak](const SharedPayload& payload) {
+        if (auto c = weak.lock()) {
+            return c->send(payload);
+        }
+        return false;
+    };
+    member.latency = [weak]() -> std::optional<MessageLatency> {
+        if (auto c = weak.lock()) {
+            return c->latency();
+        }
+        return std::nullopt;
+    };
+
+    // Pruning as the list doubles keeps creation O(1) amortized however
+    // many clients come and go
+    Shard& shard = *shards_[index];
+    shard.clients.push_back(std::move(member));
+    if (shard.clients.size() >= shard.prune_at) {
+        pruneLocked(shard);
+    }
+}
+
+std::size_t ConnectionManager::pickShard() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (options_.placement == Placement::round_robin) {
+        const std::size_t index = next_shard_;
+        next_shard_ = (next_shard_ + 1) % shards_.size();
+        return index;
+    }
+
+    std::size_t best = 0;
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        pruneLocked(*shards_[i]);
+        if (shards_[i]->clients.size() < shards_[best]->clients.size()) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void ConnectionManager::pruneLocked(Shard& shard) const {
+    auto& clients = shard.clients;
+    clients.erase(
+        std::remove_if(clients.begin(), clients.end(),
+            [](const Member& member) { return member.client.expired(); }),
+        clients.end());
+    shard.prune_at = std::max<std::size_t>(64, clients.size() * 2);
+}
+
+ConnectionManager::AggregateStats ConnectionManager::stats() const {
+    AggregateStats aggregate;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const auto& shard : shards_) {
+        pruneLocked(*shard);
+        ConnectionStats shard_totals;
+        std::size_t live = 0;
+        for (const auto& member : shard->clients) {
+            if (auto stats = member.stats()) {
+                shard_totals += *stats;
+                ++live;
+            }
+        }
+
+        aggregate.totals += shard_totals;
+        aggregate.connections += live;
+        aggregate.per_shard.push_back(shard_totals);
+        aggregate.connections_per_shard.push_back(live);
+    }
+    return aggregate;
+}
+
+MessageLatency ConnectionManager::latency() const {
+    // Snapshots are large, so they are taken outside the lock
+    std::vector<LatencySource> sources;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& shard : shards_) {
+            pruneLocked(*shard);
+            for (const auto& member : shard->clients) {
+                sources.push_back(member.latency);
+            }
+        }
+    }
+
+    MessageLatency merged;
+    for (const auto& source : sources) {
+        if (auto latency = source()) {
+            merged += *latency;
+        }
+    }
+    return merged;
+}
+
+std::size_t ConnectionManager::broadcast(const SharedPayload& payload) {
+    // Sent outside the lock, since a client may report "Not connected" to
+    // an error handler that calls back into the manager
+    std::vector<PayloadSink> sinks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& shard : shards_) {
+            pruneLocked(*shard);
+            for (const auto& member : shard->clients) {
+                sinks.push_back(member.send);
+            }
+        }
+    }
+
+    std::size_t queued = 0;
+    for (const auto& sink : sinks) {
+        if (sink(payload)) {
+            ++queued;
+        }
+    }
+    return queued;
+}
+
+void ConnectionManager::stop() {
+    for (auto& shard : shards_) {
+        shard->work.reset();
+        shard->ioc.stop();
+    }
+    for (auto& shard : shards_) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+}
+
+} // namespace websocket_client
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "connection_stats.hpp"
+#include "dns_cache.hpp"
+#include "message_latency.hpp"
+#include "shared_payload.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+
+// Owns a pool of single-threaded io_contexts ("shards"), one per core by
+// default, and places clients on them. Each client lives entirely on one
+// shard, so connections never contend for an io_context and throughput
+// grows with the number of shards.
+//
+// Clients share one DnsCache, so a fleet of connections to the same host
+// resolves it once per TTL.
+//
+// Clients handed out here must be released before the manager is destroyed,
+// since their sockets belong to the shards' io_contexts.
+class ConnectionManager {
+public:
+    enum class Placement {
+        round_robin,
+        least_loaded  // shard with the fewest live clients
+    };
+
+    struct Options {
+        std::size_t threads = 0;  // 0 = std::thread::hardware_concurrency()
+        bool pin_threads = false; // pin shard i to CPU i % cores
+        Placement placement = Placement::round_robin;
+        std::chrono::seconds dns_ttl{60};
+    };
+
+    struct AggregateStats {
+        std::size_t connections = 0;
+        ConnectionStats totals;
+        std::vector<ConnectionStats> per_shard;
+        std::vector<std::size_t> connections_per_shard;
+    };
+
+    ConnectionManager();
+    explicit ConnectionManager(Options options);
+    ~ConnectionManager();
+
+    ConnectionManager(const ConnectionManager&) = delete;
+    ConnectionManager& operator=(const ConnectionManager&) = delete;
+
+    // Create a client on the next shard chosen by the placement policy.
+    // The manager only keeps a weak reference for stats and load tracking.
+    std::shared_ptr<WebSocketClientPlain> createPlainClient();
+    std::shared_ptr<WebSocketClient> createClient(boost::asio::ssl::context& ssl_ctx);
+
+    std::size_t shardCount() const { return shards_.size(); }
+    boost::asio::io_context& shard(std::size_t index) { return shards_[index]->ioc; }
+    const std::shared_ptr<DnsCache>& dnsCache() const { return dns_cache_; }
+
+    AggregateStats stats() const;
+
+    // Latency histograms of every live client, merged. Only clients with
+    // latency tracking on contribute any samples.
+    MessageLatency latency() const;
+
+    // Queue `payload` on every live client, sharing its bytes rather than
+    // copying them, so the cost per client does not grow with its size.
+    // Each client sends it as send(SharedPayload) would. Returns how many
+    // clients took it; disconnected ones without a reconnect policy, or
+    // whose policy gave up, do not.
+    std::size_t broadcast(const SharedPayload& payload);
+
+    // Stop all shards and join their threads. Called by the destructor.
+    void stop();
+
+private:
+    // Returns std::nullopt once the client is gone
+    using StatsSource = std::function<std::optional<ConnectionStats>()>;
+    // Returns false once the client is gone or cannot take the payload
+    using PayloadSink = std::function<bool(const SharedPayload&)>;
+    // Returns std::nullopt once the client is gone
+    using LatencySource = std::function<std::optional<MessageLatency>()>;
+
+    // Clients come from make_shared, so a dead client's storage lasts as
+    // long as these do; members are pruned once `client` expires
+    struct Member {
+        std::weak_ptr<void> client;
+        StatsSource stats;
+        PayloadSink send;
+        LatencySource latency;
+    };
+
+    struct Shard {
+        Shard()
+            : ioc(1)
+            , work(boost::asio::make_work_guard(ioc))
+        {
+        }
+
+        boost::asio::io_context ioc;
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work;
+        std::thread thread;
+        std::vector<Member> clients;  // guarded by mutex_
+        std::size_t prune_at = 64;    // track() prunes once clients reaches this
+    };
+
+    std::size_t pickShard();
+    void pruneLocked(Shard& shard) const;
+
+    template <class Client>
+    void track(std::size_t index, const std::shared_ptr<Client>& client);
+
+    Options options_;
+    std::shared_ptr<DnsCache> dns_cache_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    mutable std::mutex mutex_;
+    std::size_t next_shard_;
+};
+
+} // namespace websocket_client
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace websocket_client {
+
+// Point-in-time view of a connection's traffic counters.
+struct ConnectionStats {
+    std::uint64_t messages_sent = 0;
+    std::uint64_t messages_received = 0;
+
+    // Application payload bytes: before compression on the way out and
+    // after decompression on the way in.
+    std::uint64_t payload_bytes_sent = 0;
+    std::uint64_t payload_bytes_received = 0;
+
+    // WebSocket frame bytes as handed to / taken from the transport, i.e.
+    // after permessage-deflate and before TLS.
+    std::uint64_t wire_bytes_sent = 0;
+    std::uint64_t wire_bytes_received = 0;
+
+    // Writes handed to the TCP socket: about one per frame, or one per
+    // batch of frames with write batching on.
+    std::uint64_t transport_writes = 0;
+
+    bool compression_negotiated = false;
+
+    // TLS handshakes on this connection, split by whether a cached session
+    // was resumed. Always zero for plain connections.
+    std::uint64_t tls_full_handshakes = 0;
+    std::uint64_t tls_resumed_handshakes = 0;
+
+    // Successful automatic reconnects
+    std::uint64_t reconnects = 0;
+
+    // Time from starting a connection attempt (DNS or cached addresses) to
+    // the WebSocket being open, over every successful attempt.
+    std::uint64_t connects = 0;
+    std::uint64_t connect_time_us = 0;
+    std::uint64_t max_connect_us = 0;
+
+    // Keepalive pings sent, pongs matched to them, and pings that were
+    // still unanswered when the next one was due
+    std::uint64_t pings_sent = 0;
+    std::uint64_t pongs_received = 0;
+    std::uint64_t missed_pongs = 0;
+
+    // Outbound queue depth when the snapshot was taken, counting messages
+    // from send() until their write completes
+    std::uint64_t queued_messages = 0;
+    std::uint64_t queued_bytes = 0;
+
+    // Times the queue reached a backpressure high watermark, and the time
+    // spent backpressured, including a stretch still in progress
+    std::uint64_t backpressure_events = 0;
+    std::uint64_t backpressure_time_us = 0;
+
+    // Sums the counters; compression_negotiated stays set if either side has it
+    ConnectionStats& operator+=(const ConnectionStats& other) {
+        messages_sent += other.messages_sent;
+        messages_received += other.messages_received;
+        payload_bytes_sent += other.payload_bytes_sent;
+        payload_bytes_received += other.payload_bytes_received;
+        wire_bytes_sent += other.wire_bytes_sent;
+        wire_bytes_received += other.wire_bytes_received;
+        transport_writes += other.transport_writes;
+        compression_negotiated = compression_negotiated || other.compression_negotiated;
+        tls_full_handshakes += other.tls_full_handshakes;
+        tls_resumed_handshakes += other.tls_resumed_handshakes;
+        reconnects += other.reconnects;
+        connects += other.connects;
+        connect_time_us += other.connect_time_us;
+        max_connect_us = std::max(max_connect_us, other.max_connect_us);
+        pings_sent += other.pings_sent;
+        pongs_received += other.pongs_received;
+        missed_pongs += other.missed_pongs;
+        queued_messages += other.queued_messages;
+        queued_bytes += other.queued_bytes;
+        backpressure_events += other.backpressure_events;
+        backpressure_time_us += other.backpressure_time_us;
+        return *this;
+    }
+};
+
+// Live counters owned by a client. Written on the client's strand, read from
+// anywhere.
+struct ConnectionCounters {
+    std::atomic<std::uint64_t> messages_sent{0};
+    std::atomic<std::uint64_t> messages_received{0};
+    std::atomic<std::uint64_t> payload_bytes_sent{0};
+    std::atomic<std::uint64_t> payload_bytes_received{0};
+    std::atomic<std::uint64_t> wire_bytes_sent{0};
+    std::atomic<std::uint64_t> wire_bytes_received{0};
+    std::atomic<std::uint64_t> transport_writes{0};
+    std::atomic<bool> compression_negotiated{false};
+    std::atomic<std::uint64_t> tls_full_handshakes{0};
+    std::atomic<std::uint64_t> tls_resumed_handshakes{0};
+    std::atomic<std::uint64_t> reconnects{0};
+    std::atomic<std::uint64_t> connects{0};
+    std::atomic<std::uint64_t> connect_time_us{0};
+    std::atomic<std::uint64_t> max_connect_us{0};
+    std::atomic<std::uint64_t> pings_sent{0};
+    std::atomic<std::uint64_t> pongs_received{0};
+    std::atomic<std::uint64_t> missed_pongs{0};
+    std::atomic<std::uint64_t> queued_messages{0};
+    std::atomic<std::uint64_t> queued_bytes{0};
+    std::atomic<std::uint64_t> backpressure_events{0};
+    std::atomic<std::uint64_t> backpressure_time_us{0};
+    std::atomic<std::int64_t> backpressure_since_us{0};  // 0 while not backpressured
+
+    void onSent(std::uint64_t bytes) {
+        messages_sent.fetch_add(1, std::memory_order_relaxed);
+        payload_bytes_sent.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void onReceived(std::uint64_t bytes) {
+        messages_received.fetch_add(1, std::memory_order_relaxed);
+        payload_bytes_received.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    // Streaming reads: a message counts once its last piece has arrived
+    void onReceivedPart(std::uint64_t bytes, bool last) {
+        if (last) {
+            messages_received.fetch_add(1, std::memory_order_relaxed);
+        }
+        payload_bytes_received.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    // Producers add to the queue from any thread; the strand takes away
+    void onQueued(std::uint64_t bytes) {
+        queued_messages.fetch_add(1, std::memory_order_relaxed);
+        queued_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void onDequeued(std::uint64_t bytes) {
+        queued_messages.fetch_sub(1, std::memory_order_relaxed);
+        queued_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    void onBackpressure(bool backpressured) {
+        const std::int64_t now = steadyMicros();
+        if (backpressured) {
+            backpressure_events.fetch_add(1, std::memory_order_relaxed);
+            backpressure_since_us.store(now, std::memory_order_relaxed);
+            return;
+        }
+        const std::int64_t since = backpressure_since_us.exchange(0, std::memory_order_relaxed);
+        if (since > 0) {
+            backpressure_time_us.fetch_add(static_cast<std::uint64_t>(now - since),
+                std::memory_order_relaxed);
+        }
+    }
+
+    void onConnected(std::uint64_t elapsed_us) {
+        connects.fetch_add(1, std::memory_order_relaxed);
+        connect_time_us.fetch_add(elapsed_us, std::memory_order_relaxed);
+        if (elapsed_us > max_connect_us.load(std::memory_order_relaxed)) {
+            max_connect_us.store(elapsed_us, std::memory_order_relaxed);
+        }
+    }
+
+    ConnectionStats snapshot() const {
+        ConnectionStats stats;
+        stats.messages_sent = messages_sent.load(std::memory_order_relaxed);
+        stats.messages_received = messages_received.load(std::memory_order_relaxed);
+        stats.payload_bytes_sent = payload_bytes_sent.load(std::memory_order_relaxed);
+        stats.payload_bytes_received = payload_bytes_received.load(std::memory_order_relaxed);
+        stats.wire_bytes_sent = wire_bytes_sent.load(std::memory_order_relaxed);
+        stats.wire_bytes_received = wire_bytes_received.load(std::memory_order_relaxed);
+        stats.transport_writes = transport_writes.load(std::memory_order_relaxed);
+        stats.compression_negotiated = compression_negotiated.load(std::memory_order_relaxed);
+        stats.tls_full_handshakes = tls_full_handshakes.load(std::memory_order_relaxed);
+        stats.tls_resumed_handshakes = tls_resumed_handshakes.load(std::memory_order_relaxed);
+        stats.reconnects = reconnects.load(std::memory_order_relaxed);
+        stats.connects = connects.load(std::memory_order_relaxed);
+        stats.connect_time_us = connect_time_us.load(std::memory_order_relaxed);
+        stats.max_connect_us = max_connect_us.load(std::memory_order_relaxed);
+        stats.pings_sent = pings_sent.load(std::memory_order_relaxed);
+        stats.pongs_received = pongs_received.load(std::memory_order_relaxed);
+        stats.missed_pongs = missed_pongs.load(std::memory_order_relaxed);
+        stats.queued_messages = queued_messages.load(std::memory_order_relaxed);
+        stats.queued_bytes = queued_bytes.load(std::memory_order_relaxed);
+        stats.backpressure_events = backpressure_events.load(std::memory_order_relaxed);
+        stats.backpressure_time_us = backpressure_time_us.load(std::memory_order_relaxed);
+        const std::int64_t since = backpressure_since_us.load(std::memory_order_relaxed);
+        if (since > 0) {
+            stats.backpressure_time_us += static_cast<std::uint64_t>(steadyMicros() - since);
+        }
+        return stats;
+    }
+
+    static std::int64_t steadyMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+} // namespace websocket_client
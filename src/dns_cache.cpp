@@ -0,0 +1,60 @@
+#include "dns_cache.hpp"
+
+namespace websocket_client {
+
+namespace {
+
+std::string makeKey(const std::string& host, const std::string& port) {
+    return host + ":" + port;
+}
+
+} // namespace
+
+DnsCache::DnsCache(std::chrono::milliseconds ttl)
+    : ttl_(ttl)
+{
+}
+
+std::optional<DnsCache::results_type> DnsCache::lookup(
+    const std::string& host, const std::string& port) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(makeKey(host, port));
+    if (it == entries_.end() || it->second.expires <= std::chrono::steady_clock::now()) {
+        if (it != entries_.end()) {
+            entries_.erase(it);
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return it->second.results;
+}
+
+void DnsCache::store(const std::string& host, const std::string& port, results_type results) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[makeKey(host, port)] = Entry{
+        std::move(results), std::chrono::steady_clock::now() + ttl_};
+}
+
+void DnsCache::invalidate(const std::string& host, const std::string& port) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(makeKey(host, port));
+}
+
+void DnsCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+DnsCache::Stats DnsCache::stats() const {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.entries = entries_.size();
+    return stats;
+}
+
+} // namespace websocket_client
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <boost/asio/ip/tcp.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace websocket_client {
+
+// Resolver results keyed by "host:port", shared by any number of clients so
+// only the first connect to a host pays for the lookup.
+//
+// getaddrinfo does not report record TTLs, so every entry lives for the same
+// configured time. Clients invalidate an entry when none of its addresses
+// accept a connection, which catches moved hosts long before the TTL would.
+// All methods are thread-safe.
+class DnsCache {
+public:
+    using results_type = boost::asio::ip::tcp::resolver::results_type;
+
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::size_t entries = 0;
+    };
+
+    explicit DnsCache(std::chrono::milliseconds ttl = std::chrono::seconds(60));
+
+    DnsCache(const DnsCache&) = delete;
+    DnsCache& operator=(const DnsCache&) = delete;
+
+    // Cached results that have not expired yet
+    std::optional<results_type> lookup(const std::string& host, const std::string& port);
+
+    void store(const std::string& host, const std::string& port, results_type results);
+    void invalidate(const std::string& host, const std::string& port);
+    void clear();
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        results_type results;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    const std::chrono::milliseconds ttl_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+};
+
+} // namespace websocket_client
@@ -0,0 +1,220 @@
+#include "frame_encoder.hpp"
+#include <openssl/rand.h>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WEBSOCKET_CLIENT_MASK_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WEBSOCKET_CLIENT_MASK_NEON 1
+#endif
+
+namespace websocket_client {
+
+namespace {
+
+// The key repeats every 4 bytes, so as long as a kernel only ever steps
+// forward by multiples of 4 the key lines up with the data at every step
+// and a tail of fewer than 4 bytes starts at key[0].
+void maskTail(unsigned char* p, std::size_t n, const MaskKey& key) {
+    for (std::size_t i = 0; i < n; ++i) {
+        p[i] ^= key[i & 3];
+    }
+}
+
+void maskScalar(unsigned char* p, std::size_t n, const MaskKey& key) {
+    std::uint32_t half;
+    std::memcpy(&half, key.data(), sizeof(half));
+    const std::uint64_t wide = (static_cast<std::uint64_t>(half) << 32) | half;
+
+    for (; n >= 8; p += 8, n -= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        word ^= wide;
+        std::memcpy(p, &word, sizeof(word));
+    }
+    maskTail(p, n, key);
+}
+
+#ifdef WEBSOCKET_CLIENT_MASK_X86
+
+__attribute__((target("sse2")))
+void maskSse2(unsigned char* p, std::size_t n, const MaskKey& key) {
+    std::int32_t word;
+    std::memcpy(&word, key.data(), sizeof(word));
+    const __m128i mask = _mm_set1_epi32(word);
+
+    for (; n >= 64; p += 64, n -= 64) {
+        __m128i* v = reinterpret_cast<__m128i*>(p);
+        _mm_storeu_si128(v + 0, _mm_xor_si128(_mm_loadu_si128(v + 0), mask));
+        _mm_storeu_si128(v + 1, _mm_xor_si128(_mm_loadu_si128(v + 1), mask));
+        _mm_storeu_si128(v + 2, _mm_xor_si128(_mm_loadu_si128(v + 2), mask));
+        _mm_storeu_si128(v + 3, _mm_xor_si128(_mm_loadu_si128(v + 3), mask));
+    }
+    for (; n >= 16; p += 16, n -= 16) {
+        __m128i* v = reinterpret_cast<__m128i*>(p);
+        _mm_storeu_si128(v, _mm_xor_si128(_mm_loadu_si128(v), mask));
+    }
+    maskScalar(p, n, key);
+}
+
+__attribute__((target("avx2")))
+void maskAvx2(unsigned char* p, std::size_t n, const MaskKey& key) {
+    std::int32_t word;
+    std::memcpy(&word, key.data(), sizeof(word));
+    const __m256i mask = _mm256_set1_epi32(word);
+
+    for (; n >= 128; p += 128, n -= 128) {
+        __m256i* v = reinterpret_cast<__m256i*>(p);
+        _mm256_storeu_si256(v + 0, _mm256_xor_si256(_mm256_loadu_si256(v + 0), mask));
+        _mm256_storeu_si256(v + 1, _mm256_xor_si256(_mm256_loadu_si256(v + 1), mask));
+        _mm256_storeu_si256(v + 2, _mm256_xor_si256(_mm256_loadu_si256(v + 2), mask));
+        _mm256_storeu_si256(v + 3, _mm256_xor_si256(_mm256_loadu_si256(v + 3), mask));
+    }
+    for (; n >= 32; p += 32, n -= 32) {
+        __m256i* v = reinterpret_cast<__m256i*>(p);
+        _mm256_storeu_si256(v, _mm256_xor_si256(_mm256_loadu_si256(v), mask));
+    }
+    maskScalar(p, n, key);
+}
+
+#endif
+
+#ifdef WEBSOCKET_CLIENT_MASK_NEON
+
+void maskNeon(unsigned char* p, std::size_t n, const MaskKey& key) {
+    std::uint32_t word;
+    std::memcpy(&word, key.data(), sizeof(word));
+    const uint8x16_t mask = vreinterpretq_u8_u32(vdupq_n_u32(word));
+
+    for (; n >= 64; p += 64, n -= 64) {
+        vst1q_u8(p + 0, veorq_u8(vld1q_u8(p + 0), mask));
+        vst1q_u8(p + 16, veorq_u8(vld1q_u8(p + 16), mask));
+        vst1q_u8(p + 32, veorq_u8(vld1q_u8(p + 32), mask));
+        vst1q_u8(p + 48, veorq_u8(vld1q_u8(p + 48), mask));
+    }
+    for (; n >= 16; p += 16, n -= 16) {
+        vst1q_u8(p, veorq_u8(vld1q_u8(p), mask));
+    }
+    maskScalar(p, n, key);
+}
+
+#endif
+
+} // namespace
+
+std::vector<MaskKernel> availableMaskKernels() {
+    std::vector<MaskKernel> kernels{MaskKernel::scalar};
+#ifdef WEBSOCKET_CLIENT_MASK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        kernels.push_back(MaskKernel::sse2);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back(MaskKernel::avx2);
+    }
+#endif
+#ifdef WEBSOCKET_CLIENT_MASK_NEON
+    kernels.push_back(MaskKernel::neon);
+#endif
+    return kernels;
+}
+
+MaskKernel detectMaskKernel() {
+    static const MaskKernel kernel = availableMaskKernels().back();
+    return kernel;
+}
+
+const char* maskKernelName(MaskKernel kernel) {
+    switch (kernel) {
+    case MaskKernel::scalar:
+        return "scalar";
+    case MaskKernel::sse2:
+        return "sse2";
+    case MaskKernel::avx2:
+        return "avx2";
+    case MaskKernel::neon:
+        return "neon";
+    }
+    return "unknown";
+}
+
+void maskInPlace(MaskKernel kernel, char* data, std::size_t size, const MaskKey& key) {
+    auto* p = reinterpret_cast<unsigned char*>(data);
+    switch (kernel) {
+#ifdef WEBSOCKET_CLIENT_MASK_X86
+    case MaskKernel::sse2:
+        return maskSse2(p, size, key);
+    case MaskKernel::avx2:
+        return maskAvx2(p, size, key);
+#endif
+#ifdef WEBSOCKET_CLIENT_MASK_NEON
+    case MaskKernel::neon:
+        return maskNeon(p, size, key);
+#endif
+    default:
+        return maskScalar(p, size, key);
+    }
+}
+
+void maskInPlace(char* data, std::size_t size, const MaskKey& key) {
+    maskInPlace(detectMaskKernel(), data, size, key);
+}
+
+FrameEncoder::FrameEncoder()
+    : next_key_(keys_.size())
+    , kernel_(detectMaskKernel())
+{
+}
+
+MaskKey FrameEncoder::nextKey() {
+    if (next_key_ + sizeof(MaskKey) > keys_.size()) {
+        if (RAND_bytes(keys_.data(), static_cast<int>(keys_.size())) != 1) {
+            throw std::runtime_error("RAND_bytes failed to produce a masking key");
+        }
+        next_key_ = 0;
+    }
+    MaskKey key;
+    std::memcpy(key.data(), keys_.data() + next_key_, key.size());
+    next_key_ += key.size();
+    return key;
+}
+
+FrameEncoder::Header FrameEncoder::encode(bool binary, char* payload, std::size_t size) {
+    const MaskKey key = nextKey();
+    maskInPlace(kernel_, payload, size, key);
+    return header(binary ? 0x2 : 0x1, true, size, key);
+}
+
+FrameEncoder::Header FrameEncoder::header(
+    std::uint8_t opcode, bool fin, std::uint64_t size, const MaskKey& key) {
+
+    Header header;
+    header.key = key;
+    unsigned char* out = header.bytes.data();
+
+    *out++ = static_cast<unsigned char>((fin ? 0x80 : 0x00) | (opcode & 0x0f));
+
+    // Lengths are big-endian, in the smallest of the three forms that fits
+    if (size <= 125) {
+        *out++ = static_cast<unsigned char>(0x80 | size);
+    } else if (size <= 0xffff) {
+        *out++ = 0x80 | 126;
+        *out++ = static_cast<unsigned char>(size >> 8);
+        *out++ = static_cast<unsigned char>(size);
+    } else {
+        *out++ = 0x80 | 127;
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            *out++ = static_cast<unsigned char>(size >> shift);
+        }
+    }
+
+    std::memcpy(out, key.data(), key.size());
+    out += key.size();
+    header.size = static_cast<std::size_t>(out - header.bytes.data());
+    return header;
+}
+
+} // namespace websocket_client
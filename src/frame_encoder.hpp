@@ -0,0 +1,77 @@
+#pragma once
+
+#include <boost/asio/buffer.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace websocket_client {
+
+// Client frames must be XOR-masked with a 4-byte key (RFC 6455 5.3). The
+// kernels below mask a buffer in place; each gives the same result, so
+// which one runs is only a matter of speed.
+enum class MaskKernel {
+    scalar,
+    sse2,
+    avx2,
+    neon
+};
+
+using MaskKey = std::array<unsigned char, 4>;
+
+// Kernels this CPU can run, slowest first. scalar is always there.
+std::vector<MaskKernel> availableMaskKernels();
+
+// The fastest of availableMaskKernels(), detected once
+MaskKernel detectMaskKernel();
+
+const char* maskKernelName(MaskKernel kernel);
+
+// Masks `size` bytes at `data`, which need not be aligned. Masking twice
+// with the same key gives back the original bytes. `kernel` must be one of
+// availableMaskKernels().
+void maskInPlace(MaskKernel kernel, char* data, std::size_t size, const MaskKey& key);
+void maskInPlace(char* data, std::size_t size, const MaskKey& key);
+
+// Builds single-frame client messages for the send path, in place of the
+// websocket stream's own writer. That one masks a byte at a time as it
+// copies the payload through a 4 KiB buffer, and writes the buffer out each
+// time it fills; this one masks the caller's buffer in place with
+// detectMaskKernel() and hands back just the header, so header and payload
+// go out in one gathered write.
+//
+// Keys must not be predictable (RFC 6455 5.3), so they come from OpenSSL's
+// RAND_bytes, drawn a block of keys at a time. Not thread-safe; each client
+// owns one.
+class FrameEncoder {
+public:
+    static constexpr std::size_t max_header_size = 14;
+
+    struct Header {
+        std::array<unsigned char, max_header_size> bytes{};
+        std::size_t size = 0;
+        MaskKey key{};
+
+        boost::asio::const_buffer buffer() const { return boost::asio::buffer(bytes.data(), size); }
+    };
+
+    FrameEncoder();
+
+    // Masks `payload` in place under a fresh key and returns the header of
+    // a final text or binary frame carrying it
+    Header encode(bool binary, char* payload, std::size_t size);
+
+    // Header of a masked client frame with the given opcode (0x0-0xA)
+    static Header header(std::uint8_t opcode, bool fin, std::uint64_t size, const MaskKey& key);
+
+private:
+    MaskKey nextKey();
+
+    // Random bytes not yet used as keys start at next_key_
+    std::array<unsigned char, 256> keys_{};
+    std::size_t next_key_;
+    MaskKernel kernel_;
+};
+
+} // namespace websocket_client
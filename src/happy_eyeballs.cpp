@@ -0,0 +1,177 @@
+#include "happy_eyeballs.hpp"
+#include <boost/asio/error.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <memory>
+#include <optional>
+
+namespace websocket_client {
+
+namespace {
+
+// One race. Everything runs on the caller's executor, which must be a strand
+// (or an io_context run by a single thread).
+class EyeballsRace : public std::enable_shared_from_this<EyeballsRace> {
+public:
+    EyeballsRace(
+        const boost::asio::any_io_executor& executor,
+        std::vector<boost::asio::ip::tcp::endpoint> endpoints,
+        std::chrono::milliseconds attempt_delay,
+        EyeballsHandler handler)
+        : executor_(executor)
+        , endpoints_(std::move(endpoints))
+        , attempt_delay_(attempt_delay)
+        , handler_(std::move(handler))
+        , stagger_(executor)
+        , deadline_(executor)
+    {
+        // Sockets with a connect in flight must not move
+        attempts_.reserve(endpoints_.size());
+    }
+
+    void start(std::chrono::milliseconds timeout) {
+        if (endpoints_.empty()) {
+            last_error_ = boost::asio::error::host_not_found;
+            boost::asio::post(executor_, [self = shared_from_this()]() {
+                self->finish(std::nullopt);
+            });
+            return;
+        }
+
+        deadline_.expires_after(timeout);
+        deadline_.async_wait([self = shared_from_this()](boost::system::error_code ec) {
+            if (!ec) {
+                self->last_error_ = boost::asio::error::timed_out;
+                self->finish(std::nullopt);
+            }
+        });
+
+        startNext();
+    }
+
+private:
+    void startNext() {
+        if (attempts_.size() >= endpoints_.size()) {
+            return;
+        }
+
+        const std::size_t index = attempts_.size();
+        attempts_.emplace_back(executor_);
+        ++pending_;
+
+        attempts_[index].async_connect(endpoints_[index],
+            [self = shared_from_this(), index](boost::system::error_code ec) {
+                self->onAttempt(index, ec);
+            });
+
+        // cancel() cannot recall a wait that has already completed, so each
+        // wait carries the attempt count it was armed at
+        if (attempts_.size() < endpoints_.size()) {
+            stagger_.expires_after(attempt_delay_);
+            stagger_.async_wait([self = shared_from_this(), armed = attempts_.size()](
+                    boost::system::error_code ec) {
+                if (!ec && !self->finished_ && armed == self->attempts_.size()) {
+                    self->startNext();
+                }
+            });
+        }
+    }
+
+    void onAttempt(std::size_t index, boost::system::error_code ec) {
+        --pending_;
+        if (finished_) {
+            return;
+        }
+
+        if (!ec) {
+            finish(index);
+            return;
+        }
+
+        last_error_ = ec;
+        boost::system::error_code ignored;
+        attempts_[index].close(ignored);
+
+        // A failure hands over to the next address without waiting
+        if (attempts_.size() < endpoints_.size()) {
+            stagger_.cancel();
+            startNext();
+        } else if (pending_ == 0) {
+            finish(std::nullopt);
+        }
+    }
+
+    void finish(std::optional<std::size_t> winner) {
+        if (finished_) {
+            return;
+        }
+        finished_ = true;
+        stagger_.cancel();
+        deadline_.cancel();
+
+        boost::system::error_code ignored;
+        for (std::size_t i = 0; i < attempts_.size(); ++i) {
+            if (!winner || i != *winner) {
+                attempts_[i].close(ignored);
+            }
+        }
+
+        if (winner) {
+            handler_({}, std::move(attempts_[*winner]), endpoints_[*winner]);
+        } else {
+            handler_(last_error_, boost::asio::ip::tcp::socket(executor_), {});
+        }
+    }
+
+    boost::asio::any_io_executor executor_;
+    std::vector<boost::asio::ip::tcp::endpoint> endpoints_;
+    std::chrono::milliseconds attempt_delay_;
+    EyeballsHandler handler_;
+    boost::asio::steady_timer stagger_;
+    boost::asio::steady_timer deadline_;
+    std::vector<boost::asio::ip::tcp::socket> attempts_;
+    std::size_t pending_ = 0;
+    bool finished_ = false;
+    boost::system::error_code last_error_;
+};
+
+} // namespace
+
+std::vector<boost::asio::ip::tcp::endpoint> interleaveAddressFamilies(
+    const std::vector<boost::asio::ip::tcp::endpoint>& endpoints) {
+    if (endpoints.empty()) {
+        return {};
+    }
+
+    const bool first_v6 = endpoints.front().address().is_v6();
+    std::vector<boost::asio::ip::tcp::endpoint> preferred;
+    std::vector<boost::asio::ip::tcp::endpoint> other;
+    for (const auto& ep : endpoints) {
+        (ep.address().is_v6() == first_v6 ? preferred : other).push_back(ep);
+    }
+
+    std::vector<boost::asio::ip::tcp::endpoint> ordered;
+    ordered.reserve(endpoints.size());
+    for (std::size_t i = 0; i < preferred.size() || i < other.size(); ++i) {
+        if (i < preferred.size()) {
+            ordered.push_back(preferred[i]);
+        }
+        if (i < other.size()) {
+            ordered.push_back(other[i]);
+        }
+    }
+    return ordered;
+}
+
+void asyncConnectHappyEyeballs(
+    const boost::asio::any_io_executor& executor,
+    const std::vector<boost::asio::ip::tcp::endpoint>& endpoints,
+    std::chrono::milliseconds attempt_delay,
+    std::chrono::milliseconds timeout,
+    EyeballsHandler handler) {
+    std::make_shared<EyeballsRace>(
+        executor, interleaveAddressFamilies(endpoints), attempt_delay, std::move(handler))
+        ->start(timeout);
+}
+
+} // namespace websocket_client
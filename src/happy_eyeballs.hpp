@@ -0,0 +1,40 @@
+#pragma once
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/system/error_code.hpp>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace websocket_client {
+
+// RFC 8305 "Connection Attempt Delay": how long one attempt runs alone
+// before the next address is tried alongside it.
+constexpr std::chrono::milliseconds kConnectionAttemptDelay{250};
+
+using EyeballsHandler = std::function<void(
+    boost::system::error_code ec,
+    boost::asio::ip::tcp::socket socket,
+    boost::asio::ip::tcp::endpoint endpoint)>;
+
+// Reorder addresses so the two families alternate, starting with the family
+// of the first address (RFC 8305 section 4). Order within a family is kept.
+std::vector<boost::asio::ip::tcp::endpoint> interleaveAddressFamilies(
+    const std::vector<boost::asio::ip::tcp::endpoint>& endpoints);
+
+// Staggered parallel connect (RFC 8305). Attempts start attempt_delay
+// apart, or as soon as the previous one fails, and the first socket to
+// connect wins; the rest are closed. A dead address therefore costs one
+// attempt_delay rather than a full connect timeout.
+//
+// `handler` runs on `executor` with the connected socket, or with the last
+// error once every attempt has failed or `timeout` has passed.
+void asyncConnectHappyEyeballs(
+    const boost::asio::any_io_executor& executor,
+    const std::vector<boost::asio::ip::tcp::endpoint>& endpoints,
+    std::chrono::milliseconds attempt_delay,
+    std::chrono::milliseconds timeout,
+    EyeballsHandler handler);
+
+} // namespace websocket_client
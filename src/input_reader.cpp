@@ -0,0 +1,182 @@
+#include "input_reader.hpp"
+#include <boost/asio/error.hpp>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <system_error>
+
+namespace websocket_client {
+
+std::shared_ptr<InputReader> InputReader::openStdin(
+    boost::asio::io_context& ioc, Options options) {
+    // Asio makes the descriptor non-blocking, and a dup would share that
+    // with fd 0 and, on a tty, with the shell. A tty or pipe can be opened
+    // afresh instead; O_NONBLOCK keeps the open from waiting for a writer.
+    struct stat st {};
+    if (fstat(STDIN_FILENO, &st) == 0 && (S_ISCHR(st.st_mode) || S_ISFIFO(st.st_mode))) {
+        const int fd = ::open("/proc/self/fd/0", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd >= 0) {
+            return std::shared_ptr<InputReader>(new InputReader(ioc, fd, options));
+        }
+    }
+
+    // Anything else is shared, so put its flags back when done
+    const int flags = fcntl(STDIN_FILENO, F_GETFL);
+    const int fd = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0);
+    if (flags < 0 || fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "dup stdin");
+    }
+    auto reader = std::shared_ptr<InputReader>(new InputReader(ioc, fd, options));
+    reader->stdin_flags_ = flags;
+    return reader;
+}
+
+std::shared_ptr<InputReader> InputReader::openFile(
+    boost::asio::io_context& ioc, const std::string& path, Options options) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+    }
+    return std::shared_ptr<InputReader>(new InputReader(ioc, fd, options));
+}
+
+// Regular files cannot be registered with epoll; Asio then treats them as
+// always ready, which is what a file is
+InputReader::InputReader(boost::asio::io_context& ioc, int fd, Options options)
+    : input_(ioc, fd)
+    , timer_(ioc)
+    , limiter_(options.rate, options.burst)
+    , options_(options)
+{
+}
+
+InputReader::~InputReader() {
+    if (stdin_flags_ >= 0) {
+        fcntl(STDIN_FILENO, F_SETFL, stdin_flags_);
+    }
+}
+
+void InputReader::start(LineHandler onLine, DoneHandler onDone) {
+    line_handler_ = std::move(onLine);
+    done_handler_ = std::move(onDone);
+    doRead();
+}
+
+void InputReader::stop() {
+    boost::system::error_code ignored;
+    input_.cancel(ignored);
+    timer_.cancel();
+    finish({});
+}
+
+void InputReader::pause() {
+    paused_ = true;
+}
+
+void InputReader::resume() {
+    paused_ = false;
+    if (parked_) {
+        parked_ = false;
+        deliver();
+    }
+}
+
+void InputReader::doRead() {
+    // Drop what has been delivered, then read behind what has not
+    buffer_.erase(0, pending_);
+    pending_ = 0;
+
+    const std::size_t start = buffer_.size();
+    buffer_.resize(start + options_.read_size);
+    input_.async_read_some(
+        boost::asio::buffer(&buffer_[start], options_.read_size),
+        [self = shared_from_this(), start](
+            const boost::system::error_code& ec, std::size_t bytes_transferred) {
+            self->buffer_.resize(start + bytes_transferred);
+            self->onRead(ec, bytes_transferred);
+        });
+}
+
+void InputReader::onRead(const boost::system::error_code& ec, std::size_t) {
+    if (done_) {
+        return;
+    }
+
+    if (ec == boost::asio::error::eof) {
+        // A last line without a newline still counts
+        eof_ = true;
+        if (pending_ < buffer_.size()) {
+            buffer_.push_back('\n');
+        }
+    } else if (ec) {
+        finish(ec);
+        return;
+    }
+
+    deliver();
+}
+
+void InputReader::deliver() {
+    while (!done_) {
+        if (paused_) {
+            parked_ = true;
+            return;
+        }
+
+        const std::size_t end = buffer_.find('\n', pending_);
+        if (end == std::string::npos) {
+            break;
+        }
+
+        const auto wait = limiter_.acquire();
+        if (wait != RateLimiter::Clock::duration::zero()) {
+            // Reading stays paused until the backlog is gone
+            timer_.expires_after(wait);
+            timer_.async_wait(
+                [self = shared_from_this()](const boost::system::error_code& ec) {
+                    self->onTimer(ec);
+                });
+            return;
+        }
+
+        std::string_view line(buffer_.data() + pending_, end - pending_);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        pending_ = end + 1;
+        ++lines_;
+        line_handler_(line);
+    }
+
+    if (done_) {
+        return;
+    }
+
+    if (eof_) {
+        finish({});
+        return;
+    }
+
+    doRead();
+}
+
+void InputReader::onTimer(const boost::system::error_code& ec) {
+    if (ec || done_) {
+        return;
+    }
+    deliver();
+}
+
+void InputReader::finish(const boost::system::error_code& ec) {
+    if (done_) {
+        return;
+    }
+    done_ = true;
+
+    if (done_handler_) {
+        done_handler_(ec);
+    }
+}
+
+} // namespace websocket_client
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "rate_limiter.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/error_code.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace websocket_client {
+
+// Reads newline-separated messages from stdin, a pipe or a file without
+// blocking a thread, for replaying captured request streams.
+//
+// Each wakeup reads up to read_size bytes and hands every complete line in
+// it to the line handler, so throughput is not bound to one syscall per
+// line. With a rate set, lines are paced through a RateLimiter and reading
+// pauses until the backlog has been delivered.
+//
+// All handlers run on the io_context; start() and stop() must be called
+// there as well.
+class InputReader : public std::enable_shared_from_this<InputReader> {
+public:
+    // The view is valid only until the handler returns; a trailing "\r" is
+    // stripped
+    using LineHandler = std::function<void(std::string_view)>;
+    // Called once: at end of input, on a read error or after stop()
+    using DoneHandler = std::function<void(const boost::system::error_code&)>;
+
+    struct Options {
+        double rate = 0;          // lines per second, 0 = as fast as possible
+        std::size_t burst = 1;    // lines allowed back to back
+        std::size_t read_size = 64 * 1024;
+    };
+
+    // Reads stdin through a descriptor of its own where it can, so neither
+    // stdin nor a terminal behind it is left non-blocking
+    static std::shared_ptr<InputReader> openStdin(boost::asio::io_context& ioc, Options options);
+
+    // Throws std::system_error if the file cannot be opened
+    static std::shared_ptr<InputReader> openFile(
+        boost::asio::io_context& ioc, const std::string& path, Options options);
+
+    ~InputReader();
+
+    InputReader(const InputReader&) = delete;
+    InputReader& operator=(const InputReader&) = delete;
+
+    void start(LineHandler onLine, DoneHandler onDone);
+    void stop();
+
+    // Stop handing out lines, and reading, until resume(). Lines already
+    // read stay buffered; a pause from inside the line handler takes
+    // effect before the next line.
+    void pause();
+    void resume();
+
+    std::uint64_t lines() const { return lines_; }
+
+private:
+    InputReader(boost::asio::io_context& ioc, int fd, Options options);
+
+    void doRead();
+    void onRead(const boost::system::error_code& ec, std::size_t bytes_transferred);
+    void deliver();
+    void onTimer(const boost::system::error_code& ec);
+    void finish(const boost::system::error_code& ec);
+
+    boost::asio::posix::stream_descriptor input_;
+    boost::asio::steady_timer timer_;
+    RateLimiter limiter_;
+    Options options_;
+    LineHandler line_handler_;
+    DoneHandler done_handler_;
+
+    // Bytes read but not delivered yet start at pending_
+    std::string buffer_;
+    std::size_t pending_{0};
+    std::uint64_t lines_{0};
+    bool eof_{false};
+    bool done_{false};
+    bool paused_{false};
+    bool parked_{false};  // deliver() returned on a pause; resume() restarts it
+    int stdin_flags_{-1};  // fd 0's flags to restore when reading a dup of it
+};
+
+} // namespace websocket_client
@@ -0,0 +1,67 @@
+#include "io_backend.hpp"
+#include <boost/asio/detail/config.hpp>
+#include <boost/version.hpp>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+#if defined(BOOST_ASIO_HAS_IO_URING) && BOOST_VERSION < 107800
+#error "use_io_uring needs Boost 1.78 or newer"
+#endif
+
+namespace websocket_client {
+
+IoBackend compiledIoBackend() {
+#if defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+    return IoBackend::io_uring;
+#else
+    return IoBackend::epoll;
+#endif
+}
+
+const char* ioBackendName(IoBackend backend) {
+    return backend == IoBackend::io_uring ? "io_uring" : "epoll";
+}
+
+bool kernelSupportsIoUring() {
+#if defined(__NR_io_uring_setup)
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    const long fd = syscall(__NR_io_uring_setup, 1, &params);
+    if (fd < 0) {
+        return false;
+    }
+    close(static_cast<int>(fd));
+    return true;
+#else
+    return false;
+#endif
+}
+
+void execEpollFallbackIfNeeded(char* argv[], const char* epoll_binary) {
+    if (compiledIoBackend() != IoBackend::io_uring || kernelSupportsIoUring()) {
+        return;
+    }
+
+    char self[PATH_MAX];
+    const ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length < 0) {
+        throw std::system_error(errno, std::generic_category(), "readlink /proc/self/exe");
+    }
+
+    std::string path(self, static_cast<std::size_t>(length));
+    path.erase(path.rfind('/') + 1);
+    path += epoll_binary;
+
+    std::cerr << "io_uring is not available; running " << path << std::endl;
+    execv(path.c_str(), argv);
+    throw std::system_error(errno, std::generic_category(), "exec " + path);
+}
+
+} // namespace websocket_client
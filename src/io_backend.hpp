@@ -0,0 +1,27 @@
+#pragma once
+
+namespace websocket_client {
+
+// The reactor Asio was compiled to use for sockets. Builds with the GN arg
+// `use_io_uring` define BOOST_ASIO_HAS_IO_URING and BOOST_ASIO_DISABLE_EPOLL,
+// which makes io_uring the default for all I/O; everything else is epoll.
+enum class IoBackend {
+    epoll,
+    io_uring
+};
+
+IoBackend compiledIoBackend();
+const char* ioBackendName(IoBackend backend);
+
+// True if the running kernel lets this process set up an io_uring. Kernels
+// before 5.1, seccomp profiles and kernel.io_uring_disabled all refuse it.
+bool kernelSupportsIoUring();
+
+// An io_uring build cannot create an io_context on a kernel that refuses
+// io_uring. In that case this replaces the process with `epoll_binary`,
+// found next to the running executable, passing argv through. Returns
+// without doing anything in epoll builds or when io_uring works; throws
+// std::system_error if the exec fails.
+void execEpollFallbackIfNeeded(char* argv[], const char* epoll_binary);
+
+} // namespace websocket_client
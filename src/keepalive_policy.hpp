@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace websocket_client {
+
+// Opt-in application-level pings for the clients.
+//
+// Every `interval` the client sends a ping carrying its send time. The
+// matching pong gives one round-trip sample for the connection's RTT
+// histogram, measured on the same socket as the data and behind it in the
+// same queues.
+//
+// A ping still unanswered when the next one is due counts as missed, and
+// `max_missed` misses in a row fail the connection with a "keepalive"
+// error, so a silent peer is noticed after interval * max_missed rather
+// than the stream's idle timeout. The reconnect policy then applies as for
+// any other drop.
+struct KeepalivePolicy {
+    std::chrono::milliseconds interval{0};  // 0 sends no pings
+    std::size_t max_missed = 2;
+};
+
+} // namespace websocket_client
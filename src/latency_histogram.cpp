@@ -0,0 +1,92 @@
+#include "latency_histogram.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace websocket_client {
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+std::uint64_t LatencyHistogram::bucketHighestValue(std::size_t index) {
+    if (index < (std::size_t{1} << kSubBucketBits)) {
+        return index;
+    }
+
+    const std::uint64_t shift = index / kHalfBucket - 1;
+    const std::uint64_t mantissa = index - shift * kHalfBucket;
+    return (mantissa << shift) + ((std::uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::record(std::uint64_t value) {
+    ++counts_[bucketIndex(value)];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += static_cast<long double>(value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+}
+
+void LatencyHistogram::reset() {
+    counts_.fill(0);
+    count_ = 0;
+    min_ = std::numeric_limits<std::uint64_t>::max();
+    max_ = 0;
+    sum_ = 0;
+}
+
+std::uint64_t LatencyHistogram::min() const {
+    return count_ ? min_ : 0;
+}
+
+double LatencyHistogram::mean() const {
+    return count_ ? static_cast<double>(sum_ / count_) : 0.0;
+}
+
+std::uint64_t LatencyHistogram::percentile(double p) const {
+    if (count_ == 0) {
+        return 0;
+    }
+
+    p = std::clamp(p, 0.0, 100.0);
+    const auto rank = std::max<std::uint64_t>(1,
+        static_cast<std::uint64_t>(std::ceil(p / 100.0 * static_cast<double>(count_))));
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            return std::min(bucketHighestValue(i), max_);
+        }
+    }
+    return max_;
+}
+
+LatencyHistogram AtomicLatencyHistogram::snapshot() const {
+    LatencyHistogram histogram;
+    for (std::size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+        const std::uint64_t count = counts_[i].load(std::memory_order_relaxed);
+        histogram.counts_[i] = count;
+        histogram.count_ += count;
+    }
+    if (histogram.count_ == 0) {
+        return histogram;
+    }
+
+    histogram.sum_ = static_cast<long double>(sum_.load(std::memory_order_relaxed));
+    histogram.max_ = max_.load(std::memory_order_relaxed);
+    histogram.min_ = std::min(min_.load(std::memory_order_relaxed), histogram.max_);
+    return histogram;
+}
+
+} // namespace websocket_client
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace websocket_client {
+
+// Fixed-size log-linear histogram in the style of HdrHistogram.
+//
+// Values (normally nanoseconds) are bucketed with 2^(kSubBucketBits - 1)
+// linear steps per power of two, so any recorded value is reported within
+// about 1.6% of its true value. Values at or above 2^kMaxValueBits (~68 s in
+// nanoseconds) are clamped into the top bucket. Recording is a handful of
+// integer operations and never allocates.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 7;
+    static constexpr unsigned kMaxValueBits = 36;
+
+    LatencyHistogram();
+
+    void record(std::uint64_t value);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    std::uint64_t count() const { return count_; }
+    std::uint64_t min() const;
+    std::uint64_t max() const { return max_; }
+    double mean() const;
+
+    // Value at the given percentile (0..100), reported as the highest value
+    // that falls into the same bucket. Returns 0 when empty.
+    std::uint64_t percentile(double p) const;
+
+private:
+    friend class AtomicLatencyHistogram;
+
+    static constexpr std::uint64_t kHalfBucket = std::uint64_t{1} << (kSubBucketBits - 1);
+    static constexpr std::size_t kBucketCount =
+        (kMaxValueBits - kSubBucketBits + 2) * kHalfBucket;
+
+    static std::size_t bucketIndex(std::uint64_t value) {
+        constexpr std::uint64_t kMaxValue = (std::uint64_t{1} << kMaxValueBits) - 1;
+        value = std::min(value, kMaxValue);
+
+        // Values below 2^kSubBucketBits map one to one
+        if (value < (std::uint64_t{1} << kSubBucketBits)) {
+            return static_cast<std::size_t>(value);
+        }
+
+        // Above that, keep the top kSubBucketBits bits of the value
+        const unsigned magnitude = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        const unsigned shift = magnitude - kSubBucketBits + 1;
+        return static_cast<std::size_t>(shift * kHalfBucket + (value >> shift));
+    }
+
+    static std::uint64_t bucketHighestValue(std::size_t index);
+
+    std::array<std::uint64_t, kBucketCount> counts_;
+    std::uint64_t count_;
+    std::uint64_t min_;
+    std::uint64_t max_;
+    long double sum_;
+};
+
+// LatencyHistogram that one thread records into while others take
+// snapshots of it.
+//
+// record() must only be called from one thread at a time, such as a
+// client's strand. It updates the bucket and totals with relaxed loads and
+// stores instead of read-modify-writes, so it takes a few nanoseconds and
+// never waits. snapshot() may be called from any thread; a value recorded
+// while it runs may be missing from some of the totals.
+class AtomicLatencyHistogram {
+public:
+    void record(std::uint64_t value) {
+        auto& bucket = counts_[LatencyHistogram::bucketIndex(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+        if (value < min_.load(std::memory_order_relaxed)) {
+            min_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    LatencyHistogram snapshot() const;
+
+private:
+    std::array<std::atomic<std::uint64_t>, LatencyHistogram::kBucketCount> counts_{};
+    std::atomic<std::uint64_t> sum_{0};
+    std::atomic<std::uint64_t> min_{std::numeric_limits<std::uint64_t>::max()};
+    std::atomic<std::uint64_t> max_{0};
+};
+
+} // namespace websocket_client
@@ -0,0 +1,341 @@
+#include "load_generator.hpp"
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+namespace websocket_client {
+
+// One generated connection, type-erased over the two client classes
+class LoadGenerator::Connection {
+public:
+    virtual ~Connection() = default;
+
+    virtual void stop() = 0;
+    virtual bool connected() const = 0;
+    virtual std::uint64_t errors() const = 0;
+    virtual ConnectionStats stats() const = 0;
+
+    // Move the round trips recorded so far into `into`
+    virtual void drainRtt(LatencyHistogram& into) = 0;
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Bounds timer wakeups at high rates; each wakeup sends everything due
+constexpr auto kMinTick = std::chrono::milliseconds(1);
+
+// How long stop() waits for the echoes of what was sent before closing
+constexpr auto kEchoGrace = std::chrono::seconds(1);
+
+std::uint64_t nowNs() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count());
+}
+
+std::string makePayload(const LoadOptions& options, std::mt19937& rng) {
+    std::string payload(options.payload_size, 'x');
+
+    if (options.pattern == PayloadPattern::random) {
+        static constexpr char kAlphabet[] =
+            "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+        std::uniform_int_distribution<std::size_t> pick(0, sizeof(kAlphabet) - 2);
+        for (char& c : payload) {
+            c = kAlphabet[pick(rng)];
+        }
+    } else if (options.pattern == PayloadPattern::binary) {
+        std::uniform_int_distribution<int> byte(0, 255);
+        for (char& c : payload) {
+            c = static_cast<char>(byte(rng));
+        }
+    }
+
+    if (options.measure_rtt && payload.size() < LoadGenerator::kTimestampSize) {
+        payload.resize(LoadGenerator::kTimestampSize, 'x');
+    }
+    return payload;
+}
+
+template <class Client>
+class LoadConnection
+    : public LoadGenerator::Connection
+    , public std::enable_shared_from_this<LoadConnection<Client>> {
+public:
+    LoadConnection(
+        std::shared_ptr<Client> client,
+        const LoadOptions& options,
+        std::uint32_t seed)
+        : client_(std::move(client))
+        , timer_(client_->get_executor())
+        , options_(options)
+        , rng_(seed)
+    {
+        payload_ = makePayload(options_, rng_);
+    }
+
+    void start(const std::string& host, const std::string& port, const std::string& target) {
+        // The client holds these handlers, so they must not own us
+        std::weak_ptr<LoadConnection> weak = this->shared_from_this();
+        client_->connect(
+            host,
+            port,
+            target,
+            [weak](std::string_view message, Opcode) {
+                if (auto self = weak.lock()) {
+                    self->onEcho(message);
+                }
+            },
+            [weak](const std::string&) {
+                if (auto self = weak.lock()) {
+                    self->connected_ = false;
+                    self->errors_.fetch_add(1, std::memory_order_relaxed);
+                }
+            },
+            [weak]() {
+                if (auto self = weak.lock()) {
+                    self->onConnected();
+                }
+            });
+    }
+
+    void stop() override {
+        boost::asio::post(
+            client_->get_executor(),
+            [self = this->shared_from_this()]() {
+                self->stopped_ = true;
+                self->closeWhenAnswered(Clock::now() + kEchoGrace);
+            });
+    }
+
+    bool connected() const override {
+        return connected_;
+    }
+
+    std::uint64_t errors() const override {
+        return errors_.load(std::memory_order_relaxed);
+    }
+
+    ConnectionStats stats() const override {
+        return client_->stats();
+    }
+
+    void drainRtt(LatencyHistogram& into) override {
+        std::lock_guard<std::mutex> lock(rtt_mutex_);
+        into.merge(rtt_);
+        rtt_.reset();
+    }
+
+private:
+    void onConnected() {
+        connected_ = true;
+
+        // After a reconnect the schedule simply carries on
+        if (started_ || stopped_) {
+            return;
+        }
+        started_ = true;
+        start_ = Clock::now();
+        tick();
+    }
+
+    void tick() {
+        if (stopped_ || (!connected_ && !options_.reconnect.enabled)) {
+            return;
+        }
+
+        const auto now = Clock::now();
+        const double elapsed = std::chrono::duration<double>(now - start_).count();
+        const auto due = static_cast<std::uint64_t>(elapsed * options_.rate);
+
+        // Never burst more than a second's worth to catch up
+        const auto backlog_cap = std::max<std::uint64_t>(
+            1, static_cast<std::uint64_t>(options_.rate));
+        if (due > sent_ + backlog_cap) {
+            sent_ = due - backlog_cap;
+        }
+
+        while (sent_ < due) {
+            sendOne();
+            ++sent_;
+        }
+
+        const auto next_due = start_ + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(sent_ + 1) / options_.rate));
+        timer_.expires_at(std::max(next_due, now + kMinTick));
+        timer_.async_wait(
+            [self = this->shared_from_this()](const boost::system::error_code& ec) {
+                if (!ec) {
+                    self->tick();
+                }
+            });
+    }
+
+    // Closing discards whatever arrives after the close frame goes out, so
+    // give echoes still in flight a chance to land first. A server that has
+    // not answered anything, such as a sink, is not waited for.
+    void closeWhenAnswered(Clock::time_point deadline) {
+        const ConnectionStats stats = client_->stats();
+        const bool answered = stats.queued_messages == 0
+            && stats.messages_received >= stats.messages_sent;
+        if (answered || stats.messages_received == 0 || !connected_
+            || Clock::now() >= deadline) {
+            timer_.cancel();
+            client_->close();
+            return;
+        }
+
+        timer_.expires_after(kMinTick);
+        timer_.async_wait(
+            [self = this->shared_from_this(), deadline](const boost::system::error_code& ec) {
+                if (!ec) {
+                    self->closeWhenAnswered(deadline);
+                }
+            });
+    }
+
+    void sendOne() {
+        if (options_.measure_rtt) {
+            char stamp[LoadGenerator::kTimestampSize + 1];
+            std::snprintf(stamp, sizeof(stamp), "%020llu",
+                static_cast<unsigned long long>(nowNs()));
+            std::memcpy(&payload_[0], stamp, LoadGenerator::kTimestampSize);
+        }
+
+        if (options_.pattern == PayloadPattern::binary) {
+            client_->sendBinary(std::vector<uint8_t>(payload_.begin(), payload_.end()));
+        } else {
+            client_->send(payload_);
+        }
+    }
+
+    void onEcho(std::string_view message) {
+        if (!options_.measure_rtt || message.size() < LoadGenerator::kTimestampSize) {
+            return;
+        }
+
+        std::uint64_t sent_ns = 0;
+        const char* begin = message.data();
+        const char* end = begin + LoadGenerator::kTimestampSize;
+        const auto parsed = std::from_chars(begin, end, sent_ns);
+        const std::uint64_t now = nowNs();
+        if (parsed.ec != std::errc() || parsed.ptr != end || sent_ns > now) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(rtt_mutex_);
+        rtt_.record(now - sent_ns);
+    }
+
+    std::shared_ptr<Client> client_;
+    boost::asio::steady_timer timer_;
+    const LoadOptions options_;
+    std::mt19937 rng_;
+    std::string payload_;
+
+    // Owned by the client's strand
+    Clock::time_point start_;
+    std::uint64_t sent_{0};
+    bool started_{false};
+    bool stopped_{false};
+
+    std::atomic<bool> connected_{false};
+    std::atomic<std::uint64_t> errors_{0};
+
+    // Written on the strand, drained by takeSnapshot()
+    std::mutex rtt_mutex_;
+    LatencyHistogram rtt_;
+};
+
+} // namespace
+
+LoadGenerator::LoadGenerator(ConnectionManager& manager, LoadOptions options)
+    : manager_(manager)
+    , options_(std::move(options))
+{
+}
+
+LoadGenerator::~LoadGenerator() {
+    stop();
+}
+
+void LoadGenerator::start(
+    const std::string& host, const std::string& port, const std::string& target) {
+    std::random_device seeds;
+    for (std::size_t i = 0; i < options_.connections; ++i) {
+        auto client = manager_.createPlainClient();
+        client->setCompression(options_.compression);
+        client->setReconnectPolicy(options_.reconnect);
+        client->setKeepalive(options_.keepalive);
+        client->setWriteBatching(options_.write_batch);
+        client->setFrameEncoder(options_.frame_encoder);
+        client->setTracer(options_.tracer);
+
+        auto connection = std::make_shared<LoadConnection<WebSocketClientPlain>>(
+            std::move(client), options_, seeds());
+        connections_.push_back(connection);
+        connection->start(host, port, target);
+    }
+}
+
+void LoadGenerator::start(
+    const std::string& host, const std::string& port, const std::string& target,
+    boost::asio::ssl::context& ssl_ctx, std::shared_ptr<TlsSessionCache> session_cache) {
+    std::random_device seeds;
+    for (std::size_t i = 0; i < options_.connections; ++i) {
+        auto client = manager_.createClient(ssl_ctx);
+        client->setCompression(options_.compression);
+        client->setReconnectPolicy(options_.reconnect);
+        client->setKeepalive(options_.keepalive);
+        client->setWriteBatching(options_.write_batch);
+        client->setFrameEncoder(options_.frame_encoder);
+        client->setTracer(options_.tracer);
+        client->setSessionCache(session_cache);
+
+        auto connection = std::make_shared<LoadConnection<WebSocketClient>>(
+            std::move(client), options_, seeds());
+        connections_.push_back(connection);
+        connection->start(host, port, target);
+    }
+}
+
+void LoadGenerator::stop() {
+    if (stopped_) {
+        return;
+    }
+    stopped_ = true;
+
+    for (const auto& connection : connections_) {
+        connection->stop();
+    }
+}
+
+LoadGenerator::Snapshot LoadGenerator::takeSnapshot() {
+    Snapshot snapshot;
+    for (const auto& connection : connections_) {
+        if (connection->connected()) {
+            ++snapshot.connected;
+        }
+        snapshot.errors += connection->errors();
+        snapshot.totals += connection->stats();
+        connection->drainRtt(snapshot.rtt);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    total_rtt_.merge(snapshot.rtt);
+    return snapshot;
+}
+
+LatencyHistogram LoadGenerator::totalRtt() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_rtt_;
+}
+
+} // namespace websocket_client
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "connection_manager.hpp"
+#include "connection_stats.hpp"
+#include "latency_histogram.hpp"
+#include "load_options.hpp"
+#include "tls_session_cache.hpp"
+#include <boost/asio/ssl/context.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace websocket_client {
+
+// Opens a fleet of connections through a ConnectionManager and has each one
+// send at a fixed rate, so one process can stand in for many scripted
+// clients.
+//
+// Every connection is paced by a timer on its client's strand, which sends
+// whatever the schedule says is due; one that has fallen behind sends at
+// most a second's worth at once to catch up. Echo round trips go into
+// per-connection histograms that takeSnapshot() drains.
+class LoadGenerator {
+public:
+    // Send time in nanoseconds, as 20 decimal digits leading the payload
+    static constexpr std::size_t kTimestampSize = 20;
+
+    struct Snapshot {
+        std::size_t connected = 0;
+        std::uint64_t errors = 0;
+        ConnectionStats totals;   // cumulative, summed over connections
+        LatencyHistogram rtt;     // round trips since the previous snapshot
+    };
+
+    class Connection;
+
+    // `manager` must outlive the generator
+    LoadGenerator(ConnectionManager& manager, LoadOptions options);
+    ~LoadGenerator();
+
+    LoadGenerator(const LoadGenerator&) = delete;
+    LoadGenerator& operator=(const LoadGenerator&) = delete;
+
+    // Plain connections
+    void start(const std::string& host, const std::string& port, const std::string& target);
+
+    // TLS connections through `ssl_ctx`, which must outlive the generator
+    void start(const std::string& host, const std::string& port, const std::string& target,
+               boost::asio::ssl::context& ssl_ctx,
+               std::shared_ptr<TlsSessionCache> session_cache = nullptr);
+
+    // Stop sending and close every connection once its queue has drained
+    // and the echoes of what it sent are in, waiting at most a second.
+    // start() and stop() must be called from the same thread.
+    void stop();
+
+    // Thread-safe against the connections; call from the thread that
+    // called start()
+    Snapshot takeSnapshot();
+    LatencyHistogram totalRtt() const;
+
+private:
+    ConnectionManager& manager_;
+    LoadOptions options_;
+    std::vector<std::shared_ptr<Connection>> connections_;
+    bool stopped_{false};
+
+    mutable std::mutex mutex_;
+    LatencyHistogram total_rtt_;
+};
+
+} // namespace websocket_client
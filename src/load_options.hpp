@@ -0,0 +1,40 @@
+#pragma once
+
+#include "compression_options.hpp"
+#include "keepalive_policy.hpp"
+#include "reconnect_policy.hpp"
+#include "trace_recorder.hpp"
+#include "write_batch_options.hpp"
+#include <cstddef>
+#include <memory>
+
+namespace websocket_client {
+
+// What each generated message carries after the optional timestamp
+enum class PayloadPattern {
+    fill,    // 'x' repeated
+    random,  // random printable text, drawn once per connection
+    binary   // random bytes, sent as binary frames
+};
+
+struct LoadOptions {
+    std::size_t connections = 1;
+    double rate = 10;              // messages per second per connection
+    std::size_t payload_size = 64;
+    PayloadPattern pattern = PayloadPattern::fill;
+
+    // Stamp every message with its send time and time the echo. Needs an
+    // echoing server; payloads grow to hold the 20-digit stamp if needed.
+    bool measure_rtt = false;
+
+    CompressionOptions compression;
+    ReconnectPolicy reconnect;
+    KeepalivePolicy keepalive;
+    WriteBatchOptions write_batch;
+    bool frame_encoder = false;
+
+    // Connections record their lifecycles here when set
+    std::shared_ptr<TraceRecorder> tracer;
+};
+
+} // namespace websocket_client
@@ -0,0 +1,314 @@
+#include "local_server.hpp"
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/websocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <stdexcept>
+#include <type_traits>
+
+namespace websocket_client {
+
+namespace {
+
+using PlainStream = boost::beast::tcp_stream;
+using SecureStream = boost::beast::ssl_stream<boost::beast::tcp_stream>;
+
+template <class Stream>
+class ServerSession : public std::enable_shared_from_this<ServerSession<Stream>> {
+public:
+    static constexpr bool kSecure = std::is_same<Stream, SecureStream>::value;
+    static constexpr std::size_t kSinkReadSize = 64 * 1024;
+
+    // Plain sessions take the socket only, TLS sessions also the context
+    template <class... Args>
+    ServerSession(
+        const LocalServer::Options& options,
+        std::shared_ptr<LocalServer::Counters> counters,
+        Args&&... args)
+        : ws_(std::forward<Args>(args)...)
+        , options_(options)
+        , counters_(std::move(counters))
+        , flood_sent_(0)
+    {
+    }
+
+    void run() {
+        boost::asio::dispatch(
+            ws_.get_executor(),
+            boost::beast::bind_front_handler(
+                &ServerSession::onRun,
+                this->shared_from_this()));
+    }
+
+private:
+    void onRun() {
+        if constexpr (kSecure) {
+            boost::beast::get_lowest_layer(ws_).expires_after(std::chrono::seconds(30));
+            ws_.next_layer().async_handshake(
+                boost::asio::ssl::stream_base::server,
+                boost::beast::bind_front_handler(
+                    &ServerSession::onTlsHandshake,
+                    this->shared_from_this()));
+        } else {
+            doAccept();
+        }
+    }
+
+    void onTlsHandshake(boost::beast::error_code ec) {
+        if (ec) {
+            return;
+        }
+        doAccept();
+    }
+
+    void doAccept() {
+        boost::beast::get_lowest_layer(ws_).expires_never();
+
+        ws_.set_option(
+            boost::beast::websocket::stream_base::timeout::suggested(
+                boost::beast::role_type::server));
+
+        if (options_.mode == LocalServer::Mode::sink) {
+            ws_.read_message_max(0);
+        }
+
+        if (options_.compression.enabled) {
+            auto pmd = toPermessageDeflate(options_.compression);
+            pmd.server_enable = true;
+            pmd.client_enable = false;
+            ws_.set_option(pmd);
+        }
+
+        ws_.async_accept(
+            boost::beast::bind_front_handler(
+                &ServerSession::onAccept,
+                this->shared_from_this()));
+    }
+
+    void onAccept(boost::beast::error_code ec) {
+        if (ec) {
+            return;
+        }
+
+        counters_->connections.fetch_add(1, std::memory_order_relaxed);
+
+        if (options_.mode == LocalServer::Mode::flood) {
+            flood_payload_.assign(options_.flood_message_size, 'x');
+            ws_.binary(options_.flood_binary);
+            doFlood();
+        }
+
+        doRead();
+    }
+
+    void doRead() {
+        if (options_.mode == LocalServer::Mode::sink) {
+            // Discard as it arrives so message size is not bounded by memory
+            ws_.async_read_some(
+                buffer_,
+                kSinkReadSize,
+                boost::beast::bind_front_handler(
+                    &ServerSession::onRead,
+                    this->shared_from_this()));
+            return;
+        }
+
+        ws_.async_read(
+            buffer_,
+            boost::beast::bind_front_handler(
+                &ServerSession::onRead,
+                this->shared_from_this()));
+    }
+
+    void onRead(boost::beast::error_code ec, std::size_t bytes_transferred) {
+        if (ec) {
+            return;
+        }
+
+        if (ws_.is_message_done()) {
+            counters_->messages_received.fetch_add(1, std::memory_order_relaxed);
+        }
+        counters_->bytes_received.fetch_add(bytes_transferred, std::memory_order_relaxed);
+
+        if (options_.mode == LocalServer::Mode::echo) {
+            // The next read starts once the echo has gone out
+            ws_.binary(ws_.got_binary());
+            ws_.async_write(
+                buffer_.data(),
+                boost::beast::bind_front_handler(
+                    &ServerSession::onEcho,
+                    this->shared_from_this()));
+            return;
+        }
+
+        buffer_.consume(buffer_.size());
+        doRead();
+    }
+
+    void onEcho(boost::beast::error_code ec, std::size_t bytes_transferred) {
+        if (ec) {
+            return;
+        }
+
+        counters_->messages_sent.fetch_add(1, std::memory_order_relaxed);
+        counters_->bytes_sent.fetch_add(bytes_transferred, std::memory_order_relaxed);
+
+        buffer_.consume(buffer_.size());
+        doRead();
+    }
+
+    void doFlood() {
+        if (options_.flood_count != 0 && flood_sent_ >= options_.flood_count) {
+            return;
+        }
+
+        ws_.async_write(
+            boost::asio::buffer(flood_payload_),
+            boost::beast::bind_front_handler(
+                &ServerSession::onFlood,
+                this->shared_from_this()));
+    }
+
+    void onFlood(boost::beast::error_code ec, std::size_t bytes_transferred) {
+        if (ec) {
+            return;
+        }
+
+        ++flood_sent_;
+        counters_->messages_sent.fetch_add(1, std::memory_order_relaxed);
+        counters_->bytes_sent.fetch_add(bytes_transferred, std::memory_order_relaxed);
+        doFlood();
+    }
+
+    boost::beast::websocket::stream<Stream> ws_;
+    boost::beast::flat_buffer buffer_;
+    const LocalServer::Options& options_;
+    std::shared_ptr<LocalServer::Counters> counters_;
+    std::string flood_payload_;
+    std::uint64_t flood_sent_;
+};
+
+} // namespace
+
+LocalServer::LocalServer(Options options)
+    : options_(std::move(options))
+    , ioc_(static_cast<int>(options_.threads))
+    , ssl_ctx_(options_.secure
+        ? makeSelfSignedServerContext()
+        : boost::asio::ssl::context(boost::asio::ssl::context::tls_server))
+    , acceptor_(boost::asio::make_strand(ioc_))
+    , counters_(std::make_shared<Counters>())
+    , port_(0)
+{
+}
+
+LocalServer::~LocalServer() {
+    stop();
+}
+
+void LocalServer::start() {
+    const boost::asio::ip::tcp::endpoint endpoint(
+        boost::asio::ip::make_address(options_.address), options_.port);
+
+    acceptor_.open(endpoint.protocol());
+    acceptor_.set_option(boost::asio::socket_base::reuse_address(true));
+    acceptor_.bind(endpoint);
+    acceptor_.listen(boost::asio::socket_base::max_listen_connections);
+    port_ = acceptor_.local_endpoint().port();
+
+    doAccept();
+
+    const std::size_t threads = options_.threads ? options_.threads : 1;
+    for (std::size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back([this]() {
+            ioc_.run();
+        });
+    }
+}
+
+void LocalServer::stop() {
+    ioc_.stop();
+    for (auto& t : threads_) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+    threads_.clear();
+}
+
+LocalServer::Stats LocalServer::stats() const {
+    Stats stats;
+    stats.connections = counters_->connections.load(std::memory_order_relaxed);
+    stats.messages_received = counters_->messages_received.load(std::memory_order_relaxed);
+    stats.bytes_received = counters_->bytes_received.load(std::memory_order_relaxed);
+    stats.messages_sent = counters_->messages_sent.load(std::memory_order_relaxed);
+    stats.bytes_sent = counters_->bytes_sent.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void LocalServer::doAccept() {
+    acceptor_.async_accept(
+        boost::asio::make_strand(ioc_),
+        [this](boost::beast::error_code ec, boost::asio::ip::tcp::socket socket) {
+            if (ec) {
+                if (ec == boost::asio::error::operation_aborted) {
+                    return;
+                }
+            } else {
+                // Echo latency should not include Nagle's delay
+                socket.set_option(boost::asio::ip::tcp::no_delay(true), ec);
+
+                if (options_.secure) {
+                    std::make_shared<ServerSession<SecureStream>>(
+                        options_, counters_, std::move(socket), ssl_ctx_)->run();
+                } else {
+                    std::make_shared<ServerSession<PlainStream>>(
+                        options_, counters_, std::move(socket))->run();
+                }
+            }
+
+            doAccept();
+        });
+}
+
+boost::asio::ssl::context makeSelfSignedServerContext() {
+    boost::asio::ssl::context ctx(boost::asio::ssl::context::tls_server);
+
+    std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(
+        EVP_PKEY_Q_keygen(nullptr, nullptr, "EC", "P-256"), &EVP_PKEY_free);
+    std::unique_ptr<X509, decltype(&X509_free)> cert(X509_new(), &X509_free);
+    if (!key || !cert) {
+        throw std::runtime_error("Self-signed certificate: key generation failed");
+    }
+
+    X509_set_version(cert.get(), 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert.get()), 60L * 60 * 24 * 365);
+    X509_set_pubkey(cert.get(), key.get());
+
+    X509_NAME* name = X509_get_subject_name(cert.get());
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+        reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert.get(), name);
+
+    if (!X509_sign(cert.get(), key.get(), EVP_sha256())
+        || SSL_CTX_use_certificate(ctx.native_handle(), cert.get()) != 1
+        || SSL_CTX_use_PrivateKey(ctx.native_handle(), key.get()) != 1) {
+        throw std::runtime_error("Self-signed certificate: signing failed");
+    }
+
+    // Allow both session IDs and tickets so clients can resume
+    static const unsigned char kSessionContext[] = "websocket_client_local_server";
+    SSL_CTX_set_session_id_context(ctx.native_handle(),
+        kSessionContext, sizeof(kSessionContext) - 1);
+    SSL_CTX_set_session_cache_mode(ctx.native_handle(), SSL_SESS_CACHE_SERVER);
+
+    return ctx;
+}
+
+} // namespace websocket_client
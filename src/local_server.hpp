@@ -0,0 +1,97 @@
+#pragma once
+
+#include "compression_options.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+
+// Self-contained Beast WebSocket server for tests and benchmarks, so client
+// behaviour can be measured on loopback instead of against public echo
+// servers.
+//
+//   echo  - every message is written back with the same frame type
+//   flood - after the handshake, writes flood_count messages of
+//           flood_message_size bytes as fast as the socket allows
+//           (0 = until the client goes away); incoming messages are dropped
+//   sink  - reads and discards everything, piece by piece, so messages of
+//           any size are accepted
+//
+// With `secure` set the server speaks wss using a freshly generated
+// self-signed certificate, so clients must not verify the peer.
+class LocalServer {
+public:
+    enum class Mode {
+        echo,
+        flood,
+        sink
+    };
+
+    struct Options {
+        Mode mode = Mode::echo;
+        bool secure = false;
+        std::string address = "127.0.0.1";
+        unsigned short port = 0;  // 0 picks a free port
+        std::size_t threads = 1;
+        std::size_t flood_message_size = 64;
+        std::uint64_t flood_count = 0;
+        bool flood_binary = false;
+        CompressionOptions compression;
+    };
+
+    struct Stats {
+        std::uint64_t connections = 0;
+        std::uint64_t messages_received = 0;
+        std::uint64_t bytes_received = 0;
+        std::uint64_t messages_sent = 0;
+        std::uint64_t bytes_sent = 0;
+    };
+
+    // Shared with sessions, which may outlive a stop() by a few handlers
+    struct Counters {
+        std::atomic<std::uint64_t> connections{0};
+        std::atomic<std::uint64_t> messages_received{0};
+        std::atomic<std::uint64_t> bytes_received{0};
+        std::atomic<std::uint64_t> messages_sent{0};
+        std::atomic<std::uint64_t> bytes_sent{0};
+    };
+
+    explicit LocalServer(Options options);
+    ~LocalServer();
+
+    LocalServer(const LocalServer&) = delete;
+    LocalServer& operator=(const LocalServer&) = delete;
+
+    // Bind, listen and start the worker threads. Throws on bind failure.
+    void start();
+    void stop();
+
+    unsigned short port() const { return port_; }
+    const Options& options() const { return options_; }
+    Stats stats() const;
+
+private:
+    void doAccept();
+
+    Options options_;
+    boost::asio::io_context ioc_;
+    boost::asio::ssl::context ssl_ctx_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    std::shared_ptr<Counters> counters_;
+    std::vector<std::thread> threads_;
+    unsigned short port_;
+};
+
+// Server-side TLS context with a new self-signed P-256 certificate for
+// "localhost". Enables session resumption so reconnect paths can be
+// benchmarked.
+boost::asio::ssl::context makeSelfSignedServerContext();
+
+} // namespace websocket_client
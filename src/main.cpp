@@ -1,27 +1,424 @@
+#include "capture_log.hpp"
 #include "cli_handler.hpp"
+#include "connection_manager.hpp"
+#include "input_reader.hpp"
+#include "io_backend.hpp"
+#include "load_generator.hpp"
 #include "websocket_client.hpp"
 #include "websocket_client_plain.hpp"
 #include "message_handler.hpp"
+#include "output_writer.hpp"
+#include "tls_session_cache.hpp"
+#include "trace_recorder.hpp"
+#include <boost/asio/executor_work_guard.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/ssl/context.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
 #include <iostream>
+#include <mutex>
 #include <string>
-#include <thread>
+#include <string_view>
 #include <memory>
+#include <thread>
+
+namespace {
+
+void printLatency(const websocket_client::MessageLatency& latency) {
+    const auto line = [](const char* stage, const websocket_client::LatencyHistogram& histogram) {
+        std::fprintf(stderr, "%-12s %10.1f %10.1f %10.1f %10.1f %12llu\n",
+            stage,
+            static_cast<double>(histogram.percentile(50.0)) / 1e3,
+            static_cast<double>(histogram.percentile(99.0)) / 1e3,
+            static_cast<double>(histogram.percentile(99.9)) / 1e3,
+            static_cast<double>(histogram.max()) / 1e3,
+            static_cast<unsigned long long>(histogram.count()));
+    };
+
+    std::fprintf(stderr, "%-12s %10s %10s %10s %10s %12s\n",
+        "latency", "p50(us)", "p99(us)", "p99.9(us)", "max(us)", "messages");
+    line("delivery", latency.delivery);
+    line("handler", latency.handler);
+    line("queue wait", latency.queue_wait);
+    line("write", latency.write);
+}
+
+// --latency-report: prints the manager's latency histograms, which cover
+// the whole run so far, to stderr every `interval` from a thread of its own
+class LatencyReporter {
+public:
+    LatencyReporter(const websocket_client::ConnectionManager& manager, std::chrono::seconds interval)
+        : thread_([this, &manager, interval]() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!cv_.wait_for(lock, interval, [this]() { return stop_; })) {
+                printLatency(manager.latency());
+            }
+        })
+    {
+    }
+
+    ~LatencyReporter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+// Connects `client` and sends every input line as one message, reading
+// stdin or --input-file on the main thread's own io_context. The client's
+// handlers refer to locals here, so the manager is stopped before
+// returning. Received messages are also appended to `capture`, if set.
+// Returns the process exit code.
+template <class Client>
+int runClient(
+    const std::shared_ptr<Client>& client,
+    const websocket_client::CLIHandler& cli,
+    websocket_client::MessageHandler& msg_handler,
+    websocket_client::ConnectionManager& manager,
+    websocket_client::CaptureLog* capture) {
+
+    websocket_client::InputReader::Options input_options;
+    input_options.rate = cli.getRate();
+    input_options.burst = cli.getBurst();
+
+    boost::asio::io_context input_ioc;
+    auto input_work = boost::asio::make_work_guard(input_ioc);
+    auto reader = cli.getInputFile().empty()
+        ? websocket_client::InputReader::openStdin(input_ioc, input_options)
+        : websocket_client::InputReader::openFile(input_ioc, cli.getInputFile(), input_options);
+
+    std::unique_ptr<LatencyReporter> latency_reporter;
+    if (cli.getLatencyReportInterval() > 0) {
+        latency_reporter = std::make_unique<LatencyReporter>(
+            manager, std::chrono::seconds(cli.getLatencyReportInterval()));
+    }
+
+    std::atomic<bool> failed{false};
+    std::mutex drain_mutex;
+    std::condition_variable drain_wakeup;
+    std::uint64_t sent = 0;
+    bool input_started = false;
+
+    // Runs on input_ioc: stop reading and let run() return
+    const auto end_input = [&]() {
+        reader->stop();
+        input_work.reset();
+    };
+
+    // Hold input back while the server is not keeping up with it
+    client->setBackpressure(cli.getBackpressurePolicy(), [&](bool backpressured) {
+        boost::asio::post(input_ioc, [&reader, backpressured]() {
+            if (backpressured) {
+                reader->pause();
+            } else {
+                reader->resume();
+            }
+        });
+    });
+
+    client->connect(
+        cli.getHost(),
+        cli.getPort(),
+        cli.getTarget(),
+        [&msg_handler, capture](std::string_view msg, websocket_client::Opcode opcode) {
+            if (capture) {
+                capture->append(0, opcode, msg);
+            }
+            msg_handler.handleMessage(msg);
+        },
+        [&](const std::string& error) {
+            std::cerr << "Error: " << error << std::endl;
+
+            // Without reconnect, and once reconnect gives up, nothing more
+            // can be sent
+            if (!client->canSend()) {
+                {
+                    std::lock_guard<std::mutex> lock(drain_mutex);
+                    failed = true;
+                }
+                drain_wakeup.notify_all();
+                boost::asio::post(input_ioc, end_input);
+            }
+        },
+        [&]() {
+            // Start reading once the first handshake is done, so replayed
+            // lines are not refused before the connection is up. Reconnects
+            // call this again; the reader just carries on.
+            boost::asio::post(input_ioc, [&]() {
+                if (input_started) {
+                    return;
+                }
+                input_started = true;
+
+                reader->start(
+                    [&](std::string_view line) {
+                        if (line == "quit" || line == "exit") {
+                            end_input();
+                            return;
+                        }
+                        client->send(msg_handler.formatMessage(std::string(line)));
+                        ++sent;
+                    },
+                    [&](const boost::system::error_code& ec) {
+                        if (ec) {
+                            std::cerr << "Input error: " << ec.message() << std::endl;
+                        }
+                        input_work.reset();
+                    });
+            });
+        }
+    );
+
+    input_ioc.run();
+
+    // Replayed input can be far ahead of the socket; let the queue drain
+    // before closing. Writes complete without a callback, so progress is
+    // checked every 10 ms, but a client that can no longer send ends the
+    // wait at once: it wakes us through the error handler, and canSend()
+    // covers an error reported before we got here.
+    {
+        std::unique_lock<std::mutex> lock(drain_mutex);
+        while (!failed && client->canSend() && client->stats().messages_sent < sent) {
+            drain_wakeup.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+    // Clean shutdown
+    client->close();
+    manager.stop();
+
+    if (latency_reporter) {
+        latency_reporter.reset();
+        printLatency(client->latency());
+    }
+
+    const auto stats = client->stats();
+    const auto rtt = client->pingRtt();
+    if (rtt.count() > 0) {
+        std::fprintf(stderr, "ping rtt(us): p50 %.1f  p99 %.1f  max %.1f  (%llu pongs, %llu missed)\n",
+            static_cast<double>(rtt.percentile(50.0)) / 1e3,
+            static_cast<double>(rtt.percentile(99.0)) / 1e3,
+            static_cast<double>(rtt.max()) / 1e3,
+            static_cast<unsigned long long>(stats.pongs_received),
+            static_cast<unsigned long long>(stats.missed_pongs));
+    }
+
+    if (stats.backpressure_events > 0) {
+        std::cerr << "Input was held back " << stats.backpressure_events << " times for "
+                  << stats.backpressure_time_us / 1000 << " ms in total" << std::endl;
+    }
+    return failed ? 1 : 0;
+}
+
+// --trace-file: called once the connections have stopped recording
+void writeTrace(const websocket_client::TraceRecorder& tracer, const std::string& path) {
+    tracer.writeFile(path);
+    const auto stats = tracer.stats();
+    std::cerr << "Traced " << stats.spans << " spans to " << path;
+    if (stats.dropped > 0) {
+        std::cerr << ", dropped " << stats.dropped;
+    }
+    std::cerr << std::endl;
+}
+
+void printLoadHeader() {
+    std::printf("%8s %7s %10s %10s %10s %8s %10s %10s %10s\n",
+        "time(s)", "conns", "sent/s", "recv/s", "MB/s out", "errors",
+        "p50(us)", "p99(us)", "p99.9(us)");
+}
+
+void printLoadLine(double elapsed, const websocket_client::LoadGenerator::Snapshot& now,
+                   const websocket_client::ConnectionStats& before, double seconds) {
+    const auto& rtt = now.rtt;
+    std::printf("%8.1f %7zu %10.0f %10.0f %10.2f %8llu %10.1f %10.1f %10.1f\n",
+        elapsed,
+        now.connected,
+        static_cast<double>(now.totals.messages_sent - before.messages_sent) / seconds,
+        static_cast<double>(now.totals.messages_received - before.messages_received) / seconds,
+        static_cast<double>(now.totals.payload_bytes_sent - before.payload_bytes_sent) / seconds / 1e6,
+        static_cast<unsigned long long>(now.errors),
+        static_cast<double>(rtt.percentile(50.0)) / 1e3,
+        static_cast<double>(rtt.percentile(99.0)) / 1e3,
+        static_cast<double>(rtt.percentile(99.9)) / 1e3);
+    std::fflush(stdout);
+}
+
+// --load: open the connections, print a line per report interval until
+// --duration or Ctrl-C, then a summary over the whole run
+int runLoad(
+    const websocket_client::CLIHandler& cli,
+    websocket_client::ConnectionManager& manager,
+    const std::shared_ptr<websocket_client::TraceRecorder>& tracer) {
+    using Clock = std::chrono::steady_clock;
+
+    boost::asio::ssl::context ssl_ctx{boost::asio::ssl::context::tlsv12_client};
+    ssl_ctx.set_verify_mode(boost::asio::ssl::verify_peer);
+    ssl_ctx.set_default_verify_paths();
+    auto session_cache = std::make_shared<websocket_client::TlsSessionCache>();
+    session_cache->attach(ssl_ctx);
+
+    auto load_options = cli.getLoadOptions();
+    load_options.tracer = tracer;
+    websocket_client::LoadGenerator generator(manager, load_options);
+    if (cli.isSecure()) {
+        generator.start(cli.getHost(), cli.getPort(), cli.getTarget(), ssl_ctx, session_cache);
+    } else {
+        generator.start(cli.getHost(), cli.getPort(), cli.getTarget());
+    }
+
+    boost::asio::io_context report_ioc;
+    boost::asio::signal_set signals(report_ioc, SIGINT, SIGTERM);
+    boost::asio::steady_timer report_timer(report_ioc);
+    boost::asio::steady_timer end_timer(report_ioc);
+
+    const auto start = Clock::now();
+    const auto interval = std::chrono::seconds(cli.getReportInterval());
+    auto last_report = start;
+    websocket_client::ConnectionStats last_totals;
+
+    const auto finish = [&]() {
+        signals.cancel();
+        report_timer.cancel();
+        end_timer.cancel();
+    };
+    signals.async_wait([&](const boost::system::error_code& ec, int) {
+        if (!ec) {
+            finish();
+        }
+    });
+    if (cli.getLoadDuration() > 0) {
+        end_timer.expires_after(std::chrono::seconds(cli.getLoadDuration()));
+        end_timer.async_wait([&](const boost::system::error_code& ec) {
+            if (!ec) {
+                finish();
+            }
+        });
+    }
+
+    std::function<void()> schedule_report = [&]() {
+        report_timer.expires_at(last_report + interval);
+        report_timer.async_wait([&](const boost::system::error_code& ec) {
+            if (ec) {
+                return;
+            }
+            const auto now = Clock::now();
+            const auto snapshot = generator.takeSnapshot();
+            printLoadLine(std::chrono::duration<double>(now - start).count(), snapshot,
+                last_totals, std::chrono::duration<double>(now - last_report).count());
+            last_totals = snapshot.totals;
+            last_report = now;
+            schedule_report();
+        });
+    };
+
+    printLoadHeader();
+    schedule_report();
+    report_ioc.run();
+
+    // Whatever arrived since the last report still counts for the summary
+    generator.stop();
+    const auto snapshot = generator.takeSnapshot();
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    const auto rtt = generator.totalRtt();
+
+    std::printf("\ntotal: %.1f s, %llu sent, %llu received, %llu errors\n",
+        elapsed,
+        static_cast<unsigned long long>(snapshot.totals.messages_sent),
+        static_cast<unsigned long long>(snapshot.totals.messages_received),
+        static_cast<unsigned long long>(snapshot.errors));
+    if (rtt.count() > 0) {
+        std::printf("rtt(us): p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f  (%llu samples)\n",
+            static_cast<double>(rtt.percentile(50.0)) / 1e3,
+            static_cast<double>(rtt.percentile(99.0)) / 1e3,
+            static_cast<double>(rtt.percentile(99.9)) / 1e3,
+            static_cast<double>(rtt.max()) / 1e3,
+            static_cast<unsigned long long>(rtt.count()));
+    }
+
+    // The connections refer to ssl_ctx
+    manager.stop();
+    return 0;
+}
+
+} // namespace
 
 int main(int argc, char* argv[]) {
     try {
+        // io_uring builds hand over to the epoll build on kernels without it
+        websocket_client::execEpollFallbackIfNeeded(argv, "websocket_client");
+
         // Parse command line arguments
         websocket_client::CLIHandler cli;
         if (!cli.parse(argc, argv)) {
             return 1;
         }
 
-        // Create IO context
-        boost::asio::io_context ioc;
+        // Create the io_context pool
+        websocket_client::ConnectionManager::Options manager_options;
+        manager_options.threads = cli.getIoThreads();
+        manager_options.pin_threads = cli.pinThreads();
+        websocket_client::ConnectionManager manager(manager_options);
+
+        // Connection phases for --trace-file
+        std::shared_ptr<websocket_client::TraceRecorder> tracer;
+        if (!cli.getTraceFile().empty()) {
+            websocket_client::TraceRecorder::Options trace_options;
+            trace_options.sample_every = cli.getTraceSample();
+            tracer = std::make_shared<websocket_client::TraceRecorder>(trace_options);
+        }
+
+        if (cli.isLoadMode()) {
+            const int status = runLoad(cli, manager, tracer);
+            if (tracer) {
+                writeTrace(*tracer, cli.getTraceFile());
+            }
+            return status;
+        }
+
+        // Print received messages from a writer thread, so a slow terminal
+        // or pipe does not hold up the io thread until it is 4 MiB behind.
+        // Past that the io thread waits, or with --output-drop skips them.
+        websocket_client::OutputWriter::Options output_options;
+        output_options.block_when_full = !cli.dropOutputWhenBehind();
+        std::shared_ptr<websocket_client::OutputWriter> output;
+        if (cli.getOutput() == "stdout") {
+            output = websocket_client::OutputWriter::openStdout(output_options);
+        } else if (cli.getOutput() != "none") {
+            output = websocket_client::OutputWriter::openFile(cli.getOutput(), output_options);
+        }
 
         // Create message handler
-        websocket_client::MessageHandler msg_handler;
+        websocket_client::MessageHandler msg_handler(output);
+
+        // Report how long each outage lasted
+        const auto on_reconnect = [](std::chrono::microseconds outage) {
+            std::cerr << "Reconnected after "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(outage).count()
+                      << " ms" << std::endl;
+        };
+
+        // Record what arrives, alongside printing it
+        std::unique_ptr<websocket_client::CaptureLog> capture;
+        if (!cli.getCaptureFile().empty()) {
+            capture = std::make_unique<websocket_client::CaptureLog>(cli.getCaptureFile());
+        }
+
+        int status = 0;
 
         // Create WebSocket client based on security flag
         if (cli.isSecure()) {
@@ -32,77 +429,57 @@ int main(int argc, char* argv[]) {
             ssl_ctx.set_verify_mode(boost::asio::ssl::verify_peer);
             ssl_ctx.set_default_verify_paths();
 
-            auto client = std::make_shared<websocket_client::WebSocketClient>(ioc, ssl_ctx);
-
-            client->connect(
-                cli.getHost(),
-                cli.getPort(),
-                cli.getTarget(),
-                [&msg_handler](const std::string& msg) {
-                    msg_handler.handleMessage(msg);
-                },
-                [](const std::string& error) {
-                    std::cerr << "Error: " << error << std::endl;
-                }
-            );
+            // Resume TLS sessions on reconnect
+            auto session_cache = std::make_shared<websocket_client::TlsSessionCache>();
+            session_cache->attach(ssl_ctx);
 
-            // Run IO context in a separate thread
-            std::thread ioc_thread([&ioc]() {
-                ioc.run();
-            });
+            auto client = manager.createClient(ssl_ctx);
+            client->setCompression(cli.getCompressionOptions());
+            client->setSessionCache(session_cache);
+            client->setReconnectPolicy(cli.getReconnectPolicy(), on_reconnect);
+            client->setKeepalive(cli.getKeepalivePolicy());
+            client->setWriteBatching(cli.getWriteBatchOptions());
+            client->setFrameEncoder(cli.useFrameEncoder());
+            client->setReadMessageMax(cli.getMaxMessageSize());
+            client->setLatencyTracking(cli.getLatencyReportInterval() > 0);
+            client->setTracer(tracer);
 
-            // Main input loop
-            std::string line;
-            while (std::getline(std::cin, line)) {
-                if (line == "quit" || line == "exit") {
-                    break;
-                }
-                
-                client->send(msg_handler.formatMessage(line));
-            }
-
-            // Clean shutdown
-            client->close();
-            ioc.stop();
-            ioc_thread.join();
+            status = runClient(client, cli, msg_handler, manager, capture.get());
         } else {
             // Non-secure connection
-            auto client = std::make_shared<websocket_client::WebSocketClientPlain>(ioc);
-
-            client->connect(
-                cli.getHost(),
-                cli.getPort(),
-                cli.getTarget(),
-                [&msg_handler](const std::string& msg) {
-                    msg_handler.handleMessage(msg);
-                },
-                [](const std::string& error) {
-                    std::cerr << "Error: " << error << std::endl;
-                }
-            );
+            auto client = manager.createPlainClient();
+            client->setCompression(cli.getCompressionOptions());
+            client->setReconnectPolicy(cli.getReconnectPolicy(), on_reconnect);
+            client->setKeepalive(cli.getKeepalivePolicy());
+            client->setWriteBatching(cli.getWriteBatchOptions());
+            client->setFrameEncoder(cli.useFrameEncoder());
+            client->setReadMessageMax(cli.getMaxMessageSize());
+            client->setLatencyTracking(cli.getLatencyReportInterval() > 0);
+            client->setTracer(tracer);
 
-            // Run IO context in a separate thread
-            std::thread ioc_thread([&ioc]() {
-                ioc.run();
-            });
+            status = runClient(client, cli, msg_handler, manager, capture.get());
+        }
 
-            // Main input loop
-            std::string line;
-            while (std::getline(std::cin, line)) {
-                if (line == "quit" || line == "exit") {
-                    break;
-                }
-                
-                client->send(msg_handler.formatMessage(line));
-            }
+        if (tracer) {
+            writeTrace(*tracer, cli.getTraceFile());
+        }
 
-            // Clean shutdown
-            client->close();
-            ioc.stop();
-            ioc_thread.join();
+        if (output && output->stats().dropped > 0) {
+            std::cerr << "Output fell behind; " << output->stats().dropped
+                      << " messages were not printed" << std::endl;
+        }
+
+        if (capture) {
+            const auto stats = capture->stats();
+            std::cerr << "Captured " << stats.records << " messages in " << stats.segments
+                      << " segments";
+            if (stats.dropped > 0) {
+                std::cerr << ", dropped " << stats.dropped;
+            }
+            std::cerr << std::endl;
         }
 
-        return 0;
+        return status;
     }
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -0,0 +1,95 @@
+#include "mapped_file.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <system_error>
+
+namespace websocket_client {
+
+namespace {
+
+std::size_t pageSize() {
+    static const std::size_t size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+[[noreturn]] void throwErrno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+} // namespace
+
+std::shared_ptr<const MappedFile> MappedFile::open(const std::string& path) {
+    // O_NONBLOCK so a FIFO without a writer cannot hang the open
+    const int fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        throwErrno("open " + path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        const int saved = errno;
+        ::close(fd);
+        errno = saved;
+        throwErrno("stat " + path);
+    }
+
+    // Pipes and devices report a size of 0 and cannot be mapped
+    if (!S_ISREG(st.st_mode)) {
+        ::close(fd);
+        throw std::system_error(
+            std::make_error_code(std::errc::invalid_argument), path + " is not a regular file");
+    }
+
+    // mmap rejects zero-length mappings; an empty file is an empty message
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* data = nullptr;
+    if (size > 0) {
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            const int saved = errno;
+            ::close(fd);
+            errno = saved;
+            throwErrno("mmap " + path);
+        }
+        // Read-ahead in large windows; the sender walks the file once
+        madvise(data, size, MADV_SEQUENTIAL);
+    }
+
+    // The mapping keeps the file referenced
+    ::close(fd);
+
+    return std::shared_ptr<const MappedFile>(
+        new MappedFile(static_cast<const char*>(data), size));
+}
+
+MappedFile::MappedFile(const char* data, std::size_t size)
+    : data_(data)
+    , size_(size)
+{
+}
+
+MappedFile::~MappedFile() {
+    if (size_ > 0) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+void MappedFile::release(std::size_t offset, std::size_t length) const {
+    // The page holding `offset` may have been left behind by the previous
+    // call; the page holding the end is still partly unsent
+    const std::size_t page = pageSize();
+    const std::size_t begin = offset / page * page;
+    const std::size_t end = (offset + length) / page * page;
+    if (end <= begin) {
+        return;
+    }
+
+    // Clean, file-backed pages: MADV_DONTNEED only unmaps them, and a later
+    // read faults them back in from the page cache
+    madvise(const_cast<char*>(data_) + begin, end - begin, MADV_DONTNEED);
+}
+
+} // namespace websocket_client
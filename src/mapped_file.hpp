@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace websocket_client {
+
+// Read-only memory mapping of a whole file, used to stream large payloads
+// without copying them into the heap first.
+//
+// Pages are faulted in as the sender reaches them and dropped from the
+// process's resident set again through release(), so a gigabyte file costs
+// about as much RSS as one write fragment. The page cache keeps the data,
+// which makes a resend after a reconnect cheap.
+//
+// Instances are shared: one mapping can be queued on any number of clients.
+class MappedFile {
+public:
+    // Throws std::system_error if the file cannot be opened or mapped, or
+    // is not a regular file
+    static std::shared_ptr<const MappedFile> open(const std::string& path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+    // [offset, offset + length) has been sent: let the kernel reclaim its
+    // pages, except the one still holding unsent bytes past the end.
+    // Contents are unaffected; a later read faults the pages back in.
+    void release(std::size_t offset, std::size_t length) const;
+
+private:
+    MappedFile(const char* data, std::size_t size);
+
+    const char* data_;
+    std::size_t size_;
+};
+
+} // namespace websocket_client
@@ -1,16 +1,29 @@
 #include "message_handler.hpp"
+#include "output_writer.hpp"
+#include "topic_router.hpp"
 #include <iostream>
 
 namespace websocket_client {
 
 MessageHandler::MessageHandler()
-    : message_callback_([](const std::string& msg) {
+    : message_callback_([](std::string_view msg) {
         std::cout << "Received: " << msg << std::endl;
     })
 {
 }
 
-void MessageHandler::handleMessage(const std::string& message) {
+MessageHandler::MessageHandler(std::shared_ptr<OutputWriter> output) {
+    if (output) {
+        message_callback_ = [output = std::move(output)](std::string_view msg) {
+            output->write("Received: ", msg);
+        };
+    }
+}
+
+void MessageHandler::handleMessage(std::string_view message) {
+    if (router_ && router_->dispatch(message)) {
+        return;
+    }
     if (message_callback_) {
         message_callback_(message);
     }
@@ -21,7 +34,22 @@ std::string MessageHandler::formatMessage(const std::string& message) const {
 }
 
 void MessageHandler::setMessageCallback(std::function<void(const std::string&)> callback) {
+    if (!callback) {
+        message_callback_ = nullptr;
+        return;
+    }
+
+    message_callback_ = [callback = std::move(callback)](std::string_view msg) {
+        callback(std::string(msg));
+    };
+}
+
+void MessageHandler::setMessageViewCallback(std::function<void(std::string_view)> callback) {
     message_callback_ = std::move(callback);
 }
 
+void MessageHandler::setTopicRouter(std::shared_ptr<const TopicRouter> router) {
+    router_ = std::move(router);
+}
+
 } // namespace websocket_client
@@ -1,25 +1,46 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <functional>
 
 namespace websocket_client {
 
+class OutputWriter;
+class TopicRouter;
+
 class MessageHandler {
 public:
+    // Prints each message to std::cout
     MessageHandler();
 
-    // Handle incoming messages from the server
-    void handleMessage(const std::string& message);
+    // Prints each message through `output`, off the calling thread; a null
+    // output discards messages
+    explicit MessageHandler(std::shared_ptr<OutputWriter> output);
+
+    // Handle incoming messages from the server. The message is only
+    // guaranteed to live until this call returns.
+    void handleMessage(std::string_view message);
 
     // Format outgoing messages
     std::string formatMessage(const std::string& message) const;
 
-    // Set callback for when messages are received
+    // Set callback for when messages are received. The message is copied
+    // into a std::string before the callback runs.
     void setMessageCallback(std::function<void(const std::string&)> callback);
 
+    // Set callback that sees each message in place, without a copy
+    void setMessageViewCallback(std::function<void(std::string_view)> callback);
+
+    // Offer each message to `router` before the message callback. Messages
+    // it hands to a subscriber stop there; those without a topic, or whose
+    // topic nobody subscribes to, go on to the callback. Null removes it.
+    void setTopicRouter(std::shared_ptr<const TopicRouter> router);
+
 private:
-    std::function<void(const std::string&)> message_callback_;
+    std::function<void(std::string_view)> message_callback_;
+    std::shared_ptr<const TopicRouter> router_;
 };
 
 } // namespace websocket_client
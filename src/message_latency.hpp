@@ -0,0 +1,61 @@
+#pragma once
+
+#include "latency_histogram.hpp"
+#include <chrono>
+#include <cstdint>
+
+namespace websocket_client {
+
+// Where a connection's messages spend their time, in nanoseconds.
+struct MessageLatency {
+    // From the transport read that completed a message to its handler
+    // being called: frame parsing, decompression, and waiting behind
+    // earlier messages from the same read. TLS connections count from when
+    // the decrypted bytes were available.
+    LatencyHistogram delivery;
+
+    // Inside the message (or chunk) handler
+    LatencyHistogram handler;
+
+    // From send() to the client starting to write the message
+    LatencyHistogram queue_wait;
+
+    // From starting to write a message to the write completing. A message
+    // resent after a reconnect counts from its last attempt.
+    LatencyHistogram write;
+
+    MessageLatency& operator+=(const MessageLatency& other) {
+        delivery.merge(other.delivery);
+        handler.merge(other.handler);
+        queue_wait.merge(other.queue_wait);
+        write.merge(other.write);
+        return *this;
+    }
+};
+
+// Live histograms owned by a client. Recorded on the client's strand,
+// snapshotted from anywhere.
+struct MessageLatencyRecorder {
+    using Clock = std::chrono::steady_clock;
+
+    AtomicLatencyHistogram delivery;
+    AtomicLatencyHistogram handler;
+    AtomicLatencyHistogram queue_wait;
+    AtomicLatencyHistogram write;
+
+    static std::uint64_t elapsed(Clock::time_point from, Clock::time_point to) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+        return ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+    }
+
+    MessageLatency snapshot() const {
+        MessageLatency latency;
+        latency.delivery = delivery.snapshot();
+        latency.handler = handler.snapshot();
+        latency.queue_wait = queue_wait.snapshot();
+        latency.write = write.snapshot();
+        return latency;
+    }
+};
+
+} // namespace websocket_client
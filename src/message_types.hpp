@@ -0,0 +1,40 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "shared_payload.hpp"
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace websocket_client {
+
+// Frame type of a received message.
+enum class Opcode {
+    text,
+    binary
+};
+
+// A message waiting in a client's outbound queue. The queue owns the bytes,
+// so callers may reuse or destroy their buffers as soon as send() returns.
+//
+// A message with `file` set sends the mapping's bytes instead of `payload`,
+// streamed in fragments so it is never copied. One with `shared` set sends
+// those bytes, which other queues may be holding too.
+struct OutboundMessage {
+    std::string payload;
+    bool binary = false;
+    std::shared_ptr<const MappedFile> file;
+    SharedPayload shared;
+
+    // Set by the client while it records MessageLatency
+    std::chrono::steady_clock::time_point queued_at;
+
+    std::size_t size() const {
+        if (file) {
+            return file->size();
+        }
+        return shared ? shared.size() : payload.size();
+    }
+};
+
+} // namespace websocket_client
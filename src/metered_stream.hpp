@@ -0,0 +1,244 @@
+#pragma once
+
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/core/role.hpp>
+#include <boost/beast/websocket/teardown.hpp>
+#include <boost/system/error_code.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace websocket_client {
+
+namespace detail {
+
+// Completion handler that adds the transferred byte count to a counter,
+// and optionally stamps the completion time, before invoking the wrapped
+// handler.
+template <class Handler>
+class MeteredHandler {
+public:
+    MeteredHandler(
+        Handler handler,
+        std::atomic<std::uint64_t>& counter,
+        std::chrono::steady_clock::time_point* completed = nullptr)
+        : handler_(std::move(handler))
+        , counter_(&counter)
+        , completed_(completed)
+    {
+    }
+
+    void operator()(boost::system::error_code ec, std::size_t bytes_transferred) {
+        counter_->fetch_add(bytes_transferred, std::memory_order_relaxed);
+        if (completed_) {
+            *completed_ = std::chrono::steady_clock::now();
+        }
+        handler_(ec, bytes_transferred);
+    }
+
+    const Handler& handler() const noexcept { return handler_; }
+
+private:
+    Handler handler_;
+    std::atomic<std::uint64_t>* counter_;
+    std::chrono::steady_clock::time_point* completed_;
+};
+
+} // namespace detail
+
+// Stream layer that sits directly below the websocket stream and counts the
+// bytes moving through it. These are frame bytes as they appear on the wire
+// after permessage-deflate and before TLS, which is what we compare against
+// payload sizes to see what compression saves.
+//
+// The counters belong to the owner, so totals survive the stream being
+// rebuilt on reconnect. Only the websocket stream calls into this layer,
+// always on its strand; the counters may be read from any thread.
+//
+// The clients' FrameEncoder writes whole frames straight into this layer,
+// around the websocket stream, while the stream may still write pongs and
+// pings of its own. With setExclusiveWrites() on, every write is carried
+// out in full before it completes, and one that arrives while another is
+// in progress waits for it, so frames from the two never interleave.
+template <class NextLayer>
+class MeteredStream {
+public:
+    using next_layer_type = std::remove_reference_t<NextLayer>;
+    using executor_type = typename next_layer_type::executor_type;
+
+    template <class... Args>
+    MeteredStream(
+        std::atomic<std::uint64_t>& bytes_read,
+        std::atomic<std::uint64_t>& bytes_written,
+        Args&&... args)
+        : next_layer_(std::forward<Args>(args)...)
+        , bytes_read_(&bytes_read)
+        , bytes_written_(&bytes_written)
+    {
+    }
+
+    executor_type get_executor() noexcept { return next_layer_.get_executor(); }
+
+    next_layer_type& next_layer() noexcept { return next_layer_; }
+    const next_layer_type& next_layer() const noexcept { return next_layer_; }
+
+    // Call before the first write
+    void setExclusiveWrites(bool exclusive) { exclusive_ = exclusive; }
+
+    // Store the time each read completes in `*last_read`, which must
+    // outlive the stream. Call before the first read.
+    void setReadClock(std::chrono::steady_clock::time_point* last_read) { last_read_ = last_read; }
+
+    std::uint64_t bytesRead() const noexcept {
+        return bytes_read_->load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t bytesWritten() const noexcept {
+        return bytes_written_->load(std::memory_order_relaxed);
+    }
+
+    template <class MutableBufferSequence, class ReadHandler>
+    auto async_read_some(const MutableBufferSequence& buffers, ReadHandler&& handler) {
+        return boost::asio::async_initiate<ReadHandler,
+            void(boost::system::error_code, std::size_t)>(
+                [this](auto&& h, const MutableBufferSequence& b) {
+                    using handler_type = std::decay_t<decltype(h)>;
+                    next_layer_.async_read_some(b,
+                        detail::MeteredHandler<handler_type>(
+                            std::forward<decltype(h)>(h), *bytes_read_, last_read_));
+                },
+                handler, buffers);
+    }
+
+    template <class ConstBufferSequence, class WriteHandler>
+    auto async_write_some(const ConstBufferSequence& buffers, WriteHandler&& handler) {
+        return boost::asio::async_initiate<WriteHandler,
+            void(boost::system::error_code, std::size_t)>(
+                [this](auto&& h, const ConstBufferSequence& b) {
+                    using handler_type = std::decay_t<decltype(h)>;
+                    if (exclusive_) {
+                        writeExclusive(b, handler_type(std::forward<decltype(h)>(h)));
+                        return;
+                    }
+                    next_layer_.async_write_some(b,
+                        detail::MeteredHandler<handler_type>(
+                            std::forward<decltype(h)>(h), *bytes_written_));
+                },
+                handler, buffers);
+    }
+
+private:
+    // A write held back until the one in progress completes
+    struct ParkedWrite {
+        virtual ~ParkedWrite() = default;
+        virtual void start() = 0;
+    };
+
+    template <class ConstBufferSequence, class Handler>
+    struct ParkedWriteFor final : ParkedWrite {
+        ParkedWriteFor(MeteredStream& s, const ConstBufferSequence& b, Handler h)
+            : stream(s), buffers(b), handler(std::move(h)) {}
+
+        void start() override { stream.writeExclusive(buffers, std::move(handler)); }
+
+        MeteredStream& stream;
+        ConstBufferSequence buffers;
+        Handler handler;
+    };
+
+    template <class ConstBufferSequence, class Handler>
+    void writeExclusive(const ConstBufferSequence& buffers, Handler handler) {
+        if (writing_) {
+            parked_.push_back(std::make_unique<ParkedWriteFor<ConstBufferSequence, Handler>>(
+                *this, buffers, std::move(handler)));
+            return;
+        }
+
+        writing_ = true;
+        auto ex = boost::asio::get_associated_executor(handler, get_executor());
+        boost::asio::async_write(next_layer_, buffers, boost::asio::bind_executor(ex,
+            [this, h = std::move(handler)](boost::system::error_code ec, std::size_t bytes) mutable {
+                bytes_written_->fetch_add(bytes, std::memory_order_relaxed);
+                writing_ = false;
+
+                // Started before `h` runs, so the next write from the same
+                // caller queues behind whoever was already waiting
+                if (!parked_.empty()) {
+                    auto next = std::move(parked_.front());
+                    parked_.pop_front();
+                    next->start();
+                }
+                std::move(h)(ec, bytes);
+            }));
+    }
+
+    NextLayer next_layer_;
+    std::atomic<std::uint64_t>* bytes_read_;
+    std::atomic<std::uint64_t>* bytes_written_;
+    std::chrono::steady_clock::time_point* last_read_ = nullptr;
+    bool exclusive_ = false;
+    bool writing_ = false;
+    std::deque<std::unique_ptr<ParkedWrite>> parked_;
+};
+
+// Let websocket::stream tear down whatever sits below the meter
+template <class NextLayer>
+void teardown(
+    boost::beast::role_type role,
+    MeteredStream<NextLayer>& stream,
+    boost::system::error_code& ec)
+{
+    using boost::beast::websocket::teardown;
+    teardown(role, stream.next_layer(), ec);
+}
+
+template <class NextLayer, class TeardownHandler>
+void async_teardown(
+    boost::beast::role_type role,
+    MeteredStream<NextLayer>& stream,
+    TeardownHandler&& handler)
+{
+    using boost::beast::websocket::async_teardown;
+    async_teardown(role, stream.next_layer(),
+        std::forward<TeardownHandler>(handler));
+}
+
+} // namespace websocket_client
+
+namespace boost {
+namespace asio {
+
+template <class Handler, class Executor>
+struct associated_executor<websocket_client::detail::MeteredHandler<Handler>, Executor> {
+    using type = associated_executor_t<Handler, Executor>;
+
+    static type get(
+        const websocket_client::detail::MeteredHandler<Handler>& h,
+        const Executor& ex = Executor()) noexcept
+    {
+        return associated_executor<Handler, Executor>::get(h.handler(), ex);
+    }
+};
+
+template <class Handler, class Allocator>
+struct associated_allocator<websocket_client::detail::MeteredHandler<Handler>, Allocator> {
+    using type = associated_allocator_t<Handler, Allocator>;
+
+    static type get(
+        const websocket_client::detail::MeteredHandler<Handler>& h,
+        const Allocator& a = Allocator()) noexcept
+    {
+        return associated_allocator<Handler, Allocator>::get(h.handler(), a);
+    }
+};
+
+} // namespace asio
+} // namespace boost
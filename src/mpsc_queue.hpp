@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace websocket_client {
+
+// Unbounded lock-free multi-producer / single-consumer queue.
+//
+// Any thread may push(); only one thread at a time (the owning strand) may
+// pop(). Producers never block each other: a push is one atomic exchange plus
+// one release store. pop() can briefly report empty while a push is half way
+// through, so callers must re-check after being woken by the producer.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue()
+        : head_(&stub_)
+        , tail_(&stub_)
+    {
+    }
+
+    ~MpscQueue() {
+        while (pop()) {
+        }
+        if (tail_ != &stub_) {
+            delete tail_;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Enqueue a value. Safe to call from any thread.
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Dequeue the oldest value. Consumer side only.
+    std::optional<T> pop() {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return std::nullopt;
+        }
+
+        // `next` becomes the new stub; its value moves out to the caller.
+        std::optional<T> value(std::move(next->value));
+        next->value.reset();
+        tail_ = next;
+        if (tail != &stub_) {
+            delete tail;
+        }
+        return value;
+    }
+
+    // Consumer side only.
+    bool empty() const {
+        return tail_->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T v) : value(std::move(v)) {}
+
+        std::atomic<Node*> next{nullptr};
+        std::optional<T> value;
+    };
+
+    Node stub_;
+    std::atomic<Node*> head_;
+    Node* tail_;
+};
+
+} // namespace websocket_client
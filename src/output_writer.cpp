@@ -0,0 +1,211 @@
+#include "output_writer.hpp"
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+namespace websocket_client {
+
+std::shared_ptr<OutputWriter> OutputWriter::openStdout(Options options) {
+    const int fd = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "dup stdout");
+    }
+    return std::shared_ptr<OutputWriter>(new OutputWriter(fd, options));
+}
+
+std::shared_ptr<OutputWriter> OutputWriter::openFile(const std::string& path, Options options) {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+    }
+    return std::shared_ptr<OutputWriter>(new OutputWriter(fd, options));
+}
+
+OutputWriter::OutputWriter(int fd, Options options)
+    : fd_(fd)
+    , options_(options)
+    , buffer_(std::max<std::size_t>(options.buffer_size, 1))
+{
+    worker_ = std::thread([this]() { run(); });
+}
+
+OutputWriter::~OutputWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    worker_.join();
+    ::close(fd_);
+}
+
+bool OutputWriter::write(std::string_view prefix, std::string_view message) {
+    const std::size_t size = prefix.size() + message.size() + 1;
+
+    if (options_.block_when_full && size > buffer_.size()) {
+        return writeInPieces(prefix, message);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (size > buffer_.size() || failed_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // A line being written in pieces holds the ring until it is all in
+    const auto fits = [&]() {
+        return !oversize_ && buffer_.size() - (write_pos_ - read_pos_) >= size;
+    };
+    if (!fits()) {
+        if (!options_.block_when_full) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // Below flush_size the writer thread would sleep out the interval
+        flush_requested_ = true;
+        wake_.notify_one();
+        drained_.wait(lock, [&]() { return fits() || failed_; });
+        if (failed_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    const std::uint64_t pending_before = write_pos_ - read_pos_;
+    copyIn(prefix);
+    copyIn(message);
+    copyIn("\n");
+    lines_.fetch_add(1, std::memory_order_relaxed);
+
+    // Wake the writer once per threshold crossing, not once per line
+    const bool crossed = pending_before < options_.flush_size
+        && write_pos_ - read_pos_ >= options_.flush_size;
+    lock.unlock();
+    if (crossed) {
+        wake_.notify_one();
+    }
+    return true;
+}
+
+bool OutputWriter::writeInPieces(std::string_view prefix, std::string_view message) {
+    // Other lines must not land between the pieces of this one, so wait
+    // for the ring to empty and keep it until the whole line is in
+    std::unique_lock<std::mutex> lock(mutex_);
+    flush_requested_ = true;
+    wake_.notify_one();
+    drained_.wait(lock, [&]() { return (read_pos_ == write_pos_ && !oversize_) || failed_; });
+    oversize_ = true;
+
+    for (std::string_view bytes : {prefix, message, std::string_view("\n")}) {
+        while (!bytes.empty() && !failed_) {
+            const std::size_t space = static_cast<std::size_t>(buffer_.size() - (write_pos_ - read_pos_));
+            if (space == 0) {
+                flush_requested_ = true;
+                wake_.notify_one();
+                drained_.wait(lock, [&]() { return write_pos_ - read_pos_ < buffer_.size() || failed_; });
+                continue;
+            }
+            const std::size_t n = std::min(bytes.size(), space);
+            copyIn(bytes.substr(0, n));
+            bytes.remove_prefix(n);
+        }
+    }
+
+    oversize_ = false;
+    flush_requested_ = true;
+    wake_.notify_one();
+    drained_.notify_all();
+    if (failed_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    lines_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void OutputWriter::copyIn(std::string_view bytes) {
+    while (!bytes.empty()) {
+        const std::size_t at = static_cast<std::size_t>(write_pos_ % buffer_.size());
+        const std::size_t n = std::min(bytes.size(), buffer_.size() - at);
+        std::memcpy(buffer_.data() + at, bytes.data(), n);
+        write_pos_ += n;
+        bytes.remove_prefix(n);
+    }
+}
+
+void OutputWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const std::uint64_t target = write_pos_;
+    flush_requested_ = true;
+    wake_.notify_one();
+    drained_.wait(lock, [&]() { return read_pos_ >= target || failed_; });
+}
+
+void OutputWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait_for(lock, options_.flush_interval, [this]() {
+            return stopping_ || flush_requested_
+                || write_pos_ - read_pos_ >= options_.flush_size;
+        });
+        flush_requested_ = false;
+
+        // The bytes between read_pos_ and write_pos_ are only touched here,
+        // so the syscall runs without the lock
+        while (!failed_ && read_pos_ < write_pos_) {
+            const std::size_t at = static_cast<std::size_t>(read_pos_ % buffer_.size());
+            const std::size_t n = static_cast<std::size_t>(
+                std::min<std::uint64_t>(write_pos_ - read_pos_, buffer_.size() - at));
+
+            lock.unlock();
+            ssize_t written;
+            for (;;) {
+                written = ::write(fd_, buffer_.data() + at, n);
+                if (written >= 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    break;
+                }
+                if (errno == EINTR) {
+                    continue;
+                }
+                // Someone made the description non-blocking, e.g. a tty it
+                // shares with stdin; wait until it takes bytes again
+                pollfd ready{fd_, POLLOUT, 0};
+                if (::poll(&ready, 1, -1) < 0 && errno != EINTR) {
+                    break;
+                }
+            }
+            lock.lock();
+
+            if (written < 0) {
+                // Nowhere left to write; from here on every line is dropped
+                failed_ = true;
+                read_pos_ = write_pos_;
+                break;
+            }
+            read_pos_ += static_cast<std::uint64_t>(written);
+            writes_.fetch_add(1, std::memory_order_relaxed);
+            bytes_written_.fetch_add(static_cast<std::uint64_t>(written), std::memory_order_relaxed);
+            drained_.notify_all();
+        }
+        drained_.notify_all();
+
+        if (stopping_) {
+            return;
+        }
+    }
+}
+
+OutputWriter::Stats OutputWriter::stats() const {
+    Stats stats;
+    stats.lines = lines_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.bytes_written = bytes_written_.load(std::memory_order_relaxed);
+    stats.writes = writes_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace websocket_client
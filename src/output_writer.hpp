@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+
+// Line-oriented output that keeps the caller off the terminal, pipe or
+// disk behind it.
+//
+// write() copies one line into a ring buffer and returns. A dedicated
+// thread hands the buffered bytes to write(2) once flush_size bytes are
+// pending or flush_interval has passed, so one syscall carries many lines.
+// If the ring is full because the output cannot keep up, write() waits for
+// room; lines longer than the ring go through it in pieces. With
+// block_when_full cleared it drops and counts the line instead.
+//
+// All methods are thread-safe.
+class OutputWriter {
+public:
+    struct Options {
+        std::size_t buffer_size = 4 * 1024 * 1024;
+        std::size_t flush_size = 64 * 1024;
+        std::chrono::milliseconds flush_interval{100};
+        bool block_when_full = true;
+    };
+
+    struct Stats {
+        std::uint64_t lines = 0;
+        std::uint64_t dropped = 0;
+        std::uint64_t bytes_written = 0;
+        std::uint64_t writes = 0;
+    };
+
+    // Writes to a duplicate of fd 1, so stdout itself stays open
+    static std::shared_ptr<OutputWriter> openStdout(Options options);
+
+    // Truncates or creates the file. Throws std::system_error if it cannot.
+    static std::shared_ptr<OutputWriter> openFile(const std::string& path, Options options);
+
+    // Writes out everything still buffered
+    ~OutputWriter();
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    // Buffers prefix, message and a newline as one line. Returns false if
+    // the line was dropped, or the output failed.
+    bool write(std::string_view prefix, std::string_view message);
+
+    // Blocks until every line buffered so far has been written
+    void flush();
+
+    Stats stats() const;
+
+private:
+    OutputWriter(int fd, Options options);
+
+    bool writeInPieces(std::string_view prefix, std::string_view message);
+    void copyIn(std::string_view bytes);
+    void run();
+
+    const int fd_;
+    const Options options_;
+    std::vector<char> buffer_;
+
+    // Positions count bytes since the start; the ring index is pos % size
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;      // the writer thread
+    std::condition_variable drained_;   // blocked writers and flush()
+    std::uint64_t write_pos_{0};
+    std::uint64_t read_pos_{0};
+    bool flush_requested_{false};
+    bool oversize_{false};              // writeInPieces() holds the ring
+    bool failed_{false};
+    bool stopping_{false};
+
+    std::atomic<std::uint64_t> lines_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::uint64_t> bytes_written_{0};
+    std::atomic<std::uint64_t> writes_{0};
+
+    std::thread worker_;
+};
+
+} // namespace websocket_client
@@ -0,0 +1,36 @@
+#include "rate_limiter.hpp"
+#include <algorithm>
+
+namespace websocket_client {
+
+RateLimiter::RateLimiter(double rate, std::size_t burst)
+    : rate_(rate)
+    , burst_(static_cast<double>(std::max<std::size_t>(burst, 1)))
+    , tokens_(burst_)
+    , last_(Clock::now())
+{
+}
+
+RateLimiter::Clock::duration RateLimiter::acquire(Clock::time_point now) {
+    if (unlimited()) {
+        return Clock::duration::zero();
+    }
+
+    if (now > last_) {
+        const double elapsed = std::chrono::duration<double>(now - last_).count();
+        tokens_ = std::min(burst_, tokens_ + elapsed * rate_);
+        last_ = now;
+    }
+
+    if (tokens_ >= 1.0) {
+        tokens_ -= 1.0;
+        return Clock::duration::zero();
+    }
+
+    // Round up so the caller never wakes a hair too early and spins
+    const double wait = (1.0 - tokens_) / rate_;
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(wait)) + std::chrono::nanoseconds(1);
+}
+
+} // namespace websocket_client
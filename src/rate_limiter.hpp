@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace websocket_client {
+
+// Token bucket: on average `rate` events per second, with up to `burst`
+// allowed back to back after a quiet spell. The bucket starts full.
+//
+// Not thread-safe; callers pace a single producer with it.
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A rate of 0 or less never makes anyone wait
+    RateLimiter(double rate, std::size_t burst);
+
+    bool unlimited() const { return rate_ <= 0; }
+
+    // Take a token at `now`. Returns zero if one was available; otherwise
+    // takes nothing and returns how long until one will be.
+    Clock::duration acquire(Clock::time_point now = Clock::now());
+
+private:
+    double rate_;
+    double burst_;
+    double tokens_;
+    Clock::time_point last_;
+};
+
+} // namespace websocket_client
@@ -0,0 +1,25 @@
+#include "reconnect_policy.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace websocket_client {
+
+std::chrono::milliseconds ReconnectPolicy::delayFor(std::size_t attempt, std::mt19937& rng) const {
+    if (attempt <= 1) {
+        return std::chrono::milliseconds(0);
+    }
+
+    const double cap = static_cast<double>(max_delay.count());
+    double delay = static_cast<double>(initial_delay.count())
+        * std::pow(multiplier, static_cast<double>(attempt - 2));
+    delay = std::min(delay, cap);
+
+    if (jitter > 0) {
+        std::uniform_real_distribution<double> factor(1.0 - jitter, 1.0 + jitter);
+        delay = std::min(delay * factor(rng), cap);
+    }
+
+    return std::chrono::milliseconds(std::llround(std::max(delay, 0.0)));
+}
+
+} // namespace websocket_client
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <random>
+
+namespace websocket_client {
+
+// Opt-in automatic reconnect for the clients.
+//
+// The first attempt after a drop goes out immediately: most drops are
+// one-offs, and every millisecond spent backing off is a millisecond of
+// missing data. Attempts after that back off exponentially from
+// initial_delay up to max_delay, each delay scaled by a random factor in
+// [1 - jitter, 1 + jitter] so clients dropped by the same event do not
+// reconnect in lockstep.
+//
+// A reconnect reuses the addresses from the last successful lookup; DNS is
+// only asked again once connecting to those has failed.
+struct ReconnectPolicy {
+    bool enabled = false;
+    std::chrono::milliseconds initial_delay{100};
+    std::chrono::milliseconds max_delay{5000};
+    double multiplier = 2.0;
+    double jitter = 0.2;
+    std::size_t max_attempts = 0;  // 0 retries forever
+
+    // Delay before reconnect attempt `attempt`, counting from 1
+    std::chrono::milliseconds delayFor(std::size_t attempt, std::mt19937& rng) const;
+};
+
+// Called after a reconnect handshake with the time since the drop was noticed
+using ReconnectHandler = std::function<void(std::chrono::microseconds outage)>;
+
+} // namespace websocket_client
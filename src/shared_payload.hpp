@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace websocket_client {
+
+// Immutable message bytes that any number of clients can queue at once.
+// Copying a SharedPayload only bumps a reference count, so sending one to
+// hundreds of connections costs one copy of the bytes, made when it is
+// created, and the websocket stream of each connection reads straight from
+// it while masking into its own fixed-size write buffer.
+//
+// The bytes are freed once the last copy is dropped, i.e. once every
+// client that queued it has written it. Safe to share between threads.
+class SharedPayload {
+public:
+    SharedPayload() = default;
+
+    static SharedPayload text(std::string bytes) {
+        return SharedPayload(std::move(bytes), false);
+    }
+
+    static SharedPayload binary(std::string bytes) {
+        return SharedPayload(std::move(bytes), true);
+    }
+
+    static SharedPayload binary(const std::vector<uint8_t>& bytes) {
+        return SharedPayload(std::string(bytes.begin(), bytes.end()), true);
+    }
+
+    const char* data() const { return bytes_ ? bytes_->data() : nullptr; }
+    std::size_t size() const { return bytes_ ? bytes_->size() : 0; }
+    std::string_view view() const { return bytes_ ? std::string_view(*bytes_) : std::string_view(); }
+    bool isBinary() const { return binary_; }
+
+    // Number of SharedPayloads holding these bytes, queued copies included
+    long useCount() const { return bytes_.use_count(); }
+
+    explicit operator bool() const { return bytes_ != nullptr; }
+    void reset() { bytes_.reset(); }
+
+private:
+    SharedPayload(std::string bytes, bool binary)
+        : bytes_(std::make_shared<const std::string>(std::move(bytes)))
+        , binary_(binary)
+    {
+    }
+
+    std::shared_ptr<const std::string> bytes_;
+    bool binary_ = false;
+};
+
+} // namespace websocket_client
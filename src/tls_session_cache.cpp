@@ -0,0 +1,112 @@
+#include "tls_session_cache.hpp"
+#include <openssl/ssl.h>
+
+namespace websocket_client {
+
+namespace {
+
+// ex_data slots: the owning cache on the SSL_CTX, the host key on the SSL
+int cacheIndex() {
+    static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+int keyIndex() {
+    static const int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+} // namespace
+
+TlsSessionCache::~TlsSessionCache() {
+    clear();
+}
+
+void TlsSessionCache::attach(boost::asio::ssl::context& ctx) {
+    SSL_CTX* native = ctx.native_handle();
+    SSL_CTX_set_ex_data(native, cacheIndex(), this);
+
+    // OpenSSL's internal client cache is never consulted by SSL_connect, so
+    // only the callback matters
+    SSL_CTX_set_session_cache_mode(native,
+        SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(native, &TlsSessionCache::onNewSession);
+}
+
+void TlsSessionCache::prepare(SSL* ssl, const std::string& key) {
+    SSL_set_ex_data(ssl, keyIndex(), const_cast<std::string*>(&key));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = sessions_.find(key);
+    if (it == sessions_.end()) {
+        return;
+    }
+
+    if (!SSL_SESSION_is_resumable(it->second)) {
+        SSL_SESSION_free(it->second);
+        sessions_.erase(it);
+        return;
+    }
+
+    // SSL_set_session takes its own reference
+    SSL_set_session(ssl, it->second);
+
+    // A TLS 1.3 ticket is good for one connection (RFC 8446 C.4); servers
+    // with anti-replay reject it the second time. The handshake it goes
+    // into brings a fresh one back through onNewSession().
+    if (SSL_SESSION_get_protocol_version(it->second) == TLS1_3_VERSION) {
+        SSL_SESSION_free(it->second);
+        sessions_.erase(it);
+    }
+}
+
+bool TlsSessionCache::recordHandshake(SSL* ssl) {
+    const bool resumed = SSL_session_reused(ssl) == 1;
+    (resumed ? resumed_ : full_).fetch_add(1, std::memory_order_relaxed);
+    return resumed;
+}
+
+int TlsSessionCache::onNewSession(SSL* ssl, SSL_SESSION* session) {
+    auto* cache = static_cast<TlsSessionCache*>(
+        SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), cacheIndex()));
+    auto* key = static_cast<const std::string*>(SSL_get_ex_data(ssl, keyIndex()));
+    if (!cache || !key) {
+        return 0;
+    }
+
+    cache->store(*key, session);
+
+    // Returning 1 tells OpenSSL we kept the reference it passed in
+    return 1;
+}
+
+void TlsSessionCache::store(const std::string& key, SSL_SESSION* session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SSL_SESSION*& slot = sessions_[key];
+    if (slot) {
+        SSL_SESSION_free(slot);
+    }
+    slot = session;
+    stored_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TlsSessionCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : sessions_) {
+        SSL_SESSION_free(entry.second);
+    }
+    sessions_.clear();
+}
+
+TlsSessionCache::Stats TlsSessionCache::stats() const {
+    Stats stats;
+    stats.resumed_handshakes = resumed_.load(std::memory_order_relaxed);
+    stats.full_handshakes = full_.load(std::memory_order_relaxed);
+    stats.sessions_stored = stored_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.cached_hosts = sessions_.size();
+    return stats;
+}
+
+} // namespace websocket_client
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <boost/asio/ssl/context.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace websocket_client {
+
+// Client-side TLS session cache keyed by "host:port".
+//
+// Sessions are captured through OpenSSL's new-session callback, which covers
+// both TLS 1.2 session tickets/IDs and TLS 1.3 PSK tickets (the latter arrive
+// after the handshake, during the first reads). On the next connect to the
+// same host the cached session is offered, turning a full handshake into an
+// abbreviated one. A TLS 1.2 session is offered until it expires; a TLS 1.3
+// ticket is offered once and then replaced by the next one the server sends.
+//
+// One cache serves one or more ssl::contexts; attach() it to each before
+// creating clients. All methods are thread-safe.
+class TlsSessionCache {
+public:
+    struct Stats {
+        std::uint64_t resumed_handshakes = 0;
+        std::uint64_t full_handshakes = 0;
+        std::uint64_t sessions_stored = 0;
+        std::size_t cached_hosts = 0;
+    };
+
+    TlsSessionCache() = default;
+    ~TlsSessionCache();
+
+    TlsSessionCache(const TlsSessionCache&) = delete;
+    TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+    // Turn on client session caching for ctx and route new sessions here
+    void attach(boost::asio::ssl::context& ctx);
+
+    // Before the handshake: remember which host `ssl` talks to and offer a
+    // cached session for it, taking it out of the cache if it is TLS 1.3.
+    // `key` must outlive the SSL object.
+    void prepare(SSL* ssl, const std::string& key);
+
+    // After a successful handshake: count it as resumed or full
+    bool recordHandshake(SSL* ssl);
+
+    void clear();
+    Stats stats() const;
+
+private:
+    static int onNewSession(SSL* ssl, SSL_SESSION* session);
+    void store(const std::string& key, SSL_SESSION* session);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, SSL_SESSION*> sessions_;
+    std::atomic<std::uint64_t> resumed_{0};
+    std::atomic<std::uint64_t> full_{0};
+    std::atomic<std::uint64_t> stored_{0};
+};
+
+} // namespace websocket_client
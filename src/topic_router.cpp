@@ -0,0 +1,275 @@
+#include "topic_router.hpp"
+#include <unordered_map>
+#include <utility>
+
+namespace websocket_client {
+
+namespace {
+
+constexpr std::size_t npos = std::string_view::npos;
+
+std::size_t skipWhitespace(std::string_view json, std::size_t pos) {
+    while (pos < json.size()
+           && (json[pos] == ' ' || json[pos] == '\t' || json[pos] == '\n' || json[pos] == '\r')) {
+        ++pos;
+    }
+    return pos;
+}
+
+// `pos` is at an opening quote. Returns the position after the closing one.
+std::size_t skipString(std::string_view json, std::size_t pos) {
+    for (++pos; pos < json.size(); ++pos) {
+        if (json[pos] == '\\') {
+            ++pos;
+        } else if (json[pos] == '"') {
+            return pos + 1;
+        }
+    }
+    return npos;
+}
+
+// Numbers and true/false/null end at the next delimiter
+std::size_t skipScalar(std::string_view json, std::size_t pos) {
+    while (pos < json.size() && json[pos] != ',' && json[pos] != '}' && json[pos] != ']'
+           && json[pos] != ' ' && json[pos] != '\t' && json[pos] != '\n' && json[pos] != '\r') {
+        ++pos;
+    }
+    return pos;
+}
+
+// Skips any value, nested or not, without looking inside its strings
+std::size_t skipValue(std::string_view json, std::size_t pos) {
+    if (pos >= json.size()) {
+        return npos;
+    }
+    if (json[pos] == '"') {
+        return skipString(json, pos);
+    }
+    if (json[pos] != '{' && json[pos] != '[') {
+        return skipScalar(json, pos);
+    }
+
+    std::size_t depth = 0;
+    while (pos < json.size()) {
+        const char c = json[pos];
+        if (c == '"') {
+            pos = skipString(json, pos);
+            if (pos == npos) {
+                return npos;
+            }
+            continue;
+        }
+        if (c == '{' || c == '[') {
+            ++depth;
+        } else if ((c == '}' || c == ']') && --depth == 0) {
+            return pos + 1;
+        }
+        ++pos;
+    }
+    return npos;
+}
+
+// `pos` is at the start of a value that should be an object. Returns the
+// position of the value of its member `name`.
+std::size_t findMember(std::string_view json, std::size_t pos, std::string_view name) {
+    if (pos >= json.size() || json[pos] != '{') {
+        return npos;
+    }
+
+    pos = skipWhitespace(json, pos + 1);
+    while (pos < json.size() && json[pos] == '"') {
+        const std::size_t key_end = skipString(json, pos);
+        if (key_end == npos) {
+            return npos;
+        }
+        const std::string_view key = json.substr(pos + 1, key_end - pos - 2);
+
+        pos = skipWhitespace(json, key_end);
+        if (pos >= json.size() || json[pos] != ':') {
+            return npos;
+        }
+        pos = skipWhitespace(json, pos + 1);
+        if (key == name) {
+            return pos;
+        }
+
+        pos = skipWhitespace(json, skipValue(json, pos));
+        if (pos >= json.size() || json[pos] != ',') {
+            return npos;
+        }
+        pos = skipWhitespace(json, pos + 1);
+    }
+    return npos;
+}
+
+} // namespace
+
+TopicKey TopicKey::jsonPath(std::string_view path) {
+    TopicKey key;
+    while (true) {
+        const std::size_t dot = path.find('.');
+        key.path_.emplace_back(path.substr(0, dot));
+        if (dot == npos) {
+            break;
+        }
+        path.remove_prefix(dot + 1);
+    }
+    return key;
+}
+
+TopicKey TopicKey::bytes(std::size_t offset, std::size_t length) {
+    TopicKey key;
+    key.offset_ = offset;
+    key.length_ = length;
+    return key;
+}
+
+std::optional<std::string_view> TopicKey::extract(std::string_view message) const {
+    if (path_.empty()) {
+        if (message.size() < offset_ || message.size() - offset_ < length_) {
+            return std::nullopt;
+        }
+        return message.substr(offset_, length_);
+    }
+
+    std::size_t pos = skipWhitespace(message, 0);
+    for (const auto& name : path_) {
+        pos = findMember(message, pos, name);
+        if (pos >= message.size()) {
+            return std::nullopt;
+        }
+    }
+
+    if (message[pos] == '"') {
+        const std::size_t end = skipString(message, pos);
+        if (end == npos) {
+            return std::nullopt;
+        }
+        return message.substr(pos + 1, end - pos - 2);
+    }
+    if (message[pos] == '{' || message[pos] == '[') {
+        return std::nullopt;
+    }
+    return message.substr(pos, skipScalar(message, pos) - pos);
+}
+
+TopicRouter::TopicRouter(TopicKey key)
+    : key_(std::move(key))
+{
+}
+
+TopicRouter::SubscriptionId TopicRouter::subscribe(std::string topic, Callback callback) {
+    std::vector<std::string> topics;
+    topics.push_back(std::move(topic));
+    return add(std::move(topics), std::move(callback));
+}
+
+TopicRouter::SubscriptionId TopicRouter::subscribeAll(
+    const std::vector<std::string>& topics, Callback callback) {
+    return add(topics, std::move(callback));
+}
+
+TopicRouter::SubscriptionId TopicRouter::add(std::vector<std::string> topics, Callback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const SubscriptionId id = next_id_++;
+    subscriptions_.emplace(id, Subscription{
+        std::move(topics), std::make_shared<const Callback>(std::move(callback))});
+    rebuildLocked();
+    return id;
+}
+
+bool TopicRouter::unsubscribe(SubscriptionId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (subscriptions_.erase(id) == 0) {
+        return false;
+    }
+    rebuildLocked();
+    return true;
+}
+
+void TopicRouter::rebuildLocked() {
+    // Group callbacks by topic, keeping subscription order within each
+    std::unordered_map<std::string_view, std::vector<const std::shared_ptr<const Callback>*>> by_topic;
+    std::vector<std::string_view> order;
+    for (const auto& [id, subscription] : subscriptions_) {
+        for (const auto& topic : subscription.topics) {
+            auto& callbacks = by_topic[topic];
+            if (callbacks.empty()) {
+                order.push_back(topic);
+            }
+            if (callbacks.empty() || callbacks.back() != &subscription.callback) {
+                callbacks.push_back(&subscription.callback);
+            }
+        }
+    }
+
+    auto table = std::make_shared<Table>();
+    std::size_t capacity = 1;
+    while (capacity < order.size() * 2) {
+        capacity *= 2;
+    }
+    table->slots.resize(capacity);
+    table->topics = order.size();
+
+    const std::hash<std::string_view> hasher;
+    for (const auto topic : order) {
+        const auto& callbacks = by_topic[topic];
+
+        Table::Slot slot;
+        slot.hash = hasher(topic);
+        slot.key_offset = static_cast<std::uint32_t>(table->keys.size());
+        slot.key_size = static_cast<std::uint32_t>(topic.size());
+        slot.first = static_cast<std::uint32_t>(table->callbacks.size());
+        slot.count = static_cast<std::uint32_t>(callbacks.size());
+
+        table->keys.append(topic);
+        for (const auto* callback : callbacks) {
+            table->callbacks.push_back(*callback);
+        }
+
+        std::size_t index = slot.hash & (capacity - 1);
+        while (table->slots[index].count != 0) {
+            index = (index + 1) & (capacity - 1);
+        }
+        table->slots[index] = slot;
+    }
+
+    table_.store(std::move(table), std::memory_order_release);
+}
+
+bool TopicRouter::dispatch(std::string_view message) const {
+    const auto topic = key_.extract(message);
+    if (!topic) {
+        return false;
+    }
+
+    // Holding the table keeps it, and its callbacks, alive even if a
+    // subscriber changes subscriptions from inside its callback
+    const std::shared_ptr<const Table> table = table_.load(std::memory_order_acquire);
+    if (!table || table->topics == 0) {
+        return false;
+    }
+
+    const std::size_t mask = table->slots.size() - 1;
+    const std::size_t hash = std::hash<std::string_view>()(*topic);
+    for (std::size_t index = hash & mask;; index = (index + 1) & mask) {
+        const Table::Slot& slot = table->slots[index];
+        if (slot.count == 0) {
+            return false;
+        }
+        if (slot.hash == hash
+            && std::string_view(table->keys).substr(slot.key_offset, slot.key_size) == *topic) {
+            for (std::uint32_t i = 0; i < slot.count; ++i) {
+                (*table->callbacks[slot.first + i])(*topic, message);
+            }
+            return true;
+        }
+    }
+}
+
+std::size_t TopicRouter::topicCount() const {
+    const auto table = table_.load(std::memory_order_acquire);
+    return table ? table->topics : 0;
+}
+
+} // namespace websocket_client
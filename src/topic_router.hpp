@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace websocket_client {
+
+// Where in a message its topic is found.
+class TopicKey {
+public:
+    // The value at a dotted path of object members, e.g. "channel" or
+    // "data.channel". Only the bytes up to that member are scanned, and
+    // nothing is parsed or unescaped: string values give the bytes between
+    // their quotes, numbers and literals give their text, and path names
+    // must match member names byte for byte.
+    static TopicKey jsonPath(std::string_view path);
+
+    // `length` bytes starting at `offset`
+    static TopicKey bytes(std::size_t offset, std::size_t length);
+
+    // The message's topic, or std::nullopt if it has none at this key.
+    // Points into `message`.
+    std::optional<std::string_view> extract(std::string_view message) const;
+
+private:
+    TopicKey() = default;
+
+    std::vector<std::string> path_;
+    std::size_t offset_ = 0;
+    std::size_t length_ = 0;
+};
+
+// Hands each message to the subscribers of its topic.
+//
+// Subscriptions live in a flat open-addressing table that is rebuilt and
+// swapped in whole whenever they change, so dispatch() never waits on the
+// mutex, does not allocate and costs one hash and, typically, one probe
+// whatever the number of topics. Subscribing to many topics at once with
+// subscribeAll() pays for a single rebuild.
+//
+// All methods are thread-safe. Subscribers may call subscribe() and
+// unsubscribe() from inside a callback; the change applies from the next
+// message on.
+class TopicRouter {
+public:
+    using Callback = std::function<void(std::string_view topic, std::string_view message)>;
+    using SubscriptionId = std::uint64_t;
+
+    explicit TopicRouter(TopicKey key);
+
+    TopicRouter(const TopicRouter&) = delete;
+    TopicRouter& operator=(const TopicRouter&) = delete;
+
+    SubscriptionId subscribe(std::string topic, Callback callback);
+    SubscriptionId subscribeAll(const std::vector<std::string>& topics, Callback callback);
+
+    // Returns false if `id` was not subscribed
+    bool unsubscribe(SubscriptionId id);
+
+    // Call every subscriber of the message's topic, in the order they
+    // subscribed. Returns false, having called nobody, if the message has
+    // no topic or nobody subscribes to it.
+    bool dispatch(std::string_view message) const;
+
+    // Distinct topics with at least one subscriber
+    std::size_t topicCount() const;
+
+private:
+    struct Subscription {
+        std::vector<std::string> topics;
+        std::shared_ptr<const Callback> callback;
+    };
+
+    // Immutable once published
+    struct Table {
+        struct Slot {
+            std::size_t hash = 0;
+            std::uint32_t key_offset = 0;
+            std::uint32_t key_size = 0;
+            std::uint32_t first = 0;
+            std::uint32_t count = 0;  // 0 marks an empty slot
+        };
+
+        std::vector<Slot> slots;  // power-of-two size, at most half full
+        std::string keys;
+        std::vector<std::shared_ptr<const Callback>> callbacks;
+        std::size_t topics = 0;
+    };
+
+    SubscriptionId add(std::vector<std::string> topics, Callback callback);
+    void rebuildLocked();
+
+    const TopicKey key_;
+    std::atomic<std::shared_ptr<const Table>> table_;
+
+    std::mutex mutex_;
+    std::map<SubscriptionId, Subscription> subscriptions_;  // guarded by mutex_
+    SubscriptionId next_id_ = 1;  // guarded by mutex_
+};
+
+} // namespace websocket_client
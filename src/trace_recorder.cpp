@@ -0,0 +1,209 @@
+#include "trace_recorder.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+
+namespace websocket_client {
+
+namespace {
+
+std::atomic<std::uint64_t> nextRecorderId{1};
+
+// Rows of track `track` are threads track * 3 + lane of one process
+constexpr std::uint64_t kLanes = 3;
+
+std::uint64_t rowOf(std::uint64_t track, TraceLane lane) {
+    return track * kLanes + static_cast<std::uint64_t>(lane);
+}
+
+void writeString(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+// Trace timestamps are microseconds; keep the nanoseconds as decimals
+void writeMicros(std::ostream& out, std::int64_t ns) {
+    if (ns < 0) {
+        out << '-';
+        ns = -ns;
+    }
+    char fraction[4];
+    std::snprintf(fraction, sizeof(fraction), "%03d", static_cast<int>(ns % 1000));
+    out << ns / 1000 << '.' << fraction;
+}
+
+void writeRowName(std::ostream& out, std::uint64_t row, const std::string& name) {
+    out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << row
+        << ",\"args\":{\"name\":";
+    writeString(out, name);
+    out << "}},\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << row
+        << ",\"args\":{\"sort_index\":" << row << "}}";
+}
+
+} // namespace
+
+TraceRecorder::TraceRecorder()
+    : TraceRecorder(Options()) {
+}
+
+TraceRecorder::TraceRecorder(Options options)
+    : options_(options)
+    , id_(nextRecorderId.fetch_add(1, std::memory_order_relaxed))
+    , epoch_(Clock::now()) {
+}
+
+TraceRecorder::~TraceRecorder() = default;
+
+std::uint64_t TraceRecorder::newTrack(std::string label) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tracks_.push_back(std::move(label));
+    return tracks_.size();
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::localBuffer() {
+    // The recorder this thread last recorded to, nearly always the only one
+    thread_local std::uint64_t cachedId = 0;
+    thread_local ThreadBuffer* cached = nullptr;
+    if (cachedId == id_) {
+        return *cached;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ThreadBuffer*& buffer = byThread_[std::this_thread::get_id()];
+    if (!buffer) {
+        buffers_.push_back(std::make_unique<ThreadBuffer>(options_.spans_per_thread, buffers_.size()));
+        buffer = buffers_.back().get();
+    }
+    cachedId = id_;
+    cached = buffer;
+    return *buffer;
+}
+
+void TraceRecorder::record(
+    const char* name,
+    std::uint64_t track,
+    TraceLane lane,
+    Clock::time_point start,
+    Clock::time_point end,
+    bool failed) {
+
+    ThreadBuffer& buffer = localBuffer();
+    const std::size_t size = buffer.size.load(std::memory_order_relaxed);
+    if (size == options_.spans_per_thread) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer.spans[size] = Span{
+        name,
+        track,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch_).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - epoch_).count(),
+        lane,
+        failed,
+    };
+    buffer.size.store(size + 1, std::memory_order_release);
+}
+
+void TraceRecorder::write(std::ostream& out) const {
+    struct Entry {
+        Span span;
+        std::size_t thread;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<std::string> tracks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tracks = tracks_;
+        for (const auto& buffer : buffers_) {
+            const std::size_t size = buffer->size.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < size; ++i) {
+                entries.push_back({buffer->spans[i], buffer->index});
+            }
+        }
+    }
+
+    // Name only the rows that have spans
+    std::vector<bool> used((tracks.size() + 1) * kLanes, false);
+    for (const Entry& entry : entries) {
+        const std::uint64_t row = rowOf(entry.span.track, entry.span.lane);
+        if (row < used.size()) {
+            used[row] = true;
+        }
+    }
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+        << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+        << "\"args\":{\"name\":\"websocket_client\"}}";
+
+    for (std::size_t track = 1; track <= tracks.size(); ++track) {
+        // Clients of one server share a label, so number them
+        const std::string label = tracks[track - 1] + " #" + std::to_string(track);
+        if (used[rowOf(track, TraceLane::lifecycle)]) {
+            writeRowName(out, rowOf(track, TraceLane::lifecycle), label);
+        }
+        if (used[rowOf(track, TraceLane::reads)]) {
+            writeRowName(out, rowOf(track, TraceLane::reads), label + " reads");
+        }
+        if (used[rowOf(track, TraceLane::writes)]) {
+            writeRowName(out, rowOf(track, TraceLane::writes), label + " writes");
+        }
+    }
+
+    for (const Entry& entry : entries) {
+        const Span& span = entry.span;
+        out << ",\n{\"name\":";
+        writeString(out, span.name);
+        out << ",\"cat\":\"connection\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+            << rowOf(span.track, span.lane) << ",\"ts\":";
+        writeMicros(out, span.start_ns);
+        out << ",\"dur\":";
+        writeMicros(out, span.end_ns > span.start_ns ? span.end_ns - span.start_ns : 0);
+        out << ",\"args\":{\"thread\":" << entry.thread;
+        if (span.failed) {
+            out << ",\"failed\":true";
+        }
+        out << "}}";
+    }
+
+    out << "\n]}\n";
+}
+
+void TraceRecorder::writeFile(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+    }
+
+    write(out);
+    out.flush();
+    if (!out) {
+        throw std::system_error(errno, std::generic_category(), "write " + path);
+    }
+}
+
+TraceRecorder::Stats TraceRecorder::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.threads = buffers_.size();
+    for (const auto& buffer : buffers_) {
+        stats.spans += buffer->size.load(std::memory_order_acquire);
+        stats.dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+} // namespace websocket_client
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace websocket_client {
+
+// Row of a track that a span is drawn on. Spans on one row must nest or
+// follow each other, so reads and writes, which overlap everything else,
+// get rows of their own.
+enum class TraceLane : std::uint8_t {
+    lifecycle,  // connect phases, first message, reconnect backoff
+    reads,
+    writes,
+};
+
+// Records connection lifecycles as timed spans and writes them out in the
+// Chrome Trace Event format, for chrome://tracing or ui.perfetto.dev.
+//
+// Each recording thread appends to a fixed-size buffer of its own, found
+// through a thread_local after the thread's first span, so record() never
+// takes a lock or allocates. Spans beyond a buffer's capacity are dropped
+// and counted. Span names must outlive the recorder; string literals do.
+// All methods are thread-safe.
+class TraceRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        // Capacity of each thread's buffer
+        std::size_t spans_per_thread = 32 * 1024;
+
+        // Trace one read and one write in this many per client (0 = none)
+        std::uint32_t sample_every = 0;
+    };
+
+    struct Stats {
+        std::uint64_t spans = 0;
+        std::uint64_t dropped = 0;
+        std::size_t threads = 0;
+    };
+
+    TraceRecorder();
+    explicit TraceRecorder(Options options);
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    const Options& options() const { return options_; }
+
+    // A new track, one per client, shown as `label` and its number in the
+    // trace. Never 0.
+    std::uint64_t newTrack(std::string label);
+
+    void record(
+        const char* name,
+        std::uint64_t track,
+        TraceLane lane,
+        Clock::time_point start,
+        Clock::time_point end,
+        bool failed = false
+    );
+
+    // Whether a client's `count`th read or write should be traced
+    bool sampled(std::uint64_t count) const {
+        return options_.sample_every != 0 && count % options_.sample_every == 0;
+    }
+
+    // Spans recorded so far. Those still being recorded by other threads
+    // may be left out.
+    void write(std::ostream& out) const;
+
+    // Throws std::system_error if the file cannot be written
+    void writeFile(const std::string& path) const;
+
+    Stats stats() const;
+
+private:
+    struct Span {
+        const char* name;
+        std::uint64_t track;
+        std::int64_t start_ns;
+        std::int64_t end_ns;
+        TraceLane lane;
+        bool failed;
+    };
+
+    // Written by one thread only; `size` publishes its spans to readers
+    struct ThreadBuffer {
+        explicit ThreadBuffer(std::size_t capacity, std::size_t index)
+            : spans(new Span[capacity]), index(index) {}
+
+        std::unique_ptr<Span[]> spans;
+        std::atomic<std::size_t> size{0};
+        std::atomic<std::uint64_t> dropped{0};
+        std::size_t index;
+    };
+
+    ThreadBuffer& localBuffer();
+
+    const Options options_;
+    const std::uint64_t id_;
+    const Clock::time_point epoch_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+    std::unordered_map<std::thread::id, ThreadBuffer*> byThread_;
+    std::vector<std::string> tracks_;
+};
+
+} // namespace websocket_client
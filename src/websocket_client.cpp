@@ -1,9 +1,13 @@
 #include "websocket_client.hpp"
+#include "happy_eyeballs.hpp"
 #include <boost/beast/core.hpp>
 #include <boost/beast/ssl.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/websocket/ssl.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/strand.hpp>
+#include <algorithm>
+#include <charconv>
 
 namespace websocket_client {
 
@@ -11,12 +15,17 @@ WebSocketClient::WebSocketClient(
     boost::asio::io_context& ioc,
     boost::asio::ssl::context& ssl_ctx
 )
-    : resolver_(boost::asio::make_strand(ioc))
-    , ws_(boost::asio::make_strand(ioc), ssl_ctx)
-    , buffer_()
+    : strand_(boost::asio::make_strand(ioc))
+    , ssl_ctx_(ssl_ctx)
+    , resolver_(strand_)
+    , buffer_(BufferPool::global())
     , host_()
     , target_()
+    , reconnect_timer_(strand_)
+    , rng_(std::random_device{}())
+    , keepalive_timer_(strand_)
 {
+    reset_stream();
 }
 
 void WebSocketClient::connect(
@@ -24,27 +33,143 @@ void WebSocketClient::connect(
     const std::string& port,
     const std::string& target,
     MessageHandler onMessage,
-    ErrorHandler onError
+    ErrorHandler onError,
+    ConnectHandler onConnect
 )
 {
-    // Store handlers and connection info
+    // Copying adapter over the zero-copy path
+    MessageViewHandler on_message_view;
+    if(onMessage)
+    {
+        on_message_view = [onMessage = std::move(onMessage)](std::string_view message, Opcode)
+        {
+            onMessage(std::string(message));
+        };
+    }
+
+    connect(host, port, target, std::move(on_message_view), std::move(onError), std::move(onConnect));
+}
+
+void WebSocketClient::connect(
+    const std::string& host,
+    const std::string& port,
+    const std::string& target,
+    PooledMessageHandler onMessage,
+    ErrorHandler onError,
+    ConnectHandler onConnect
+)
+{
+    // Set before the connect is posted to the strand
+    message_handler_ = nullptr;
+    pooled_handler_ = std::move(onMessage);
+    chunk_handler_ = nullptr;
+    post_connect(host, port, target, std::move(onError), std::move(onConnect));
+}
+
+void WebSocketClient::connect(
+    const std::string& host,
+    const std::string& port,
+    const std::string& target,
+    MessageChunkHandler onChunk,
+    ErrorHandler onError,
+    ConnectHandler onConnect
+)
+{
+    // Set before the connect is posted to the strand
+    message_handler_ = nullptr;
+    pooled_handler_ = nullptr;
+    chunk_handler_ = std::move(onChunk);
+    post_connect(host, port, target, std::move(onError), std::move(onConnect));
+}
+
+void WebSocketClient::connect(
+    const std::string& host,
+    const std::string& port,
+    const std::string& target,
+    MessageViewHandler onMessage,
+    ErrorHandler onError,
+    ConnectHandler onConnect
+)
+{
+    // on_read prefers the other handler kinds, so drop any left from before
     message_handler_ = std::move(onMessage);
+    pooled_handler_ = nullptr;
+    chunk_handler_ = nullptr;
+    post_connect(host, port, target, std::move(onError), std::move(onConnect));
+}
+
+void WebSocketClient::post_connect(
+    const std::string& host,
+    const std::string& port,
+    const std::string& target,
+    ErrorHandler onError,
+    ConnectHandler onConnect
+)
+{
+    // Store handlers and connection info
     error_handler_ = std::move(onError);
+    connect_handler_ = std::move(onConnect);
     host_ = host;
+    port_ = port;
     target_ = target;
+    session_key_ = host + ":" + port;
+    reconnect_exhausted_ = false;
+    if(tracer_ && trace_track_ == 0)
+        trace_track_ = tracer_->newTrack(session_key_);
 
-    // Set SNI Hostname (many hosts need this to handshake successfully)
-    if(!SSL_set_tlsext_host_name(ws_.next_layer().native_handle(), host.c_str()))
+    boost::asio::post(
+        strand_,
+        boost::beast::bind_front_handler(
+            &WebSocketClient::start_connect,
+            shared_from_this()));
+}
+
+void WebSocketClient::reset_stream()
+{
+    ws_.emplace(counters_.wire_bytes_received, counters_.wire_bytes_sent, strand_, ssl_ctx_);
+    ws_->next_layer().next_layer().next_layer().setOptions(write_batch_, counters_.transport_writes);
+    ws_->next_layer().setExclusiveWrites(frame_encoder_enabled_);
+    ws_->next_layer().setReadClock(latency_ ? &last_read_ : nullptr);
+    ws_->set_option(toPermessageDeflate(compression_));
+    ws_->read_message_max(read_message_max_);
+    buffer_.clear();
+    handshake_response_ = {};
+
+    // Pongs to our keepalive pings arrive in the middle of reads
+    ws_->control_callback(
+        [this](boost::beast::websocket::frame_type kind, boost::beast::string_view payload)
+        {
+            on_control_frame(kind, payload);
+        });
+}
+
+void WebSocketClient::start_connect()
+{
+    connecting_ = true;
+    connect_started_ = std::chrono::steady_clock::now();
+
+    // Reuse addresses from our last connect, then from the shared cache
+    if(endpoints_.empty() && dns_cache_)
     {
-        boost::beast::error_code ec{static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()};
-        error_handler_("SSL set hostname failed: " + ec.message());
-        return;
+        if(auto cached = dns_cache_->lookup(host_, port_))
+            endpoints_.assign(cached->begin(), cached->end());
     }
 
+    if(endpoints_.empty())
+        do_resolve();
+    else
+        do_connect();
+}
+
+void WebSocketClient::do_resolve()
+{
+    if(tracer_)
+        phase_started_ = TraceRecorder::Clock::now();
+
     // Look up the domain name
     resolver_.async_resolve(
-        host,
-        port,
+        host_,
+        port_,
         boost::beast::bind_front_handler(
             &WebSocketClient::on_resolve,
             shared_from_this()));
@@ -55,18 +180,31 @@ void WebSocketClient::on_resolve(
     boost::asio::ip::tcp::resolver::results_type results
 )
 {
+    trace_span("resolve", TraceLane::lifecycle, phase_started_, bool(ec));
     if(ec)
     {
-        error_handler_("Resolve failed: " + ec.message());
+        fail("Resolve failed: " + ec.message());
         return;
     }
 
-    // Set a timeout on the operation
-    boost::beast::get_lowest_layer(ws_).expires_after(std::chrono::seconds(30));
+    // Reconnects go straight to these addresses
+    endpoints_.assign(results.begin(), results.end());
+    if(dns_cache_)
+        dns_cache_->store(host_, port_, std::move(results));
+    do_connect();
+}
+
+void WebSocketClient::do_connect()
+{
+    if(tracer_)
+        phase_started_ = TraceRecorder::Clock::now();
 
-    // Make the connection on the IP address we get from a lookup
-    boost::beast::get_lowest_layer(ws_).async_connect(
-        results,
+    // Race the addresses so a dead one costs 250 ms, not the whole timeout
+    asyncConnectHappyEyeballs(
+        strand_,
+        endpoints_,
+        kConnectionAttemptDelay,
+        std::chrono::seconds(30),
         boost::beast::bind_front_handler(
             &WebSocketClient::on_connect,
             shared_from_this()));
@@ -74,22 +212,49 @@ void WebSocketClient::on_resolve(
 
 void WebSocketClient::on_connect(
     boost::beast::error_code ec,
-    boost::asio::ip::tcp::resolver::endpoint_type ep
+    boost::asio::ip::tcp::socket socket,
+    boost::asio::ip::tcp::endpoint ep
 )
 {
     boost::ignore_unused(ep);
     
+    trace_span("tcp_connect", TraceLane::lifecycle, phase_started_, bool(ec));
     if(ec)
     {
-        error_handler_("Connect failed: " + ec.message());
+        // The cached addresses may be stale; look them up again next time
+        endpoints_.clear();
+        if(dns_cache_)
+            dns_cache_->invalidate(host_, port_);
+        fail("Connect failed: " + ec.message());
+        return;
+    }
+
+    // Small messages go out now rather than waiting on delayed ACKs
+    boost::beast::error_code ignored;
+    socket.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+    boost::beast::get_lowest_layer(*ws_).socket() = std::move(socket);
+
+    SSL* ssl = ws_->next_layer().next_layer().native_handle();
+
+    // Set SNI Hostname (many hosts need this to handshake successfully)
+    if(!SSL_set_tlsext_host_name(ssl, host_.c_str()))
+    {
+        boost::beast::error_code ssl_ec{static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()};
+        fail("SSL set hostname failed: " + ssl_ec.message());
         return;
     }
 
     // Set a timeout on the operation
-    boost::beast::get_lowest_layer(ws_).expires_after(std::chrono::seconds(30));
+    boost::beast::get_lowest_layer(*ws_).expires_after(std::chrono::seconds(30));
+
+    // Offer a cached session so the handshake can be abbreviated
+    if(session_cache_)
+        session_cache_->prepare(ssl, session_key_);
 
     // Perform the SSL handshake
-    ws_.next_layer().async_handshake(
+    if(tracer_)
+        phase_started_ = TraceRecorder::Clock::now();
+    ws_->next_layer().next_layer().async_handshake(
         boost::asio::ssl::stream_base::client,
         boost::beast::bind_front_handler(
             &WebSocketClient::on_ssl_handshake,
@@ -98,23 +263,31 @@ void WebSocketClient::on_connect(
 
 void WebSocketClient::on_ssl_handshake(boost::beast::error_code ec)
 {
+    trace_span("tls_handshake", TraceLane::lifecycle, phase_started_, bool(ec));
     if(ec)
     {
-        error_handler_("SSL handshake failed: " + ec.message());
+        fail("SSL handshake failed: " + ec.message());
         return;
     }
 
+    const bool resumed = session_cache_
+        && session_cache_->recordHandshake(ws_->next_layer().next_layer().native_handle());
+    (resumed ? counters_.tls_resumed_handshakes : counters_.tls_full_handshakes)
+        .fetch_add(1, std::memory_order_relaxed);
+
     // Turn off the timeout on the tcp_stream, because
     // the websocket stream has its own timeout system.
-    boost::beast::get_lowest_layer(ws_).expires_never();
+    boost::beast::get_lowest_layer(*ws_).expires_never();
 
     // Set suggested timeout settings for the websocket
-    ws_.set_option(
+    ws_->set_option(
         boost::beast::websocket::stream_base::timeout::suggested(
             boost::beast::role_type::client));
 
     // Perform the websocket handshake
-    ws_.async_handshake(host_, target_,
+    if(tracer_)
+        phase_started_ = TraceRecorder::Clock::now();
+    ws_->async_handshake(handshake_response_, host_, target_,
         boost::beast::bind_front_handler(
             &WebSocketClient::on_handshake,
             shared_from_this()));
@@ -122,19 +295,78 @@ void WebSocketClient::on_ssl_handshake(boost::beast::error_code ec)
 
 void WebSocketClient::on_handshake(boost::beast::error_code ec)
 {
+    trace_span("ws_handshake", TraceLane::lifecycle, phase_started_, bool(ec));
     if(ec)
     {
-        error_handler_("Websocket handshake failed: " + ec.message());
+        fail("Websocket handshake failed: " + ec.message());
         return;
     }
 
+    if(tracer_)
+    {
+        trace_span("connect", TraceLane::lifecycle, connect_started_);
+        handshake_done_ = TraceRecorder::Clock::now();
+        awaiting_first_message_ = true;
+    }
+
+    connecting_ = false;
+    connected_ = true;
+    open_ = true;
+    counters_.onConnected(static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - connect_started_).count()));
+    counters_.compression_negotiated.store(
+        handshake_response_[boost::beast::http::field::sec_websocket_extensions]
+            .find("permessage-deflate") != boost::beast::string_view::npos,
+        std::memory_order_relaxed);
+
+    if(reconnecting_)
+    {
+        reconnecting_ = false;
+        reconnect_attempt_ = 0;
+        counters_.reconnects.fetch_add(1, std::memory_order_relaxed);
+        if(reconnect_handler_)
+            reconnect_handler_(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - outage_start_));
+    }
+
+    // Notify that connection is established
+    if(connect_handler_)
+        connect_handler_();
+
+    // Flush anything that was sent before the handshake finished
+    do_write();
+
     // Start reading messages
     do_read();
+
+    start_keepalive();
 }
 
 void WebSocketClient::do_read()
 {
-    ws_.async_read(
+    read_in_flight_ = true;
+    if(tracer_)
+    {
+        read_traced_ = tracer_->sampled(reads_seen_++);
+        if(read_traced_)
+            read_started_ = TraceRecorder::Clock::now();
+    }
+
+    if(chunk_handler_)
+    {
+        // Whatever has arrived, up to one chunk, without waiting for the
+        // rest of the message
+        ws_->async_read_some(
+            buffer_,
+            read_chunk_size_,
+            boost::beast::bind_front_handler(
+                &WebSocketClient::on_read,
+                shared_from_this()));
+        return;
+    }
+
+    ws_->async_read(
         buffer_,
         boost::beast::bind_front_handler(
             &WebSocketClient::on_read,
@@ -146,76 +378,819 @@ void WebSocketClient::on_read(
     std::size_t bytes_transferred
 )
 {
-    boost::ignore_unused(bytes_transferred);
+    read_in_flight_ = false;
+    if(read_traced_)
+    {
+        read_traced_ = false;
+        trace_span("read", TraceLane::reads, read_started_, bool(ec));
+    }
 
     if(ec)
     {
-        if(ec != boost::beast::websocket::error::closed)
-            error_handler_("Read failed: " + ec.message());
+        // A read cut short by our own close is not an error
+        if(closing_)
+            return;
+
+        // Nor is one cut short by tearing down a connection already lost
+        if(reconnecting_)
+        {
+            schedule_reconnect();
+            return;
+        }
+
+        // The server closing is not a failed read
+        if(ec == boost::beast::websocket::error::closed)
+        {
+            fail(close_notice());
+            return;
+        }
+
+        fail("Read failed: " + ec.message());
         return;
     }
 
-    // Handle the message
-    message_handler_(boost::beast::buffers_to_string(buffer_.data()));
+    // The message was complete as of the last transport read
+    MessageLatencyRecorder::Clock::time_point delivered;
+    if(latency_)
+    {
+        delivered = MessageLatencyRecorder::Clock::now();
+        latency_->delivery.record(MessageLatencyRecorder::elapsed(last_read_, delivered));
+    }
+
+    if(awaiting_first_message_)
+    {
+        awaiting_first_message_ = false;
+        trace_span("first_message", TraceLane::lifecycle, handshake_done_);
+    }
+
+    const Opcode opcode = ws_->got_binary() ? Opcode::binary : Opcode::text;
+    if(chunk_handler_)
+    {
+        const bool last = ws_->is_message_done();
+        counters_.onReceivedPart(bytes_transferred, last);
+
+        const auto data = buffer_.data();
+        chunk_handler_(
+            std::string_view(static_cast<const char*>(data.data()), data.size()),
+            opcode,
+            last);
+        buffer_.clear();
+    }
+    else if(pooled_handler_)
+    {
+        counters_.onReceived(bytes_transferred);
+        // The block leaves with the message; the next read takes a new one
+        pooled_handler_(buffer_.detach(), opcode);
+    }
+    else
+    {
+        counters_.onReceived(bytes_transferred);
+
+        if(message_handler_)
+        {
+            // Hand the message over in place; the view dies with the clear below
+            const auto data = buffer_.data();
+            message_handler_(
+                std::string_view(static_cast<const char*>(data.data()), data.size()),
+                opcode);
+        }
+        buffer_.clear();
+    }
 
-    // Clear the buffer
-    buffer_.consume(buffer_.size());
+    if(latency_)
+    {
+        latency_->handler.record(
+            MessageLatencyRecorder::elapsed(delivered, MessageLatencyRecorder::Clock::now()));
+    }
 
     // Queue up another read
     do_read();
 }
 
-void WebSocketClient::send(const std::string& message)
+void WebSocketClient::send(std::string message)
+{
+    if(!canSend())
+    {
+        if(error_handler_)
+            error_handler_("Not connected");
+        return;
+    }
+
+    OutboundMessage queued;
+    queued.payload = std::move(message);
+    enqueue(std::move(queued));
+}
+
+void WebSocketClient::sendBinary(const std::vector<uint8_t>& data)
+{
+    if(!canSend())
+    {
+        if(error_handler_)
+            error_handler_("Not connected");
+        return;
+    }
+
+    OutboundMessage message;
+    message.payload.assign(data.begin(), data.end());
+    message.binary = true;
+    enqueue(std::move(message));
+}
+
+bool WebSocketClient::send(SharedPayload payload)
+{
+    if(!canSend())
+    {
+        if(error_handler_)
+            error_handler_("Not connected");
+        return false;
+    }
+
+    OutboundMessage message;
+    message.binary = payload.isBinary();
+    message.shared = std::move(payload);
+    enqueue(std::move(message));
+    return true;
+}
+
+bool WebSocketClient::trySend(std::string message)
+{
+    if(is_backpressured() || !canSend())
+        return false;
+
+    OutboundMessage queued;
+    queued.payload = std::move(message);
+    enqueue(std::move(queued));
+    return true;
+}
+
+bool WebSocketClient::trySendBinary(const std::vector<uint8_t>& data)
+{
+    if(is_backpressured() || !canSend())
+        return false;
+
+    OutboundMessage message;
+    message.payload.assign(data.begin(), data.end());
+    message.binary = true;
+    enqueue(std::move(message));
+    return true;
+}
+
+bool WebSocketClient::trySend(SharedPayload payload)
+{
+    if(is_backpressured() || !canSend())
+        return false;
+
+    OutboundMessage message;
+    message.binary = payload.isBinary();
+    message.shared = std::move(payload);
+    enqueue(std::move(message));
+    return true;
+}
+
+void WebSocketClient::sendFile(const std::string& path, bool binary)
+{
+    sendFile(MappedFile::open(path), binary);
+}
+
+void WebSocketClient::sendFile(std::shared_ptr<const MappedFile> file, bool binary)
+{
+    if(!canSend())
+    {
+        if(error_handler_)
+            error_handler_("Not connected");
+        return;
+    }
+
+    OutboundMessage message;
+    message.binary = binary;
+    message.file = std::move(file);
+    enqueue(std::move(message));
+}
+
+void WebSocketClient::enqueue(OutboundMessage message)
+{
+    if(latency_)
+        message.queued_at = MessageLatencyRecorder::Clock::now();
+
+    // Counted before the push, so the strand never sees it uncounted
+    counters_.onQueued(message.size());
+    write_queue_.push(std::move(message));
+
+    // Wake the strand unless a wakeup is already pending
+    if(!write_scheduled_.exchange(true, std::memory_order_acq_rel))
+    {
+        boost::asio::post(
+            strand_,
+            boost::beast::bind_front_handler(
+                &WebSocketClient::on_write_scheduled,
+                shared_from_this()));
+    }
+}
+
+void WebSocketClient::on_write_scheduled()
 {
-    ws_.async_write(
-        boost::asio::buffer(message),
+    // Clear the flag before draining so a concurrent send() either lands in
+    // this drain or schedules a new one.
+    write_scheduled_.exchange(false, std::memory_order_acq_rel);
+    update_backpressure();
+    do_write();
+}
+
+bool WebSocketClient::is_backpressured() const
+{
+    // The strand may not have caught up with the producers yet
+    return backpressured_.load(std::memory_order_acquire)
+        || backpressure_.reachedHigh(
+            counters_.queued_bytes.load(std::memory_order_relaxed),
+            counters_.queued_messages.load(std::memory_order_relaxed));
+}
+
+void WebSocketClient::update_backpressure()
+{
+    if(!backpressure_.enabled())
+        return;
+
+    const std::uint64_t bytes = counters_.queued_bytes.load(std::memory_order_relaxed);
+    const std::uint64_t messages = counters_.queued_messages.load(std::memory_order_relaxed);
+    const bool was = backpressured_.load(std::memory_order_relaxed);
+    const bool now = was
+        ? !backpressure_.drainedToLow(bytes, messages)
+        : backpressure_.reachedHigh(bytes, messages);
+    if(now == was)
+        return;
+
+    backpressured_.store(now, std::memory_order_release);
+    counters_.onBackpressure(now);
+    if(backpressure_handler_)
+        backpressure_handler_(now);
+}
+
+void WebSocketClient::do_write()
+{
+    // Only one write may be in flight on the stream at a time
+    if(write_in_flight_ || !open_ || closing_)
+        return;
+
+    // A message interrupted by a drop goes out first on the new connection
+    const bool resend = resend_current_;
+    if(!resend)
+    {
+        auto next = write_queue_.pop();
+        if(!next)
+        {
+            maybe_close();
+            return;
+        }
+        current_write_ = std::move(*next);
+        current_masked_ = false;
+    }
+    else if(current_masked_)
+    {
+        // Unmasked again, since the new connection may have negotiated
+        // compression and need the plain bytes
+        maskInPlace(current_write_.payload.data(), current_write_.payload.size(), frame_header_.key);
+        current_masked_ = false;
+    }
+
+    resend_current_ = false;
+    write_in_flight_ = true;
+
+    if(latency_ || tracer_)
+    {
+        write_started_ = MessageLatencyRecorder::Clock::now();
+        if(latency_ && !resend)
+        {
+            latency_->queue_wait.record(
+                MessageLatencyRecorder::elapsed(current_write_.queued_at, write_started_));
+        }
+        write_traced_ = tracer_ && tracer_->sampled(writes_seen_++);
+    }
+
+    // The frame type travels with the message, so set it per write
+    ws_->binary(current_write_.binary);
+
+    if(current_write_.file)
+    {
+        // A resend starts the message over
+        write_offset_ = 0;
+        write_fragment();
+        return;
+    }
+
+    // Shared bytes are read in place and masked by the stream as it copies
+    // them out, since masking in place would change them for everyone
+    if(current_write_.shared)
+    {
+        ws_->async_write(
+            boost::asio::buffer(current_write_.shared.data(), current_write_.shared.size()),
+            boost::beast::bind_front_handler(
+                &WebSocketClient::on_write,
+                shared_from_this()));
+        return;
+    }
+
+    if(frame_encoder_enabled_
+        && !counters_.compression_negotiated.load(std::memory_order_relaxed))
+    {
+        write_encoded();
+        return;
+    }
+
+    ws_->async_write(
+        boost::asio::buffer(current_write_.payload),
         boost::beast::bind_front_handler(
             &WebSocketClient::on_write,
             shared_from_this()));
 }
 
-void WebSocketClient::sendBinary(const std::vector<uint8_t>& data)
+void WebSocketClient::write_encoded()
 {
-    // Set binary mode
-    ws_.binary(true);
-    
-    ws_.async_write(
-        boost::asio::buffer(data),
+    frame_header_ = frame_encoder_.encode(
+        current_write_.binary, current_write_.payload.data(), current_write_.payload.size());
+    current_masked_ = true;
+
+    // Header and payload in one write below the websocket stream. With
+    // exclusive writes on it is carried out in full, so a pong the stream
+    // sends meanwhile waits for it instead of landing inside the frame.
+    ws_->next_layer().async_write_some(
+        boost::beast::buffers_cat(
+            frame_header_.buffer(),
+            boost::asio::buffer(current_write_.payload)),
         boost::beast::bind_front_handler(
-            &WebSocketClient::on_write,
+            &WebSocketClient::on_write_encoded,
             shared_from_this()));
 }
 
+void WebSocketClient::on_write_encoded(
+    boost::beast::error_code ec,
+    std::size_t bytes_transferred
+)
+{
+    // Report payload bytes, as the websocket stream does
+    const std::size_t header_size = frame_header_.size;
+    on_write(ec, bytes_transferred > header_size ? bytes_transferred - header_size : 0);
+}
+
+void WebSocketClient::write_fragment()
+{
+    const MappedFile& file = *current_write_.file;
+    const std::size_t size = std::min(write_fragment_size_, file.size() - write_offset_);
+    const bool fin = write_offset_ + size == file.size();
+
+    ws_->async_write_some(
+        fin,
+        boost::asio::buffer(file.data() + write_offset_, size),
+        boost::beast::bind_front_handler(
+            &WebSocketClient::on_write_fragment,
+            shared_from_this()));
+}
+
+void WebSocketClient::on_write_fragment(
+    boost::beast::error_code ec,
+    std::size_t bytes_transferred
+)
+{
+    if(ec)
+    {
+        on_write(ec, write_offset_ + bytes_transferred);
+        return;
+    }
+
+    // Sent pages leave our RSS so memory stays flat however big the file
+    const MappedFile& file = *current_write_.file;
+    file.release(write_offset_, bytes_transferred);
+    write_offset_ += bytes_transferred;
+
+    if(write_offset_ < file.size())
+    {
+        write_fragment();
+        return;
+    }
+
+    on_write(ec, write_offset_);
+}
+
 void WebSocketClient::on_write(
     boost::beast::error_code ec,
     std::size_t bytes_transferred
 )
 {
-    boost::ignore_unused(bytes_transferred);
+    write_in_flight_ = false;
+    if(write_traced_)
+    {
+        write_traced_ = false;
+        trace_span("write", TraceLane::writes, write_started_, bool(ec));
+    }
 
     if(ec)
     {
-        error_handler_("Write failed: " + ec.message());
+        // The peer may or may not have seen it; sending it again is the
+        // only way not to lose it
+        resend_current_ = reconnect_policy_.enabled && !close_requested_;
+        if(!resend_current_)
+        {
+            counters_.onDequeued(current_write_.size());
+            current_write_.payload.clear();
+            current_write_.file.reset();
+            current_write_.shared.reset();
+            update_backpressure();
+        }
+
+        if(reconnecting_)
+            schedule_reconnect();
+        else
+            fail("Write failed: " + ec.message());
         return;
     }
-    
-    // Reset to text mode after any write
-    ws_.binary(false);
+
+    if(latency_)
+    {
+        latency_->write.record(
+            MessageLatencyRecorder::elapsed(write_started_, MessageLatencyRecorder::Clock::now()));
+    }
+
+    counters_.onDequeued(current_write_.size());
+    current_write_.payload.clear();
+    current_write_.file.reset();
+    current_write_.shared.reset();
+    counters_.onSent(bytes_transferred);
+    update_backpressure();
+
+    do_write();
 }
 
 void WebSocketClient::close()
 {
-    ws_.async_close(boost::beast::websocket::close_code::normal,
+    connected_ = false;
+
+    boost::asio::post(
+        strand_,
+        boost::beast::bind_front_handler(
+            &WebSocketClient::do_close,
+            shared_from_this()));
+}
+
+void WebSocketClient::do_close()
+{
+    close_requested_ = true;
+    maybe_close();
+}
+
+void WebSocketClient::maybe_close()
+{
+    if(!close_requested_ || closing_)
+        return;
+
+    // A connect in progress finishes first and calls back in here
+    if(connecting_)
+        return;
+
+    // Let the queue drain first; on_write calls back in here when it is empty
+    if(open_ && (write_in_flight_ || resend_current_ || !write_queue_.empty()))
+        return;
+
+    closing_ = true;
+    keepalive_timer_.cancel();
+
+    if(!open_)
+    {
+        // Nothing to close gracefully: drop any pending reconnect
+        reconnecting_ = false;
+        reconnect_timer_.cancel();
+        boost::beast::get_lowest_layer(*ws_).close();
+        return;
+    }
+
+    ws_->async_close(boost::beast::websocket::close_code::normal,
         boost::beast::bind_front_handler(
             &WebSocketClient::on_close,
             shared_from_this()));
 }
 
+void WebSocketClient::start_keepalive()
+{
+    if(keepalive_.interval.count() <= 0)
+        return;
+
+    awaiting_pong_ = false;
+    missed_pongs_ = 0;
+
+    // Re-arming also cancels a wait left over from the last connection
+    keepalive_timer_.expires_after(keepalive_.interval);
+    keepalive_timer_.async_wait(
+        boost::beast::bind_front_handler(
+            &WebSocketClient::on_keepalive_timer,
+            shared_from_this()));
+}
+
+void WebSocketClient::on_keepalive_timer(boost::beast::error_code ec)
+{
+    if(ec || !open_ || closing_)
+        return;
+
+    if(awaiting_pong_)
+    {
+        counters_.missed_pongs.fetch_add(1, std::memory_order_relaxed);
+        if(++missed_pongs_ >= keepalive_.max_missed)
+        {
+            fail("Keepalive failed: no pong for "
+                + std::to_string(missed_pongs_) + " pings");
+
+            // A reconnect tears the stream down itself; otherwise close it
+            // here, or the read would wait on the silent peer indefinitely
+            if(!reconnecting_ && !closing_)
+            {
+                closing_ = true;
+                boost::beast::get_lowest_layer(*ws_).close();
+            }
+            return;
+        }
+    }
+
+    // While the last ping is still stuck behind a write there is no point
+    // queueing another
+    awaiting_pong_ = true;
+    if(!ping_in_flight_)
+    {
+        const auto sent = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        const std::string stamp = std::to_string(sent);
+
+        ping_in_flight_ = true;
+        counters_.pings_sent.fetch_add(1, std::memory_order_relaxed);
+        ws_->async_ping(
+            boost::beast::websocket::ping_data(stamp.data(), stamp.size()),
+            boost::beast::bind_front_handler(
+                &WebSocketClient::on_ping,
+                shared_from_this()));
+    }
+
+    keepalive_timer_.expires_after(keepalive_.interval);
+    keepalive_timer_.async_wait(
+        boost::beast::bind_front_handler(
+            &WebSocketClient::on_keepalive_timer,
+            shared_from_this()));
+}
+
+void WebSocketClient::on_ping(boost::beast::error_code ec)
+{
+    ping_in_flight_ = false;
+
+    // A failed ping means a failed connection, which the read reports
+    if(ec && reconnecting_)
+        schedule_reconnect();
+}
+
+void WebSocketClient::on_control_frame(
+    boost::beast::websocket::frame_type kind,
+    boost::beast::string_view payload
+)
+{
+    if(kind != boost::beast::websocket::frame_type::pong)
+        return;
+
+    // Anything but one of our stamps is an unsolicited pong
+    std::int64_t sent = 0;
+    const char* end = payload.data() + payload.size();
+    const auto parsed = std::from_chars(payload.data(), end, sent);
+    const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    if(parsed.ec != std::errc() || parsed.ptr != end || sent > now)
+        return;
+
+    awaiting_pong_ = false;
+    missed_pongs_ = 0;
+    counters_.pongs_received.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(ping_rtt_mutex_);
+    ping_rtt_.record(static_cast<std::uint64_t>(now - sent));
+}
+
+void WebSocketClient::fail(const std::string& message)
+{
+    if(connecting_)
+        trace_span("connect", TraceLane::lifecycle, connect_started_, true);
+
+    connecting_ = false;
+    connected_ = false;
+    open_ = false;
+    keepalive_timer_.cancel();
+
+    // Errors after close() are just the connection going away
+    if(closing_)
+        return;
+
+    if(error_handler_)
+        error_handler_(message);
+
+    if(close_requested_)
+    {
+        maybe_close();
+        return;
+    }
+
+    begin_reconnect();
+}
+
+std::string WebSocketClient::close_notice() const
+{
+    // Add the code and reason from the server's close frame, if it sent any
+    auto const& reason = ws_->reason();
+    std::string notice = "Server closed the connection";
+    if(reason.code != boost::beast::websocket::close_code::none)
+    {
+        notice += " (" + std::to_string(reason.code);
+        if(!reason.reason.empty())
+            notice += ": " + std::string(reason.reason.data(), reason.reason.size());
+        notice += ")";
+    }
+    return notice;
+}
+
+void WebSocketClient::begin_reconnect()
+{
+    if(!reconnect_policy_.enabled || close_requested_)
+        return;
+
+    // Retries after a failed attempt keep the original outage start
+    if(!reconnecting_)
+    {
+        reconnecting_ = true;
+        reconnect_attempt_ = 0;
+        outage_start_ = std::chrono::steady_clock::now();
+    }
+
+    schedule_reconnect();
+}
+
+void WebSocketClient::schedule_reconnect()
+{
+    if(reconnect_timer_armed_)
+        return;
+
+    // The old stream may only be replaced once nothing is pending on it;
+    // closing the socket makes the read, write and ping finish and call
+    // back here
+    if(read_in_flight_ || write_in_flight_ || ping_in_flight_)
+    {
+        boost::beast::get_lowest_layer(*ws_).close();
+        return;
+    }
+
+    const std::size_t attempt = ++reconnect_attempt_;
+    if(reconnect_policy_.max_attempts && attempt > reconnect_policy_.max_attempts)
+    {
+        reconnecting_ = false;
+        reconnect_exhausted_ = true;
+        if(error_handler_)
+            error_handler_("reconnect: gave up after "
+                + std::to_string(reconnect_policy_.max_attempts) + " attempts");
+        return;
+    }
+
+    reconnect_timer_armed_ = true;
+    if(tracer_)
+        backoff_started_ = TraceRecorder::Clock::now();
+    reconnect_timer_.expires_after(reconnect_policy_.delayFor(attempt, rng_));
+    reconnect_timer_.async_wait(
+        boost::beast::bind_front_handler(
+            &WebSocketClient::on_reconnect_timer,
+            shared_from_this()));
+}
+
+void WebSocketClient::on_reconnect_timer(boost::beast::error_code ec)
+{
+    reconnect_timer_armed_ = false;
+    if(ec || !reconnecting_)
+        return;
+
+    trace_span("reconnect_backoff", TraceLane::lifecycle, backoff_started_);
+    reset_stream();
+    start_connect();
+}
+
+void WebSocketClient::setCompression(const CompressionOptions& options)
+{
+    compression_ = options;
+    ws_->set_option(toPermessageDeflate(compression_));
+}
+
+void WebSocketClient::setSessionCache(std::shared_ptr<TlsSessionCache> cache)
+{
+    session_cache_ = std::move(cache);
+}
+
+void WebSocketClient::setReadMessageMax(std::uint64_t bytes)
+{
+    read_message_max_ = bytes;
+    ws_->read_message_max(read_message_max_);
+}
+
+void WebSocketClient::setReadChunkSize(std::size_t bytes)
+{
+    read_chunk_size_ = bytes;
+}
+
+void WebSocketClient::setWriteFragmentSize(std::size_t bytes)
+{
+    write_fragment_size_ = bytes;
+}
+
+void WebSocketClient::setWriteBatching(const WriteBatchOptions& options)
+{
+    write_batch_ = options;
+    ws_->next_layer().next_layer().next_layer().setOptions(write_batch_, counters_.transport_writes);
+}
+
+void WebSocketClient::setFrameEncoder(bool enabled)
+{
+    frame_encoder_enabled_ = enabled;
+    ws_->next_layer().setExclusiveWrites(frame_encoder_enabled_);
+}
+
+void WebSocketClient::setBufferPool(std::shared_ptr<BufferPool> pool)
+{
+    buffer_.setPool(std::move(pool));
+}
+
+void WebSocketClient::setLatencyTracking(bool enabled)
+{
+    if(enabled && !latency_)
+        latency_ = std::make_unique<MessageLatencyRecorder>();
+    else if(!enabled)
+        latency_.reset();
+    ws_->next_layer().setReadClock(latency_ ? &last_read_ : nullptr);
+}
+
+bool WebSocketClient::canSend() const
+{
+    return connected_ || (reconnect_policy_.enabled && !reconnect_exhausted_);
+}
+
+void WebSocketClient::setTracer(std::shared_ptr<TraceRecorder> tracer)
+{
+    tracer_ = std::move(tracer);
+    trace_track_ = 0;
+}
+
+void WebSocketClient::trace_span(
+    const char* name,
+    TraceLane lane,
+    TraceRecorder::Clock::time_point start,
+    bool failed
+)
+{
+    if(tracer_)
+        tracer_->record(name, trace_track_, lane, start, TraceRecorder::Clock::now(), failed);
+}
+
+void WebSocketClient::setDnsCache(std::shared_ptr<DnsCache> cache)
+{
+    dns_cache_ = std::move(cache);
+}
+
+void WebSocketClient::setReconnectPolicy(const ReconnectPolicy& policy, ReconnectHandler onReconnect)
+{
+    reconnect_policy_ = policy;
+    reconnect_handler_ = std::move(onReconnect);
+}
+
+void WebSocketClient::setKeepalive(const KeepalivePolicy& policy)
+{
+    keepalive_ = policy;
+}
+
+void WebSocketClient::setBackpressure(const BackpressurePolicy& policy, BackpressureHandler onBackpressure)
+{
+    backpressure_ = policy;
+    backpressure_handler_ = std::move(onBackpressure);
+}
+
+ConnectionStats WebSocketClient::stats() const
+{
+    return counters_.snapshot();
+}
+
+LatencyHistogram WebSocketClient::pingRtt() const
+{
+    std::lock_guard<std::mutex> lock(ping_rtt_mutex_);
+    return ping_rtt_;
+}
+
+MessageLatency WebSocketClient::latency() const
+{
+    return latency_ ? latency_->snapshot() : MessageLatency();
+}
+
 void WebSocketClient::on_close(boost::beast::error_code ec)
 {
+    connected_ = false;
+    open_ = false;
+
     if(ec)
     {
-        error_handler_("Close failed: " + ec.message());
+        if(error_handler_)
+            error_handler_("Close failed: " + ec.message());
         return;
     }
 }
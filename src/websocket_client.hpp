@@ -4,10 +4,35 @@
 #include <boost/beast/ssl.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/websocket/ssl.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
+#include "backpressure_policy.hpp"
+#include "buffer_pool.hpp"
+#include "coalescing_stream.hpp"
+#include "compression_options.hpp"
+#include "connection_stats.hpp"
+#include "dns_cache.hpp"
+#include "frame_encoder.hpp"
+#include "keepalive_policy.hpp"
+#include "latency_histogram.hpp"
+#include "message_latency.hpp"
+#include "message_types.hpp"
+#include "metered_stream.hpp"
+#include "mpsc_queue.hpp"
+#include "reconnect_policy.hpp"
+#include "shared_payload.hpp"
+#include "tls_session_cache.hpp"
+#include "trace_recorder.hpp"
+#include "write_batch_options.hpp"
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace websocket_client {
@@ -15,7 +40,15 @@ namespace websocket_client {
 class WebSocketClient : public std::enable_shared_from_this<WebSocketClient> {
 public:
     using MessageHandler = std::function<void(const std::string&)>;
+    // Receives a view into the read buffer, valid only until it returns.
+    using MessageViewHandler = std::function<void(std::string_view, Opcode)>;
+    // Receives a pooled handle that may be kept after it returns.
+    using PooledMessageHandler = std::function<void(PooledMessage, Opcode)>;
+    // Receives a message piece by piece as it arrives; `last` is set on the
+    // final piece. Each view is valid only until the handler returns.
+    using MessageChunkHandler = std::function<void(std::string_view, Opcode, bool last)>;
     using ErrorHandler = std::function<void(const std::string&)>;
+    using ConnectHandler = std::function<void()>;
 
     WebSocketClient(
         boost::asio::io_context& ioc,
@@ -27,39 +60,302 @@ public:
         const std::string& port,
         const std::string& target,
         MessageHandler onMessage,
-        ErrorHandler onError
+        ErrorHandler onError,
+        ConnectHandler onConnect = nullptr
     );
 
-    void send(const std::string& message);
+    // Zero-copy variant: messages are delivered straight from the read buffer
+    void connect(
+        const std::string& host,
+        const std::string& port,
+        const std::string& target,
+        MessageViewHandler onMessage,
+        ErrorHandler onError,
+        ConnectHandler onConnect = nullptr
+    );
+
+    // Hand-off variant: each message is passed on without a copy and its
+    // block returns to the buffer pool once the last handle is dropped
+    void connect(
+        const std::string& host,
+        const std::string& port,
+        const std::string& target,
+        PooledMessageHandler onMessage,
+        ErrorHandler onError,
+        ConnectHandler onConnect = nullptr
+    );
+
+    // Streaming variant: messages are delivered in pieces of at most
+    // setReadChunkSize() bytes as they arrive, so a large message is never
+    // held in memory whole
+    void connect(
+        const std::string& host,
+        const std::string& port,
+        const std::string& target,
+        MessageChunkHandler onChunk,
+        ErrorHandler onError,
+        ConnectHandler onConnect = nullptr
+    );
+
+    // Thread-safe: messages are queued and written one at a time on the
+    // stream's strand, in the order they were sent. Without a reconnect
+    // policy, sending while disconnected reports "Not connected"; with one,
+    // the message waits for the next connection, until the policy gives up.
+    void send(std::string message);
     void sendBinary(const std::vector<uint8_t>& data);
+
+    // Queue bytes that other clients may be sending too, without copying
+    // them. Text or binary as the payload says. Never goes through the
+    // frame encoder, which masks in place. Returns false if the client
+    // could not take it, after reporting "Not connected".
+    bool send(SharedPayload payload);
+
+    // Like send(), but instead of queueing returns false while the client
+    // is backpressured or, without a reconnect policy, disconnected.
+    bool trySend(std::string message);
+    bool trySendBinary(const std::vector<uint8_t>& data);
+    bool trySend(SharedPayload payload);
+
+    // Send a file as one message without reading it into memory. It is
+    // mapped and written in setWriteFragmentSize() fragments; messages
+    // queued behind it go out once it is complete. Throws
+    // std::system_error if the file cannot be mapped.
+    void sendFile(const std::string& path, bool binary = true);
+    void sendFile(std::shared_ptr<const MappedFile> file, bool binary = true);
+
+    // Closes the connection once every queued message has been written.
+    // During a reconnect outage the pending attempt is abandoned instead.
     void close();
 
+    // Offer permessage-deflate on the next handshake. Call before connect().
+    void setCompression(const CompressionOptions& options);
+
+    // Offer and capture TLS sessions through `cache`, which must be attached
+    // to the ssl::context this client was built with. Call before connect().
+    void setSessionCache(std::shared_ptr<TlsSessionCache> cache);
+
+    // Share resolver results with other clients. Call before connect().
+    void setDnsCache(std::shared_ptr<DnsCache> cache);
+
+    // Reconnect automatically after the connection drops, keeping unsent
+    // messages queued. `onReconnect` runs on the client's strand after each
+    // reconnect handshake, before the connect handler. Call before connect().
+    void setReconnectPolicy(const ReconnectPolicy& policy, ReconnectHandler onReconnect = nullptr);
+
+    // Ping the server periodically, timing the pongs and failing the
+    // connection once too many go unanswered. Call before connect().
+    void setKeepalive(const KeepalivePolicy& policy);
+
+    // Watermarks on the outbound queue. `onBackpressure` runs on the
+    // client's strand whenever the client becomes backpressured or
+    // recovers. Call before connect().
+    void setBackpressure(const BackpressurePolicy& policy, BackpressureHandler onBackpressure = nullptr);
+
+    // Largest message accepted, in bytes (0 = no limit). A bigger one fails
+    // the connection instead of growing the buffer. Defaults to 16 MiB.
+    // Call before connect().
+    void setReadMessageMax(std::uint64_t bytes);
+
+    // Largest piece handed to a MessageChunkHandler. Call before connect().
+    void setReadChunkSize(std::size_t bytes);
+
+    // Largest frame written by sendFile(). Defaults to 64 KiB.
+    void setWriteFragmentSize(std::size_t bytes);
+
+    // Gather small frames and write them together, below TLS so a batch
+    // also leaves in one write. Call before connect().
+    void setWriteBatching(const WriteBatchOptions& options);
+
+    // Frame and mask send() and sendBinary() messages with FrameEncoder,
+    // in place in the queued copy, instead of through the websocket
+    // stream. Ignored while permessage-deflate is in use and for
+    // sendFile(). Call before connect().
+    void setFrameEncoder(bool enabled);
+
+    // Take receive buffers from `pool` instead of BufferPool::global().
+    // Call before connect().
+    void setBufferPool(std::shared_ptr<BufferPool> pool);
+
+    // Traffic counters; safe to call from any thread.
+    ConnectionStats stats() const;
+
+    // Ping round trips in nanoseconds over every connection so far; safe to
+    // call from any thread.
+    LatencyHistogram pingRtt() const;
+
+    // True once the reconnect policy has given up. The client will not
+    // connect again and refuses sends. Safe to call from any thread.
+    bool reconnectExhausted() const { return reconnect_exhausted_; }
+
+    // Whether send() would queue a message rather than report "Not
+    // connected": connected, or waiting to reconnect. Safe to call from
+    // any thread.
+    bool canSend() const;
+
+    // Record how long messages take to be delivered, handled, queued and
+    // written. Off by default, since the histograms take 64 KiB per client.
+    // Call before connect().
+    void setLatencyTracking(bool enabled);
+
+    // Histograms over every connection so far; empty unless latency
+    // tracking is on. Safe to call from any thread.
+    MessageLatency latency() const;
+
+    // Record each connection's phases, and sampled reads and writes, as
+    // spans on a track of this client's own. Call before connect().
+    void setTracer(std::shared_ptr<TraceRecorder> tracer);
+
+    // The strand every handler of this client runs on. Timers and work bound
+    // to it are serialized with the message handler.
+    using executor_type = boost::asio::strand<boost::asio::io_context::executor_type>;
+    executor_type get_executor() const { return strand_; }
+
 private:
+    using stream_type = boost::beast::websocket::stream<
+        MeteredStream<boost::beast::ssl_stream<CoalescingStream<boost::beast::tcp_stream>>>>;
+
+    // Stores the connection details and posts start_connect(); the message
+    // handler is already set
+    void post_connect(
+        const std::string& host,
+        const std::string& port,
+        const std::string& target,
+        ErrorHandler onError,
+        ConnectHandler onConnect
+    );
+    void reset_stream();
+    void start_connect();
+    void do_resolve();
     void on_resolve(
         boost::beast::error_code ec,
         boost::asio::ip::tcp::resolver::results_type results
     );
-    
+
+    void do_connect();
     void on_connect(
         boost::beast::error_code ec,
-        boost::asio::ip::tcp::resolver::endpoint_type ep
+        boost::asio::ip::tcp::socket socket,
+        boost::asio::ip::tcp::endpoint ep
     );
     
     void on_ssl_handshake(boost::beast::error_code ec);
     void on_handshake(boost::beast::error_code ec);
+    void enqueue(OutboundMessage message);
+    bool is_backpressured() const;
+    void update_backpressure();
+    void on_write_scheduled();
+    void do_write();
+    void write_encoded();
+    void on_write_encoded(boost::beast::error_code ec, std::size_t bytes_transferred);
+    void write_fragment();
+    void on_write_fragment(boost::beast::error_code ec, std::size_t bytes_transferred);
     void on_write(boost::beast::error_code ec, std::size_t bytes_transferred);
     void do_read();
     void on_read(boost::beast::error_code ec, std::size_t bytes_transferred);
+    void do_close();
+    void maybe_close();
     void on_close(boost::beast::error_code ec);
+    void start_keepalive();
+    void on_keepalive_timer(boost::beast::error_code ec);
+    void on_ping(boost::beast::error_code ec);
+    void on_control_frame(boost::beast::websocket::frame_type kind, boost::beast::string_view payload);
+    void fail(const std::string& message);
+    std::string close_notice() const;
+    void begin_reconnect();
+    void schedule_reconnect();
+    void on_reconnect_timer(boost::beast::error_code ec);
 
+    // A span from `start` to now, if tracing
+    void trace_span(const char* name, TraceLane lane, TraceRecorder::Clock::time_point start, bool failed = false);
+
+    // Every handler, including the resolver's and the timer's, runs here
+    boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+    boost::asio::ssl::context& ssl_ctx_;
     boost::asio::ip::tcp::resolver resolver_;
-    boost::beast::websocket::stream<
-        boost::beast::ssl_stream<boost::beast::tcp_stream>> ws_;
-    boost::beast::flat_buffer buffer_;
-    MessageHandler message_handler_;
+    std::shared_ptr<DnsCache> dns_cache_;
+    std::vector<boost::asio::ip::tcp::endpoint> endpoints_;
+    std::chrono::steady_clock::time_point connect_started_;
+
+    // Rebuilt for every connection attempt; SSL state cannot be reused
+    std::optional<stream_type> ws_;
+    boost::beast::websocket::response_type handshake_response_;
+    PooledBuffer buffer_;
+    MessageViewHandler message_handler_;
+    PooledMessageHandler pooled_handler_;
+    MessageChunkHandler chunk_handler_;
+    std::uint64_t read_message_max_{16 * 1024 * 1024};
+    std::size_t read_chunk_size_{64 * 1024};
     ErrorHandler error_handler_;
+    ConnectHandler connect_handler_;
     std::string host_;
+    std::string port_;
     std::string target_;
+    std::shared_ptr<TlsSessionCache> session_cache_;
+    std::string session_key_;
+    CompressionOptions compression_;
+    ConnectionCounters counters_;
+
+    // Outbound path. Producers only touch write_queue_ and write_scheduled_;
+    // everything else is owned by the strand.
+    MpscQueue<OutboundMessage> write_queue_;
+    std::atomic<bool> write_scheduled_{false};
+    OutboundMessage current_write_;
+    std::size_t write_offset_{0};
+    std::size_t write_fragment_size_{64 * 1024};
+    WriteBatchOptions write_batch_;
+    bool frame_encoder_enabled_{false};
+    FrameEncoder frame_encoder_;
+    FrameEncoder::Header frame_header_;
+    bool current_masked_{false};  // current_write_.payload is masked under frame_header_.key
+    BackpressurePolicy backpressure_;
+    BackpressureHandler backpressure_handler_;
+    std::atomic<bool> backpressured_{false};
+    bool write_in_flight_{false};
+    bool resend_current_{false};
+    bool read_in_flight_{false};
+    bool connecting_{false};
+    bool open_{false};
+    std::atomic<bool> connected_{false};  // open_, for producers on other threads
+    bool close_requested_{false};
+    bool closing_{false};
+
+    // Reconnect state, owned by the strand
+    ReconnectPolicy reconnect_policy_;
+    ReconnectHandler reconnect_handler_;
+    boost::asio::steady_timer reconnect_timer_;
+    bool reconnect_timer_armed_{false};
+    bool reconnecting_{false};
+    std::atomic<bool> reconnect_exhausted_{false};
+    std::size_t reconnect_attempt_{0};
+    std::chrono::steady_clock::time_point outage_start_;
+    std::mt19937 rng_;
+
+    // Latency recording, written on the strand
+    std::unique_ptr<MessageLatencyRecorder> latency_;
+    std::chrono::steady_clock::time_point last_read_;
+    std::chrono::steady_clock::time_point write_started_;
+
+    // Tracing, owned by the strand
+    std::shared_ptr<TraceRecorder> tracer_;
+    std::uint64_t trace_track_{0};
+    TraceRecorder::Clock::time_point phase_started_;
+    TraceRecorder::Clock::time_point handshake_done_;
+    TraceRecorder::Clock::time_point backoff_started_;
+    TraceRecorder::Clock::time_point read_started_;
+    std::uint64_t reads_seen_{0};
+    std::uint64_t writes_seen_{0};
+    bool awaiting_first_message_{false};
+    bool read_traced_{false};
+    bool write_traced_{false};
+
+    // Keepalive state, owned by the strand except for the histogram
+    KeepalivePolicy keepalive_;
+    boost::asio::steady_timer keepalive_timer_;
+    bool ping_in_flight_{false};
+    bool awaiting_pong_{false};
+    std::size_t missed_pongs_{0};
+    mutable std::mutex ping_rtt_mutex_;
+    LatencyHistogram ping_rtt_;
 };
 
 } // namespace websocket_client
@@ -1,14 +1,22 @@
 #include "websocket_client_plain.hpp"
+#include "happy_eyeballs.hpp"
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
+#include <boost/asio/post.hpp>
+#include <algorithm>
+#include <charconv>
 #include <iostream>
 
 namespace websocket_client {
 
 WebSocketClientPlain::WebSocketClientPlain(boost::asio::io_context& ioc)
-    : resolver_(boost::asio::make_strand(ioc))
-    , ws_(boost::asio::make_strand(ioc))
-    , connected_(false) {
+    : strand_(boost::asio::make_strand(ioc))
+    , resolver_(strand_)
+    , connected_(false)
+    , reconnectTimer_(strand_)
+    , rng_(std::random_device{}())
+    , keepaliveTimer_(strand_) {
+    resetStream();
 }
 
 void WebSocketClientPlain::connect(
@@ -18,17 +26,134 @@ void WebSocketClientPlain::connect(
     MessageHandler onMessage,
     ErrorHandler onError,
     ConnectHandler onConnect) {
-    
+
+    // Copying adapter over the zero-copy path
+    MessageViewHandler onMessageView;
+    if (onMessage) {
+        onMessageView = [onMessage = std::move(onMessage)](std::string_view message, Opcode) {
+            onMessage(std::string(message));
+        };
+    }
+
+    connect(host, port, target, std::move(onMessageView), std::move(onError), std::move(onConnect));
+}
+
+void WebSocketClientPlain::connect(
+    const std::string& host,
+    const std::string& port,
+    const std::string& target,
+    PooledMessageHandler onMessage,
+    ErrorHandler onError,
+    ConnectHandler onConnect) {
+
+    // Set before the connect is posted to the strand
+    onMessage_ = nullptr;
+    onPooledMessage_ = std::move(onMessage);
+    onChunk_ = nullptr;
+    postConnect(host, port, target, std::move(onError), std::move(onConnect));
+}
+
+void WebSocketClientPlain::connect(
+    const std::string& host,
+    const std::string& port,
+    const std::string& target,
+    MessageChunkHandler onChunk,
+    ErrorHandler onError,
+    ConnectHandler onConnect) {
+
+    // Set before the connect is posted to the strand
+    onMessage_ = nullptr;
+    onPooledMessage_ = nullptr;
+    onChunk_ = std::move(onChunk);
+    postConnect(host, port, target, std::move(onError), std::move(onConnect));
+}
+
+void WebSocketClientPlain::connect(
+    const std::string& host,
+    const std::string& port,
+    const std::string& target,
+    MessageViewHandler onMessage,
+    ErrorHandler onError,
+    ConnectHandler onConnect) {
+
+    // onRead prefers the other handler kinds, so drop any left from before
+    onMessage_ = std::move(onMessage);
+    onPooledMessage_ = nullptr;
+    onChunk_ = nullptr;
+    postConnect(host, port, target, std::move(onError), std::move(onConnect));
+}
+
+void WebSocketClientPlain::postConnect(
+    const std::string& host,
+    const std::string& port,
+    const std::string& target,
+    ErrorHandler onError,
+    ConnectHandler onConnect) {
+
     host_ = host;
+    port_ = port;
     target_ = target;
-    onMessage_ = onMessage;
-    onError_ = onError;
-    onConnect_ = onConnect;
+    onError_ = std::move(onError);
+    onConnect_ = std::move(onConnect);
+    reconnectExhausted_ = false;
+    if (tracer_ && traceTrack_ == 0) {
+        traceTrack_ = tracer_->newTrack(host + ":" + port);
+    }
+
+    boost::asio::post(
+        strand_,
+        boost::beast::bind_front_handler(
+            &WebSocketClientPlain::startConnect,
+            shared_from_this()
+        )
+    );
+}
+
+void WebSocketClientPlain::resetStream() {
+    ws_.emplace(counters_.wire_bytes_received, counters_.wire_bytes_sent, strand_);
+    ws_->next_layer().next_layer().setOptions(writeBatch_, counters_.transport_writes);
+    ws_->next_layer().setExclusiveWrites(frameEncoderEnabled_);
+    ws_->next_layer().setReadClock(latency_ ? &lastRead_ : nullptr);
+    ws_->set_option(toPermessageDeflate(compression_));
+    ws_->read_message_max(readMessageMax_);
+    buffer_.clear();
+    handshakeResponse_ = {};
+
+    // Pongs to our keepalive pings arrive in the middle of reads
+    ws_->control_callback(
+        [this](boost::beast::websocket::frame_type kind, boost::beast::string_view payload) {
+            onControlFrame(kind, payload);
+        }
+    );
+}
+
+void WebSocketClientPlain::startConnect() {
+    connecting_ = true;
+    connectStarted_ = std::chrono::steady_clock::now();
+
+    // Reuse addresses from our last connect, then from the shared cache
+    if (endpoints_.empty() && dnsCache_) {
+        if (auto cached = dnsCache_->lookup(host_, port_)) {
+            endpoints_.assign(cached->begin(), cached->end());
+        }
+    }
+
+    if (endpoints_.empty()) {
+        doResolve();
+    } else {
+        doConnect();
+    }
+}
+
+void WebSocketClientPlain::doResolve() {
+    if (tracer_) {
+        phaseStarted_ = TraceRecorder::Clock::now();
+    }
 
     // Look up the domain name
     resolver_.async_resolve(
-        host,
-        port,
+        host_,
+        port_,
         boost::beast::bind_front_handler(
             &WebSocketClientPlain::onResolve,
             shared_from_this()
@@ -40,16 +165,30 @@ void WebSocketClientPlain::onResolve(
     boost::beast::error_code ec,
     boost::asio::ip::tcp::resolver::results_type results) {
     
+    traceSpan("resolve", TraceLane::lifecycle, phaseStarted_, bool(ec));
     if (ec) {
         return fail(ec, "resolve");
     }
 
-    // Set the timeout for the operation
-    boost::beast::get_lowest_layer(ws_).expires_after(std::chrono::seconds(30));
+    // Reconnects go straight to these addresses
+    endpoints_.assign(results.begin(), results.end());
+    if (dnsCache_) {
+        dnsCache_->store(host_, port_, std::move(results));
+    }
+    doConnect();
+}
 
-    // Make the connection on the IP address we get from a lookup
-    boost::beast::get_lowest_layer(ws_).async_connect(
-        results,
+void WebSocketClientPlain::doConnect() {
+    if (tracer_) {
+        phaseStarted_ = TraceRecorder::Clock::now();
+    }
+
+    // Race the addresses so a dead one costs 250 ms, not the whole timeout
+    asyncConnectHappyEyeballs(
+        strand_,
+        endpoints_,
+        kConnectionAttemptDelay,
+        std::chrono::seconds(30),
         boost::beast::bind_front_handler(
             &WebSocketClientPlain::onConnect,
             shared_from_this()
@@ -59,25 +198,37 @@ void WebSocketClientPlain::onResolve(
 
 void WebSocketClientPlain::onConnect(
     boost::beast::error_code ec,
-    boost::asio::ip::tcp::resolver::results_type::endpoint_type ep) {
+    boost::asio::ip::tcp::socket socket,
+    boost::asio::ip::tcp::endpoint ep) {
     
+    traceSpan("tcp_connect", TraceLane::lifecycle, phaseStarted_, bool(ec));
     if (ec) {
+        // The cached addresses may be stale; look them up again next time
+        endpoints_.clear();
+        if (dnsCache_) {
+            dnsCache_->invalidate(host_, port_);
+        }
         return fail(ec, "connect");
     }
 
+    // Small messages go out now rather than waiting on delayed ACKs
+    boost::beast::error_code ignored;
+    socket.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+    boost::beast::get_lowest_layer(*ws_).socket() = std::move(socket);
+
     // Turn off the timeout on the tcp_stream, because
     // the websocket stream has its own timeout system.
-    boost::beast::get_lowest_layer(ws_).expires_never();
+    boost::beast::get_lowest_layer(*ws_).expires_never();
 
     // Set suggested timeout settings for the websocket
-    ws_.set_option(
+    ws_->set_option(
         boost::beast::websocket::stream_base::timeout::suggested(
             boost::beast::role_type::client
         )
     );
 
     // Set a decorator to change the User-Agent of the handshake
-    ws_.set_option(boost::beast::websocket::stream_base::decorator(
+    ws_->set_option(boost::beast::websocket::stream_base::decorator(
         [](boost::beast::websocket::request_type& req) {
             req.set(boost::beast::http::field::user_agent,
                 std::string(BOOST_BEAST_VERSION_STRING) + " websocket-client-cpp");
@@ -92,7 +243,11 @@ void WebSocketClientPlain::onConnect(
     }
 
     // Perform the websocket handshake
-    ws_.async_handshake(
+    if (tracer_) {
+        phaseStarted_ = TraceRecorder::Clock::now();
+    }
+    ws_->async_handshake(
+        handshakeResponse_,
         host_header,
         target_,
         boost::beast::bind_front_handler(
@@ -103,24 +258,78 @@ void WebSocketClientPlain::onConnect(
 }
 
 void WebSocketClientPlain::onHandshake(boost::beast::error_code ec) {
+    traceSpan("ws_handshake", TraceLane::lifecycle, phaseStarted_, bool(ec));
     if (ec) {
         return fail(ec, "handshake");
     }
 
+    if (tracer_) {
+        traceSpan("connect", TraceLane::lifecycle, connectStarted_);
+        handshakeDone_ = TraceRecorder::Clock::now();
+        awaitingFirstMessage_ = true;
+    }
+
+    connecting_ = false;
     connected_ = true;
+    open_ = true;
+    counters_.onConnected(static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - connectStarted_).count()));
+    counters_.compression_negotiated.store(
+        handshakeResponse_[boost::beast::http::field::sec_websocket_extensions]
+            .find("permessage-deflate") != boost::beast::string_view::npos,
+        std::memory_order_relaxed
+    );
+
+    if (reconnecting_) {
+        reconnecting_ = false;
+        reconnectAttempt_ = 0;
+        counters_.reconnects.fetch_add(1, std::memory_order_relaxed);
+        if (onReconnect_) {
+            onReconnect_(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - outageStart_));
+        }
+    }
     
     // Notify that connection is established
     if (onConnect_) {
         onConnect_();
     }
+
+    // Flush anything queued while connecting
+    doWrite();
     
     // Read a message
     doRead();
+
+    startKeepalive();
 }
 
 void WebSocketClientPlain::doRead() {
+    readInFlight_ = true;
+    if (tracer_) {
+        readTraced_ = tracer_->sampled(readsSeen_++);
+        if (readTraced_) {
+            readStarted_ = TraceRecorder::Clock::now();
+        }
+    }
+
+    if (onChunk_) {
+        // Whatever has arrived, up to one chunk, without waiting for the
+        // rest of the message
+        ws_->async_read_some(
+            buffer_,
+            readChunkSize_,
+            boost::beast::bind_front_handler(
+                &WebSocketClientPlain::onRead,
+                shared_from_this()
+            )
+        );
+        return;
+    }
+
     // Read a message into our buffer
-    ws_.async_read(
+    ws_->async_read(
         buffer_,
         boost::beast::bind_front_handler(
             &WebSocketClientPlain::onRead,
@@ -133,57 +342,301 @@ void WebSocketClientPlain::onRead(
     boost::beast::error_code ec,
     std::size_t bytes_transferred) {
     
-    boost::ignore_unused(bytes_transferred);
+    readInFlight_ = false;
+    if (readTraced_) {
+        readTraced_ = false;
+        traceSpan("read", TraceLane::reads, readStarted_, bool(ec));
+    }
 
     if (ec) {
+        // A read cut short by our own close is not an error
+        if (closing_) {
+            return;
+        }
+
+        // Nor is one cut short by tearing down a connection already lost
+        if (reconnecting_) {
+            return scheduleReconnect();
+        }
+
+        // The server closing is not a failed read
+        if (ec == boost::beast::websocket::error::closed) {
+            return fail(closeNotice());
+        }
+
         return fail(ec, "read");
     }
 
+    // The message was complete as of the last transport read
+    MessageLatencyRecorder::Clock::time_point delivered;
+    if (latency_) {
+        delivered = MessageLatencyRecorder::Clock::now();
+        latency_->delivery.record(MessageLatencyRecorder::elapsed(lastRead_, delivered));
+    }
+
+    if (awaitingFirstMessage_) {
+        awaitingFirstMessage_ = false;
+        traceSpan("first_message", TraceLane::lifecycle, handshakeDone_);
+    }
+
     // Process the message
-    if (onMessage_) {
-        std::string message = boost::beast::buffers_to_string(buffer_.data());
-        onMessage_(message);
+    const Opcode opcode = ws_->got_binary() ? Opcode::binary : Opcode::text;
+    if (onChunk_) {
+        const bool last = ws_->is_message_done();
+        counters_.onReceivedPart(bytes_transferred, last);
+
+        const auto data = buffer_.data();
+        onChunk_(
+            std::string_view(static_cast<const char*>(data.data()), data.size()),
+            opcode,
+            last
+        );
+        buffer_.clear();
+    } else if (onPooledMessage_) {
+        counters_.onReceived(bytes_transferred);
+        // The block leaves with the message; the next read takes a new one
+        onPooledMessage_(buffer_.detach(), opcode);
+    } else {
+        counters_.onReceived(bytes_transferred);
+        if (onMessage_) {
+            // Hand the message over in place; the view dies with the clear below
+            const auto data = buffer_.data();
+            onMessage_(
+                std::string_view(static_cast<const char*>(data.data()), data.size()),
+                opcode
+            );
+        }
+        buffer_.clear();
     }
 
-    // Clear the buffer
-    buffer_.consume(buffer_.size());
+    if (latency_) {
+        latency_->handler.record(
+            MessageLatencyRecorder::elapsed(delivered, MessageLatencyRecorder::Clock::now()));
+    }
 
     // Read another message
     doRead();
 }
 
-void WebSocketClientPlain::send(const std::string& message) {
-    if (!connected_) {
+void WebSocketClientPlain::send(std::string message) {
+    if (!canSend()) {
         if (onError_) {
             onError_("Not connected");
         }
         return;
     }
 
-    // Send the message
-    ws_.async_write(
-        boost::asio::buffer(message),
-        boost::beast::bind_front_handler(
-            &WebSocketClientPlain::onWrite,
-            shared_from_this()
-        )
-    );
+    OutboundMessage queued;
+    queued.payload = std::move(message);
+    enqueue(std::move(queued));
 }
 
 void WebSocketClientPlain::sendBinary(const std::vector<uint8_t>& data) {
-    if (!connected_) {
+    if (!canSend()) {
+        if (onError_) {
+            onError_("Not connected");
+        }
+        return;
+    }
+
+    OutboundMessage message;
+    message.payload.assign(data.begin(), data.end());
+    message.binary = true;
+    enqueue(std::move(message));
+}
+
+bool WebSocketClientPlain::send(SharedPayload payload) {
+    if (!canSend()) {
+        if (onError_) {
+            onError_("Not connected");
+        }
+        return false;
+    }
+
+    OutboundMessage message;
+    message.binary = payload.isBinary();
+    message.shared = std::move(payload);
+    enqueue(std::move(message));
+    return true;
+}
+
+bool WebSocketClientPlain::trySend(std::string message) {
+    if (isBackpressured() || !canSend()) {
+        return false;
+    }
+
+    OutboundMessage queued;
+    queued.payload = std::move(message);
+    enqueue(std::move(queued));
+    return true;
+}
+
+bool WebSocketClientPlain::trySendBinary(const std::vector<uint8_t>& data) {
+    if (isBackpressured() || !canSend()) {
+        return false;
+    }
+
+    OutboundMessage message;
+    message.payload.assign(data.begin(), data.end());
+    message.binary = true;
+    enqueue(std::move(message));
+    return true;
+}
+
+bool WebSocketClientPlain::trySend(SharedPayload payload) {
+    if (isBackpressured() || !canSend()) {
+        return false;
+    }
+
+    OutboundMessage message;
+    message.binary = payload.isBinary();
+    message.shared = std::move(payload);
+    enqueue(std::move(message));
+    return true;
+}
+
+void WebSocketClientPlain::sendFile(const std::string& path, bool binary) {
+    sendFile(MappedFile::open(path), binary);
+}
+
+void WebSocketClientPlain::sendFile(std::shared_ptr<const MappedFile> file, bool binary) {
+    if (!canSend()) {
         if (onError_) {
             onError_("Not connected");
         }
         return;
     }
 
-    // Set binary mode
-    ws_.binary(true);
+    OutboundMessage message;
+    message.binary = binary;
+    message.file = std::move(file);
+    enqueue(std::move(message));
+}
+
+void WebSocketClientPlain::enqueue(OutboundMessage message) {
+    if (latency_) {
+        message.queued_at = MessageLatencyRecorder::Clock::now();
+    }
+
+    // Counted before the push, so the strand never sees it uncounted
+    counters_.onQueued(message.size());
+    writeQueue_.push(std::move(message));
+
+    // Wake the strand unless a wakeup is already pending
+    if (!writeScheduled_.exchange(true, std::memory_order_acq_rel)) {
+        boost::asio::post(
+            strand_,
+            boost::beast::bind_front_handler(
+                &WebSocketClientPlain::onWriteScheduled,
+                shared_from_this()
+            )
+        );
+    }
+}
+
+void WebSocketClientPlain::onWriteScheduled() {
+    // Clear the flag before draining so a concurrent send() either lands in
+    // this drain or schedules a new one.
+    writeScheduled_.exchange(false, std::memory_order_acq_rel);
+    updateBackpressure();
+    doWrite();
+}
+
+bool WebSocketClientPlain::isBackpressured() const {
+    // The strand may not have caught up with the producers yet
+    return backpressured_.load(std::memory_order_acquire)
+        || backpressure_.reachedHigh(
+            counters_.queued_bytes.load(std::memory_order_relaxed),
+            counters_.queued_messages.load(std::memory_order_relaxed));
+}
+
+void WebSocketClientPlain::updateBackpressure() {
+    if (!backpressure_.enabled()) {
+        return;
+    }
+
+    const std::uint64_t bytes = counters_.queued_bytes.load(std::memory_order_relaxed);
+    const std::uint64_t messages = counters_.queued_messages.load(std::memory_order_relaxed);
+    const bool was = backpressured_.load(std::memory_order_relaxed);
+    const bool now = was
+        ? !backpressure_.drainedToLow(bytes, messages)
+        : backpressure_.reachedHigh(bytes, messages);
+    if (now == was) {
+        return;
+    }
+
+    backpressured_.store(now, std::memory_order_release);
+    counters_.onBackpressure(now);
+    if (onBackpressure_) {
+        onBackpressure_(now);
+    }
+}
+
+void WebSocketClientPlain::doWrite() {
+    // Only one write may be in flight on the stream at a time
+    if (writeInFlight_ || !open_ || closing_) {
+        return;
+    }
+
+    // A message interrupted by a drop goes out first on the new connection
+    const bool resend = resendCurrent_;
+    if (!resend) {
+        auto next = writeQueue_.pop();
+        if (!next) {
+            maybeClose();
+            return;
+        }
+        currentWrite_ = std::move(*next);
+        currentMasked_ = false;
+    } else if (currentMasked_) {
+        // Unmasked again, since the new connection may have negotiated
+        // compression and need the plain bytes
+        maskInPlace(currentWrite_.payload.data(), currentWrite_.payload.size(), frameHeader_.key);
+        currentMasked_ = false;
+    }
+
+    resendCurrent_ = false;
+    writeInFlight_ = true;
+
+    if (latency_ || tracer_) {
+        writeStarted_ = MessageLatencyRecorder::Clock::now();
+        if (latency_ && !resend) {
+            latency_->queue_wait.record(
+                MessageLatencyRecorder::elapsed(currentWrite_.queued_at, writeStarted_));
+        }
+        writeTraced_ = tracer_ && tracer_->sampled(writesSeen_++);
+    }
+
+    // The frame type travels with the message, so set it per write
+    ws_->binary(currentWrite_.binary);
+
+    if (currentWrite_.file) {
+        // A resend starts the message over
+        writeOffset_ = 0;
+        writeFragment();
+        return;
+    }
+
+    // Shared bytes are read in place and masked by the stream as it copies
+    // them out, since masking in place would change them for everyone
+    if (currentWrite_.shared) {
+        ws_->async_write(
+            boost::asio::buffer(currentWrite_.shared.data(), currentWrite_.shared.size()),
+            boost::beast::bind_front_handler(
+                &WebSocketClientPlain::onWrite,
+                shared_from_this()
+            )
+        );
+        return;
+    }
+
+    if (frameEncoderEnabled_ && !counters_.compression_negotiated.load(std::memory_order_relaxed)) {
+        writeEncoded();
+        return;
+    }
 
-    // Send the binary data
-    ws_.async_write(
-        boost::asio::buffer(data),
+    ws_->async_write(
+        boost::asio::buffer(currentWrite_.payload),
         boost::beast::bind_front_handler(
             &WebSocketClientPlain::onWrite,
             shared_from_this()
@@ -191,29 +644,158 @@ void WebSocketClientPlain::sendBinary(const std::vector<uint8_t>& data) {
     );
 }
 
+void WebSocketClientPlain::writeEncoded() {
+    frameHeader_ = frameEncoder_.encode(
+        currentWrite_.binary, currentWrite_.payload.data(), currentWrite_.payload.size());
+    currentMasked_ = true;
+
+    // Header and payload in one write below the websocket stream. With
+    // exclusive writes on it is carried out in full, so a pong the stream
+    // sends meanwhile waits for it instead of landing inside the frame.
+    ws_->next_layer().async_write_some(
+        boost::beast::buffers_cat(
+            frameHeader_.buffer(),
+            boost::asio::buffer(currentWrite_.payload)
+        ),
+        boost::beast::bind_front_handler(
+            &WebSocketClientPlain::onWriteEncoded,
+            shared_from_this()
+        )
+    );
+}
+
+void WebSocketClientPlain::onWriteEncoded(
+    boost::beast::error_code ec,
+    std::size_t bytes_transferred) {
+
+    // Report payload bytes, as the websocket stream does
+    const std::size_t headerSize = frameHeader_.size;
+    onWrite(ec, bytes_transferred > headerSize ? bytes_transferred - headerSize : 0);
+}
+
+void WebSocketClientPlain::writeFragment() {
+    const MappedFile& file = *currentWrite_.file;
+    const std::size_t size = std::min(writeFragmentSize_, file.size() - writeOffset_);
+    const bool fin = writeOffset_ + size == file.size();
+
+    ws_->async_write_some(
+        fin,
+        boost::asio::buffer(file.data() + writeOffset_, size),
+        boost::beast::bind_front_handler(
+            &WebSocketClientPlain::onWriteFragment,
+            shared_from_this()
+        )
+    );
+}
+
+void WebSocketClientPlain::onWriteFragment(
+    boost::beast::error_code ec,
+    std::size_t bytes_transferred) {
+
+    if (ec) {
+        return onWrite(ec, writeOffset_ + bytes_transferred);
+    }
+
+    // Sent pages leave our RSS so memory stays flat however big the file
+    const MappedFile& file = *currentWrite_.file;
+    file.release(writeOffset_, bytes_transferred);
+    writeOffset_ += bytes_transferred;
+
+    if (writeOffset_ < file.size()) {
+        return writeFragment();
+    }
+
+    onWrite(ec, writeOffset_);
+}
+
 void WebSocketClientPlain::onWrite(
     boost::beast::error_code ec,
     std::size_t bytes_transferred) {
     
-    boost::ignore_unused(bytes_transferred);
+    writeInFlight_ = false;
+    if (writeTraced_) {
+        writeTraced_ = false;
+        traceSpan("write", TraceLane::writes, writeStarted_, bool(ec));
+    }
 
     if (ec) {
+        // The peer may or may not have seen it; sending it again is the
+        // only way not to lose it
+        resendCurrent_ = reconnectPolicy_.enabled && !closeRequested_;
+        if (!resendCurrent_) {
+            counters_.onDequeued(currentWrite_.size());
+            currentWrite_.payload.clear();
+            currentWrite_.file.reset();
+            currentWrite_.shared.reset();
+            updateBackpressure();
+        }
+
+        if (reconnecting_) {
+            return scheduleReconnect();
+        }
         return fail(ec, "write");
     }
 
-    // Reset to text mode after binary send
-    ws_.binary(false);
+    if (latency_) {
+        latency_->write.record(
+            MessageLatencyRecorder::elapsed(writeStarted_, MessageLatencyRecorder::Clock::now()));
+    }
+
+    counters_.onDequeued(currentWrite_.size());
+    currentWrite_.payload.clear();
+    currentWrite_.file.reset();
+    currentWrite_.shared.reset();
+    counters_.onSent(bytes_transferred);
+    updateBackpressure();
+
+    doWrite();
 }
 
 void WebSocketClientPlain::close() {
-    if (!connected_) {
+    connected_ = false;
+
+    boost::asio::post(
+        strand_,
+        boost::beast::bind_front_handler(
+            &WebSocketClientPlain::doClose,
+            shared_from_this()
+        )
+    );
+}
+
+void WebSocketClientPlain::doClose() {
+    closeRequested_ = true;
+    maybeClose();
+}
+
+void WebSocketClientPlain::maybeClose() {
+    if (!closeRequested_ || closing_) {
         return;
     }
 
-    connected_ = false;
+    // A connect in progress finishes first and calls back in here
+    if (connecting_) {
+        return;
+    }
+
+    // Let the queue drain first; onWrite calls back in here when it is empty
+    if (open_ && (writeInFlight_ || resendCurrent_ || !writeQueue_.empty())) {
+        return;
+    }
+
+    closing_ = true;
+    keepaliveTimer_.cancel();
+
+    if (!open_) {
+        // Nothing to close gracefully: drop any pending reconnect
+        reconnecting_ = false;
+        reconnectTimer_.cancel();
+        boost::beast::get_lowest_layer(*ws_).close();
+        return;
+    }
 
     // Close the WebSocket connection
-    ws_.async_close(
+    ws_->async_close(
         boost::beast::websocket::close_code::normal,
         boost::beast::bind_front_handler(
             &WebSocketClientPlain::onClose,
@@ -222,20 +804,316 @@ void WebSocketClientPlain::close() {
     );
 }
 
+void WebSocketClientPlain::setCompression(const CompressionOptions& options) {
+    compression_ = options;
+    ws_->set_option(toPermessageDeflate(compression_));
+}
+
+void WebSocketClientPlain::setReadMessageMax(std::uint64_t bytes) {
+    readMessageMax_ = bytes;
+    ws_->read_message_max(readMessageMax_);
+}
+
+void WebSocketClientPlain::setReadChunkSize(std::size_t bytes) {
+    readChunkSize_ = bytes;
+}
+
+void WebSocketClientPlain::setWriteFragmentSize(std::size_t bytes) {
+    writeFragmentSize_ = bytes;
+}
+
+void WebSocketClientPlain::setWriteBatching(const WriteBatchOptions& options) {
+    writeBatch_ = options;
+    ws_->next_layer().next_layer().setOptions(writeBatch_, counters_.transport_writes);
+}
+
+void WebSocketClientPlain::setFrameEncoder(bool enabled) {
+    frameEncoderEnabled_ = enabled;
+    ws_->next_layer().setExclusiveWrites(frameEncoderEnabled_);
+}
+
+void WebSocketClientPlain::setBufferPool(std::shared_ptr<BufferPool> pool) {
+    buffer_.setPool(std::move(pool));
+}
+
+void WebSocketClientPlain::setLatencyTracking(bool enabled) {
+    if (enabled && !latency_) {
+        latency_ = std::make_unique<MessageLatencyRecorder>();
+    } else if (!enabled) {
+        latency_.reset();
+    }
+    ws_->next_layer().setReadClock(latency_ ? &lastRead_ : nullptr);
+}
+
+bool WebSocketClientPlain::canSend() const {
+    return connected_ || (reconnectPolicy_.enabled && !reconnectExhausted_);
+}
+
+void WebSocketClientPlain::setTracer(std::shared_ptr<TraceRecorder> tracer) {
+    tracer_ = std::move(tracer);
+    traceTrack_ = 0;
+}
+
+void WebSocketClientPlain::traceSpan(
+    const char* name,
+    TraceLane lane,
+    TraceRecorder::Clock::time_point start,
+    bool failed) {
+
+    if (tracer_) {
+        tracer_->record(name, traceTrack_, lane, start, TraceRecorder::Clock::now(), failed);
+    }
+}
+
+void WebSocketClientPlain::setDnsCache(std::shared_ptr<DnsCache> cache) {
+    dnsCache_ = std::move(cache);
+}
+
+void WebSocketClientPlain::setReconnectPolicy(const ReconnectPolicy& policy, ReconnectHandler onReconnect) {
+    reconnectPolicy_ = policy;
+    onReconnect_ = std::move(onReconnect);
+}
+
+void WebSocketClientPlain::setKeepalive(const KeepalivePolicy& policy) {
+    keepalive_ = policy;
+}
+
+void WebSocketClientPlain::setBackpressure(const BackpressurePolicy& policy, BackpressureHandler onBackpressure) {
+    backpressure_ = policy;
+    onBackpressure_ = std::move(onBackpressure);
+}
+
+ConnectionStats WebSocketClientPlain::stats() const {
+    return counters_.snapshot();
+}
+
+LatencyHistogram WebSocketClientPlain::pingRtt() const {
+    std::lock_guard<std::mutex> lock(pingRttMutex_);
+    return pingRtt_;
+}
+
+MessageLatency WebSocketClientPlain::latency() const {
+    return latency_ ? latency_->snapshot() : MessageLatency();
+}
+
 void WebSocketClientPlain::onClose(boost::beast::error_code ec) {
+    // Closed or not, the connection is done with
+    connected_ = false;
+    open_ = false;
+
     if (ec) {
-        return fail(ec, "close");
+        if (onError_) {
+            onError_(std::string("close: ") + ec.message());
+        }
     }
+}
 
-    // The WebSocket is closed
-    connected_ = false;
+void WebSocketClientPlain::startKeepalive() {
+    if (keepalive_.interval.count() <= 0) {
+        return;
+    }
+
+    awaitingPong_ = false;
+    missedPongs_ = 0;
+
+    // Re-arming also cancels a wait left over from the last connection
+    keepaliveTimer_.expires_after(keepalive_.interval);
+    keepaliveTimer_.async_wait(
+        boost::beast::bind_front_handler(
+            &WebSocketClientPlain::onKeepaliveTimer,
+            shared_from_this()
+        )
+    );
+}
+
+void WebSocketClientPlain::onKeepaliveTimer(boost::beast::error_code ec) {
+    if (ec || !open_ || closing_) {
+        return;
+    }
+
+    if (awaitingPong_) {
+        counters_.missed_pongs.fetch_add(1, std::memory_order_relaxed);
+        if (++missedPongs_ >= keepalive_.max_missed) {
+            fail(boost::asio::error::timed_out, "keepalive");
+
+            // A reconnect tears the stream down itself; otherwise close it
+            // here, or the read would wait on the silent peer indefinitely
+            if (!reconnecting_ && !closing_) {
+                closing_ = true;
+                boost::beast::get_lowest_layer(*ws_).close();
+            }
+            return;
+        }
+    }
+
+    // While the last ping is still stuck behind a write there is no point
+    // queueing another
+    awaitingPong_ = true;
+    if (!pingInFlight_) {
+        const auto sent = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        const std::string stamp = std::to_string(sent);
+
+        pingInFlight_ = true;
+        counters_.pings_sent.fetch_add(1, std::memory_order_relaxed);
+        ws_->async_ping(
+            boost::beast::websocket::ping_data(stamp.data(), stamp.size()),
+            boost::beast::bind_front_handler(
+                &WebSocketClientPlain::onPing,
+                shared_from_this()
+            )
+        );
+    }
+
+    keepaliveTimer_.expires_after(keepalive_.interval);
+    keepaliveTimer_.async_wait(
+        boost::beast::bind_front_handler(
+            &WebSocketClientPlain::onKeepaliveTimer,
+            shared_from_this()
+        )
+    );
+}
+
+void WebSocketClientPlain::onPing(boost::beast::error_code ec) {
+    pingInFlight_ = false;
+
+    // A failed ping means a failed connection, which the read reports
+    if (ec && reconnecting_) {
+        return scheduleReconnect();
+    }
+}
+
+void WebSocketClientPlain::onControlFrame(
+    boost::beast::websocket::frame_type kind,
+    boost::beast::string_view payload) {
+
+    if (kind != boost::beast::websocket::frame_type::pong) {
+        return;
+    }
+
+    // Anything but one of our stamps is an unsolicited pong
+    std::int64_t sent = 0;
+    const char* end = payload.data() + payload.size();
+    const auto parsed = std::from_chars(payload.data(), end, sent);
+    const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (parsed.ec != std::errc() || parsed.ptr != end || sent > now) {
+        return;
+    }
+
+    awaitingPong_ = false;
+    missedPongs_ = 0;
+    counters_.pongs_received.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(pingRttMutex_);
+    pingRtt_.record(static_cast<std::uint64_t>(now - sent));
 }
 
 void WebSocketClientPlain::fail(boost::beast::error_code ec, const char* what) {
+    fail(std::string(what) + ": " + ec.message());
+}
+
+void WebSocketClientPlain::fail(const std::string& message) {
+    if (connecting_) {
+        traceSpan("connect", TraceLane::lifecycle, connectStarted_, true);
+    }
+
     connected_ = false;
+    connecting_ = false;
+    open_ = false;
+    keepaliveTimer_.cancel();
+
+    // Errors after close() are just the connection going away
+    if (closing_) {
+        return;
+    }
+
     if (onError_) {
-        onError_(std::string(what) + ": " + ec.message());
+        onError_(message);
+    }
+
+    if (closeRequested_) {
+        return maybeClose();
+    }
+
+    beginReconnect();
+}
+
+std::string WebSocketClientPlain::closeNotice() const {
+    // Add the code and reason from the server's close frame, if it sent any
+    const auto& reason = ws_->reason();
+    std::string notice = "Server closed the connection";
+    if (reason.code != boost::beast::websocket::close_code::none) {
+        notice += " (" + std::to_string(reason.code);
+        if (!reason.reason.empty()) {
+            notice += ": " + std::string(reason.reason.data(), reason.reason.size());
+        }
+        notice += ")";
+    }
+    return notice;
+}
+
+void WebSocketClientPlain::beginReconnect() {
+    if (!reconnectPolicy_.enabled || closeRequested_) {
+        return;
+    }
+
+    // Retries after a failed attempt keep the original outage start
+    if (!reconnecting_) {
+        reconnecting_ = true;
+        reconnectAttempt_ = 0;
+        outageStart_ = std::chrono::steady_clock::now();
+    }
+
+    scheduleReconnect();
+}
+
+void WebSocketClientPlain::scheduleReconnect() {
+    if (reconnectTimerArmed_) {
+        return;
+    }
+
+    // The old stream may only be replaced once nothing is pending on it;
+    // closing the socket makes the read, write and ping finish and call
+    // back here
+    if (readInFlight_ || writeInFlight_ || pingInFlight_) {
+        boost::beast::get_lowest_layer(*ws_).close();
+        return;
+    }
+
+    const std::size_t attempt = ++reconnectAttempt_;
+    if (reconnectPolicy_.max_attempts && attempt > reconnectPolicy_.max_attempts) {
+        reconnecting_ = false;
+        reconnectExhausted_ = true;
+        if (onError_) {
+            onError_("reconnect: gave up after "
+                + std::to_string(reconnectPolicy_.max_attempts) + " attempts");
+        }
+        return;
     }
+
+    reconnectTimerArmed_ = true;
+    if (tracer_) {
+        backoffStarted_ = TraceRecorder::Clock::now();
+    }
+    reconnectTimer_.expires_after(reconnectPolicy_.delayFor(attempt, rng_));
+    reconnectTimer_.async_wait(
+        boost::beast::bind_front_handler(
+            &WebSocketClientPlain::onReconnectTimer,
+            shared_from_this()
+        )
+    );
+}
+
+void WebSocketClientPlain::onReconnectTimer(boost::beast::error_code ec) {
+    reconnectTimerArmed_ = false;
+    if (ec || !reconnecting_) {
+        return;
+    }
+
+    traceSpan("reconnect_backoff", TraceLane::lifecycle, backoffStarted_);
+    resetStream();
+    startConnect();
 }
 
 } // namespace websocket_client
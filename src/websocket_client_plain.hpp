@@ -2,10 +2,34 @@
 
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
+#include "backpressure_policy.hpp"
+#include "buffer_pool.hpp"
+#include "coalescing_stream.hpp"
+#include "compression_options.hpp"
+#include "connection_stats.hpp"
+#include "dns_cache.hpp"
+#include "frame_encoder.hpp"
+#include "keepalive_policy.hpp"
+#include "latency_histogram.hpp"
+#include "message_latency.hpp"
+#include "message_types.hpp"
+#include "metered_stream.hpp"
+#include "mpsc_queue.hpp"
+#include "reconnect_policy.hpp"
+#include "shared_payload.hpp"
+#include "trace_recorder.hpp"
+#include "write_batch_options.hpp"
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace websocket_client {
@@ -13,6 +37,13 @@ namespace websocket_client {
 class WebSocketClientPlain : public std::enable_shared_from_this<WebSocketClientPlain> {
 public:
     using MessageHandler = std::function<void(const std::string&)>;
+    // Receives a view into the read buffer, valid only until it returns.
+    using MessageViewHandler = std::function<void(std::string_view, Opcode)>;
+    // Receives a pooled handle that may be kept after it returns.
+    using PooledMessageHandler = std::function<void(PooledMessage, Opcode)>;
+    // Receives a message piece by piece as it arrives; `last` is set on the
+    // final piece. Each view is valid only until the handler returns.
+    using MessageChunkHandler = std::function<void(std::string_view, Opcode, bool last)>;
     using ErrorHandler = std::function<void(const std::string&)>;
     using ConnectHandler = std::function<void()>;
 
@@ -27,38 +58,291 @@ public:
         ConnectHandler onConnect = nullptr
     );
 
-    void send(const std::string& message);
+    // Zero-copy variant: messages are delivered straight from the read buffer
+    void connect(
+        const std::string& host,
+        const std::string& port,
+        const std::string& target,
+        MessageViewHandler onMessage,
+        ErrorHandler onError,
+        ConnectHandler onConnect = nullptr
+    );
+
+    // Hand-off variant: each message is passed on without a copy and its
+    // block returns to the buffer pool once the last handle is dropped
+    void connect(
+        const std::string& host,
+        const std::string& port,
+        const std::string& target,
+        PooledMessageHandler onMessage,
+        ErrorHandler onError,
+        ConnectHandler onConnect = nullptr
+    );
+
+    // Streaming variant: messages are delivered in pieces of at most
+    // setReadChunkSize() bytes as they arrive, so a large message is never
+    // held in memory whole
+    void connect(
+        const std::string& host,
+        const std::string& port,
+        const std::string& target,
+        MessageChunkHandler onChunk,
+        ErrorHandler onError,
+        ConnectHandler onConnect = nullptr
+    );
+
+    // Thread-safe: messages are queued and written one at a time on the
+    // stream's strand, in the order they were sent. Without a reconnect
+    // policy, sending while disconnected reports "Not connected"; with one,
+    // the message waits for the next connection, until the policy gives up.
+    void send(std::string message);
     void sendBinary(const std::vector<uint8_t>& data);
+
+    // Queue bytes that other clients may be sending too, without copying
+    // them. Text or binary as the payload says. Never goes through the
+    // frame encoder, which masks in place. Returns false if the client
+    // could not take it, after reporting "Not connected".
+    bool send(SharedPayload payload);
+
+    // Like send(), but instead of queueing returns false while the client
+    // is backpressured or, without a reconnect policy, disconnected.
+    bool trySend(std::string message);
+    bool trySendBinary(const std::vector<uint8_t>& data);
+    bool trySend(SharedPayload payload);
+
+    // Send a file as one message without reading it into memory. It is
+    // mapped and written in setWriteFragmentSize() fragments; messages
+    // queued behind it go out once it is complete. Throws
+    // std::system_error if the file cannot be mapped.
+    void sendFile(const std::string& path, bool binary = true);
+    void sendFile(std::shared_ptr<const MappedFile> file, bool binary = true);
+
+    // Closes the connection once every queued message has been written.
+    // During a reconnect outage the pending attempt is abandoned instead.
     void close();
 
+    // Offer permessage-deflate on the next handshake. Call before connect().
+    void setCompression(const CompressionOptions& options);
+
+    // Share resolver results with other clients. Call before connect().
+    void setDnsCache(std::shared_ptr<DnsCache> cache);
+
+    // Reconnect automatically after the connection drops, keeping unsent
+    // messages queued. `onReconnect` runs on the client's strand after each
+    // reconnect handshake, before the connect handler. Call before connect().
+    void setReconnectPolicy(const ReconnectPolicy& policy, ReconnectHandler onReconnect = nullptr);
+
+    // Ping the server periodically, timing the pongs and failing the
+    // connection once too many go unanswered. Call before connect().
+    void setKeepalive(const KeepalivePolicy& policy);
+
+    // Watermarks on the outbound queue. `onBackpressure` runs on the
+    // client's strand whenever the client becomes backpressured or
+    // recovers. Call before connect().
+    void setBackpressure(const BackpressurePolicy& policy, BackpressureHandler onBackpressure = nullptr);
+
+    // Largest message accepted, in bytes (0 = no limit). A bigger one fails
+    // the connection instead of growing the buffer. Defaults to 16 MiB.
+    // Call before connect().
+    void setReadMessageMax(std::uint64_t bytes);
+
+    // Largest piece handed to a MessageChunkHandler. Call before connect().
+    void setReadChunkSize(std::size_t bytes);
+
+    // Largest frame written by sendFile(). Defaults to 64 KiB.
+    void setWriteFragmentSize(std::size_t bytes);
+
+    // Gather small frames and write them together. Call before connect().
+    void setWriteBatching(const WriteBatchOptions& options);
+
+    // Frame and mask send() and sendBinary() messages with FrameEncoder,
+    // in place in the queued copy, instead of through the websocket
+    // stream. Ignored while permessage-deflate is in use and for
+    // sendFile(). Call before connect().
+    void setFrameEncoder(bool enabled);
+
+    // Take receive buffers from `pool` instead of BufferPool::global().
+    // Call before connect().
+    void setBufferPool(std::shared_ptr<BufferPool> pool);
+
+    // Traffic counters; safe to call from any thread.
+    ConnectionStats stats() const;
+
+    // Ping round trips in nanoseconds over every connection so far; safe to
+    // call from any thread.
+    LatencyHistogram pingRtt() const;
+
+    // True once the reconnect policy has given up. The client will not
+    // connect again and refuses sends. Safe to call from any thread.
+    bool reconnectExhausted() const { return reconnectExhausted_; }
+
+    // Whether send() would queue a message rather than report "Not
+    // connected": connected, or waiting to reconnect. Safe to call from
+    // any thread.
+    bool canSend() const;
+
+    // Record how long messages take to be delivered, handled, queued and
+    // written. Off by default, since the histograms take 64 KiB per client.
+    // Call before connect().
+    void setLatencyTracking(bool enabled);
+
+    // Histograms over every connection so far; empty unless latency
+    // tracking is on. Safe to call from any thread.
+    MessageLatency latency() const;
+
+    // Record each connection's phases, and sampled reads and writes, as
+    // spans on a track of this client's own. Call before connect().
+    void setTracer(std::shared_ptr<TraceRecorder> tracer);
+
+    // The strand every handler of this client runs on. Timers and work bound
+    // to it are serialized with the message handler.
+    using executor_type = boost::asio::strand<boost::asio::io_context::executor_type>;
+    executor_type get_executor() const { return strand_; }
+
 private:
+    using stream_type = boost::beast::websocket::stream<
+        MeteredStream<CoalescingStream<boost::beast::tcp_stream>>>;
+
+    // Stores the connection details and posts startConnect(); the message
+    // handler is already set
+    void postConnect(
+        const std::string& host,
+        const std::string& port,
+        const std::string& target,
+        ErrorHandler onError,
+        ConnectHandler onConnect);
+    void resetStream();
+    void startConnect();
+    void doResolve();
     void onResolve(
         boost::beast::error_code ec,
         boost::asio::ip::tcp::resolver::results_type results
     );
 
+    void doConnect();
     void onConnect(
         boost::beast::error_code ec,
-        boost::asio::ip::tcp::resolver::results_type::endpoint_type ep
+        boost::asio::ip::tcp::socket socket,
+        boost::asio::ip::tcp::endpoint ep
     );
 
     void onHandshake(boost::beast::error_code ec);
     void doRead();
     void onRead(boost::beast::error_code ec, std::size_t bytes_transferred);
+    void enqueue(OutboundMessage message);
+    bool isBackpressured() const;
+    void updateBackpressure();
+    void onWriteScheduled();
+    void doWrite();
+    void writeEncoded();
+    void onWriteEncoded(boost::beast::error_code ec, std::size_t bytes_transferred);
+    void writeFragment();
+    void onWriteFragment(boost::beast::error_code ec, std::size_t bytes_transferred);
     void onWrite(boost::beast::error_code ec, std::size_t bytes_transferred);
+    void doClose();
+    void maybeClose();
     void onClose(boost::beast::error_code ec);
 
+    void startKeepalive();
+    void onKeepaliveTimer(boost::beast::error_code ec);
+    void onPing(boost::beast::error_code ec);
+    void onControlFrame(boost::beast::websocket::frame_type kind, boost::beast::string_view payload);
+
     void fail(boost::beast::error_code ec, const char* what);
+    void fail(const std::string& message);
+    std::string closeNotice() const;
+    void beginReconnect();
+    void scheduleReconnect();
+    void onReconnectTimer(boost::beast::error_code ec);
 
+    // A span from `start` to now, if tracing
+    void traceSpan(const char* name, TraceLane lane, TraceRecorder::Clock::time_point start, bool failed = false);
+
+    // Every handler, including the resolver's and the timer's, runs here
+    boost::asio::strand<boost::asio::io_context::executor_type> strand_;
     boost::asio::ip::tcp::resolver resolver_;
-    boost::beast::websocket::stream<boost::beast::tcp_stream> ws_;
-    boost::beast::flat_buffer buffer_;
+    std::shared_ptr<DnsCache> dnsCache_;
+    std::vector<boost::asio::ip::tcp::endpoint> endpoints_;
+    std::chrono::steady_clock::time_point connectStarted_;
+
+    // Rebuilt for every connection attempt
+    std::optional<stream_type> ws_;
+    boost::beast::websocket::response_type handshakeResponse_;
+    PooledBuffer buffer_;
     std::string host_;
+    std::string port_;
     std::string target_;
-    MessageHandler onMessage_;
+    MessageViewHandler onMessage_;
+    PooledMessageHandler onPooledMessage_;
+    MessageChunkHandler onChunk_;
+    std::uint64_t readMessageMax_{16 * 1024 * 1024};
+    std::size_t readChunkSize_{64 * 1024};
     ErrorHandler onError_;
     ConnectHandler onConnect_;
-    bool connected_;
+    std::atomic<bool> connected_;
+    CompressionOptions compression_;
+    ConnectionCounters counters_;
+
+    // Outbound path. Producers only touch writeQueue_ and writeScheduled_;
+    // everything else is owned by the strand.
+    MpscQueue<OutboundMessage> writeQueue_;
+    std::atomic<bool> writeScheduled_{false};
+    OutboundMessage currentWrite_;
+    std::size_t writeOffset_{0};
+    std::size_t writeFragmentSize_{64 * 1024};
+    WriteBatchOptions writeBatch_;
+    bool frameEncoderEnabled_{false};
+    FrameEncoder frameEncoder_;
+    FrameEncoder::Header frameHeader_;
+    bool currentMasked_{false};  // currentWrite_.payload is masked under frameHeader_.key
+    BackpressurePolicy backpressure_;
+    BackpressureHandler onBackpressure_;
+    std::atomic<bool> backpressured_{false};
+    bool writeInFlight_{false};
+    bool resendCurrent_{false};
+    bool readInFlight_{false};
+    bool connecting_{false};
+    bool open_{false};
+    bool closeRequested_{false};
+    bool closing_{false};
+
+    // Reconnect state, owned by the strand
+    ReconnectPolicy reconnectPolicy_;
+    ReconnectHandler onReconnect_;
+    boost::asio::steady_timer reconnectTimer_;
+    bool reconnectTimerArmed_{false};
+    bool reconnecting_{false};
+    std::atomic<bool> reconnectExhausted_{false};
+    std::size_t reconnectAttempt_{0};
+    std::chrono::steady_clock::time_point outageStart_;
+    std::mt19937 rng_;
+
+    // Latency recording, written on the strand
+    std::unique_ptr<MessageLatencyRecorder> latency_;
+    std::chrono::steady_clock::time_point lastRead_;
+    std::chrono::steady_clock::time_point writeStarted_;
+
+    // Tracing, owned by the strand
+    std::shared_ptr<TraceRecorder> tracer_;
+    std::uint64_t traceTrack_{0};
+    TraceRecorder::Clock::time_point phaseStarted_;
+    TraceRecorder::Clock::time_point handshakeDone_;
+    TraceRecorder::Clock::time_point backoffStarted_;
+    TraceRecorder::Clock::time_point readStarted_;
+    std::uint64_t readsSeen_{0};
+    std::uint64_t writesSeen_{0};
+    bool awaitingFirstMessage_{false};
+    bool readTraced_{false};
+    bool writeTraced_{false};
+
+    // Keepalive state, owned by the strand except for the histogram
+    KeepalivePolicy keepalive_;
+    boost::asio::steady_timer keepaliveTimer_;
+    bool pingInFlight_{false};
+    bool awaitingPong_{false};
+    std::size_t missedPongs_{0};
+    mutable std::mutex pingRttMutex_;
+    LatencyHistogram pingRtt_;
 };
 
 } // namespace websocket_client
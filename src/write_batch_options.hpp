@@ -0,0 +1,28 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace websocket_client {
+
+// Opt-in coalescing of outbound frames.
+//
+// Without it every message costs at least one socket write. With it the
+// frames of consecutive messages, pings and pongs are gathered in order and
+// written together in one system call. A batch goes out once `max_bytes`
+// are gathered, and otherwise as soon as nothing more is queued or, with a
+// non-zero `linger`, that long after its first frame, trading that much
+// latency for bigger batches when messages trickle in one at a time.
+//
+// A message counts as written once it is in the batch, so stats() and the
+// backpressure watermarks see it leave the queue a little earlier, and a
+// batch cut off by a dropped connection is not resent on reconnect, much
+// like data already in the kernel's socket buffer.
+struct WriteBatchOptions {
+    std::size_t max_bytes = 0;  // 0 writes every frame on its own
+    std::chrono::microseconds linger{0};
+
+    bool enabled() const { return max_bytes > 0; }
+};
+
+} // namespace websocket_client
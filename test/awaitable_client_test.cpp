@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "awaitable_client.hpp"
+#include "local_server.hpp"
+
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/system/system_error.hpp>
+#include <exception>
+#include <string>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+// Runs `body` as a coroutine to completion and rethrows what it threw
+template <class Body>
+void runCoroutine(Body body) {
+    boost::asio::io_context ioc;
+    std::exception_ptr failure;
+    boost::asio::co_spawn(ioc, std::move(body),
+        [&failure](std::exception_ptr e) { failure = e; });
+    ioc.run();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+} // namespace
+
+TEST(AwaitableClientTest, EchoesTextAndBinary) {
+    LocalServer server({});
+    server.start();
+
+    ConnectionStats stats;
+    runCoroutine([&]() -> boost::asio::awaitable<void> {
+        AwaitableClientPlain client(co_await boost::asio::this_coro::executor);
+        co_await client.connect("127.0.0.1", std::to_string(server.port()), "/");
+
+        co_await client.write("hello");
+        auto reply = co_await client.read();
+        EXPECT_EQ(reply.data, "hello");
+        EXPECT_EQ(reply.opcode, Opcode::text);
+
+        const std::string bytes("\x00\x01\xff", 3);
+        co_await client.write(bytes, Opcode::binary);
+        reply = co_await client.read();
+        EXPECT_EQ(reply.data, bytes);
+        EXPECT_EQ(reply.opcode, Opcode::binary);
+
+        stats = client.stats();
+        co_await client.close();
+    });
+
+    EXPECT_EQ(stats.messages_sent, 2u);
+    EXPECT_EQ(stats.messages_received, 2u);
+    EXPECT_EQ(stats.payload_bytes_received, 8u);
+    EXPECT_EQ(stats.connects, 1u);
+    EXPECT_GT(stats.wire_bytes_sent, 8u);
+}
+
+TEST(AwaitableClientTest, EchoesOverTls) {
+    LocalServer::Options options;
+    options.secure = true;
+    LocalServer server(options);
+    server.start();
+
+    boost::asio::ssl::context ssl_ctx{boost::asio::ssl::context::tlsv12_client};
+    ssl_ctx.set_verify_mode(boost::asio::ssl::verify_none);
+
+    ConnectionStats stats;
+    runCoroutine([&]() -> boost::asio::awaitable<void> {
+        AwaitableClient client(co_await boost::asio::this_coro::executor, ssl_ctx);
+        co_await client.connect("127.0.0.1", std::to_string(server.port()), "/");
+
+        co_await client.write("secure");
+        const auto reply = co_await client.read();
+        EXPECT_EQ(reply.data, "secure");
+
+        stats = client.stats();
+        co_await client.close();
+    });
+
+    EXPECT_EQ(stats.tls_full_handshakes, 1u);
+    EXPECT_EQ(stats.messages_received, 1u);
+}
+
+TEST(AwaitableClientTest, ConnectFailureThrows) {
+    // Bind a port, then free it so nothing listens there
+    unsigned short port = 0;
+    {
+        LocalServer server({});
+        server.start();
+        port = server.port();
+        server.stop();
+    }
+
+    EXPECT_THROW(runCoroutine([port]() -> boost::asio::awaitable<void> {
+        AwaitableClientPlain client(co_await boost::asio::this_coro::executor);
+        co_await client.connect("127.0.0.1", std::to_string(port), "/");
+    }), boost::system::system_error);
+}
+
+} // namespace test
+} // namespace websocket_client
+
+#endif // BOOST_ASIO_HAS_CO_AWAIT
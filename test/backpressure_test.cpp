@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include "backpressure_policy.hpp"
+#include "local_server.hpp"
+#include "test_util.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/websocket.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+// Completes the WebSocket handshake, then reads nothing until
+// startReading(), so the client's writes back up behind full socket buffers
+class StalledServer {
+public:
+    StalledServer()
+        : acceptor_(ioc_, {boost::asio::ip::make_address("127.0.0.1"), 0})
+    {
+        acceptor_.async_accept(
+            [this](boost::system::error_code ec, boost::asio::ip::tcp::socket socket) {
+                if (ec) {
+                    return;
+                }
+                ws_ = std::make_unique<stream_type>(std::move(socket));
+                ws_->async_accept([](boost::system::error_code) {});
+            });
+        thread_ = std::thread([this]() { ioc_.run(); });
+    }
+
+    ~StalledServer() {
+        work_.reset();
+        ioc_.stop();
+        thread_.join();
+    }
+
+    unsigned short port() const { return acceptor_.local_endpoint().port(); }
+
+    void startReading() {
+        boost::asio::post(ioc_, [this]() { read(); });
+    }
+
+private:
+    using stream_type = boost::beast::websocket::stream<boost::asio::ip::tcp::socket>;
+
+    void read() {
+        ws_->async_read(buffer_, [this](boost::system::error_code ec, std::size_t) {
+            if (ec) {
+                return;
+            }
+            buffer_.clear();
+            read();
+        });
+    }
+
+    boost::asio::io_context ioc_;
+    // Keeps run() going while there is nothing to do but wait for startReading()
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_{
+        ioc_.get_executor()};
+    boost::asio::ip::tcp::acceptor acceptor_;
+    std::unique_ptr<stream_type> ws_;
+    boost::beast::flat_buffer buffer_;
+    std::thread thread_;
+};
+
+} // namespace
+
+TEST(BackpressurePolicyTest, DisabledByDefault) {
+    BackpressurePolicy policy;
+    EXPECT_FALSE(policy.enabled());
+    EXPECT_FALSE(policy.reachedHigh(1ull << 40, 1ull << 40));
+    EXPECT_TRUE(policy.drainedToLow(1ull << 40, 1ull << 40));
+}
+
+TEST(BackpressurePolicyTest, EitherHighMarkTriggersAndBothMustDrain) {
+    BackpressurePolicy policy;
+    policy.high_water_bytes = 1000;
+    policy.low_water_bytes = 500;
+    policy.high_water_messages = 10;
+    policy.low_water_messages = 5;
+
+    EXPECT_FALSE(policy.reachedHigh(999, 9));
+    EXPECT_TRUE(policy.reachedHigh(1000, 1));
+    EXPECT_TRUE(policy.reachedHigh(1, 10));
+
+    EXPECT_FALSE(policy.drainedToLow(600, 1));
+    EXPECT_FALSE(policy.drainedToLow(100, 6));
+    EXPECT_TRUE(policy.drainedToLow(500, 5));
+}
+
+TEST(BackpressurePolicyTest, UnsetCountIsIgnored) {
+    BackpressurePolicy policy;
+    policy.high_water_messages = 4;
+    policy.low_water_messages = 2;
+
+    EXPECT_FALSE(policy.reachedHigh(1ull << 40, 3));
+    EXPECT_TRUE(policy.drainedToLow(1ull << 40, 2));
+}
+
+class BackpressureTest : public ClientTest {
+protected:
+    void onBackpressure(bool backpressured) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        transitions_.push_back(backpressured);
+    }
+
+    std::vector<bool> transitions() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return transitions_;
+    }
+
+    std::vector<bool> transitions_;
+};
+
+TEST_F(BackpressureTest, SlowReaderStopsTrySendUntilDrained) {
+    StalledServer server;
+
+    BackpressurePolicy policy;
+    policy.high_water_bytes = 1024 * 1024;
+    policy.low_water_bytes = 256 * 1024;
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setBackpressure(policy, [this](bool backpressured) { onBackpressure(backpressured); });
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    // Socket buffers absorb the first few megabytes; after that the queue
+    // can only grow until trySend() refuses
+    const std::string payload(64 * 1024, 'x');
+    std::size_t accepted = 0;
+    ASSERT_TRUE(waitFor([&]() {
+        if (client->trySend(payload)) {
+            ++accepted;
+            return false;
+        }
+        return true;
+    }, std::chrono::seconds(30)));
+
+    ASSERT_TRUE(waitFor([this]() { return !transitions().empty(); }));
+    EXPECT_EQ(transitions(), std::vector<bool>{true});
+
+    ConnectionStats stats = client->stats();
+    EXPECT_GE(stats.queued_bytes, policy.high_water_bytes);
+    EXPECT_LE(stats.queued_bytes, policy.high_water_bytes + payload.size());
+    EXPECT_EQ(stats.backpressure_events, 1u);
+
+    // Still refused while draining down to the low mark
+    EXPECT_FALSE(client->trySend(payload));
+
+    server.startReading();
+    ASSERT_TRUE(waitFor([this]() { return transitions().size() == 2; }));
+    EXPECT_EQ(transitions(), (std::vector<bool>{true, false}));
+    EXPECT_TRUE(client->trySend(payload));
+
+    ASSERT_TRUE(waitFor([&]() { return client->stats().messages_sent == accepted + 1; }));
+    stats = client->stats();
+    EXPECT_EQ(stats.queued_messages, 0u);
+    EXPECT_EQ(stats.queued_bytes, 0u);
+    EXPECT_GT(stats.backpressure_time_us, 0u);
+}
+
+TEST_F(BackpressureTest, SecureClientCountsQueueDepth) {
+    LocalServer::Options options;
+    options.secure = true;
+    LocalServer server(options);
+    server.start();
+
+    BackpressurePolicy policy;
+    policy.high_water_messages = 1000;
+    policy.low_water_messages = 100;
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    client->setBackpressure(policy, [this](bool backpressured) { onBackpressure(backpressured); });
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(client->trySend("message " + std::to_string(i)));
+    }
+
+    ASSERT_TRUE(waitFor([&client]() { return client->stats().messages_sent == 100; }));
+    const ConnectionStats stats = client->stats();
+    EXPECT_EQ(stats.queued_messages, 0u);
+    EXPECT_EQ(stats.queued_bytes, 0u);
+    EXPECT_EQ(stats.backpressure_events, 0u);
+    EXPECT_TRUE(transitions().empty());
+}
+
+} // namespace test
+} // namespace websocket_client
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include "buffer_pool.hpp"
+#include "local_server.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+void append(PooledBuffer& buffer, const std::string& bytes) {
+    auto region = buffer.prepare(bytes.size());
+    std::memcpy(region.data(), bytes.data(), bytes.size());
+    buffer.commit(bytes.size());
+}
+
+std::string contents(const PooledBuffer& buffer) {
+    const auto data = buffer.data();
+    return std::string(static_cast<const char*>(data.data()), data.size());
+}
+
+} // namespace
+
+TEST(BufferPoolTest, ReleasedBlocksAreReused) {
+    auto pool = BufferPool::create();
+
+    detail::PoolBlock* first = pool->acquire(100);
+    EXPECT_EQ(first->capacity, 512u);
+    EXPECT_EQ(pool->stats().bytes_in_use, 512u);
+    pool->release(first);
+
+    detail::PoolBlock* second = pool->acquire(512);
+    EXPECT_EQ(second, first);
+    pool->release(second);
+
+    const BufferPool::Stats stats = pool->stats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.bytes_in_use, 0u);
+    EXPECT_EQ(stats.bytes_cached, 512u);
+}
+
+TEST(BufferPoolTest, SizeClassesRoundUpToPowersOfTwo) {
+    auto pool = BufferPool::create();
+    detail::PoolBlock* block = pool->acquire(513);
+    EXPECT_EQ(block->capacity, 1024u);
+    pool->release(block);
+
+    block = pool->acquire(100000);
+    EXPECT_EQ(block->capacity, 131072u);
+    pool->release(block);
+}
+
+TEST(BufferPoolTest, OversizedAndExcessBlocksAreFreed) {
+    BufferPool::Options options;
+    options.max_block = 4096;
+    options.max_cached_bytes = 1024;
+    auto pool = BufferPool::create(options);
+
+    // Above max_block: exact size, never cached
+    detail::PoolBlock* big = pool->acquire(5000);
+    EXPECT_EQ(big->capacity, 5000u);
+    pool->release(big);
+    EXPECT_EQ(pool->stats().bytes_cached, 0u);
+
+    // Only 1024 bytes may sit on the free lists
+    detail::PoolBlock* a = pool->acquire(1024);
+    detail::PoolBlock* b = pool->acquire(1024);
+    pool->release(a);
+    pool->release(b);
+    EXPECT_EQ(pool->stats().bytes_cached, 1024u);
+}
+
+TEST(BufferPoolTest, BufferGrowsAndKeepsItsContents) {
+    auto pool = BufferPool::create();
+    PooledBuffer buffer(pool);
+
+    append(buffer, std::string(400, 'a'));
+    append(buffer, std::string(400, 'b'));
+    EXPECT_EQ(buffer.size(), 800u);
+    EXPECT_GE(buffer.capacity(), 1024u);
+    EXPECT_EQ(contents(buffer), std::string(400, 'a') + std::string(400, 'b'));
+
+    buffer.consume(400);
+    EXPECT_EQ(contents(buffer), std::string(400, 'b'));
+
+    // The 512-byte block went back to the pool when the buffer grew
+    EXPECT_EQ(pool->stats().blocks_in_use, 1u);
+}
+
+TEST(BufferPoolTest, DetachedMessageOutlivesBuffer) {
+    auto pool = BufferPool::create();
+    PooledMessage kept;
+    {
+        PooledBuffer buffer(pool);
+        append(buffer, "hello");
+        kept = buffer.detach();
+        EXPECT_EQ(buffer.size(), 0u);
+    }
+
+    EXPECT_EQ(kept.view(), "hello");
+    EXPECT_EQ(pool->stats().blocks_in_use, 1u);
+
+    PooledMessage copy = kept;
+    EXPECT_EQ(copy.data(), kept.data());
+
+    kept = PooledMessage();
+    EXPECT_EQ(pool->stats().blocks_in_use, 1u);
+    copy = PooledMessage();
+    EXPECT_EQ(pool->stats().blocks_in_use, 0u);
+    EXPECT_EQ(pool->stats().bytes_in_use, 0u);
+}
+
+TEST(BufferPoolTest, ClearReturnsLargeBlocksOnly) {
+    auto pool = BufferPool::create();
+    PooledBuffer buffer(pool, 4096);
+
+    append(buffer, std::string(100, 'x'));
+    buffer.clear();
+    EXPECT_EQ(pool->stats().blocks_in_use, 1u);
+
+    append(buffer, std::string(64 * 1024, 'x'));
+    buffer.clear();
+    EXPECT_EQ(pool->stats().blocks_in_use, 0u);
+}
+
+TEST(BufferPoolTest, ClientHandsOffMessagesWithoutCopying) {
+    LocalServer::Options server_options;
+    server_options.mode = LocalServer::Mode::flood;
+    server_options.flood_count = 200;
+    server_options.flood_message_size = 3000;
+    LocalServer server(server_options);
+    server.start();
+
+    auto pool = BufferPool::create();
+    boost::asio::io_context ioc;
+    auto client = std::make_shared<WebSocketClientPlain>(ioc);
+    client->setBufferPool(pool);
+
+    std::mutex mutex;
+    std::vector<PooledMessage> kept;
+    client->connect(
+        "127.0.0.1",
+        std::to_string(server.port()),
+        "/",
+        [&](PooledMessage message, Opcode) {
+            std::lock_guard<std::mutex> lock(mutex);
+            kept.push_back(std::move(message));
+        },
+        [](const std::string& error) { ADD_FAILURE() << error; }
+    );
+    std::thread io_thread([&ioc]() { ioc.run(); });
+
+    const auto receivedAll = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return kept.size() == 200;
+    };
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!receivedAll() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ASSERT_EQ(kept.size(), 200u);
+        for (const auto& message : kept) {
+            EXPECT_EQ(message.view(), std::string(3000, 'x'));
+        }
+
+        // Each kept message still owns its block
+        EXPECT_GE(pool->stats().blocks_in_use, 200u);
+        kept.clear();
+    }
+
+    client->close();
+    io_thread.join();
+    client.reset();
+
+    EXPECT_EQ(pool->stats().blocks_in_use, 0u);
+}
+
+} // namespace test
+} // namespace websocket_client
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "capture_log.hpp"
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+// A fresh base path; removes every segment written under it
+class TempLog {
+public:
+    TempLog() {
+        char dir[] = "/tmp/websocket_capture_XXXXXX";
+        EXPECT_NE(mkdtemp(dir), nullptr);
+        dir_ = dir;
+        base_ = dir_ + "/log";
+    }
+
+    ~TempLog() {
+        for (std::uint64_t i = 0; unlink(capture::segmentPath(base_, i).c_str()) == 0; ++i) {
+        }
+        rmdir(dir_.c_str());
+    }
+
+    const std::string& base() const { return base_; }
+
+private:
+    std::string dir_;
+    std::string base_;
+};
+
+std::string message(std::uint32_t writer, std::uint32_t sequence) {
+    // Varying lengths exercise the alignment padding
+    return std::to_string(writer) + ":" + std::to_string(sequence) + ":"
+        + std::string(sequence % 37, 'x');
+}
+
+} // namespace
+
+TEST(CaptureLogTest, ConcurrentAppendsReadBackAcrossSegments) {
+    TempLog log;
+    constexpr std::uint32_t kWriters = 4;
+    constexpr std::uint32_t kPerWriter = 5000;
+
+    CaptureLog::Options options;
+    options.segment_size = 16 * 1024;
+    {
+        CaptureLog capture(log.base(), options);
+
+        std::vector<std::thread> writers;
+        for (std::uint32_t w = 0; w < kWriters; ++w) {
+            writers.emplace_back([&capture, w]() {
+                for (std::uint32_t i = 0; i < kPerWriter; ++i) {
+                    const Opcode opcode = i % 2 ? Opcode::binary : Opcode::text;
+                    EXPECT_TRUE(capture.append(w, opcode, message(w, i)));
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+
+        const auto stats = capture.stats();
+        EXPECT_EQ(stats.records, kWriters * kPerWriter);
+        EXPECT_EQ(stats.dropped, 0u);
+        EXPECT_GT(stats.segments, 10u);
+    }
+
+    // Every writer's messages come back whole, in its own order
+    CaptureReader reader(log.base());
+    std::map<std::uint32_t, std::uint32_t> next;
+    std::uint64_t records = 0;
+
+    CaptureRecord record;
+    while (reader.next(record)) {
+        ASSERT_LT(record.connection_id, kWriters);
+        const std::uint32_t i = next[record.connection_id]++;
+        EXPECT_EQ(record.payload, message(record.connection_id, i));
+        EXPECT_EQ(record.opcode, i % 2 ? Opcode::binary : Opcode::text);
+        EXPECT_GT(record.timestamp_ns, 0u);
+        ++records;
+    }
+
+    EXPECT_EQ(records, kWriters * kPerWriter);
+    EXPECT_GT(reader.segmentsRead(), 10u);
+    for (std::uint32_t w = 0; w < kWriters; ++w) {
+        EXPECT_EQ(next[w], kPerWriter);
+    }
+}
+
+TEST(CaptureLogTest, DropsMessagesLargerThanASegment) {
+    TempLog log;
+    CaptureLog::Options options;
+    options.segment_size = 4096;
+    {
+        CaptureLog capture(log.base(), options);
+        EXPECT_TRUE(capture.append(7, Opcode::text, "small"));
+        EXPECT_FALSE(capture.append(7, Opcode::binary, std::string(8192, 'b')));
+        EXPECT_TRUE(capture.append(7, Opcode::text, ""));
+
+        const auto stats = capture.stats();
+        EXPECT_EQ(stats.records, 2u);
+        EXPECT_EQ(stats.dropped, 1u);
+        EXPECT_EQ(stats.payload_bytes, 5u);
+    }
+
+    CaptureReader reader(log.base());
+    CaptureRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.payload, "small");
+    EXPECT_EQ(record.connection_id, 7u);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_TRUE(record.payload.empty());
+    EXPECT_FALSE(reader.next(record));
+}
+
+TEST(CaptureLogTest, ReaderRejectsMissingLog) {
+    TempLog log;
+    EXPECT_THROW(CaptureReader reader(log.base()), std::system_error);
+}
+
+TEST(ReplayClockTest, PacesToTheOriginalSpacing) {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::uint64_t kMs = 1000 * 1000;
+
+    ReplayClock flat_out(0);
+    auto start = Clock::now();
+    flat_out.waitFor(1000 * kMs);
+    flat_out.waitFor(2000 * kMs);
+    EXPECT_LT(Clock::now() - start, std::chrono::milliseconds(100));
+
+    // 100 ms of capture at double speed
+    ReplayClock doubled(2.0);
+    start = Clock::now();
+    doubled.waitFor(1000 * kMs);
+    doubled.waitFor(1100 * kMs);
+    const auto elapsed = Clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(50));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(500));
+}
+
+} // namespace test
+} // namespace websocket_client
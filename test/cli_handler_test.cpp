@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "cli_handler.hpp"
+#include <boost/version.hpp>
 
 namespace websocket_client {
 namespace test {
@@ -13,6 +14,7 @@ TEST(CLIHandlerTest, DefaultValues) {
     EXPECT_EQ(cli.getPort(), "443");
     EXPECT_EQ(cli.getTarget(), "/");
     EXPECT_TRUE(cli.isSecure());
+    EXPECT_FALSE(cli.getCompressionOptions().enabled);
 }
 
 TEST(CLIHandlerTest, CustomValues) {
@@ -32,5 +34,204 @@ TEST(CLIHandlerTest, CustomValues) {
     EXPECT_FALSE(cli.isSecure());
 }
 
+TEST(CLIHandlerTest, CompressionOptions) {
+    CLIHandler cli;
+    const char* argv[] = {
+        "program",
+        "--compress",
+        "--compress-window-bits", "10",
+        "--compress-no-context-takeover",
+        "--compress-mem-level", "8"
+    };
+    ASSERT_TRUE(cli.parse(7, const_cast<char**>(argv)));
+
+    const CompressionOptions options = cli.getCompressionOptions();
+    EXPECT_TRUE(options.enabled);
+    EXPECT_EQ(options.window_bits, 10);
+    EXPECT_TRUE(options.no_context_takeover);
+    EXPECT_EQ(options.mem_level, 8);
+    EXPECT_EQ(options.min_message_size, 0u);
+}
+
+TEST(CLIHandlerTest, CompressMinSize) {
+    CLIHandler cli;
+    const char* argv[] = {"program", "--compress", "--compress-min-size", "256"};
+#if BOOST_VERSION >= 108100
+    ASSERT_TRUE(cli.parse(4, const_cast<char**>(argv)));
+    EXPECT_EQ(cli.getCompressionOptions().min_message_size, 256u);
+#else
+    // Beast before 1.81 has no threshold to pass it on to
+    EXPECT_FALSE(cli.parse(4, const_cast<char**>(argv)));
+
+    CLIHandler zero;
+    const char* zero_argv[] = {"program", "--compress", "--compress-min-size", "0"};
+    EXPECT_TRUE(zero.parse(4, const_cast<char**>(zero_argv)));
+#endif
+}
+
+TEST(CLIHandlerTest, ReconnectPolicy) {
+    CLIHandler cli;
+    const char* argv[] = {
+        "program",
+        "--reconnect",
+        "--reconnect-initial-delay", "50",
+        "--reconnect-max-delay", "2000",
+        "--reconnect-max-attempts", "7"
+    };
+    ASSERT_TRUE(cli.parse(8, const_cast<char**>(argv)));
+
+    const ReconnectPolicy policy = cli.getReconnectPolicy();
+    EXPECT_TRUE(policy.enabled);
+    EXPECT_EQ(policy.initial_delay.count(), 50);
+    EXPECT_EQ(policy.max_delay.count(), 2000);
+    EXPECT_EQ(policy.max_attempts, 7u);
+}
+
+TEST(CLIHandlerTest, KeepalivePolicy) {
+    CLIHandler defaults;
+    const char* no_args[] = {"program"};
+    ASSERT_TRUE(defaults.parse(1, const_cast<char**>(no_args)));
+    EXPECT_EQ(defaults.getKeepalivePolicy().interval.count(), 0);
+
+    CLIHandler cli;
+    const char* argv[] = {"program", "--ping-interval", "250", "--ping-max-missed", "3"};
+    ASSERT_TRUE(cli.parse(5, const_cast<char**>(argv)));
+
+    const KeepalivePolicy policy = cli.getKeepalivePolicy();
+    EXPECT_EQ(policy.interval.count(), 250);
+    EXPECT_EQ(policy.max_missed, 3u);
+    EXPECT_EQ(cli.getLoadOptions().keepalive.interval.count(), 250);
+}
+
+TEST(CLIHandlerTest, BackpressurePolicy) {
+    CLIHandler cli;
+    const char* argv[] = {
+        "program", "--max-queued-bytes", "1048576", "--max-queued-messages", "1000"};
+    ASSERT_TRUE(cli.parse(5, const_cast<char**>(argv)));
+
+    const BackpressurePolicy policy = cli.getBackpressurePolicy();
+    EXPECT_EQ(policy.high_water_bytes, 1048576u);
+    EXPECT_EQ(policy.low_water_bytes, 524288u);
+    EXPECT_EQ(policy.high_water_messages, 1000u);
+    EXPECT_EQ(policy.low_water_messages, 500u);
+}
+
+TEST(CLIHandlerTest, WriteBatchOptions) {
+    CLIHandler cli;
+    EXPECT_FALSE(cli.getWriteBatchOptions().enabled());
+
+    const char* argv[] = {"program", "--batch-bytes", "16384", "--batch-linger-us", "50"};
+    ASSERT_TRUE(cli.parse(5, const_cast<char**>(argv)));
+
+    const WriteBatchOptions options = cli.getWriteBatchOptions();
+    EXPECT_EQ(options.max_bytes, 16384u);
+    EXPECT_EQ(options.linger.count(), 50);
+    EXPECT_EQ(cli.getLoadOptions().write_batch.max_bytes, 16384u);
+}
+
+TEST(CLIHandlerTest, FrameEncoder) {
+    CLIHandler cli;
+    EXPECT_FALSE(cli.useFrameEncoder());
+
+    const char* argv[] = {"program", "--frame-encoder"};
+    ASSERT_TRUE(cli.parse(2, const_cast<char**>(argv)));
+    EXPECT_TRUE(cli.useFrameEncoder());
+    EXPECT_TRUE(cli.getLoadOptions().frame_encoder);
+}
+
+TEST(CLIHandlerTest, MaxMessageSize) {
+    CLIHandler cli;
+    const char* argv[] = {"program", "--max-message-size", "1048576"};
+    ASSERT_TRUE(cli.parse(3, const_cast<char**>(argv)));
+    EXPECT_EQ(cli.getMaxMessageSize(), 1048576u);
+}
+
+TEST(CLIHandlerTest, InputReplayOptions) {
+    CLIHandler cli;
+    const char* argv[] = {"program", "--rate", "2500", "--burst", "50"};
+    ASSERT_TRUE(cli.parse(5, const_cast<char**>(argv)));
+    EXPECT_TRUE(cli.getInputFile().empty());
+    EXPECT_DOUBLE_EQ(cli.getRate(), 2500.0);
+    EXPECT_EQ(cli.getBurst(), 50u);
+}
+
+TEST(CLIHandlerTest, CaptureFile) {
+    CLIHandler cli;
+    EXPECT_TRUE(cli.getCaptureFile().empty());
+
+    const char* argv[] = {"program", "--capture", "/tmp/feed"};
+    ASSERT_TRUE(cli.parse(3, const_cast<char**>(argv)));
+    EXPECT_EQ(cli.getCaptureFile(), "/tmp/feed");
+}
+
+TEST(CLIHandlerTest, Output) {
+    CLIHandler cli;
+    EXPECT_EQ(cli.getOutput(), "stdout");
+    EXPECT_FALSE(cli.dropOutputWhenBehind());
+
+    const char* argv[] = {"program", "--output", "none", "--output-drop"};
+    ASSERT_TRUE(cli.parse(4, const_cast<char**>(argv)));
+    EXPECT_EQ(cli.getOutput(), "none");
+    EXPECT_TRUE(cli.dropOutputWhenBehind());
+}
+
+TEST(CLIHandlerTest, LatencyReport) {
+    CLIHandler cli;
+    EXPECT_EQ(cli.getLatencyReportInterval(), 0u);
+
+    const char* argv[] = {"program", "--latency-report", "5"};
+    ASSERT_TRUE(cli.parse(3, const_cast<char**>(argv)));
+    EXPECT_EQ(cli.getLatencyReportInterval(), 5u);
+}
+
+TEST(CLIHandlerTest, TraceFile) {
+    CLIHandler cli;
+    EXPECT_TRUE(cli.getTraceFile().empty());
+    EXPECT_EQ(cli.getTraceSample(), 0u);
+
+    const char* argv[] = {"program", "--trace-file", "trace.json", "--trace-sample", "100"};
+    ASSERT_TRUE(cli.parse(5, const_cast<char**>(argv)));
+    EXPECT_EQ(cli.getTraceFile(), "trace.json");
+    EXPECT_EQ(cli.getTraceSample(), 100u);
+}
+
+TEST(CLIHandlerTest, LoadOptions) {
+    CLIHandler cli;
+    const char* argv[] = {
+        "program",
+        "--load",
+        "--connections", "200",
+        "--load-rate", "50",
+        "--payload-size", "512",
+        "--payload-pattern", "binary",
+        "--measure-rtt",
+        "--duration", "30"
+    };
+    ASSERT_TRUE(cli.parse(13, const_cast<char**>(argv)));
+
+    EXPECT_TRUE(cli.isLoadMode());
+    EXPECT_EQ(cli.getLoadDuration(), 30u);
+    EXPECT_EQ(cli.getReportInterval(), 1u);
+
+    const LoadOptions options = cli.getLoadOptions();
+    EXPECT_EQ(options.connections, 200u);
+    EXPECT_DOUBLE_EQ(options.rate, 50.0);
+    EXPECT_EQ(options.payload_size, 512u);
+    EXPECT_EQ(options.pattern, PayloadPattern::binary);
+    EXPECT_TRUE(options.measure_rtt);
+}
+
+TEST(CLIHandlerTest, RejectsUnknownPayloadPattern) {
+    CLIHandler cli;
+    const char* argv[] = {"program", "--load", "--payload-pattern", "zeros"};
+    EXPECT_FALSE(cli.parse(4, const_cast<char**>(argv)));
+}
+
+TEST(CLIHandlerTest, RejectsOutOfRangeWindowBits) {
+    CLIHandler cli;
+    const char* argv[] = {"program", "--compress-window-bits", "8"};
+    EXPECT_FALSE(cli.parse(3, const_cast<char**>(argv)));
+}
+
 } // namespace test
 } // namespace websocket_client
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "connection_manager.hpp"
+#include "local_server.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace websocket_client {
+namespace test {
+
+TEST(ConnectionManagerTest, RoundRobinSpreadsClientsEvenly) {
+    ConnectionManager::Options options;
+    options.threads = 3;
+    ConnectionManager manager(options);
+    ASSERT_EQ(manager.shardCount(), 3u);
+
+    std::vector<std::shared_ptr<WebSocketClientPlain>> clients;
+    for (int i = 0; i < 6; ++i) {
+        clients.push_back(manager.createPlainClient());
+    }
+
+    const auto stats = manager.stats();
+    EXPECT_EQ(stats.connections, 6u);
+    EXPECT_EQ(stats.connections_per_shard, (std::vector<std::size_t>{2, 2, 2}));
+}
+
+TEST(ConnectionManagerTest, LeastLoadedRefillsEmptiedShard) {
+    ConnectionManager::Options options;
+    options.threads = 2;
+    options.placement = ConnectionManager::Placement::least_loaded;
+    ConnectionManager manager(options);
+
+    auto a = manager.createPlainClient();  // shard 0
+    auto b = manager.createPlainClient();  // shard 1
+    auto c = manager.createPlainClient();  // shard 0
+    a.reset();
+    c.reset();
+
+    auto d = manager.createPlainClient();
+    EXPECT_EQ(manager.stats().connections_per_shard, (std::vector<std::size_t>{1, 1}));
+}
+
+TEST(ConnectionManagerTest, AggregatesTrafficAcrossShards) {
+    LocalServer server({});
+    server.start();
+
+    ConnectionManager::Options options;
+    options.threads = 2;
+    ConnectionManager manager(options);
+
+    constexpr int kClients = 4;
+    constexpr int kMessages = 10;
+    std::atomic<int> connected{0};
+    std::atomic<int> received{0};
+
+    std::vector<std::shared_ptr<WebSocketClientPlain>> clients;
+    for (int i = 0; i < kClients; ++i) {
+        auto client = manager.createPlainClient();
+        client->connect(
+            "127.0.0.1",
+            std::to_string(server.port()),
+            "/",
+            [&received](std::string_view, Opcode) { ++received; },
+            [](const std::string& error) { ADD_FAILURE() << error; },
+            [&connected]() { ++connected; }
+        );
+        clients.push_back(client);
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (connected < kClients && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(connected, kClients);
+
+    for (auto& client : clients) {
+        for (int i = 0; i < kMessages; ++i) {
+            client->send("ping");
+        }
+    }
+    while (received < kClients * kMessages && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    const auto stats = manager.stats();
+    EXPECT_EQ(stats.connections, static_cast<std::size_t>(kClients));
+    EXPECT_EQ(stats.totals.messages_received, static_cast<std::uint64_t>(kClients * kMessages));
+    EXPECT_EQ(stats.totals.messages_sent, static_cast<std::uint64_t>(kClients * kMessages));
+    ASSERT_EQ(stats.per_shard.size(), 2u);
+    EXPECT_EQ(stats.per_shard[0].messages_received, stats.per_shard[1].messages_received);
+
+    manager.stop();
+}
+
+TEST(ConnectionManagerTest, BroadcastSharesOnePayloadAcrossClients) {
+    LocalServer server({});
+    server.start();
+
+    ConnectionManager::Options options;
+    options.threads = 2;
+    ConnectionManager manager(options);
+
+    constexpr int kClients = 8;
+    std::atomic<int> connected{0};
+    std::atomic<int> received{0};
+    std::atomic<int> mismatched{0};
+
+    const std::string bytes(256 * 1024, 'b');
+    std::vector<std::shared_ptr<WebSocketClientPlain>> clients;
+    for (int i = 0; i < kClients; ++i) {
+        auto client = manager.createPlainClient();
+        client->connect(
+            "127.0.0.1",
+            std::to_string(server.port()),
+            "/",
+            [&](std::string_view message, Opcode opcode) {
+                if (message != bytes || opcode != Opcode::binary) {
+                    ++mismatched;
+                }
+                ++received;
+            },
+            [](const std::string& error) { ADD_FAILURE() << error; },
+            [&connected]() { ++connected; }
+        );
+        clients.push_back(client);
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (connected < kClients && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(connected, kClients);
+
+    // A client that is gone no longer counts
+    auto extra = manager.createPlainClient();
+    extra.reset();
+
+    // Nor does one that is not connected and has no reconnect policy
+    auto idle = manager.createPlainClient();
+
+    SharedPayload payload = SharedPayload::binary(bytes);
+    EXPECT_EQ(manager.broadcast(payload), static_cast<std::size_t>(kClients));
+
+    while (received < kClients && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(received, kClients);
+    EXPECT_EQ(mismatched, 0);
+
+    // Every queue has let go of the bytes once they are written
+    while (payload.useCount() > 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(payload.useCount(), 1);
+    EXPECT_EQ(manager.stats().totals.messages_sent, static_cast<std::uint64_t>(kClients));
+
+    manager.stop();
+}
+
+} // namespace test
+} // namespace websocket_client
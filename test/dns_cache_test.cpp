@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "connection_manager.hpp"
+#include "dns_cache.hpp"
+#include "local_server.hpp"
+#include <boost/asio/io_context.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+DnsCache::results_type resolveLoopback() {
+    boost::asio::io_context ioc;
+    boost::asio::ip::tcp::resolver resolver(ioc);
+    return resolver.resolve("127.0.0.1", "9001");
+}
+
+} // namespace
+
+TEST(DnsCacheTest, LookupHitsAfterStore) {
+    DnsCache cache;
+    EXPECT_FALSE(cache.lookup("127.0.0.1", "9001"));
+
+    cache.store("127.0.0.1", "9001", resolveLoopback());
+    const auto results = cache.lookup("127.0.0.1", "9001");
+    ASSERT_TRUE(results);
+    EXPECT_EQ(results->begin()->endpoint().port(), 9001);
+
+    // Keyed by port as well as host
+    EXPECT_FALSE(cache.lookup("127.0.0.1", "9002"));
+
+    const DnsCache::Stats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.entries, 1u);
+}
+
+TEST(DnsCacheTest, EntriesExpireAfterTtl) {
+    DnsCache cache(std::chrono::milliseconds(20));
+    cache.store("127.0.0.1", "9001", resolveLoopback());
+    EXPECT_TRUE(cache.lookup("127.0.0.1", "9001"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_FALSE(cache.lookup("127.0.0.1", "9001"));
+    EXPECT_EQ(cache.stats().entries, 0u);
+}
+
+TEST(DnsCacheTest, InvalidateDropsEntry) {
+    DnsCache cache;
+    cache.store("127.0.0.1", "9001", resolveLoopback());
+    cache.invalidate("127.0.0.1", "9001");
+    EXPECT_FALSE(cache.lookup("127.0.0.1", "9001"));
+}
+
+TEST(DnsCacheTest, ManagerClientsShareLookups) {
+    LocalServer server({});
+    server.start();
+
+    ConnectionManager::Options options;
+    options.threads = 1;
+    ConnectionManager manager(options);
+
+    for (int i = 0; i < 3; ++i) {
+        auto client = manager.createPlainClient();
+        std::atomic<bool> connected{false};
+        client->connect(
+            "127.0.0.1",
+            std::to_string(server.port()),
+            "/",
+            [](std::string_view, Opcode) {},
+            [](const std::string& error) { ADD_FAILURE() << error; },
+            [&connected]() { connected = true; }
+        );
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!connected && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        ASSERT_TRUE(connected);
+
+        const ConnectionStats stats = client->stats();
+        EXPECT_EQ(stats.connects, 1u);
+        EXPECT_GT(stats.connect_time_us, 0u);
+        EXPECT_EQ(stats.max_connect_us, stats.connect_time_us);
+        client->close();
+    }
+
+    const DnsCache::Stats stats = manager.dnsCache()->stats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 2u);
+}
+
+} // namespace test
+} // namespace websocket_client
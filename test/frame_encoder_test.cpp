@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+#include "frame_encoder.hpp"
+#include "keepalive_policy.hpp"
+#include "local_server.hpp"
+#include "test_util.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+std::string randomBytes(std::size_t size, std::mt19937& rng) {
+    std::string bytes(size, '\0');
+    for (char& c : bytes) {
+        c = static_cast<char>(rng());
+    }
+    return bytes;
+}
+
+} // namespace
+
+TEST(MaskKernelTest, EveryKernelMatchesTheDefinition) {
+    std::mt19937 rng(7);
+    const MaskKey key{0x12, 0x9a, 0xff, 0x01};
+
+    // Every size around the vector widths, at every alignment
+    for (MaskKernel kernel : availableMaskKernels()) {
+        for (std::size_t size = 0; size <= 300; ++size) {
+            for (std::size_t offset = 0; offset < 4; ++offset) {
+                const std::string original = randomBytes(size + offset, rng);
+                std::string masked = original;
+                maskInPlace(kernel, masked.data() + offset, size, key);
+
+                std::string expected = original;
+                for (std::size_t i = 0; i < size; ++i) {
+                    expected[offset + i] = static_cast<char>(
+                        static_cast<unsigned char>(expected[offset + i]) ^ key[i % 4]);
+                }
+                ASSERT_EQ(masked, expected)
+                    << maskKernelName(kernel) << " size " << size << " offset " << offset;
+            }
+        }
+    }
+}
+
+TEST(MaskKernelTest, MaskingTwiceRestoresThePayload) {
+    std::mt19937 rng(11);
+    const std::string original = randomBytes(1024 * 1024 + 3, rng);
+    std::string payload = original;
+    const MaskKey key{0xde, 0xad, 0xbe, 0xef};
+
+    maskInPlace(payload.data(), payload.size(), key);
+    EXPECT_NE(payload, original);
+    maskInPlace(payload.data(), payload.size(), key);
+    EXPECT_EQ(payload, original);
+}
+
+TEST(MaskKernelTest, DetectsTheFastestAvailableKernel) {
+    const auto kernels = availableMaskKernels();
+    ASSERT_FALSE(kernels.empty());
+    EXPECT_EQ(kernels.front(), MaskKernel::scalar);
+    EXPECT_EQ(detectMaskKernel(), kernels.back());
+}
+
+TEST(FrameEncoderTest, HeaderUsesTheShortestLengthForm) {
+    const MaskKey key{1, 2, 3, 4};
+
+    const auto tiny = FrameEncoder::header(0x1, true, 125, key);
+    ASSERT_EQ(tiny.size, 6u);
+    EXPECT_EQ(tiny.bytes[0], 0x81);
+    EXPECT_EQ(tiny.bytes[1], 0x80 | 125);
+    EXPECT_EQ(tiny.bytes[2], 1);
+    EXPECT_EQ(tiny.bytes[5], 4);
+
+    const auto medium = FrameEncoder::header(0x2, true, 0xffff, key);
+    ASSERT_EQ(medium.size, 8u);
+    EXPECT_EQ(medium.bytes[0], 0x82);
+    EXPECT_EQ(medium.bytes[1], 0x80 | 126);
+    EXPECT_EQ(medium.bytes[2], 0xff);
+    EXPECT_EQ(medium.bytes[3], 0xff);
+
+    const auto large = FrameEncoder::header(0x0, false, 0x10000, key);
+    ASSERT_EQ(large.size, FrameEncoder::max_header_size);
+    EXPECT_EQ(large.bytes[0], 0x00);
+    EXPECT_EQ(large.bytes[1], 0x80 | 127);
+    EXPECT_EQ(large.bytes[7], 0x01);
+    EXPECT_EQ(large.bytes[8], 0x00);
+    EXPECT_EQ(large.bytes[9], 0x00);
+    EXPECT_EQ(large.bytes[13], 4);
+}
+
+TEST(FrameEncoderTest, EncodeMasksInPlaceUnderTheHeaderKey) {
+    FrameEncoder encoder;
+    const std::string original = "hello, masked world";
+    std::string payload = original;
+
+    const auto header = encoder.encode(false, payload.data(), payload.size());
+    EXPECT_EQ(header.bytes[0], 0x81);
+    EXPECT_EQ(header.bytes[1], 0x80 | original.size());
+
+    maskInPlace(payload.data(), payload.size(), header.key);
+    EXPECT_EQ(payload, original);
+}
+
+TEST(FrameEncoderTest, KeysDoNotRepeat) {
+    // Spans several refills of the encoder's block of random bytes
+    FrameEncoder encoder;
+    std::set<MaskKey> keys;
+    char byte = 0;
+    for (int i = 0; i < 1000; ++i) {
+        keys.insert(encoder.encode(false, &byte, 1).key);
+    }
+    EXPECT_GT(keys.size(), 990u);
+}
+
+class FrameEncoderClientTest : public ClientTest {
+protected:
+    void onMessage(std::string_view message, Opcode opcode) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        echoes_.emplace_back(message);
+        opcodes_.push_back(opcode);
+    }
+
+    // Sizes around each header length form, plus a few large ones
+    std::vector<std::string> payloads() {
+        std::mt19937 rng(3);
+        std::vector<std::string> messages;
+        for (std::size_t size : {0, 1, 125, 126, 65535, 65536, 1024 * 1024, 3 * 1024 * 1024 + 5}) {
+            messages.push_back(randomBytes(size, rng));
+        }
+        return messages;
+    }
+
+    template <class Client>
+    void sendAll(const std::shared_ptr<Client>& client, const std::vector<std::string>& messages) {
+        for (const std::string& message : messages) {
+            client->sendBinary(std::vector<uint8_t>(message.begin(), message.end()));
+        }
+    }
+
+    std::size_t echoCount() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return echoes_.size();
+    }
+
+    std::vector<std::string> echoes() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return echoes_;
+    }
+
+    std::vector<std::string> echoes_;
+    std::vector<Opcode> opcodes_;
+};
+
+TEST_F(FrameEncoderClientTest, PlainClientEchoesEncodedFrames) {
+    LocalServer server({});
+    server.start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setFrameEncoder(true);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    const auto messages = payloads();
+    sendAll(client, messages);
+    client->send("text");
+
+    ASSERT_TRUE(waitFor([&]() { return echoCount() == messages.size() + 1; }));
+    auto expected = messages;
+    expected.push_back("text");
+    EXPECT_EQ(echoes(), expected);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EXPECT_EQ(opcodes_.front(), Opcode::binary);
+        EXPECT_EQ(opcodes_.back(), Opcode::text);
+    }
+    EXPECT_TRUE(errors().empty());
+
+    // One write per message, where Beast would have needed one per 4 KiB
+    const ConnectionStats stats = client->stats();
+    EXPECT_EQ(stats.messages_sent, expected.size());
+    EXPECT_LT(stats.transport_writes, 100u);
+}
+
+TEST_F(FrameEncoderClientTest, PingsDoNotSplitEncodedFrames) {
+    LocalServer server({});
+    server.start();
+
+    KeepalivePolicy keepalive;
+    keepalive.interval = std::chrono::milliseconds(1);
+    keepalive.max_missed = 1000;
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setFrameEncoder(true);
+    client->setKeepalive(keepalive);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    std::mt19937 rng(5);
+    std::vector<std::string> messages;
+    for (int i = 0; i < 20; ++i) {
+        messages.push_back(randomBytes(512 * 1024, rng));
+    }
+    sendAll(client, messages);
+
+    ASSERT_TRUE(waitFor([&]() { return echoCount() == messages.size(); }));
+    EXPECT_EQ(echoes(), messages);
+    EXPECT_GT(client->stats().pings_sent, 0u);
+    EXPECT_TRUE(errors().empty());
+}
+
+TEST_F(FrameEncoderClientTest, CompressedConnectionsFallBackToBeast) {
+    LocalServer::Options options;
+    options.compression.enabled = true;
+    LocalServer server(options);
+    server.start();
+
+    CompressionOptions compression;
+    compression.enabled = true;
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setFrameEncoder(true);
+    client->setCompression(compression);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+    ASSERT_TRUE(client->stats().compression_negotiated);
+
+    const std::string message(64 * 1024, 'z');
+    client->send(message);
+
+    ASSERT_TRUE(waitFor([this]() { return echoCount() == 1; }));
+    EXPECT_EQ(echoes().front(), message);
+    EXPECT_LT(client->stats().wire_bytes_sent, message.size());
+}
+
+TEST_F(FrameEncoderClientTest, SecureClientEchoesEncodedFrames) {
+    LocalServer::Options options;
+    options.secure = true;
+    LocalServer server(options);
+    server.start();
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    client->setFrameEncoder(true);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    const auto messages = payloads();
+    sendAll(client, messages);
+
+    ASSERT_TRUE(waitFor([&]() { return echoCount() == messages.size(); }));
+    EXPECT_EQ(echoes(), messages);
+    EXPECT_TRUE(errors().empty());
+}
+
+} // namespace test
+} // namespace websocket_client
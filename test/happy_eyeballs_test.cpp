@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "happy_eyeballs.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+#include <chrono>
+#include <optional>
+#include <thread>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+using boost::asio::ip::make_address;
+using boost::asio::ip::tcp;
+
+struct Outcome {
+    boost::system::error_code ec;
+    tcp::endpoint endpoint;
+    bool open = false;
+    std::chrono::steady_clock::duration elapsed{};
+};
+
+// With `hold` set, the io_context starts running only after that long, so
+// everything that is done by then completes in one batch
+Outcome race(const std::vector<tcp::endpoint>& endpoints,
+             std::chrono::milliseconds timeout = std::chrono::seconds(30),
+             std::chrono::milliseconds attempt_delay = kConnectionAttemptDelay,
+             std::chrono::milliseconds hold = std::chrono::milliseconds(0)) {
+    boost::asio::io_context ioc;
+    std::optional<Outcome> outcome;
+    const auto start = std::chrono::steady_clock::now();
+
+    asyncConnectHappyEyeballs(
+        boost::asio::make_strand(ioc),
+        endpoints,
+        attempt_delay,
+        timeout,
+        [&](boost::system::error_code ec, tcp::socket socket, tcp::endpoint endpoint) {
+            outcome = Outcome{ec, endpoint, socket.is_open(),
+                std::chrono::steady_clock::now() - start};
+        });
+
+    std::this_thread::sleep_for(hold);
+    ioc.run();
+    EXPECT_TRUE(outcome);
+    return outcome.value_or(Outcome{});
+}
+
+unsigned short closedPort() {
+    boost::asio::io_context ioc;
+    tcp::acceptor acceptor(ioc, tcp::endpoint(make_address("127.0.0.1"), 0));
+    return acceptor.local_endpoint().port();
+}
+
+} // namespace
+
+TEST(HappyEyeballsTest, InterleavesAddressFamilies) {
+    const tcp::endpoint v6a(make_address("::1"), 1);
+    const tcp::endpoint v6b(make_address("fe80::1"), 1);
+    const tcp::endpoint v4a(make_address("127.0.0.1"), 1);
+    const tcp::endpoint v4b(make_address("127.0.0.2"), 1);
+    const tcp::endpoint v4c(make_address("127.0.0.3"), 1);
+
+    EXPECT_EQ(interleaveAddressFamilies({v6a, v6b, v4a, v4b, v4c}),
+        (std::vector<tcp::endpoint>{v6a, v4a, v6b, v4b, v4c}));
+    EXPECT_EQ(interleaveAddressFamilies({v4a, v4b, v6a}),
+        (std::vector<tcp::endpoint>{v4a, v6a, v4b}));
+}
+
+TEST(HappyEyeballsTest, ConnectsPastUnroutableAddress) {
+    boost::asio::io_context server_ioc;
+    tcp::acceptor acceptor(server_ioc, tcp::endpoint(make_address("127.0.0.1"), 0));
+    const unsigned short port = acceptor.local_endpoint().port();
+
+    // TEST-NET-1 is never routed: the attempt either fails at once or hangs
+    // until the next one overtakes it
+    const tcp::endpoint unroutable(make_address("192.0.2.1"), port);
+    const tcp::endpoint loopback(make_address("127.0.0.1"), port);
+
+    const Outcome outcome = race({unroutable, loopback});
+    EXPECT_FALSE(outcome.ec) << outcome.ec.message();
+    EXPECT_TRUE(outcome.open);
+    EXPECT_EQ(outcome.endpoint, loopback);
+    EXPECT_LT(outcome.elapsed, std::chrono::seconds(2));
+}
+
+TEST(HappyEyeballsTest, ReportsLastErrorWhenEveryAttemptFails) {
+    const Outcome outcome = race({
+        tcp::endpoint(make_address("127.0.0.1"), closedPort()),
+        tcp::endpoint(make_address("127.0.0.1"), closedPort()),
+    });
+    EXPECT_EQ(outcome.ec, boost::asio::error::connection_refused);
+    EXPECT_FALSE(outcome.open);
+}
+
+TEST(HappyEyeballsTest, FailureAsTheNextAttemptIsDueStartsItOnce) {
+    boost::asio::io_context server_ioc;
+    tcp::acceptor acceptor(server_ioc, tcp::endpoint(make_address("127.0.0.1"), 0));
+    const tcp::endpoint refused(make_address("127.0.0.1"), closedPort());
+    const tcp::endpoint listening(make_address("127.0.0.1"), acceptor.local_endpoint().port());
+
+    // By the time the race runs, the refusal and the stagger timer are both
+    // done, so the failure starts the second attempt before the timer's
+    // handler gets to it
+    const Outcome outcome = race({refused, listening}, std::chrono::seconds(30),
+        std::chrono::milliseconds(1), std::chrono::milliseconds(50));
+    EXPECT_FALSE(outcome.ec) << outcome.ec.message();
+    EXPECT_TRUE(outcome.open);
+    EXPECT_EQ(outcome.endpoint, listening);
+}
+
+TEST(HappyEyeballsTest, FailsWithoutEndpoints) {
+    const Outcome outcome = race({});
+    EXPECT_EQ(outcome.ec, boost::asio::error::host_not_found);
+}
+
+TEST(HappyEyeballsTest, GivesUpAtTimeout) {
+    const Outcome outcome = race({tcp::endpoint(make_address("192.0.2.1"), 9)},
+        std::chrono::milliseconds(100));
+    EXPECT_TRUE(outcome.ec);
+    EXPECT_LT(outcome.elapsed, std::chrono::seconds(2));
+}
+
+} // namespace test
+} // namespace websocket_client
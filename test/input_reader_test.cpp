@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+#include "input_reader.hpp"
+#include "rate_limiter.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+class TempFile {
+public:
+    explicit TempFile(const std::string& contents) {
+        char path[] = "/tmp/websocket_input_XXXXXX";
+        const int fd = mkstemp(path);
+        EXPECT_GE(fd, 0);
+        close(fd);
+        path_ = path;
+        std::ofstream(path_, std::ios::binary) << contents;
+    }
+
+    ~TempFile() { unlink(path_.c_str()); }
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+struct ReadResult {
+    std::vector<std::string> lines;
+    boost::system::error_code error;
+    bool done = false;
+};
+
+ReadResult readAll(boost::asio::io_context& ioc, const std::shared_ptr<InputReader>& reader) {
+    ReadResult result;
+    reader->start(
+        [&result](std::string_view line) { result.lines.emplace_back(line); },
+        [&result](const boost::system::error_code& ec) {
+            result.error = ec;
+            result.done = true;
+        });
+    ioc.run();
+    return result;
+}
+
+} // namespace
+
+TEST(RateLimiterTest, AllowsBurstThenPaces) {
+    RateLimiter limiter(100.0, 3);
+    const auto now = RateLimiter::Clock::now();
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(limiter.acquire(now), RateLimiter::Clock::duration::zero());
+    }
+
+    // Empty: the next token is 10 ms away
+    const auto wait = limiter.acquire(now);
+    EXPECT_GT(wait, 9ms);
+    EXPECT_LE(wait, 11ms);
+
+    EXPECT_EQ(limiter.acquire(now + 10ms), RateLimiter::Clock::duration::zero());
+    EXPECT_NE(limiter.acquire(now + 10ms), RateLimiter::Clock::duration::zero());
+
+    // A long quiet spell refills no more than the burst
+    const auto later = now + 10s;
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(limiter.acquire(later), RateLimiter::Clock::duration::zero());
+    }
+    EXPECT_NE(limiter.acquire(later), RateLimiter::Clock::duration::zero());
+}
+
+TEST(RateLimiterTest, ZeroRateIsUnlimited) {
+    RateLimiter limiter(0, 1);
+    EXPECT_TRUE(limiter.unlimited());
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(limiter.acquire(), RateLimiter::Clock::duration::zero());
+    }
+}
+
+TEST(InputReaderTest, ReadsEveryLineOfAFile) {
+    TempFile file("first\r\nsecond\n\nlast without newline");
+
+    boost::asio::io_context ioc;
+    InputReader::Options options;
+    options.read_size = 4;  // lines straddle reads
+    auto reader = InputReader::openFile(ioc, file.path(), options);
+    const ReadResult result = readAll(ioc, reader);
+
+    EXPECT_TRUE(result.done);
+    EXPECT_FALSE(result.error);
+    EXPECT_EQ(result.lines,
+        (std::vector<std::string>{"first", "second", "", "last without newline"}));
+    EXPECT_EQ(reader->lines(), 4u);
+}
+
+TEST(InputReaderTest, ReadsFromAPipe) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    std::thread writer([fd = fds[1]]() {
+        for (int i = 0; i < 1000; ++i) {
+            const std::string line = "line " + std::to_string(i) + "\n";
+            EXPECT_EQ(write(fd, line.data(), line.size()), static_cast<ssize_t>(line.size()));
+        }
+        close(fd);
+    });
+
+    boost::asio::io_context ioc;
+    auto reader = InputReader::openFile(ioc, "/proc/self/fd/" + std::to_string(fds[0]), {});
+    close(fds[0]);
+    const ReadResult result = readAll(ioc, reader);
+    writer.join();
+
+    ASSERT_EQ(result.lines.size(), 1000u);
+    EXPECT_EQ(result.lines.front(), "line 0");
+    EXPECT_EQ(result.lines.back(), "line 999");
+}
+
+TEST(InputReaderTest, PacesLinesToTheRate) {
+    std::string contents;
+    for (int i = 0; i < 25; ++i) {
+        contents += "x\n";
+    }
+    TempFile file(contents);
+
+    boost::asio::io_context ioc;
+    InputReader::Options options;
+    options.rate = 400;
+    options.burst = 5;
+    auto reader = InputReader::openFile(ioc, file.path(), options);
+
+    const auto start = std::chrono::steady_clock::now();
+    const ReadResult result = readAll(ioc, reader);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // 5 go out at once, the other 20 at 2.5 ms intervals
+    EXPECT_EQ(result.lines.size(), 25u);
+    EXPECT_GE(elapsed, 45ms);
+}
+
+TEST(InputReaderTest, StopFromHandlerEndsInput) {
+    TempFile file("a\nb\nquit\nc\n");
+
+    boost::asio::io_context ioc;
+    auto reader = InputReader::openFile(ioc, file.path(), {});
+
+    std::vector<std::string> lines;
+    int done_calls = 0;
+    reader->start(
+        [&](std::string_view line) {
+            if (line == "quit") {
+                reader->stop();
+                return;
+            }
+            lines.emplace_back(line);
+        },
+        [&](const boost::system::error_code&) { ++done_calls; });
+    ioc.run();
+
+    EXPECT_EQ(lines, (std::vector<std::string>{"a", "b"}));
+    EXPECT_EQ(done_calls, 1);
+}
+
+TEST(InputReaderTest, PauseHoldsLinesUntilResume) {
+    TempFile file("a\nb\nc\nd\n");
+
+    boost::asio::io_context ioc;
+    auto reader = InputReader::openFile(ioc, file.path(), {});
+
+    std::vector<std::string> lines;
+    bool done = false;
+    reader->start(
+        [&](std::string_view line) {
+            lines.emplace_back(line);
+            if (line == "b") {
+                reader->pause();
+            }
+        },
+        [&](const boost::system::error_code&) { done = true; });
+    ioc.run();
+
+    // Nothing is pending while parked, so run() returns
+    EXPECT_EQ(lines, (std::vector<std::string>{"a", "b"}));
+    EXPECT_FALSE(done);
+
+    ioc.restart();
+    boost::asio::post(ioc, [&reader]() { reader->resume(); });
+    ioc.run();
+
+    EXPECT_EQ(lines, (std::vector<std::string>{"a", "b", "c", "d"}));
+    EXPECT_TRUE(done);
+}
+
+TEST(InputReaderTest, LeavesStdinBlocking) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    const int saved_stdin = dup(STDIN_FILENO);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+
+    const std::string input = "a\nb\n";
+    ASSERT_EQ(write(fds[1], input.data(), input.size()), static_cast<ssize_t>(input.size()));
+    close(fds[1]);
+
+    int flags_while_reading = -1;
+    {
+        boost::asio::io_context ioc;
+        auto reader = InputReader::openStdin(ioc, {});
+        std::vector<std::string> lines;
+        reader->start(
+            [&](std::string_view line) {
+                lines.emplace_back(line);
+                flags_while_reading = fcntl(STDIN_FILENO, F_GETFL);
+            },
+            [](const boost::system::error_code&) {});
+        ioc.run();
+        EXPECT_EQ(lines, (std::vector<std::string>{"a", "b"}));
+    }
+    const int flags_after = fcntl(STDIN_FILENO, F_GETFL);
+    dup2(saved_stdin, STDIN_FILENO);
+    close(saved_stdin);
+
+    ASSERT_GE(flags_while_reading, 0);
+    EXPECT_EQ(flags_while_reading & O_NONBLOCK, 0);
+    EXPECT_EQ(flags_after & O_NONBLOCK, 0);
+}
+
+TEST(InputReaderTest, MissingFileThrows) {
+    boost::asio::io_context ioc;
+    EXPECT_THROW(InputReader::openFile(ioc, "/nonexistent/websocket_input", {}),
+        std::system_error);
+}
+
+} // namespace test
+} // namespace websocket_client
@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+#include "io_backend.hpp"
+#include <boost/asio/detail/config.hpp>
+#include <string>
+
+namespace websocket_client {
+namespace test {
+
+TEST(IoBackendTest, ReportsTheCompiledBackend) {
+#if defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+    EXPECT_EQ(compiledIoBackend(), IoBackend::io_uring);
+#else
+    EXPECT_EQ(compiledIoBackend(), IoBackend::epoll);
+#endif
+    EXPECT_EQ(std::string(ioBackendName(IoBackend::epoll)), "epoll");
+    EXPECT_EQ(std::string(ioBackendName(IoBackend::io_uring)), "io_uring");
+}
+
+TEST(IoBackendTest, FallbackIsNotNeededWhenTheBuildCanRun) {
+    // Returning at all means no exec happened
+    char program[] = "websocket_client_test";
+    char* argv[] = {program, nullptr};
+    execEpollFallbackIfNeeded(argv, "does_not_exist");
+
+    if (compiledIoBackend() == IoBackend::io_uring) {
+        EXPECT_TRUE(kernelSupportsIoUring());
+    }
+}
+
+} // namespace test
+} // namespace websocket_client
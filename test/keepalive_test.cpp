@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include "keepalive_policy.hpp"
+#include "local_server.hpp"
+#include "reconnect_policy.hpp"
+#include "test_util.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/beast/websocket.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+KeepalivePolicy fastKeepalive() {
+    KeepalivePolicy policy;
+    policy.interval = std::chrono::milliseconds(20);
+    policy.max_missed = 2;
+    return policy;
+}
+
+// Completes the WebSocket handshake and then never reads again, so pings
+// go unanswered, like a peer that has hung with its socket still open
+class SilentServer {
+public:
+    SilentServer()
+        : acceptor_(ioc_, {boost::asio::ip::make_address("127.0.0.1"), 0})
+    {
+        accept();
+        thread_ = std::thread([this]() { ioc_.run(); });
+    }
+
+    ~SilentServer() {
+        ioc_.stop();
+        thread_.join();
+    }
+
+    unsigned short port() const { return acceptor_.local_endpoint().port(); }
+    int handshakes() const { return handshakes_; }
+
+private:
+    using stream_type = boost::beast::websocket::stream<boost::asio::ip::tcp::socket>;
+
+    void accept() {
+        acceptor_.async_accept(
+            [this](boost::system::error_code ec, boost::asio::ip::tcp::socket socket) {
+                if (ec) {
+                    return;
+                }
+                auto ws = std::make_shared<stream_type>(std::move(socket));
+                streams_.push_back(ws);
+                ws->async_accept([this](boost::system::error_code ec) {
+                    if (!ec) {
+                        ++handshakes_;
+                    }
+                });
+                accept();
+            });
+    }
+
+    boost::asio::io_context ioc_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    std::vector<std::shared_ptr<stream_type>> streams_;
+    std::atomic<int> handshakes_{0};
+    std::thread thread_;
+};
+
+} // namespace
+
+class KeepaliveTest : public ClientTest {};
+
+TEST_F(KeepaliveTest, PlainClientTimesPongs) {
+    LocalServer server({});
+    server.start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setKeepalive(fastKeepalive());
+    connect(*client, server.port());
+    runIoContext();
+
+    ASSERT_TRUE(waitFor([&client]() { return client->stats().pongs_received >= 3; }));
+
+    const LatencyHistogram rtt = client->pingRtt();
+    EXPECT_GE(rtt.count(), 3u);
+    EXPECT_GT(rtt.max(), 0u);
+    EXPECT_LT(rtt.max(), 1000000000u);
+    EXPECT_GE(client->stats().pings_sent, client->stats().pongs_received);
+    EXPECT_TRUE(errors().empty());
+}
+
+TEST_F(KeepaliveTest, SecureClientTimesPongs) {
+    LocalServer::Options options;
+    options.secure = true;
+    LocalServer server(options);
+    server.start();
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    client->setKeepalive(fastKeepalive());
+    connect(*client, server.port());
+    runIoContext();
+
+    ASSERT_TRUE(waitFor([&client]() { return client->stats().pongs_received >= 3; }));
+    EXPECT_GE(client->pingRtt().count(), 3u);
+    EXPECT_TRUE(errors().empty());
+}
+
+TEST_F(KeepaliveTest, NoPingsWhenDisabled) {
+    LocalServer server({});
+    server.start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    connect(*client, server.port());
+    runIoContext();
+
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(client->stats().pings_sent, 0u);
+    EXPECT_EQ(client->pingRtt().count(), 0u);
+}
+
+TEST_F(KeepaliveTest, PlainClientFailsOnSilentPeer) {
+    SilentServer server;
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setKeepalive(fastKeepalive());
+    connect(*client, server.port());
+    runIoContext();
+
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+    const auto connected = std::chrono::steady_clock::now();
+    ASSERT_TRUE(waitFor([this]() { return !errors().empty(); }));
+    const auto noticed = std::chrono::steady_clock::now() - connected;
+
+    // Two missed pings at 20 ms, well before any stream timeout
+    EXPECT_LT(noticed, std::chrono::seconds(1));
+    EXPECT_NE(errors().front().find("keepalive"), std::string::npos);
+    EXPECT_EQ(client->stats().pongs_received, 0u);
+    EXPECT_EQ(client->stats().missed_pongs, 2u);
+
+    // The read torn down with the connection is not reported again
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(errors().size(), 1u);
+}
+
+TEST_F(KeepaliveTest, ReconnectsAfterSilentPeer) {
+    SilentServer server;
+
+    ReconnectPolicy reconnect;
+    reconnect.enabled = true;
+    reconnect.initial_delay = std::chrono::milliseconds(10);
+    reconnect.max_delay = std::chrono::milliseconds(50);
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setKeepalive(fastKeepalive());
+    client->setReconnectPolicy(reconnect);
+    connect(*client, server.port());
+    runIoContext();
+
+    // Each new connection goes silent too and is dropped in turn
+    ASSERT_TRUE(waitFor([this]() { return connects_ >= 3; }));
+    EXPECT_GE(client->stats().reconnects, 2u);
+    EXPECT_GE(server.handshakes(), 3);
+    for (const auto& error : errors()) {
+        EXPECT_NE(error.find("keepalive"), std::string::npos) << error;
+    }
+}
+
+} // namespace test
+} // namespace websocket_client
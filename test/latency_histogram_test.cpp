@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "latency_histogram.hpp"
+
+namespace websocket_client {
+namespace test {
+
+TEST(LatencyHistogramTest, EmptyHistogramReportsZero) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.min(), 0u);
+    EXPECT_EQ(histogram.max(), 0u);
+    EXPECT_EQ(histogram.percentile(99.0), 0u);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+    LatencyHistogram histogram;
+    for (std::uint64_t v = 1; v <= 100; ++v) {
+        histogram.record(v);
+    }
+
+    EXPECT_EQ(histogram.count(), 100u);
+    EXPECT_EQ(histogram.min(), 1u);
+    EXPECT_EQ(histogram.max(), 100u);
+    EXPECT_EQ(histogram.percentile(50.0), 50u);
+    EXPECT_EQ(histogram.percentile(99.0), 99u);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 50.5);
+}
+
+TEST(LatencyHistogramTest, LargeValuesStayWithinRelativeError) {
+    LatencyHistogram histogram;
+    for (std::uint64_t v = 1; v <= 100000; ++v) {
+        histogram.record(v * 1000);
+    }
+
+    const double tolerance = 1.0 / 64;
+    for (double p : {50.0, 90.0, 99.0, 99.9}) {
+        const double expected = p / 100.0 * 100000 * 1000;
+        const double actual = static_cast<double>(histogram.percentile(p));
+        EXPECT_NEAR(actual, expected, expected * tolerance) << "p" << p;
+    }
+    EXPECT_EQ(histogram.percentile(100.0), 100000u * 1000);
+}
+
+TEST(LatencyHistogramTest, MergeCombinesCounts) {
+    LatencyHistogram a;
+    LatencyHistogram b;
+    a.record(10);
+    b.record(1000000);
+
+    a.merge(b);
+    EXPECT_EQ(a.count(), 2u);
+    EXPECT_EQ(a.min(), 10u);
+    EXPECT_EQ(a.max(), 1000000u);
+
+    a.reset();
+    EXPECT_EQ(a.count(), 0u);
+}
+
+TEST(AtomicLatencyHistogramTest, SnapshotMatchesPlainHistogram) {
+    AtomicLatencyHistogram atomic;
+    LatencyHistogram plain;
+    EXPECT_EQ(atomic.snapshot().count(), 0u);
+    EXPECT_EQ(atomic.snapshot().min(), 0u);
+
+    for (std::uint64_t v = 1; v <= 50000; v += 7) {
+        atomic.record(v * 13);
+        plain.record(v * 13);
+    }
+
+    const LatencyHistogram snapshot = atomic.snapshot();
+    EXPECT_EQ(snapshot.count(), plain.count());
+    EXPECT_EQ(snapshot.min(), plain.min());
+    EXPECT_EQ(snapshot.max(), plain.max());
+    EXPECT_DOUBLE_EQ(snapshot.mean(), plain.mean());
+    for (double p : {0.0, 50.0, 99.0, 99.9, 100.0}) {
+        EXPECT_EQ(snapshot.percentile(p), plain.percentile(p)) << "p" << p;
+    }
+}
+
+} // namespace test
+} // namespace websocket_client
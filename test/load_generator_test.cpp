@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "connection_manager.hpp"
+#include "load_generator.hpp"
+#include "local_server.hpp"
+#include "test_util.hpp"
+#include <chrono>
+#include <thread>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+// With `echoed` set, waits for every message sent to come back before
+// reading the counters
+LoadGenerator::Snapshot runFor(LoadGenerator& generator, std::chrono::milliseconds duration,
+                               bool echoed = true) {
+    std::this_thread::sleep_for(duration);
+    generator.stop();
+    if (echoed) {
+        EXPECT_TRUE(waitFor([&generator]() {
+            const auto snapshot = generator.takeSnapshot();
+            return snapshot.totals.messages_received == snapshot.totals.messages_sent;
+        }));
+    }
+    // Each snapshot drains the RTTs recorded since the one before; the
+    // generator keeps the running total
+    auto snapshot = generator.takeSnapshot();
+    snapshot.rtt = generator.totalRtt();
+    return snapshot;
+}
+
+} // namespace
+
+TEST(LoadGeneratorTest, SendsAtTheConfiguredRateAndTimesEchoes) {
+    LocalServer server({});
+    server.start();
+
+    ConnectionManager::Options manager_options;
+    manager_options.threads = 2;
+    ConnectionManager manager(manager_options);
+
+    LoadOptions options;
+    options.connections = 4;
+    options.rate = 200;
+    options.payload_size = 100;
+    options.measure_rtt = true;
+    LoadGenerator generator(manager, options);
+    generator.start("127.0.0.1", std::to_string(server.port()), "/");
+
+    const auto snapshot = runFor(generator, std::chrono::milliseconds(500));
+
+    // 4 connections x 200/s x ~0.5 s, give or take connect time and ticks
+    EXPECT_EQ(snapshot.connected, 4u);
+    EXPECT_EQ(snapshot.errors, 0u);
+    EXPECT_GE(snapshot.totals.messages_sent, 250u);
+    EXPECT_LE(snapshot.totals.messages_sent, 420u);
+    EXPECT_EQ(snapshot.totals.payload_bytes_sent, snapshot.totals.messages_sent * 100);
+    EXPECT_EQ(snapshot.totals.messages_received, snapshot.totals.messages_sent);
+
+    // Every echo was matched and timed
+    EXPECT_EQ(snapshot.rtt.count(), snapshot.totals.messages_received);
+    EXPECT_GT(snapshot.rtt.percentile(50.0), 0u);
+    EXPECT_EQ(generator.totalRtt().count(), snapshot.rtt.count());
+
+    manager.stop();
+}
+
+TEST(LoadGeneratorTest, BinaryPayloadGrowsToHoldTheTimestamp) {
+    LocalServer::Options server_options;
+    server_options.mode = LocalServer::Mode::sink;
+    LocalServer server(server_options);
+    server.start();
+
+    ConnectionManager::Options manager_options;
+    manager_options.threads = 1;
+    ConnectionManager manager(manager_options);
+
+    LoadOptions options;
+    options.connections = 2;
+    options.rate = 100;
+    options.payload_size = 10;
+    options.pattern = PayloadPattern::binary;
+    options.measure_rtt = true;  // grows the payload to fit the stamp
+    LoadGenerator generator(manager, options);
+    generator.start("127.0.0.1", std::to_string(server.port()), "/");
+
+    const auto snapshot = runFor(generator, std::chrono::milliseconds(300), false);
+
+    EXPECT_GT(snapshot.totals.messages_sent, 0u);
+    EXPECT_EQ(snapshot.totals.payload_bytes_sent,
+        snapshot.totals.messages_sent * LoadGenerator::kTimestampSize);
+    EXPECT_EQ(server.stats().bytes_received, snapshot.totals.payload_bytes_sent);
+
+    // Nothing echoes in sink mode, so there is nothing to time
+    EXPECT_EQ(snapshot.rtt.count(), 0u);
+
+    manager.stop();
+}
+
+} // namespace test
+} // namespace websocket_client
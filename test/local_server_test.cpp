@@ -0,0 +1,268 @@
+#include <gtest/gtest.h>
+#include "local_server.hpp"
+#include "test_util.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+struct Received {
+    std::string payload;
+    Opcode opcode;
+};
+
+} // namespace
+
+class LocalServerTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        ioc_.stop();
+        if (ioc_thread_.joinable()) {
+            ioc_thread_.join();
+        }
+    }
+
+    void runIoContext() {
+        ioc_thread_ = std::thread([this]() {
+            ioc_.run();
+        });
+    }
+
+    std::shared_ptr<WebSocketClientPlain> connectPlain(LocalServer& server) {
+        auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+        client->connect(
+            "127.0.0.1",
+            std::to_string(server.port()),
+            "/",
+            [this](std::string_view msg, Opcode opcode) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                received_.push_back({std::string(msg), opcode});
+            },
+            [this](const std::string& error) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                errors_.push_back(error);
+            },
+            [this]() {
+                connected_ = true;
+            }
+        );
+        runIoContext();
+        EXPECT_TRUE(waitFor([this]() { return connected_.load(); }));
+        return client;
+    }
+
+    std::size_t receivedCount() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return received_.size();
+    }
+
+    boost::asio::io_context ioc_;
+    std::thread ioc_thread_;
+    std::mutex mutex_;
+    std::vector<Received> received_;
+    std::vector<std::string> errors_;
+    std::atomic<bool> connected_{false};
+};
+
+TEST_F(LocalServerTest, PlainClientEchoesTextAndBinaryInOrder) {
+    LocalServer server({});
+    server.start();
+
+    auto client = connectPlain(server);
+    client->send("hello");
+    client->sendBinary({0x00, 0x01, 0xFF});
+    client->send("world");
+
+    ASSERT_TRUE(waitFor([this]() { return receivedCount() == 3; }));
+    EXPECT_EQ(received_[0].payload, "hello");
+    EXPECT_EQ(received_[0].opcode, Opcode::text);
+    EXPECT_EQ(received_[1].payload, std::string("\x00\x01\xFF", 3));
+    EXPECT_EQ(received_[1].opcode, Opcode::binary);
+    EXPECT_EQ(received_[2].payload, "world");
+    EXPECT_EQ(received_[2].opcode, Opcode::text);
+    EXPECT_TRUE(errors_.empty());
+}
+
+TEST_F(LocalServerTest, ConcurrentSendersKeepPerThreadOrder) {
+    LocalServer server({});
+    server.start();
+
+    auto client = connectPlain(server);
+
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 250;
+    std::vector<std::thread> senders;
+    for (int t = 0; t < kThreads; ++t) {
+        senders.emplace_back([client, t]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                client->send(std::to_string(t) + ":" + std::to_string(i));
+            }
+        });
+    }
+    for (auto& s : senders) {
+        s.join();
+    }
+
+    ASSERT_TRUE(waitFor([this]() { return receivedCount() == kThreads * kPerThread; }));
+
+    std::vector<int> next(kThreads, 0);
+    for (const auto& msg : received_) {
+        const auto colon = msg.payload.find(':');
+        const int t = std::stoi(msg.payload.substr(0, colon));
+        const int i = std::stoi(msg.payload.substr(colon + 1));
+        EXPECT_EQ(i, next[t]);
+        next[t] = i + 1;
+    }
+    EXPECT_TRUE(errors_.empty());
+}
+
+TEST_F(LocalServerTest, SecureClientEchoesOverSelfSignedTls) {
+    LocalServer::Options options;
+    options.secure = true;
+    LocalServer server(options);
+    server.start();
+
+    boost::asio::ssl::context ssl_ctx{boost::asio::ssl::context::tlsv12_client};
+    ssl_ctx.set_verify_mode(boost::asio::ssl::verify_none);
+
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx);
+    client->connect(
+        "127.0.0.1",
+        std::to_string(server.port()),
+        "/",
+        [this](const std::string& msg) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            received_.push_back({msg, Opcode::text});
+        },
+        [this](const std::string& error) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            errors_.push_back(error);
+        },
+        [this]() {
+            connected_ = true;
+        }
+    );
+    runIoContext();
+
+    ASSERT_TRUE(waitFor([this]() { return connected_.load(); }));
+    client->send("over tls");
+
+    ASSERT_TRUE(waitFor([this]() { return receivedCount() == 1; }));
+    EXPECT_EQ(received_[0].payload, "over tls");
+    EXPECT_TRUE(errors_.empty());
+}
+
+TEST_F(LocalServerTest, SecureClientWithoutMessageHandlerKeepsReading) {
+    LocalServer::Options options;
+    options.secure = true;
+    LocalServer server(options);
+    server.start();
+
+    boost::asio::ssl::context ssl_ctx{boost::asio::ssl::context::tlsv12_client};
+    ssl_ctx.set_verify_mode(boost::asio::ssl::verify_none);
+
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx);
+    client->connect(
+        "127.0.0.1",
+        std::to_string(server.port()),
+        "/",
+        WebSocketClient::MessageHandler(),
+        [this](const std::string& error) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            errors_.push_back(error);
+        },
+        [this]() {
+            connected_ = true;
+        }
+    );
+    runIoContext();
+
+    ASSERT_TRUE(waitFor([this]() { return connected_.load(); }));
+    client->send("one");
+    client->send("two");
+
+    ASSERT_TRUE(waitFor([&client]() { return client->stats().messages_received == 2; }));
+    EXPECT_TRUE(errors_.empty());
+}
+
+TEST_F(LocalServerTest, FloodModeSendsRequestedCount) {
+    LocalServer::Options options;
+    options.mode = LocalServer::Mode::flood;
+    options.flood_count = 500;
+    options.flood_message_size = 128;
+    LocalServer server(options);
+    server.start();
+
+    auto client = connectPlain(server);
+
+    ASSERT_TRUE(waitFor([this]() { return receivedCount() == 500; }));
+    EXPECT_EQ(received_.back().payload.size(), 128u);
+    EXPECT_EQ(client->stats().messages_received, 500u);
+}
+
+TEST_F(LocalServerTest, SinkModeCountsWithoutReplying) {
+    LocalServer::Options options;
+    options.mode = LocalServer::Mode::sink;
+    LocalServer server(options);
+    server.start();
+
+    auto client = connectPlain(server);
+    for (int i = 0; i < 10; ++i) {
+        client->send("discard me");
+    }
+
+    ASSERT_TRUE(waitFor([&server]() { return server.stats().messages_received == 10; }));
+    EXPECT_EQ(server.stats().messages_sent, 0u);
+    EXPECT_EQ(receivedCount(), 0u);
+}
+
+TEST_F(LocalServerTest, CompressionShrinksWireBytes) {
+    LocalServer::Options options;
+    options.compression.enabled = true;
+    LocalServer server(options);
+    server.start();
+
+    CompressionOptions compression;
+    compression.enabled = true;
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setCompression(compression);
+    client->connect(
+        "127.0.0.1",
+        std::to_string(server.port()),
+        "/",
+        [this](std::string_view msg, Opcode opcode) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            received_.push_back({std::string(msg), opcode});
+        },
+        [](const std::string&) {},
+        [this]() {
+            connected_ = true;
+        }
+    );
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connected_.load(); }));
+
+    const std::string payload(64 * 1024, 'a');
+    client->send(payload);
+    ASSERT_TRUE(waitFor([this]() { return receivedCount() == 1; }));
+    EXPECT_EQ(received_[0].payload, payload);
+
+    const ConnectionStats stats = client->stats();
+    EXPECT_TRUE(stats.compression_negotiated);
+    EXPECT_EQ(stats.payload_bytes_sent, payload.size());
+    EXPECT_LT(stats.wire_bytes_sent, payload.size() / 10);
+    EXPECT_LT(stats.wire_bytes_received, payload.size() / 10);
+}
+
+} // namespace test
+} // namespace websocket_client
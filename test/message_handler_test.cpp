@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "message_handler.hpp"
+#include "topic_router.hpp"
+#include <memory>
+#include <vector>
 
 namespace websocket_client {
 namespace test {
@@ -16,6 +19,49 @@ TEST(MessageHandlerTest, HandleMessage) {
     EXPECT_EQ(received_message, "test message");
 }
 
+TEST(MessageHandlerTest, ViewCallbackSeesCallerBuffer) {
+    MessageHandler handler;
+    const std::string buffer = "in-place message";
+    const char* seen = nullptr;
+    std::size_t seen_size = 0;
+
+    handler.setMessageViewCallback([&](std::string_view msg) {
+        seen = msg.data();
+        seen_size = msg.size();
+    });
+
+    handler.handleMessage(buffer);
+    EXPECT_EQ(seen, buffer.data());
+    EXPECT_EQ(seen_size, buffer.size());
+}
+
+TEST(MessageHandlerTest, RoutedMessagesSkipTheCallback) {
+    MessageHandler handler;
+    std::vector<std::string> unrouted;
+    std::vector<std::string> routed;
+
+    handler.setMessageCallback([&unrouted](const std::string& msg) {
+        unrouted.push_back(msg);
+    });
+
+    auto router = std::make_shared<TopicRouter>(TopicKey::jsonPath("channel"));
+    router->subscribe("trades", [&routed](std::string_view, std::string_view msg) {
+        routed.emplace_back(msg);
+    });
+    handler.setTopicRouter(router);
+
+    handler.handleMessage(R"({"channel":"trades","px":1})");
+    handler.handleMessage(R"({"channel":"book"})");
+    handler.handleMessage("plain text");
+    EXPECT_EQ(routed, std::vector<std::string>{R"({"channel":"trades","px":1})"});
+    EXPECT_EQ(unrouted, (std::vector<std::string>{R"({"channel":"book"})", "plain text"}));
+
+    handler.setTopicRouter(nullptr);
+    handler.handleMessage(R"({"channel":"trades"})");
+    EXPECT_EQ(routed.size(), 1u);
+    EXPECT_EQ(unrouted.size(), 3u);
+}
+
 TEST(MessageHandlerTest, FormatMessage) {
     MessageHandler handler;
     std::string formatted = handler.formatMessage("test message");
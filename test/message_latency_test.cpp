@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include "connection_manager.hpp"
+#include "local_server.hpp"
+#include "message_latency.hpp"
+#include "test_util.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+constexpr auto kHandlerTime = std::chrono::milliseconds(2);
+
+} // namespace
+
+class MessageLatencyTest : public ClientTest {
+protected:
+    // Each echo spends kHandlerTime in the handler
+    void onMessage(std::string_view, Opcode) override {
+        std::this_thread::sleep_for(kHandlerTime);
+        ++echoes_;
+    }
+
+    std::atomic<int> echoes_{0};
+};
+
+TEST_F(MessageLatencyTest, RecordsEveryStageOfEachMessage) {
+    LocalServer server({});
+    server.start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setLatencyTracking(true);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    // One at a time, so no echo arrives in a read behind another and
+    // waits out its handler
+    constexpr int kMessages = 20;
+    for (int i = 0; i < kMessages; ++i) {
+        client->send("message " + std::to_string(i));
+        ASSERT_TRUE(waitFor([this, i]() { return echoes_ == i + 1; }));
+    }
+    EXPECT_TRUE(errors().empty());
+
+    const MessageLatency latency = client->latency();
+    EXPECT_EQ(latency.delivery.count(), static_cast<std::uint64_t>(kMessages));
+    EXPECT_EQ(latency.handler.count(), static_cast<std::uint64_t>(kMessages));
+    EXPECT_EQ(latency.queue_wait.count(), static_cast<std::uint64_t>(kMessages));
+    EXPECT_EQ(latency.write.count(), static_cast<std::uint64_t>(kMessages));
+
+    // Handler time is what the handler spent, not what came before it
+    const auto handler_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(kHandlerTime).count());
+    EXPECT_GE(latency.handler.min(), handler_ns);
+    EXPECT_LT(latency.delivery.percentile(50.0), handler_ns);
+
+    // Even an idle client takes a moment to pick a message up
+    EXPECT_GT(latency.queue_wait.max(), 0u);
+    EXPECT_GT(latency.write.min(), 0u);
+}
+
+TEST_F(MessageLatencyTest, OffUnlessEnabled) {
+    LocalServer server({});
+    server.start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    client->send("hello");
+    ASSERT_TRUE(waitFor([this]() { return echoes_ == 1; }));
+
+    const MessageLatency latency = client->latency();
+    EXPECT_EQ(latency.delivery.count(), 0u);
+    EXPECT_EQ(latency.handler.count(), 0u);
+    EXPECT_EQ(latency.queue_wait.count(), 0u);
+    EXPECT_EQ(latency.write.count(), 0u);
+}
+
+TEST_F(MessageLatencyTest, SecureClientRecordsEveryStage) {
+    LocalServer::Options options;
+    options.secure = true;
+    LocalServer server(options);
+    server.start();
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    client->setLatencyTracking(true);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    constexpr int kMessages = 5;
+    for (int i = 0; i < kMessages; ++i) {
+        client->send(std::string(1000, 'x'));
+    }
+    ASSERT_TRUE(waitFor([this]() { return echoes_ == kMessages; }));
+    EXPECT_TRUE(errors().empty());
+
+    const MessageLatency latency = client->latency();
+    EXPECT_EQ(latency.delivery.count(), static_cast<std::uint64_t>(kMessages));
+    EXPECT_EQ(latency.handler.count(), static_cast<std::uint64_t>(kMessages));
+    EXPECT_EQ(latency.queue_wait.count(), static_cast<std::uint64_t>(kMessages));
+    EXPECT_EQ(latency.write.count(), static_cast<std::uint64_t>(kMessages));
+}
+
+TEST(MessageLatencyManagerTest, MergesClientsThatTrackLatency) {
+    LocalServer server({});
+    server.start();
+
+    ConnectionManager::Options options;
+    options.threads = 2;
+    ConnectionManager manager(options);
+
+    std::atomic<int> connected{0};
+    std::atomic<int> received{0};
+    std::vector<std::shared_ptr<WebSocketClientPlain>> clients;
+    for (int i = 0; i < 3; ++i) {
+        auto client = manager.createPlainClient();
+        client->setLatencyTracking(i != 0);
+        client->connect(
+            "127.0.0.1",
+            std::to_string(server.port()),
+            "/",
+            [&received](std::string_view, Opcode) { ++received; },
+            [](const std::string& error) { ADD_FAILURE() << error; },
+            [&connected]() { ++connected; }
+        );
+        clients.push_back(client);
+    }
+    ASSERT_TRUE(waitFor([&]() { return connected == 3; }));
+
+    for (const auto& client : clients) {
+        client->send("a");
+        client->send("b");
+    }
+    ASSERT_TRUE(waitFor([&]() { return received == 6; }));
+
+    const MessageLatency merged = manager.latency();
+    EXPECT_EQ(merged.delivery.count(), 4u);
+    EXPECT_EQ(merged.write.count(), 4u);
+
+    manager.stop();
+}
+
+} // namespace test
+} // namespace websocket_client
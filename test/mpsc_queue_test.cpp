@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "mpsc_queue.hpp"
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+TEST(MpscQueueTest, PopsInPushOrder) {
+    MpscQueue<std::string> queue;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop());
+
+    queue.push("first");
+    queue.push("second");
+    EXPECT_FALSE(queue.empty());
+
+    EXPECT_EQ(*queue.pop(), "first");
+    EXPECT_EQ(*queue.pop(), "second");
+    EXPECT_FALSE(queue.pop());
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpscQueueTest, ConcurrentProducersKeepPerProducerOrder) {
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 20000;
+
+    MpscQueue<std::pair<int, int>> queue;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < kPerProducer; ++i) {
+                queue.push({p, i});
+            }
+        });
+    }
+
+    std::vector<int> next(kProducers, 0);
+    int received = 0;
+    while (received < kProducers * kPerProducer) {
+        auto item = queue.pop();
+        if (!item) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(item->second, next[item->first]);
+        ++next[item->first];
+        ++received;
+    }
+
+    for (auto& t : producers) {
+        t.join();
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpscQueueTest, DestructorReleasesPendingItems) {
+    auto tracked = std::make_shared<int>(42);
+    {
+        MpscQueue<std::shared_ptr<int>> queue;
+        queue.push(tracked);
+        queue.push(tracked);
+        EXPECT_EQ(tracked.use_count(), 3);
+    }
+    EXPECT_EQ(tracked.use_count(), 1);
+}
+
+} // namespace test
+} // namespace websocket_client
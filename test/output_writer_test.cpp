@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include "message_handler.hpp"
+#include "output_writer.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+class TempPath {
+public:
+    TempPath() {
+        char path[] = "/tmp/websocket_output_XXXXXX";
+        const int fd = mkstemp(path);
+        EXPECT_GE(fd, 0);
+        close(fd);
+        path_ = path;
+    }
+
+    ~TempPath() { unlink(path_.c_str()); }
+
+    const std::string& path() const { return path_; }
+
+    std::string contents() const {
+        std::ifstream in(path_, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+private:
+    std::string path_;
+};
+
+} // namespace
+
+TEST(OutputWriterTest, BatchesLinesIntoFewWrites) {
+    TempPath file;
+    std::string expected;
+    {
+        OutputWriter::Options options;
+        options.flush_interval = std::chrono::seconds(10);
+        auto output = OutputWriter::openFile(file.path(), options);
+
+        for (int i = 0; i < 10000; ++i) {
+            const std::string message = "message " + std::to_string(i);
+            ASSERT_TRUE(output->write("Received: ", message));
+            expected += "Received: " + message + "\n";
+        }
+        output->flush();
+
+        EXPECT_EQ(file.contents(), expected);
+        const auto stats = output->stats();
+        EXPECT_EQ(stats.lines, 10000u);
+        EXPECT_EQ(stats.bytes_written, expected.size());
+        EXPECT_LT(stats.writes, 100u);
+    }
+    EXPECT_EQ(file.contents(), expected);
+}
+
+TEST(OutputWriterTest, FlushesAfterTheIntervalWithoutBeingAsked) {
+    TempPath file;
+    OutputWriter::Options options;
+    options.flush_interval = std::chrono::milliseconds(20);
+    auto output = OutputWriter::openFile(file.path(), options);
+
+    output->write("", "hello");
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (file.contents().empty() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(file.contents(), "hello\n");
+}
+
+TEST(OutputWriterTest, DropsLinesWhileTheOutputIsStuck) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    const int saved_stdout = dup(STDOUT_FILENO);
+    dup2(fds[1], STDOUT_FILENO);
+    close(fds[1]);
+
+    OutputWriter::Options options;
+    options.buffer_size = 4096;
+    options.flush_size = 1024;
+    options.block_when_full = false;
+    auto output = OutputWriter::openStdout(options);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    // Nobody reads the pipe, so the writer thread blocks once it is full
+    // and write() has to drop instead of waiting
+    const std::string line(100, 'x');
+    const auto start = std::chrono::steady_clock::now();
+    std::uint64_t accepted = 0;
+    for (int i = 0; i < 10000; ++i) {
+        accepted += output->write("", line) ? 1 : 0;
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    EXPECT_GT(output->stats().dropped, 0u);
+    EXPECT_EQ(output->stats().lines, accepted);
+
+    // Drain the pipe so the buffered lines can go out and the writer stops
+    std::thread reader([fd = fds[0]]() {
+        char sink[65536];
+        while (read(fd, sink, sizeof(sink)) > 0) {
+        }
+    });
+    output.reset();
+    reader.join();
+    close(fds[0]);
+}
+
+TEST(OutputWriterTest, WaitsForRoomByDefault) {
+    TempPath file;
+    std::string expected;
+    {
+        OutputWriter::Options options;
+        options.buffer_size = 4096;
+        options.flush_size = 1024;
+        auto output = OutputWriter::openFile(file.path(), options);
+
+        // Lines longer than the ring go through it in pieces
+        const std::string lines[] = {"short", std::string(10000, 'x'), "after", std::string(4095, 'y')};
+        for (int i = 0; i < 200; ++i) {
+            for (const std::string& line : lines) {
+                ASSERT_TRUE(output->write("", line));
+                expected += line + "\n";
+            }
+        }
+        output->flush();
+        EXPECT_EQ(output->stats().dropped, 0u);
+        EXPECT_EQ(output->stats().lines, 800u);
+    }
+    EXPECT_EQ(file.contents(), expected);
+}
+
+TEST(OutputWriterTest, WaitsOutANonBlockingOutput) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK), 0);
+    const int saved_stdout = dup(STDOUT_FILENO);
+    dup2(fds[1], STDOUT_FILENO);
+    close(fds[1]);
+
+    OutputWriter::Options options;
+    options.buffer_size = 4096;
+    options.flush_size = 1024;
+    auto output = OutputWriter::openStdout(options);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    // The reader falls behind, so the pipe fills and write(2) says EAGAIN
+    std::string received;
+    std::thread reader([&received, fd = fds[0]]() {
+        char chunk[4096];
+        ssize_t n;
+        while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+            received.append(chunk, static_cast<std::size_t>(n));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    std::string expected;
+    const std::string line(100, 'x');
+    int accepted = 0;
+    for (int i = 0; i < 5000; ++i) {
+        accepted += output->write("", line) ? 1 : 0;
+        expected += line + "\n";
+    }
+    output->flush();
+    EXPECT_EQ(accepted, 5000);
+    EXPECT_EQ(output->stats().dropped, 0u);
+    EXPECT_EQ(output->stats().bytes_written, expected.size());
+
+    output.reset();
+    reader.join();
+    close(fds[0]);
+    EXPECT_EQ(received, expected);
+}
+
+TEST(OutputWriterTest, MessageHandlerPrintsThroughTheWriter) {
+    TempPath file;
+    {
+        MessageHandler handler(OutputWriter::openFile(file.path(), {}));
+        handler.handleMessage("first");
+        handler.handleMessage("second");
+    }
+    EXPECT_EQ(file.contents(), "Received: first\nReceived: second\n");
+
+    // A null output discards messages
+    MessageHandler silent(nullptr);
+    silent.handleMessage("ignored");
+}
+
+} // namespace test
+} // namespace websocket_client
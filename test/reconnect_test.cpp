@@ -0,0 +1,369 @@
+#include <gtest/gtest.h>
+#include "local_server.hpp"
+#include "reconnect_policy.hpp"
+#include "test_util.hpp"
+#include "tls_session_cache.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/asio/ssl/stream.hpp>
+#include <boost/beast/websocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+ReconnectPolicy fastPolicy() {
+    ReconnectPolicy policy;
+    policy.enabled = true;
+    policy.initial_delay = std::chrono::milliseconds(10);
+    policy.max_delay = std::chrono::milliseconds(50);
+    return policy;
+}
+
+// Completes the handshake and then closes each connection from its side
+// with going_away, like a server that is shutting down cleanly
+template <bool Secure>
+class ClosingServer {
+public:
+    ClosingServer()
+        : acceptor_(ioc_, {boost::asio::ip::make_address("127.0.0.1"), 0})
+    {
+        accept();
+        thread_ = std::thread([this]() { ioc_.run(); });
+    }
+
+    ~ClosingServer() {
+        ioc_.stop();
+        thread_.join();
+    }
+
+    unsigned short port() const { return acceptor_.local_endpoint().port(); }
+
+private:
+    using socket_type = std::conditional_t<Secure,
+        boost::asio::ssl::stream<boost::asio::ip::tcp::socket>,
+        boost::asio::ip::tcp::socket>;
+    using stream_type = boost::beast::websocket::stream<socket_type>;
+
+    void accept() {
+        acceptor_.async_accept(
+            [this](boost::system::error_code ec, boost::asio::ip::tcp::socket socket) {
+                if (ec) {
+                    return;
+                }
+                std::shared_ptr<stream_type> ws;
+                if constexpr (Secure) {
+                    ws = std::make_shared<stream_type>(std::move(socket), ssl_ctx_);
+                    ws->next_layer().async_handshake(
+                        boost::asio::ssl::stream_base::server,
+                        [this, ws](boost::system::error_code ec) {
+                            if (!ec) {
+                                handshake(ws);
+                            }
+                        });
+                } else {
+                    ws = std::make_shared<stream_type>(std::move(socket));
+                    handshake(ws);
+                }
+                streams_.push_back(ws);
+                accept();
+            });
+    }
+
+    void handshake(const std::shared_ptr<stream_type>& ws) {
+        ws->async_accept([ws](boost::system::error_code ec) {
+            if (ec) {
+                return;
+            }
+            ws->async_close(
+                {boost::beast::websocket::close_code::going_away, "bye"},
+                [](boost::system::error_code) {});
+        });
+    }
+
+    boost::asio::io_context ioc_;
+    boost::asio::ssl::context ssl_ctx_ = makeSelfSignedServerContext();
+    boost::asio::ip::tcp::acceptor acceptor_;
+    std::vector<std::shared_ptr<stream_type>> streams_;
+    std::thread thread_;
+};
+
+} // namespace
+
+TEST(ReconnectPolicyTest, FirstAttemptIsImmediate) {
+    ReconnectPolicy policy;
+    std::mt19937 rng(1);
+    EXPECT_EQ(policy.delayFor(1, rng).count(), 0);
+}
+
+TEST(ReconnectPolicyTest, BacksOffExponentiallyUpToCap) {
+    ReconnectPolicy policy;
+    policy.initial_delay = std::chrono::milliseconds(100);
+    policy.max_delay = std::chrono::milliseconds(1000);
+    policy.jitter = 0;
+    std::mt19937 rng(1);
+
+    EXPECT_EQ(policy.delayFor(2, rng).count(), 100);
+    EXPECT_EQ(policy.delayFor(3, rng).count(), 200);
+    EXPECT_EQ(policy.delayFor(4, rng).count(), 400);
+    EXPECT_EQ(policy.delayFor(6, rng).count(), 1000);
+    EXPECT_EQ(policy.delayFor(500, rng).count(), 1000);
+}
+
+TEST(ReconnectPolicyTest, JitterStaysWithinBounds) {
+    ReconnectPolicy policy;
+    policy.initial_delay = std::chrono::milliseconds(1000);
+    policy.max_delay = std::chrono::milliseconds(10000);
+    policy.jitter = 0.25;
+    std::mt19937 rng(42);
+
+    bool varied = false;
+    const auto first = policy.delayFor(2, rng);
+    for (int i = 0; i < 100; ++i) {
+        const auto delay = policy.delayFor(2, rng);
+        EXPECT_GE(delay.count(), 750);
+        EXPECT_LE(delay.count(), 1250);
+        varied = varied || delay != first;
+    }
+    EXPECT_TRUE(varied);
+}
+
+class ReconnectTest : public ClientTest {
+protected:
+    // Stop the server, dropping every connection, then bring up a new one
+    // on the same port once `whileDown` has run
+    void bounceServer(std::unique_ptr<LocalServer>& server, const std::function<void()>& whileDown) {
+        LocalServer::Options options = server->options();
+        options.port = server->port();
+        server.reset();
+
+        ASSERT_TRUE(waitFor([this]() { return errorCount() > 0; }));
+        whileDown();
+
+        server = std::make_unique<LocalServer>(options);
+        server->start();
+    }
+
+    void onMessage(std::string_view message, Opcode) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        received_.emplace_back(message);
+    }
+
+    void onReconnect(std::chrono::microseconds outage) {
+        outage_ = outage;
+        ++reconnects_;
+    }
+
+    std::size_t receivedCount() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return received_.size();
+    }
+
+    std::vector<std::string> received_;
+    std::atomic<int> reconnects_{0};
+    std::atomic<std::chrono::microseconds> outage_{std::chrono::microseconds(0)};
+};
+
+TEST_F(ReconnectTest, PlainClientFlushesQueuedMessagesInOrder) {
+    auto server = std::make_unique<LocalServer>(LocalServer::Options{});
+    server->start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setReconnectPolicy(fastPolicy(),
+        [this](std::chrono::microseconds outage) { onReconnect(outage); });
+    connect(*client, server->port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    client->send("before");
+    ASSERT_TRUE(waitFor([this]() { return receivedCount() == 1; }));
+
+    bounceServer(server, [&client]() {
+        client->send("during 1");
+        client->send("during 2");
+        client->send("during 3");
+    });
+    client->send("after");
+
+    ASSERT_TRUE(waitFor([this]() { return receivedCount() == 5; }));
+    EXPECT_EQ(received_, (std::vector<std::string>{
+        "before", "during 1", "during 2", "during 3", "after"}));
+    EXPECT_EQ(reconnects_, 1);
+    EXPECT_EQ(connects_, 2);
+    EXPECT_GT(outage_.load().count(), 0);
+    EXPECT_EQ(client->stats().reconnects, 1u);
+}
+
+TEST_F(ReconnectTest, SecureClientReconnectsWithResumedSession) {
+    LocalServer::Options options;
+    options.secure = true;
+    auto server = std::make_unique<LocalServer>(options);
+    server->start();
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto cache = std::make_shared<TlsSessionCache>();
+    cache->attach(ssl_ctx_);
+
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    client->setSessionCache(cache);
+    client->setReconnectPolicy(fastPolicy(),
+        [this](std::chrono::microseconds outage) { onReconnect(outage); });
+    connect(*client, server->port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    client->send("before");
+    ASSERT_TRUE(waitFor([this]() { return receivedCount() == 1; }));
+
+    bounceServer(server, [&client]() {
+        client->send("during");
+    });
+
+    ASSERT_TRUE(waitFor([this]() { return receivedCount() == 2; }));
+    EXPECT_EQ(received_[1], "during");
+    EXPECT_EQ(reconnects_, 1);
+
+    // The restarted server has a new certificate and session cache, so the
+    // offered session is refused; what matters is that one was offered.
+    const ConnectionStats stats = client->stats();
+    EXPECT_EQ(stats.reconnects, 1u);
+    EXPECT_EQ(stats.tls_full_handshakes + stats.tls_resumed_handshakes, 2u);
+}
+
+TEST_F(ReconnectTest, GivesUpAfterMaxAttempts) {
+    auto server = std::make_unique<LocalServer>(LocalServer::Options{});
+    server->start();
+
+    ReconnectPolicy policy = fastPolicy();
+    policy.max_attempts = 3;
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setReconnectPolicy(policy);
+    connect(*client, server->port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    server.reset();
+
+    // The drop, three refused connects, then the give-up notice
+    ASSERT_TRUE(waitFor([this]() { return errorCount() == 5; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_EQ(errorCount(), 5u);
+    EXPECT_NE(errors().back().find("gave up"), std::string::npos);
+    EXPECT_EQ(reconnects_, 0);
+
+    // Nothing will carry a message now, so it is refused
+    EXPECT_TRUE(client->reconnectExhausted());
+    EXPECT_FALSE(client->canSend());
+    EXPECT_FALSE(client->trySend("late"));
+    client->send("late");
+    EXPECT_EQ(errors().back(), "Not connected");
+}
+
+TEST_F(ReconnectTest, SecureClientGivesUpAfterMaxAttempts) {
+    LocalServer::Options options;
+    options.secure = true;
+    auto server = std::make_unique<LocalServer>(options);
+    server->start();
+
+    ReconnectPolicy policy = fastPolicy();
+    policy.max_attempts = 2;
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    client->setReconnectPolicy(policy);
+    connect(*client, server->port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+    EXPECT_FALSE(client->reconnectExhausted());
+
+    server.reset();
+
+    ASSERT_TRUE(waitFor([&client]() { return client->reconnectExhausted(); }));
+    EXPECT_EQ(errors().back(), "reconnect: gave up after 2 attempts");
+    client->send("late");
+    EXPECT_EQ(errors().back(), "Not connected");
+}
+
+TEST_F(ReconnectTest, SecureClientWithoutPolicyReportsDropAndRefusesSends) {
+    LocalServer::Options options;
+    options.secure = true;
+    auto server = std::make_unique<LocalServer>(options);
+    server->start();
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    connect(*client, server->port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    EXPECT_TRUE(client->canSend());
+
+    server.reset();
+    ASSERT_TRUE(waitFor([this]() { return errorCount() == 1; }));
+    EXPECT_FALSE(client->canSend());
+
+    EXPECT_FALSE(client->trySend("late"));
+    client->send("late");
+    EXPECT_EQ(errors().back(), "Not connected");
+    EXPECT_EQ(client->stats().queued_messages, 0u);
+}
+
+// A clean close from the server is reported as such, not as a failed read,
+// and by both clients alike
+TEST_F(ReconnectTest, PlainClientReportsServerClose) {
+    ClosingServer<false> server;
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    connect(*client, server.port());
+    runIoContext();
+
+    ASSERT_TRUE(waitFor([this]() { return errorCount() == 1; }));
+    EXPECT_EQ(errors().front(), "Server closed the connection (1001: bye)");
+    EXPECT_FALSE(client->canSend());
+}
+
+TEST_F(ReconnectTest, SecureClientReportsServerClose) {
+    ClosingServer<true> server;
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    connect(*client, server.port());
+    runIoContext();
+
+    ASSERT_TRUE(waitFor([this]() { return errorCount() == 1; }));
+    EXPECT_EQ(errors().front(), "Server closed the connection (1001: bye)");
+    EXPECT_FALSE(client->canSend());
+}
+
+TEST_F(ReconnectTest, SecureClientReportsServerCloseAndReconnects) {
+    ClosingServer<true> server;
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    client->setReconnectPolicy(fastPolicy());
+    connect(*client, server.port());
+    runIoContext();
+
+    ASSERT_TRUE(waitFor([this]() { return connects_ >= 2 && errorCount() >= 2; }));
+    for (const auto& error : errors()) {
+        EXPECT_EQ(error.rfind("Server closed the connection", 0), 0u) << error;
+    }
+}
+
+} // namespace test
+} // namespace websocket_client
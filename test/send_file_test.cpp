@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include "local_server.hpp"
+#include "mapped_file.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+// Removes the file when the test ends
+class TempFile {
+public:
+    explicit TempFile(const std::string& contents) {
+        char path[] = "/tmp/websocket_send_file_XXXXXX";
+        const int fd = mkstemp(path);
+        EXPECT_GE(fd, 0);
+        close(fd);
+        path_ = path;
+        std::ofstream(path_, std::ios::binary) << contents;
+    }
+
+    ~TempFile() { unlink(path_.c_str()); }
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+// Deterministic, non-repeating enough to catch reordered fragments
+std::string pattern(std::size_t size) {
+    std::string bytes(size, '\0');
+    for (std::size_t i = 0; i < size; ++i) {
+        bytes[i] = static_cast<char>((i * 131 + i / 4096) & 0xff);
+    }
+    return bytes;
+}
+
+// Sends "before", the file and "after" through an echo server and checks
+// all three come back whole and in order
+template <class Client>
+void echoFileBetweenMessages(Client& client, boost::asio::io_context& ioc,
+                             unsigned short port) {
+    const std::string contents = pattern(3 * 1024 * 1024 + 123);
+    TempFile file(contents);
+
+    std::mutex mutex;
+    std::vector<std::string> received;
+    client.setWriteFragmentSize(16 * 1024);
+    client.connect(
+        "127.0.0.1",
+        std::to_string(port),
+        "/",
+        [&](std::string_view message, Opcode) {
+            std::lock_guard<std::mutex> lock(mutex);
+            received.emplace_back(message);
+        },
+        [](const std::string& error) { ADD_FAILURE() << error; },
+        [&]() {
+            client.send("before");
+            client.sendFile(file.path());
+            client.send("after");
+        }
+    );
+    std::thread io_thread([&ioc]() { ioc.run(); });
+
+    const auto receivedAll = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return received.size() == 3;
+    };
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!receivedAll() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    client.close();
+    io_thread.join();
+
+    ASSERT_EQ(received.size(), 3u);
+    EXPECT_EQ(received[0], "before");
+    EXPECT_TRUE(received[1] == contents) << "file came back as " << received[1].size() << " bytes";
+    EXPECT_EQ(received[2], "after");
+    EXPECT_EQ(client.stats().payload_bytes_sent, contents.size() + 11);
+}
+
+} // namespace
+
+TEST(MappedFileTest, MapsFileContents) {
+    const std::string contents = pattern(10000);
+    TempFile file(contents);
+
+    auto mapped = MappedFile::open(file.path());
+    ASSERT_EQ(mapped->size(), contents.size());
+    EXPECT_EQ(std::string(mapped->data(), mapped->size()), contents);
+
+    // Dropping pages never changes what the mapping reads back
+    mapped->release(0, mapped->size());
+    EXPECT_EQ(std::string(mapped->data(), mapped->size()), contents);
+}
+
+TEST(MappedFileTest, EmptyFileMapsToNothing) {
+    TempFile file("");
+    auto mapped = MappedFile::open(file.path());
+    EXPECT_EQ(mapped->size(), 0u);
+}
+
+TEST(MappedFileTest, MissingFileThrows) {
+    EXPECT_THROW(MappedFile::open("/nonexistent/websocket_send_file"), std::system_error);
+}
+
+TEST(MappedFileTest, NonRegularFileThrows) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    EXPECT_THROW(MappedFile::open("/proc/self/fd/" + std::to_string(fds[0])), std::system_error);
+    close(fds[0]);
+    close(fds[1]);
+
+    EXPECT_THROW(MappedFile::open("/dev/null"), std::system_error);
+}
+
+TEST(SendFileTest, PlainClientStreamsFileAsOneMessage) {
+    LocalServer server({});
+    server.start();
+
+    boost::asio::io_context ioc;
+    auto client = std::make_shared<WebSocketClientPlain>(ioc);
+    echoFileBetweenMessages(*client, ioc, server.port());
+}
+
+TEST(SendFileTest, SecureClientStreamsFileAsOneMessage) {
+    LocalServer::Options options;
+    options.secure = true;
+    LocalServer server(options);
+    server.start();
+
+    boost::asio::ssl::context ssl_ctx{boost::asio::ssl::context::tlsv12_client};
+    ssl_ctx.set_verify_mode(boost::asio::ssl::verify_none);
+    boost::asio::io_context ioc;
+    auto client = std::make_shared<WebSocketClient>(ioc, ssl_ctx);
+    echoFileBetweenMessages(*client, ioc, server.port());
+}
+
+} // namespace test
+} // namespace websocket_client
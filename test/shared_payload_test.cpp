@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "local_server.hpp"
+#include "shared_payload.hpp"
+#include "test_util.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+TEST(SharedPayloadTest, CopiesShareTheBytes) {
+    const SharedPayload empty;
+    EXPECT_FALSE(empty);
+    EXPECT_EQ(empty.size(), 0u);
+
+    const SharedPayload text = SharedPayload::text("hello");
+    EXPECT_TRUE(text);
+    EXPECT_FALSE(text.isBinary());
+    EXPECT_EQ(text.view(), "hello");
+
+    SharedPayload copy = text;
+    EXPECT_EQ(copy.data(), text.data());
+    EXPECT_EQ(text.useCount(), 2);
+    copy.reset();
+    EXPECT_EQ(text.useCount(), 1);
+
+    const SharedPayload binary = SharedPayload::binary(std::vector<uint8_t>{0, 1, 2});
+    EXPECT_TRUE(binary.isBinary());
+    EXPECT_EQ(binary.view(), std::string_view("\0\1\2", 3));
+}
+
+class SharedPayloadClientTest : public ClientTest {
+protected:
+    void onMessage(std::string_view message, Opcode opcode) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        echoes_.emplace_back(message);
+        opcodes_.push_back(opcode);
+    }
+
+    std::size_t echoCount() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return echoes_.size();
+    }
+
+    std::vector<std::string> echoes_;
+    std::vector<Opcode> opcodes_;
+};
+
+TEST_F(SharedPayloadClientTest, FrameEncoderLeavesSharedBytesAlone) {
+    LocalServer server({});
+    server.start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setFrameEncoder(true);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    const std::string original(100 * 1024, 's');
+    const SharedPayload payload = SharedPayload::text(original);
+    client->send(payload);
+    client->send(payload);
+    EXPECT_TRUE(client->trySend(payload));
+
+    ASSERT_TRUE(waitFor([this]() { return echoCount() == 3; }));
+    EXPECT_EQ(payload.view(), original);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        EXPECT_EQ(echoes_, std::vector<std::string>(3, original));
+        EXPECT_EQ(opcodes_.front(), Opcode::text);
+    }
+    ASSERT_TRUE(waitFor([&]() { return payload.useCount() == 1; }));
+    EXPECT_EQ(client->stats().queued_bytes, 0u);
+    EXPECT_TRUE(errors().empty());
+}
+
+TEST_F(SharedPayloadClientTest, SecureClientSendsSharedBytes) {
+    LocalServer::Options options;
+    options.secure = true;
+    LocalServer server(options);
+    server.start();
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    const SharedPayload payload = SharedPayload::binary(std::string(64 * 1024, '\x7f'));
+    client->send(payload);
+
+    ASSERT_TRUE(waitFor([this]() { return echoCount() == 1; }));
+    EXPECT_TRUE(errors().empty());
+    std::lock_guard<std::mutex> lock(mutex_);
+    EXPECT_EQ(echoes_.front(), payload.view());
+    EXPECT_EQ(opcodes_.front(), Opcode::binary);
+}
+
+} // namespace test
+} // namespace websocket_client
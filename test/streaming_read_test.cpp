@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include "local_server.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+constexpr std::size_t kMessageSize = 1024 * 1024;
+constexpr std::uint64_t kMessageCount = 8;
+constexpr std::size_t kChunkSize = 16 * 1024;
+
+// What a streaming handler saw, filled in on the io thread
+struct ChunkLog {
+    std::mutex mutex;
+    std::size_t chunks = 0;
+    std::size_t largest_chunk = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t messages = 0;
+    std::uint64_t current_message = 0;
+    bool intact = true;
+
+    void record(std::string_view chunk, bool last) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++chunks;
+        largest_chunk = std::max(largest_chunk, chunk.size());
+        bytes += chunk.size();
+        current_message += chunk.size();
+        intact = intact && chunk.find_first_not_of('x') == std::string_view::npos;
+        if (last) {
+            intact = intact && current_message == kMessageSize;
+            current_message = 0;
+            ++messages;
+        }
+    }
+
+    bool done() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return messages == kMessageCount;
+    }
+};
+
+LocalServer::Options floodOptions(bool secure) {
+    LocalServer::Options options;
+    options.mode = LocalServer::Mode::flood;
+    options.flood_count = kMessageCount;
+    options.flood_message_size = kMessageSize;
+    options.secure = secure;
+    return options;
+}
+
+template <class Client>
+void receiveInChunks(Client& client, boost::asio::io_context& ioc,
+                     unsigned short port, ChunkLog& log) {
+    client.setReadChunkSize(kChunkSize);
+    client.connect(
+        "127.0.0.1",
+        std::to_string(port),
+        "/",
+        [&log](std::string_view chunk, Opcode, bool last) {
+            log.record(chunk, last);
+        },
+        [](const std::string& error) { ADD_FAILURE() << error; }
+    );
+    std::thread io_thread([&ioc]() { ioc.run(); });
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    while (!log.done() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    client.close();
+    io_thread.join();
+}
+
+void expectWholeMessages(ChunkLog& log, const ConnectionStats& stats) {
+    std::lock_guard<std::mutex> lock(log.mutex);
+    EXPECT_EQ(log.messages, kMessageCount);
+    EXPECT_EQ(log.bytes, kMessageCount * kMessageSize);
+    EXPECT_LE(log.largest_chunk, kChunkSize);
+    EXPECT_GE(log.chunks, kMessageCount * (kMessageSize / kChunkSize));
+    EXPECT_TRUE(log.intact);
+
+    EXPECT_EQ(stats.messages_received, kMessageCount);
+    EXPECT_EQ(stats.payload_bytes_received, kMessageCount * kMessageSize);
+}
+
+} // namespace
+
+TEST(StreamingReadTest, PlainClientDeliversLargeMessagesInChunks) {
+    LocalServer server(floodOptions(false));
+    server.start();
+
+    boost::asio::io_context ioc;
+    auto client = std::make_shared<WebSocketClientPlain>(ioc);
+    ChunkLog log;
+    receiveInChunks(*client, ioc, server.port(), log);
+
+    expectWholeMessages(log, client->stats());
+}
+
+TEST(StreamingReadTest, SecureClientDeliversLargeMessagesInChunks) {
+    LocalServer server(floodOptions(true));
+    server.start();
+
+    boost::asio::ssl::context ssl_ctx{boost::asio::ssl::context::tlsv12_client};
+    ssl_ctx.set_verify_mode(boost::asio::ssl::verify_none);
+    boost::asio::io_context ioc;
+    auto client = std::make_shared<WebSocketClient>(ioc, ssl_ctx);
+    ChunkLog log;
+    receiveInChunks(*client, ioc, server.port(), log);
+
+    expectWholeMessages(log, client->stats());
+}
+
+TEST(StreamingReadTest, MessageOverLimitFailsTheRead) {
+    LocalServer::Options options;
+    options.mode = LocalServer::Mode::flood;
+    options.flood_count = 1;
+    options.flood_message_size = 128 * 1024;
+    LocalServer server(options);
+    server.start();
+
+    boost::asio::io_context ioc;
+    auto client = std::make_shared<WebSocketClientPlain>(ioc);
+    client->setReadMessageMax(64 * 1024);
+
+    std::atomic<bool> delivered{false};
+    std::promise<std::string> failed;
+    auto failed_future = failed.get_future();
+    client->connect(
+        "127.0.0.1",
+        std::to_string(server.port()),
+        "/",
+        [&delivered](std::string_view, Opcode) { delivered = true; },
+        [&failed](const std::string& error) { failed.set_value(error); }
+    );
+    std::thread io_thread([&ioc]() { ioc.run(); });
+
+    ASSERT_EQ(failed_future.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    const std::string error = failed_future.get();
+    EXPECT_NE(error.find("limit"), std::string::npos) << error;
+    EXPECT_FALSE(delivered);
+
+    client->close();
+    io_thread.join();
+}
+
+} // namespace test
+} // namespace websocket_client
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include "message_types.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+// Polls `done` until it holds. Returns false if `timeout` passes first.
+inline bool waitFor(const std::function<bool()>& done,
+                    std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+// Fixture for tests that run clients on one io thread against a server on
+// 127.0.0.1. Errors and connects are recorded; fixtures that look at the
+// messages override onMessage(), which runs on the io thread.
+class ClientTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        ioc_.stop();
+        if (ioc_thread_.joinable()) {
+            ioc_thread_.join();
+        }
+    }
+
+    void runIoContext() {
+        ioc_thread_ = std::thread([this]() {
+            ioc_.run();
+        });
+    }
+
+    template <class Client>
+    void connect(Client& client, unsigned short port) {
+        client.connect(
+            "127.0.0.1",
+            std::to_string(port),
+            "/",
+            [this](std::string_view message, Opcode opcode) {
+                onMessage(message, opcode);
+            },
+            [this](const std::string& error) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                errors_.push_back(error);
+            },
+            [this]() {
+                ++connects_;
+            }
+        );
+    }
+
+    virtual void onMessage(std::string_view, Opcode) {}
+
+    std::vector<std::string> errors() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return errors_;
+    }
+
+    std::size_t errorCount() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return errors_.size();
+    }
+
+    // A member, not a local of the test, since the io thread may still be
+    // using it until TearDown()
+    boost::asio::ssl::context ssl_ctx_{boost::asio::ssl::context::tlsv12_client};
+    boost::asio::io_context ioc_;
+    std::thread ioc_thread_;
+    std::mutex mutex_;
+    std::vector<std::string> errors_;
+    std::atomic<int> connects_{0};
+};
+
+} // namespace test
+} // namespace websocket_client
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "local_server.hpp"
+#include "tls_session_cache.hpp"
+#include "websocket_client.hpp"
+#include <boost/asio/io_context.hpp>
+#include <openssl/ssl.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace websocket_client {
+namespace test {
+
+class TlsSessionCacheTest
+    : public ::testing::TestWithParam<boost::asio::ssl::context::method> {
+protected:
+    void SetUp() override {
+        LocalServer::Options options;
+        options.secure = true;
+        server_ = std::make_unique<LocalServer>(options);
+        server_->start();
+
+        ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+        cache_->attach(ssl_ctx_);
+    }
+
+    // Connect, round-trip one message (so TLS 1.3 tickets have arrived), close
+    ConnectionStats connectOnce() {
+        boost::asio::io_context ioc;
+        auto client = std::make_shared<WebSocketClient>(ioc, ssl_ctx_);
+        client->setSessionCache(cache_);
+
+        std::atomic<bool> echoed{false};
+        client->connect(
+            "127.0.0.1",
+            std::to_string(server_->port()),
+            "/",
+            [&](std::string_view, Opcode) { echoed = true; },
+            [](const std::string& error) { ADD_FAILURE() << error; },
+            [&client]() { client->send("hello"); }
+        );
+
+        std::thread io_thread([&ioc]() { ioc.run(); });
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!echoed && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_TRUE(echoed);
+
+        const ConnectionStats stats = client->stats();
+        client->close();
+        io_thread.join();
+        return stats;
+    }
+
+    std::unique_ptr<LocalServer> server_;
+    boost::asio::ssl::context ssl_ctx_{GetParam()};
+    std::shared_ptr<TlsSessionCache> cache_ = std::make_shared<TlsSessionCache>();
+};
+
+TEST_P(TlsSessionCacheTest, SecondConnectResumesSession) {
+    const ConnectionStats first = connectOnce();
+    EXPECT_EQ(first.tls_full_handshakes, 1u);
+    EXPECT_EQ(first.tls_resumed_handshakes, 0u);
+    EXPECT_EQ(cache_->stats().cached_hosts, 1u);
+
+    const ConnectionStats second = connectOnce();
+    EXPECT_EQ(second.tls_full_handshakes, 0u);
+    EXPECT_EQ(second.tls_resumed_handshakes, 1u);
+
+    const TlsSessionCache::Stats stats = cache_->stats();
+    EXPECT_EQ(stats.full_handshakes, 1u);
+    EXPECT_EQ(stats.resumed_handshakes, 1u);
+    EXPECT_GE(stats.sessions_stored, 1u);
+}
+
+TEST_P(TlsSessionCacheTest, ClearForcesFullHandshake) {
+    connectOnce();
+    cache_->clear();
+
+    const ConnectionStats second = connectOnce();
+    EXPECT_EQ(second.tls_full_handshakes, 1u);
+    EXPECT_EQ(cache_->stats().resumed_handshakes, 0u);
+}
+
+TEST_P(TlsSessionCacheTest, Tls13TicketIsOfferedOnce) {
+    connectOnce();
+
+    const std::string key = "127.0.0.1:" + std::to_string(server_->port());
+    SSL* first = SSL_new(ssl_ctx_.native_handle());
+    SSL* second = SSL_new(ssl_ctx_.native_handle());
+    cache_->prepare(first, key);
+    cache_->prepare(second, key);
+
+    SSL_SESSION* offered = SSL_get_session(first);
+    ASSERT_NE(offered, nullptr);
+    if (SSL_SESSION_get_protocol_version(offered) == TLS1_3_VERSION) {
+        EXPECT_EQ(SSL_get_session(second), nullptr);
+        EXPECT_EQ(cache_->stats().cached_hosts, 0u);
+    } else {
+        EXPECT_EQ(SSL_get_session(second), offered);
+    }
+
+    SSL_free(first);
+    SSL_free(second);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    TlsVersions,
+    TlsSessionCacheTest,
+    ::testing::Values(
+        boost::asio::ssl::context::tlsv12_client,
+        boost::asio::ssl::context::tlsv13_client));
+
+} // namespace test
+} // namespace websocket_client
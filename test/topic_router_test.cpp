@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "topic_router.hpp"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+TEST(TopicKeyTest, FindsMembersAtAJsonPath) {
+    const auto channel = TopicKey::jsonPath("channel");
+    EXPECT_EQ(channel.extract(R"({"channel":"trades","data":1})"), "trades");
+    EXPECT_EQ(channel.extract(R"( { "id" : 7 , "channel" : "book" } )"), "book");
+    EXPECT_EQ(channel.extract(R"({"channel":42})"), "42");
+    EXPECT_EQ(channel.extract(R"({"channel":"a\"b"})"), R"(a\"b)");
+
+    // Members before it are skipped whole, strings and nesting included
+    EXPECT_EQ(channel.extract(
+        R"({"x":{"channel":"no","y":[1,{"z":"}"}]},"s":"\"channel\":","channel":"yes"})"),
+        "yes");
+
+    EXPECT_FALSE(channel.extract(R"({"data":{"channel":"nested"}})"));
+    EXPECT_FALSE(channel.extract(R"({"channel":{"a":1}})"));
+    EXPECT_FALSE(channel.extract(R"(["channel","x"])"));
+    EXPECT_FALSE(channel.extract(R"({"channel":"unterminated)"));
+    EXPECT_FALSE(channel.extract(R"({"channel":)"));
+    EXPECT_FALSE(channel.extract("not json"));
+    EXPECT_FALSE(channel.extract(""));
+
+    const auto nested = TopicKey::jsonPath("data.channel");
+    EXPECT_EQ(nested.extract(R"({"type":"update","data":{"seq":3,"channel":"nested"}})"), "nested");
+    EXPECT_FALSE(nested.extract(R"({"data":"channel"})"));
+}
+
+TEST(TopicKeyTest, TakesBytesAtAnOffset) {
+    const auto key = TopicKey::bytes(2, 3);
+    EXPECT_EQ(key.extract("xxABCyy"), "ABC");
+    EXPECT_EQ(key.extract("xxABC"), "ABC");
+    EXPECT_FALSE(key.extract("xxAB"));
+    EXPECT_FALSE(key.extract("x"));
+}
+
+TEST(TopicRouterTest, DispatchesToSubscribersOfTheTopic) {
+    TopicRouter router(TopicKey::jsonPath("channel"));
+    std::vector<std::string> calls;
+
+    router.subscribe("trades", [&](std::string_view topic, std::string_view message) {
+        calls.push_back("first " + std::string(topic) + " " + std::string(message));
+    });
+    router.subscribe("trades", [&](std::string_view topic, std::string_view) {
+        calls.push_back("second " + std::string(topic));
+    });
+    const auto book = router.subscribeAll({"book", "ticker"}, [&](std::string_view topic, std::string_view) {
+        calls.push_back("multi " + std::string(topic));
+    });
+    EXPECT_EQ(router.topicCount(), 3u);
+
+    EXPECT_TRUE(router.dispatch(R"({"channel":"trades"})"));
+    EXPECT_TRUE(router.dispatch(R"({"channel":"ticker"})"));
+    EXPECT_FALSE(router.dispatch(R"({"channel":"other"})"));
+    EXPECT_FALSE(router.dispatch(R"({"type":"heartbeat"})"));
+    EXPECT_EQ(calls, (std::vector<std::string>{
+        R"(first trades {"channel":"trades"})",
+        "second trades",
+        "multi ticker",
+    }));
+
+    EXPECT_TRUE(router.unsubscribe(book));
+    EXPECT_FALSE(router.unsubscribe(book));
+    EXPECT_EQ(router.topicCount(), 1u);
+    EXPECT_FALSE(router.dispatch(R"({"channel":"book"})"));
+}
+
+TEST(TopicRouterTest, FindsEveryTopicInALargeTable) {
+    TopicRouter router(TopicKey::bytes(0, 8));
+    constexpr int kTopics = 50000;
+
+    std::vector<std::string> topics;
+    for (int i = 0; i < kTopics; ++i) {
+        char topic[9];
+        std::snprintf(topic, sizeof(topic), "%08d", i);
+        topics.emplace_back(topic);
+    }
+
+    std::vector<int> hits(kTopics);
+    router.subscribeAll(topics, [&](std::string_view topic, std::string_view) {
+        ++hits[std::stoi(std::string(topic))];
+    });
+    EXPECT_EQ(router.topicCount(), static_cast<std::size_t>(kTopics));
+
+    for (const auto& topic : topics) {
+        EXPECT_TRUE(router.dispatch(topic + "payload"));
+    }
+    EXPECT_FALSE(router.dispatch("99999999payload"));
+    EXPECT_EQ(hits, std::vector<int>(kTopics, 1));
+}
+
+TEST(TopicRouterTest, SubscribersMayUnsubscribeWhileDispatching) {
+    TopicRouter router(TopicKey::jsonPath("channel"));
+    int calls = 0;
+    TopicRouter::SubscriptionId id = 0;
+    id = router.subscribe("once", [&](std::string_view, std::string_view) {
+        ++calls;
+        router.unsubscribe(id);
+    });
+
+    EXPECT_TRUE(router.dispatch(R"({"channel":"once"})"));
+    EXPECT_FALSE(router.dispatch(R"({"channel":"once"})"));
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(TopicRouterTest, SubscriptionsChangeWhileOtherThreadsDispatch) {
+    TopicRouter router(TopicKey::jsonPath("channel"));
+    std::atomic<int> stable{0};
+    router.subscribe("stable", [&](std::string_view, std::string_view) { ++stable; });
+
+    std::atomic<bool> done{false};
+    std::thread churn([&]() {
+        for (int i = 0; i < 200; ++i) {
+            const auto id = router.subscribe("topic" + std::to_string(i),
+                [](std::string_view, std::string_view) {});
+            if (i % 2 == 0) {
+                router.unsubscribe(id);
+            }
+        }
+        done = true;
+    });
+
+    int dispatched = 0;
+    while (!done) {
+        EXPECT_TRUE(router.dispatch(R"({"channel":"stable"})"));
+        ++dispatched;
+    }
+    churn.join();
+
+    EXPECT_EQ(stable, dispatched);
+    EXPECT_EQ(router.topicCount(), 101u);
+}
+
+} // namespace test
+} // namespace websocket_client
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include "local_server.hpp"
+#include "test_util.hpp"
+#include "trace_recorder.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+std::string traceOf(const TraceRecorder& tracer) {
+    std::ostringstream out;
+    tracer.write(out);
+    return out.str();
+}
+
+bool hasSpan(const std::string& trace, const std::string& name) {
+    return trace.find("{\"name\":\"" + name + "\",\"cat\":\"connection\",\"ph\":\"X\"")
+        != std::string::npos;
+}
+
+} // namespace
+
+TEST(TraceRecorderTest, WritesSpansAsTraceEvents) {
+    TraceRecorder tracer;
+    const auto track = tracer.newTrack("example.com:443");
+    EXPECT_NE(track, 0u);
+
+    const auto start = TraceRecorder::Clock::now();
+    tracer.record("resolve", track, TraceLane::lifecycle, start, start + std::chrono::nanoseconds(1500));
+    tracer.record("tcp_connect", track, TraceLane::lifecycle, start, start, true);
+    std::thread([&]() {
+        tracer.record("read", track, TraceLane::reads, start, start);
+    }).join();
+
+    const std::string trace = traceOf(tracer);
+    EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    EXPECT_TRUE(hasSpan(trace, "resolve"));
+    EXPECT_TRUE(hasSpan(trace, "tcp_connect"));
+    EXPECT_TRUE(hasSpan(trace, "read"));
+    EXPECT_NE(trace.find("\"dur\":1.500"), std::string::npos);
+    EXPECT_NE(trace.find("\"failed\":true"), std::string::npos);
+
+    // Rows are named after the track, and only rows with spans appear
+    EXPECT_NE(trace.find("\"name\":\"example.com:443 #1\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"example.com:443 #1 reads\""), std::string::npos);
+    EXPECT_EQ(trace.find("writes"), std::string::npos);
+
+    const auto stats = tracer.stats();
+    EXPECT_EQ(stats.spans, 3u);
+    EXPECT_EQ(stats.dropped, 0u);
+    EXPECT_EQ(stats.threads, 2u);
+}
+
+TEST(TraceRecorderTest, EscapesLabels) {
+    TraceRecorder tracer;
+    const auto track = tracer.newTrack("a\"b\\c\n");
+    const auto now = TraceRecorder::Clock::now();
+    tracer.record("connect", track, TraceLane::lifecycle, now, now);
+
+    EXPECT_NE(traceOf(tracer).find("\"a\\\"b\\\\c\\u000a #1\""), std::string::npos);
+}
+
+TEST(TraceRecorderTest, DropsSpansBeyondCapacity) {
+    TraceRecorder::Options options;
+    options.spans_per_thread = 2;
+    TraceRecorder tracer(options);
+    const auto track = tracer.newTrack("host:1");
+
+    const auto now = TraceRecorder::Clock::now();
+    for (int i = 0; i < 5; ++i) {
+        tracer.record("write", track, TraceLane::writes, now, now);
+    }
+
+    const auto stats = tracer.stats();
+    EXPECT_EQ(stats.spans, 2u);
+    EXPECT_EQ(stats.dropped, 3u);
+}
+
+TEST(TraceRecorderTest, SamplesOneInN) {
+    EXPECT_FALSE(TraceRecorder().sampled(0));
+
+    TraceRecorder::Options options;
+    options.sample_every = 4;
+    TraceRecorder tracer(options);
+    EXPECT_TRUE(tracer.sampled(0));
+    EXPECT_FALSE(tracer.sampled(1));
+    EXPECT_FALSE(tracer.sampled(3));
+    EXPECT_TRUE(tracer.sampled(4));
+}
+
+TEST(TraceRecorderTest, WriteFileThrowsWhenItCannotOpen) {
+    TraceRecorder tracer;
+    EXPECT_THROW(tracer.writeFile("/nonexistent/dir/trace.json"), std::system_error);
+
+    const std::string path = testing::TempDir() + "trace_recorder_test.json";
+    tracer.writeFile(path);
+    std::ifstream in(path);
+    const std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(contents, traceOf(tracer));
+    std::remove(path.c_str());
+}
+
+class TraceRecorderClientTest : public ClientTest {
+protected:
+    void SetUp() override {
+        TraceRecorder::Options options;
+        options.sample_every = 1;
+        tracer_ = std::make_shared<TraceRecorder>(options);
+    }
+
+    void onMessage(std::string_view, Opcode) override {
+        ++echoes_;
+    }
+
+    std::shared_ptr<TraceRecorder> tracer_;
+    std::atomic<int> echoes_{0};
+};
+
+TEST_F(TraceRecorderClientTest, PlainClientTracesEachPhase) {
+    LocalServer server({});
+    server.start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setTracer(tracer_);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    client->send("hello");
+    ASSERT_TRUE(waitFor([this]() { return echoes_ == 1; }));
+    EXPECT_TRUE(errors().empty());
+
+    const std::string trace = traceOf(*tracer_);
+    EXPECT_TRUE(hasSpan(trace, "resolve"));
+    EXPECT_TRUE(hasSpan(trace, "tcp_connect"));
+    EXPECT_TRUE(hasSpan(trace, "ws_handshake"));
+    EXPECT_TRUE(hasSpan(trace, "connect"));
+    EXPECT_TRUE(hasSpan(trace, "first_message"));
+    EXPECT_TRUE(hasSpan(trace, "read"));
+    EXPECT_TRUE(hasSpan(trace, "write"));
+    EXPECT_FALSE(hasSpan(trace, "tls_handshake"));
+    EXPECT_EQ(trace.find("\"failed\":true"), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"127.0.0.1:" + std::to_string(server.port()) + " #1\""),
+              std::string::npos);
+}
+
+TEST_F(TraceRecorderClientTest, SecureClientTracesTlsHandshake) {
+    LocalServer::Options options;
+    options.secure = true;
+    LocalServer server(options);
+    server.start();
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    client->setTracer(tracer_);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    client->send("hello");
+    ASSERT_TRUE(waitFor([this]() { return echoes_ == 1; }));
+    EXPECT_TRUE(errors().empty());
+
+    const std::string trace = traceOf(*tracer_);
+    EXPECT_TRUE(hasSpan(trace, "tcp_connect"));
+    EXPECT_TRUE(hasSpan(trace, "tls_handshake"));
+    EXPECT_TRUE(hasSpan(trace, "ws_handshake"));
+    EXPECT_TRUE(hasSpan(trace, "first_message"));
+}
+
+} // namespace test
+} // namespace websocket_client
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include "keepalive_policy.hpp"
+#include "local_server.hpp"
+#include "test_util.hpp"
+#include "websocket_client.hpp"
+#include "websocket_client_plain.hpp"
+#include "write_batch_options.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace websocket_client {
+namespace test {
+
+namespace {
+
+WriteBatchOptions batching(std::chrono::microseconds linger = std::chrono::microseconds(0)) {
+    WriteBatchOptions options;
+    options.max_bytes = 16 * 1024;
+    options.linger = linger;
+    return options;
+}
+
+} // namespace
+
+class WriteBatchTest : public ClientTest {
+protected:
+    void onMessage(std::string_view message, Opcode) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        echoes_.emplace_back(message);
+    }
+
+    // Queues every message from one handler on the client's strand, so they
+    // are all waiting before the first write starts
+    template <class Client>
+    void sendBurst(const std::shared_ptr<Client>& client, const std::vector<std::string>& messages) {
+        boost::asio::post(client->get_executor(), [client, messages]() {
+            for (const std::string& message : messages) {
+                client->send(message);
+            }
+        });
+    }
+
+    std::size_t echoCount() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return echoes_.size();
+    }
+
+    std::vector<std::string> echoes() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return echoes_;
+    }
+
+    static std::vector<std::string> numbered(std::size_t count, std::size_t size) {
+        std::vector<std::string> messages;
+        for (std::size_t i = 0; i < count; ++i) {
+            std::string message = std::to_string(i);
+            message.resize(std::max(size, message.size()), '.');
+            messages.push_back(std::move(message));
+        }
+        return messages;
+    }
+
+    std::vector<std::string> echoes_;
+};
+
+TEST_F(WriteBatchTest, PlainClientCoalescesQueuedMessages) {
+    LocalServer server({});
+    server.start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setWriteBatching(batching());
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    const auto before = client->stats().transport_writes;
+    const auto messages = numbered(1000, 64);
+    sendBurst(client, messages);
+
+    ASSERT_TRUE(waitFor([&]() { return echoCount() == messages.size(); }));
+    EXPECT_EQ(echoes(), messages);
+
+    // 1000 frames of 70 bytes fill a 16 KiB batch about every 230 frames
+    const ConnectionStats stats = client->stats();
+    EXPECT_EQ(stats.messages_sent, messages.size());
+    EXPECT_LE(stats.transport_writes - before, 20u);
+    EXPECT_TRUE(errors().empty());
+}
+
+TEST_F(WriteBatchTest, UnbatchedClientWritesEveryFrame) {
+    LocalServer server({});
+    server.start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    const auto before = client->stats().transport_writes;
+    const auto messages = numbered(200, 64);
+    sendBurst(client, messages);
+
+    ASSERT_TRUE(waitFor([&]() { return echoCount() == messages.size(); }));
+    EXPECT_GE(client->stats().transport_writes - before, messages.size());
+}
+
+TEST_F(WriteBatchTest, LargeMessagesBypassTheBatchInOrder) {
+    LocalServer server({});
+    server.start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setWriteBatching(batching());
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    std::vector<std::string> messages;
+    for (std::size_t i = 0; i < 20; ++i) {
+        messages.push_back(std::string(i % 3 == 0 ? 100 * 1024 : 32, static_cast<char>('a' + i)));
+    }
+    sendBurst(client, messages);
+
+    ASSERT_TRUE(waitFor([&]() { return echoCount() == messages.size(); }));
+    EXPECT_EQ(echoes(), messages);
+}
+
+TEST_F(WriteBatchTest, LingerHoldsALoneMessage) {
+    LocalServer server({});
+    server.start();
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setWriteBatching(batching(std::chrono::milliseconds(100)));
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    const auto start = std::chrono::steady_clock::now();
+    client->send("alone");
+    ASSERT_TRUE(waitFor([this]() { return echoCount() == 1; }));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(90));
+}
+
+TEST_F(WriteBatchTest, PingsGoOutWithoutTraffic) {
+    LocalServer server({});
+    server.start();
+
+    KeepalivePolicy keepalive;
+    keepalive.interval = std::chrono::milliseconds(20);
+
+    auto client = std::make_shared<WebSocketClientPlain>(ioc_);
+    client->setWriteBatching(batching());
+    client->setKeepalive(keepalive);
+    connect(*client, server.port());
+    runIoContext();
+
+    ASSERT_TRUE(waitFor([&client]() { return client->stats().pongs_received >= 3; }));
+    EXPECT_EQ(client->stats().missed_pongs, 0u);
+}
+
+TEST_F(WriteBatchTest, SecureClientCoalescesBelowTls) {
+    LocalServer::Options options;
+    options.secure = true;
+    LocalServer server(options);
+    server.start();
+
+    ssl_ctx_.set_verify_mode(boost::asio::ssl::verify_none);
+    auto client = std::make_shared<WebSocketClient>(ioc_, ssl_ctx_);
+    client->setWriteBatching(batching());
+    connect(*client, server.port());
+    runIoContext();
+    ASSERT_TRUE(waitFor([this]() { return connects_ == 1; }));
+
+    const auto before = client->stats().transport_writes;
+    const auto messages = numbered(1000, 64);
+    sendBurst(client, messages);
+
+    ASSERT_TRUE(waitFor([&]() { return echoCount() == messages.size(); }));
+    EXPECT_EQ(echoes(), messages);
+    EXPECT_LE(client->stats().transport_writes - before, 100u);
+    EXPECT_TRUE(errors().empty());
+}
+
+} // namespace test
+} // namespace websocket_client
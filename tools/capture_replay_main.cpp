@@ -0,0 +1,228 @@
+// Reads a capture log written by `websocket_client --capture <path>` and
+// replays it:
+//
+//   print - feeds every payload to a MessageHandler, as if just received
+//   send  - sends every payload with its original frame type to --host and
+//           --port, or to an in-process sink server when no port is given
+//   stats - per-connection message and byte counts and the time span
+//
+// --speed 1 keeps the original spacing between messages, 2 halves it, and
+// 0 replays as fast as possible. Payloads are read straight from the mapped
+// segments.
+
+#include "capture_log.hpp"
+#include "local_server.hpp"
+#include "message_handler.hpp"
+#include "output_writer.hpp"
+#include "websocket_client_plain.hpp"
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <CLI/CLI.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ReplayOptions {
+    std::string log;
+    std::string mode{"print"};
+    double speed = 1.0;
+    std::string host{"127.0.0.1"};
+    std::string port;
+    std::string target{"/"};
+    std::size_t window = 1024;
+};
+
+int runPrint(const ReplayOptions& options) {
+    websocket_client::CaptureReader reader(options.log);
+    websocket_client::ReplayClock clock(options.speed);
+    websocket_client::MessageHandler handler(websocket_client::OutputWriter::openStdout({}));
+
+    websocket_client::CaptureRecord record;
+    while (reader.next(record)) {
+        clock.waitFor(record.timestamp_ns);
+        handler.handleMessage(record.payload);
+    }
+    return 0;
+}
+
+int runStats(const ReplayOptions& options) {
+    struct PerConnection {
+        std::uint64_t text = 0;
+        std::uint64_t binary = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    websocket_client::CaptureReader reader(options.log);
+    std::map<std::uint32_t, PerConnection> connections;
+    std::uint64_t first_ns = 0;
+    std::uint64_t last_ns = 0;
+    std::uint64_t records = 0;
+
+    websocket_client::CaptureRecord record;
+    while (reader.next(record)) {
+        auto& entry = connections[record.connection_id];
+        ++(record.opcode == websocket_client::Opcode::binary ? entry.binary : entry.text);
+        entry.bytes += record.payload.size();
+
+        if (records++ == 0) {
+            first_ns = record.timestamp_ns;
+        }
+        last_ns = std::max(last_ns, record.timestamp_ns);
+    }
+
+    std::printf("%-10s %12s %12s %14s\n", "connection", "text", "binary", "bytes");
+    for (const auto& [id, entry] : connections) {
+        std::printf("%-10u %12llu %12llu %14llu\n", id,
+            static_cast<unsigned long long>(entry.text),
+            static_cast<unsigned long long>(entry.binary),
+            static_cast<unsigned long long>(entry.bytes));
+    }
+    std::printf("\n%llu records in %llu segments over %.3f s\n",
+        static_cast<unsigned long long>(records),
+        static_cast<unsigned long long>(reader.segmentsRead()),
+        records > 0 ? static_cast<double>(last_ns - first_ns) / 1e9 : 0.0);
+    return 0;
+}
+
+int runSend(const ReplayOptions& options) {
+    // Without a destination, measure against a local sink
+    std::unique_ptr<websocket_client::LocalServer> server;
+    std::string port = options.port;
+    if (port.empty()) {
+        websocket_client::LocalServer::Options server_options;
+        server_options.mode = websocket_client::LocalServer::Mode::sink;
+        server = std::make_unique<websocket_client::LocalServer>(server_options);
+        server->start();
+        port = std::to_string(server->port());
+    }
+
+    boost::asio::io_context ioc;
+    auto work = boost::asio::make_work_guard(ioc);
+    std::thread io_thread([&ioc]() { ioc.run(); });
+
+    auto client = std::make_shared<websocket_client::WebSocketClientPlain>(ioc);
+    client->setReadMessageMax(0);
+
+    std::promise<void> connected;
+    auto connected_future = connected.get_future();
+    std::atomic<bool> failed{false};
+    client->connect(
+        options.host,
+        port,
+        options.target,
+        [](std::string_view, websocket_client::Opcode) {},
+        [&failed](const std::string& error) {
+            std::cerr << "Error: " << error << std::endl;
+            failed = true;
+        },
+        [&connected]() { connected.set_value(); });
+
+    int status = 0;
+    if (connected_future.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+        std::cerr << "Error: connect timed out" << std::endl;
+        status = 1;
+    } else {
+        websocket_client::CaptureReader reader(options.log);
+        websocket_client::ReplayClock clock(options.speed);
+        std::uint64_t sent = 0;
+        std::uint64_t bytes = 0;
+        const auto start = Clock::now();
+
+        websocket_client::CaptureRecord record;
+        while (!failed && reader.next(record)) {
+            clock.waitFor(record.timestamp_ns);
+
+            // Keep the outbound queue bounded when replaying flat out. A
+            // full window takes a while to drain, so sleep rather than spin.
+            while (!failed && sent - client->stats().messages_sent >= options.window) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+
+            if (record.opcode == websocket_client::Opcode::binary) {
+                client->sendBinary(std::vector<uint8_t>(record.payload.begin(), record.payload.end()));
+            } else {
+                client->send(std::string(record.payload));
+            }
+            ++sent;
+            bytes += record.payload.size();
+        }
+
+        while (!failed && client->stats().messages_sent < sent) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::printf("sent %llu messages, %llu bytes in %.3f s (%.0f msgs/s, %.1f MB/s)\n",
+            static_cast<unsigned long long>(sent),
+            static_cast<unsigned long long>(bytes),
+            seconds,
+            static_cast<double>(sent) / seconds,
+            static_cast<double>(bytes) / seconds / 1e6);
+        status = failed ? 1 : 0;
+    }
+
+    client->close();
+    work.reset();
+    io_thread.join();
+
+    if (server) {
+        server->stop();
+        const auto stats = server->stats();
+        std::printf("sink received %llu messages, %llu bytes\n",
+            static_cast<unsigned long long>(stats.messages_received),
+            static_cast<unsigned long long>(stats.bytes_received));
+    }
+    return status;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    ReplayOptions options;
+
+    CLI::App app{"Capture log replay"};
+    app.add_option("--log", options.log, "Capture base path, as passed to --capture")
+        ->required();
+    app.add_option("-m,--mode", options.mode, "What to do with the records")
+        ->check(CLI::IsMember({"print", "send", "stats"}));
+    app.add_option("--speed", options.speed,
+        "Replay speed relative to the original timing (0 = as fast as possible)")
+        ->check(CLI::NonNegativeNumber);
+    app.add_option("--host", options.host, "Server host for --mode send");
+    app.add_option("--port", options.port,
+        "Server port for --mode send (default: an in-process sink)");
+    app.add_option("--target", options.target, "Target path for --mode send");
+    app.add_option("--window", options.window, "Messages in flight for --mode send")
+        ->check(CLI::PositiveNumber);
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError& e) {
+        return app.exit(e);
+    }
+
+    try {
+        if (options.mode == "stats") {
+            return runStats(options);
+        }
+        if (options.mode == "send") {
+            return runSend(options);
+        }
+        return runPrint(options);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
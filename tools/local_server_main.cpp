@@ -0,0 +1,64 @@
+// Standalone LocalServer for manual testing and for benchmarking against a
+// separate process: `websocket_local_server --mode echo --port 9001`.
+
+#include "local_server.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <CLI/CLI.hpp>
+#include <csignal>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    websocket_client::LocalServer::Options options;
+    options.port = 9001;
+    std::string mode{"echo"};
+
+    CLI::App app{"Local WebSocket test server"};
+    app.add_option("-a,--address", options.address, "Listen address");
+    app.add_option("-p,--port", options.port, "Listen port (0 picks a free one)");
+    app.add_option("-m,--mode", mode, "Server behaviour")
+        ->check(CLI::IsMember({"echo", "flood", "sink"}));
+    app.add_flag("--secure", options.secure, "Serve wss:// with a self-signed certificate");
+    app.add_option("--threads", options.threads, "Server io threads");
+    app.add_option("--flood-size", options.flood_message_size, "Flood message size in bytes");
+    app.add_option("--flood-count", options.flood_count, "Messages per flood connection (0 = unlimited)");
+    app.add_flag("--flood-binary", options.flood_binary, "Flood with binary frames");
+    app.add_flag("--compress", options.compression.enabled, "Accept permessage-deflate");
+
+    try {
+        app.parse(argc, argv);
+    } catch (const CLI::ParseError& e) {
+        return app.exit(e);
+    }
+
+    if (mode == "flood") {
+        options.mode = websocket_client::LocalServer::Mode::flood;
+    } else if (mode == "sink") {
+        options.mode = websocket_client::LocalServer::Mode::sink;
+    }
+
+    try {
+        websocket_client::LocalServer server(options);
+        server.start();
+        std::cout << "Listening on " << (options.secure ? "wss://" : "ws://")
+                  << options.address << ":" << server.port() << " (" << mode << ")" << std::endl;
+
+        // Serve until interrupted
+        boost::asio::io_context signals_ioc;
+        boost::asio::signal_set signals(signals_ioc, SIGINT, SIGTERM);
+        signals.async_wait([](const boost::system::error_code&, int) {});
+        signals_ioc.run();
+
+        server.stop();
+        const auto stats = server.stats();
+        std::cout << "connections=" << stats.connections
+                  << " received=" << stats.messages_received
+                  << " sent=" << stats.messages_sent << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}